@@ -23,12 +23,14 @@
 
 #include "Border.h"
 #include "BorderFile.h"
+#include "CaretOMP.h"
 #include "GiftiLabelTable.h"
 #include "GiftiMetaData.h"
 #include "SurfaceFile.h"
 #include "SurfaceProjectedItem.h"
 #include "SurfaceProjectionBarycentric.h"
 #include "SignedDistanceHelper.h"
+#include "SphericalTriangleLocator.h"
 
 using namespace caret;
 using namespace std;
@@ -89,7 +91,54 @@ AlgorithmBorderResample::AlgorithmBorderResample(ProgressObject* myProgObj, cons
         borderOut->addBorderMetadataKey(borderIn->getBorderMetadataKey(m));//rely on the keys being in order added
     }
     int numBorders = borderIn->getNumberOfBorders();
-    CaretPointer<SignedDistanceHelper> myHelp = newAdjust.getSignedDistanceHelper();
+    vector<int> pointStart(numBorders + 1, 0);//flatten the points of all borders we use, so the projection can be parallel across borders
+    for (int i = 0; i < numBorders; ++i)
+    {
+        const Border* inputBorder = borderIn->getBorder(i);
+        pointStart[i + 1] = pointStart[i];
+        if (inputBorder->getStructure() != curSphere->getStructure()) continue;
+        pointStart[i + 1] += inputBorder->getNumberOfPoints();
+    }
+    int totalPoints = pointStart[numBorders];
+    vector<BarycentricInfo> projections(totalPoints);
+    vector<char> pointStatus(totalPoints, 0);//0 is good, 1 is no barycentric projection, 2 is invalid for the current sphere
+    SphericalTriangleLocator myLocator(&newAdjust);
+#pragma omp CARET_PAR
+    {
+        CaretPointer<SignedDistanceHelper> myHelp = newAdjust.getSignedDistanceHelper();
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int i = 0; i < numBorders; ++i)
+        {
+            if (pointStart[i + 1] == pointStart[i]) continue;
+            const Border* inputBorder = borderIn->getBorder(i);
+            int numPoints = inputBorder->getNumberOfPoints();
+            int32_t lastTriangle = -1;//border points are close together, so each walk starts where the last ended
+            for (int j = 0; j < numPoints; ++j)
+            {
+                float coord[3];
+                const SurfaceProjectedItem* myItem = inputBorder->getPoint(j);
+                if (!myItem->getBarycentricProjection()->isValid())
+                {
+                    pointStatus[pointStart[i] + j] = 1;
+                    continue;
+                }
+                bool valid = myItem->getBarycentricProjection()->unprojectToSurface(curAdjust, coord, 0.0f, true);//should really be "from" surface - "true" makes it not use the signed distance above surface, if present
+                if (!valid)
+                {
+                    pointStatus[pointStart[i] + j] = 2;
+                    continue;
+                }
+                int32_t hint = myLocator.locate(coord, lastTriangle);
+                if (hint != -1) lastTriangle = hint;
+                myHelp->barycentricWeights(coord, projections[pointStart[i] + j], hint);
+            }
+        }
+    }
+    for (int i = 0; i < totalPoints; ++i)
+    {
+        if (pointStatus[i] == 1) throw AlgorithmException("input file has a border point without barycentric projection");//because we never want to use van essen projection or straight coords
+        if (pointStatus[i] == 2) throw AlgorithmException("input file has a border point that is invalid for the current sphere");
+    }
     for (int i = 0; i < numBorders; ++i)
     {
         const Border* inputBorder = borderIn->getBorder(i);
@@ -102,13 +151,7 @@ AlgorithmBorderResample::AlgorithmBorderResample(ProgressObject* myProgObj, cons
         for (int j = 0; j < numPoints; ++j)
         {
             CaretPointer<SurfaceProjectedItem> outPoint(new SurfaceProjectedItem());//ditto
-            float coord[3];
-            const SurfaceProjectedItem* myItem = inputBorder->getPoint(j);
-            if (!myItem->getBarycentricProjection()->isValid()) throw AlgorithmException("input file has a border point without barycentric projection");//because we never want to use van essen projection or straight coords
-            bool valid = myItem->getBarycentricProjection()->unprojectToSurface(curAdjust, coord, 0.0f, true);//should really be "from" surface - "true" makes it not use the signed distance above surface, if present
-            if (!valid) throw AlgorithmException("input file has a border point that is invalid for the current sphere");
-            BarycentricInfo myBaryInfo;
-            myHelp->barycentricWeights(coord, myBaryInfo);
+            const BarycentricInfo& myBaryInfo = projections[pointStart[i] + j];
             outPoint->setStructure(inputBorder->getStructure());
             outPoint->getBarycentricProjection()->setTriangleNodes(myBaryInfo.nodes);
             outPoint->getBarycentricProjection()->setTriangleAreas(myBaryInfo.baryWeights);
@@ -87,6 +87,9 @@ OperationParameters* AlgorithmCiftiFindClusters::getParameters()
     OptionalParameter* startOpt = ret->createOptionalParameter(14, "-start", "start labeling clusters from a value other than 1");
     startOpt->addIntegerParameter(1, "startval", "the value to give the first cluster found");
     
+    OptionalParameter* connectOpt = ret->createOptionalParameter(17, "-volume-connectivity", "set which voxels are considered neighbors");
+    connectOpt->addIntegerParameter(1, "neighbors", "6 for shared faces, 18 for shared faces or edges, 26 for shared faces, edges or corners (default 6)");
+    
     ret->setHelpText(
         AString("Outputs a cifti file with nonzero integers for all brainordinates within a large enough cluster, and zeros elsewhere.  ") +
         "The integers denote cluster membership (by default, first cluster found will use value 1, second cluster 2, etc).  " +
@@ -183,9 +186,15 @@ void AlgorithmCiftiFindClusters::useParameters(OperationParameters* myParams, Pr
             throw AlgorithmException("at least one distance cutoff must be positive");
         }
     }
+    OptionalParameter* connectOpt = myParams->getOptionalParameter(17);
+    int volConnectivity = 6;
+    if (connectOpt->m_present)
+    {
+        volConnectivity = (int)connectOpt->getInteger(1);
+    }
     AlgorithmCiftiFindClusters(myProgObj, myCifti, surfThresh, surfSize, volThresh, volSize, myDir, myCiftiOut, lessThan,
                                myLeftSurf, myLeftAreas, myRightSurf, myRightAreas, myCerebSurf, myCerebAreas,
-                               roiCifti, mergedVol, startVal, NULL, surfSizeRatio, volSizeRatio, surfDistCutoff, volDistCutoff);
+                               roiCifti, mergedVol, startVal, NULL, surfSizeRatio, volSizeRatio, surfDistCutoff, volDistCutoff, volConnectivity);
 }
 
 AlgorithmCiftiFindClusters::AlgorithmCiftiFindClusters(ProgressObject* myProgObj, const CiftiFile* myCifti,
@@ -195,13 +204,18 @@ AlgorithmCiftiFindClusters::AlgorithmCiftiFindClusters(ProgressObject* myProgObj
                                                        const SurfaceFile* myRightSurf, const MetricFile* myRightAreas,
                                                        const SurfaceFile* myCerebSurf, const MetricFile* myCerebAreas,
                                                        const CiftiFile* roiCifti, const bool& mergedVol, const int& startVal, int* endVal,
-                                                       const float& surfSizeRatio, const float& volSizeRatio, const float& surfDistCutoff, const float& volDistCutoff) : AbstractAlgorithm(myProgObj)
+                                                       const float& surfSizeRatio, const float& volSizeRatio, const float& surfDistCutoff, const float& volDistCutoff,
+                                                       const int& volConnectivity) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (startVal == 0)
     {
         throw AlgorithmException("0 is not a valid cluster marking start value");
     }
+    if (volConnectivity != 6 && volConnectivity != 18 && volConnectivity != 26)
+    {
+        throw AlgorithmException("volume connectivity must be 6, 18, or 26");
+    }
     const CiftiXML& myXML = myCifti->getCiftiXML();
     if (myXML.getNumberOfDimensions() != 2) throw AlgorithmException("cifti separate only supported on 2D cifti");
     if (myDir >= myXML.getNumberOfDimensions() || myDir < 0) throw AlgorithmException("direction invalid for input cifti");
@@ -297,7 +311,7 @@ AlgorithmCiftiFindClusters::AlgorithmCiftiFindClusters(ProgressObject* myProgObj
             {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
                 AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXMLOld::ALONG_COLUMN, &myRoi, offset, NULL, true);
             }
-            AlgorithmVolumeFindClusters(NULL, &myVol, volThresh, volSize, &myVolOut, lessThan, &myRoi, -1, markVal, &markVal, volSizeRatio, volDistCutoff);
+            AlgorithmVolumeFindClusters(NULL, &myVol, volThresh, volSize, &myVolOut, lessThan, &myRoi, -1, markVal, &markVal, volSizeRatio, volDistCutoff, volConnectivity);
             AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, &myVolOut, true);
         }
     } else {
@@ -311,7 +325,7 @@ AlgorithmCiftiFindClusters::AlgorithmCiftiFindClusters(ProgressObject* myProgObj
             {//due to above testing, we know the structure mask is the same, so just overwrite the ROI from the mask
                 AlgorithmCiftiSeparate(NULL, roiCifti, CiftiXML::ALONG_COLUMN, volumeList[whichStruct], &myRoi, offset, NULL, true);
             }
-            AlgorithmVolumeFindClusters(NULL, &myVol, volThresh, volSize, &myVolOut, lessThan, &myRoi, -1, markVal, &markVal, volSizeRatio, volDistCutoff);
+            AlgorithmVolumeFindClusters(NULL, &myVol, volThresh, volSize, &myVolOut, lessThan, &myRoi, -1, markVal, &markVal, volSizeRatio, volDistCutoff, volConnectivity);
             AlgorithmCiftiReplaceStructure(NULL, myCiftiOut, myDir, volumeList[whichStruct], &myVolOut, true);
         }
     }
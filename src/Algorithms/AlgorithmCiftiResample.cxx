@@ -38,6 +38,8 @@
 #include "VolumePaddingHelper.h"
 #include "WarpfieldFile.h"
 
+#include <QTemporaryFile>
+
 #include <algorithm>
 #include <cmath>
 
@@ -109,6 +111,8 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
     OptionalParameter* leftAreaMetricsOpt = leftSpheresOpt->createOptionalParameter(4, "-left-area-metrics", "specify left vertex area metrics to do area correction based on");
     leftAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
     leftAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
+    OptionalParameter* leftOperatorOpt = leftSpheresOpt->createOptionalParameter(5, "-left-operator", "use precomputed left resampling weights instead of computing them");
+    leftOperatorOpt->addStringParameter(1, "operator-file", "a resampling operator made by -create-resample-operator from these spheres");
     
     OptionalParameter* rightSpheresOpt = ret->createOptionalParameter(14, "-right-spheres", "specify spheres for right surface resampling");
     rightSpheresOpt->addSurfaceParameter(1, "current-sphere", "a sphere with the same mesh as the current right surface");
@@ -119,6 +123,8 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
     OptionalParameter* rightAreaMetricsOpt = rightSpheresOpt->createOptionalParameter(4, "-right-area-metrics", "specify right vertex area metrics to do area correction based on");
     rightAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
     rightAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
+    OptionalParameter* rightOperatorOpt = rightSpheresOpt->createOptionalParameter(5, "-right-operator", "use precomputed right resampling weights instead of computing them");
+    rightOperatorOpt->addStringParameter(1, "operator-file", "a resampling operator made by -create-resample-operator from these spheres");
     
     OptionalParameter* cerebSpheresOpt = ret->createOptionalParameter(15, "-cerebellum-spheres", "specify spheres for cerebellum surface resampling");
     cerebSpheresOpt->addSurfaceParameter(1, "current-sphere", "a sphere with the same mesh as the current cerebellum surface");
@@ -129,6 +135,8 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
     OptionalParameter* cerebAreaMetricsOpt = cerebSpheresOpt->createOptionalParameter(4, "-cerebellum-area-metrics", "specify cerebellum vertex area metrics to do area correction based on");
     cerebAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
     cerebAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
+    OptionalParameter* cerebOperatorOpt = cerebSpheresOpt->createOptionalParameter(5, "-cerebellum-operator", "use precomputed cerebellum resampling weights instead of computing them");
+    cerebOperatorOpt->addStringParameter(1, "operator-file", "a resampling operator made by -create-resample-operator from these spheres");
     
     AString myHelpText =
         AString("Resample cifti data to a different brainordinate space.  Use COLUMN for the direction to resample dscalar, dlabel, or dtseries.  ") +
@@ -140,7 +148,9 @@ OperationParameters* AlgorithmCiftiResample::getParameters()
         "Volume components are padded before dilation so that dilation doesn't run into the edge of the component bounding box.  " +
         "If neither -affine nor -warpfield are specified, the identity transform is assumed for the volume data.\n\n" +
         "The recommended resampling methods are ADAP_BARY_AREA and CUBIC (cubic spline), except for label data which should use ADAP_BARY_AREA and ENCLOSING_VOXEL.  " +
-        "Using ADAP_BARY_AREA requires specifying an area option to each used -*-spheres option.\n\n" +
+        "Using ADAP_BARY_AREA requires specifying an area option to each used -*-spheres option, unless its -*-operator option is used.  " +
+        "The -*-operator options read weights made by -create-resample-operator, which must have been given the vertices used by the input cifti file as its -current-roi " +
+        "if the input doesn't use every vertex of that structure.\n\n" +
         "The <volume-method> argument must be one of the following:\n\n" +
         "CUBIC\nENCLOSING_VOXEL\nTRILINEAR\n\n" +
         "The <surface-method> argument must be one of the following:\n\n";
@@ -303,6 +313,8 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
     SurfaceFile* curLeftSphere = NULL, *newLeftSphere = NULL;
     MetricFile* curLeftAreas = NULL, *newLeftAreas = NULL;
     MetricFile curLeftAreasTemp, newLeftAreasTemp;
+    SurfaceResamplingHelper leftOperator;
+    const SurfaceResamplingHelper* leftOperatorPtr = NULL;
     OptionalParameter* leftSpheresOpt = myParams->getOptionalParameter(13);
     if (leftSpheresOpt->m_present)
     {
@@ -333,10 +345,18 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
             curLeftAreas = leftAreaMetricsOpt->getMetric(1);
             newLeftAreas = leftAreaMetricsOpt->getMetric(2);
         }
+        OptionalParameter* leftOperatorOpt = leftSpheresOpt->getOptionalParameter(5);
+        if (leftOperatorOpt->m_present)
+        {
+            leftOperator.readOperator(leftOperatorOpt->getString(1));
+            leftOperatorPtr = &leftOperator;
+        }
     }
     SurfaceFile* curRightSphere = NULL, *newRightSphere = NULL;
     MetricFile* curRightAreas = NULL, *newRightAreas = NULL;
     MetricFile curRightAreasTemp, newRightAreasTemp;
+    SurfaceResamplingHelper rightOperator;
+    const SurfaceResamplingHelper* rightOperatorPtr = NULL;
     OptionalParameter* rightSpheresOpt = myParams->getOptionalParameter(14);
     if (rightSpheresOpt->m_present)
     {
@@ -367,10 +387,18 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
             curRightAreas = rightAreaMetricsOpt->getMetric(1);
             newRightAreas = rightAreaMetricsOpt->getMetric(2);
         }
+        OptionalParameter* rightOperatorOpt = rightSpheresOpt->getOptionalParameter(5);
+        if (rightOperatorOpt->m_present)
+        {
+            rightOperator.readOperator(rightOperatorOpt->getString(1));
+            rightOperatorPtr = &rightOperator;
+        }
     }
     SurfaceFile* curCerebSphere = NULL, *newCerebSphere = NULL;
     MetricFile* curCerebAreas = NULL, *newCerebAreas = NULL;
     MetricFile curCerebAreasTemp, newCerebAreasTemp;
+    SurfaceResamplingHelper cerebOperator;
+    const SurfaceResamplingHelper* cerebOperatorPtr = NULL;
     OptionalParameter* cerebSpheresOpt = myParams->getOptionalParameter(15);
     if (cerebSpheresOpt->m_present)
     {
@@ -401,6 +429,12 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
             curCerebAreas = cerebAreaMetricsOpt->getMetric(1);
             newCerebAreas = cerebAreaMetricsOpt->getMetric(2);
         }
+        OptionalParameter* cerebOperatorOpt = cerebSpheresOpt->getOptionalParameter(5);
+        if (cerebOperatorOpt->m_present)
+        {
+            cerebOperator.readOperator(cerebOperatorOpt->getString(1));
+            cerebOperatorPtr = &cerebOperator;
+        }
     }
     if (warpfieldOpt->m_present)
     {
@@ -408,13 +442,15 @@ void AlgorithmCiftiResample::useParameters(OperationParameters* myParams, Progre
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent,
+                               leftOperatorPtr, rightOperatorPtr, cerebOperatorPtr);
     } else {//rely on AffineFile() being the identity transform for if neither option is specified
         AlgorithmCiftiResample(myProgObj, myCiftiIn, direction, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm, myAffine.getMatrix(),
                                curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                curRightSphere, newRightSphere, curRightAreas, newRightAreas,
                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
-                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent);
+                               volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent,
+                               leftOperatorPtr, rightOperatorPtr, cerebOperatorPtr);
     }
 }
 
@@ -422,7 +458,8 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
                                                            const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                            const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
                                                            const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
-                                                           const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas)
+                                                           const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                                                           const SurfaceResamplingHelper* leftOperator, const SurfaceResamplingHelper* rightOperator, const SurfaceResamplingHelper* cerebOperator)
 {
     if (direction > 1) return make_pair(true, AString("unsupported mapping direction for cifti resample"));
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
@@ -439,6 +476,7 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
         if (!inModels.hasSurfaceData(surfList[i])) return make_pair(true, AString("input cifti missing surface information for structure: " + StructureEnum::toGuiName(surfList[i])));
         const SurfaceFile* curSphere = NULL, *newSphere = NULL;
         const MetricFile* curAreas = NULL, *newAreas = NULL;
+        const SurfaceResamplingHelper* surfOperator = NULL;
         AString structName;
         switch (surfList[i])
         {
@@ -447,6 +485,7 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
                 newSphere = newLeftSphere;
                 curAreas = curLeftAreas;
                 newAreas = newLeftAreas;
+                surfOperator = leftOperator;
                 structName = "left";
                 break;
             case StructureEnum::CORTEX_RIGHT:
@@ -454,6 +493,7 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
                 newSphere = newRightSphere;
                 curAreas = curRightAreas;
                 newAreas = newRightAreas;
+                surfOperator = rightOperator;
                 structName = "right";
                 break;
             case StructureEnum::CEREBELLUM:
@@ -461,6 +501,7 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
                 newSphere = newCerebSphere;
                 curAreas = curCerebAreas;
                 newAreas = newCerebAreas;
+                surfOperator = cerebOperator;
                 structName = "cerebellum";
                 break;
             default:
@@ -472,15 +513,21 @@ pair<bool, AString> AlgorithmCiftiResample::checkForErrors(const CiftiFile* myCi
             if (newSphere == NULL) return make_pair(true, AString("missing " + structName + " new sphere"));
             if (curSphere->getNumberOfNodes() != inModels.getSurfaceNumberOfNodes(surfList[i])) return make_pair(true, AString(structName + " current sphere doesn't match input cifti"));
             if (newSphere->getNumberOfNodes() != outModels.getSurfaceNumberOfNodes(surfList[i])) return make_pair(true, AString(structName + " new sphere doesn't match input cifti"));
-            switch (mySurfMethod)
+            if (surfOperator != NULL)
             {
-                case SurfaceResamplingMethodEnum::ADAP_BARY_AREA:
-                    if (curAreas == NULL || newAreas == NULL) return make_pair(true, AString(structName + " area data is missing"));
-                    if (curAreas->getNumberOfNodes() != curSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " current area data has the wrong number of vertices"));
-                    if (newAreas->getNumberOfNodes() != newSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " new area data has the wrong number of vertices"));
-                    break;
-                default:
-                    break;
+                if (surfOperator->getNumberOfInputNodes() != curSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " resampling operator doesn't match current sphere"));
+                if (surfOperator->getNumberOfOutputNodes() != newSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " resampling operator doesn't match new sphere"));
+            } else {
+                switch (mySurfMethod)
+                {
+                    case SurfaceResamplingMethodEnum::ADAP_BARY_AREA:
+                        if (curAreas == NULL || newAreas == NULL) return make_pair(true, AString(structName + " area data is missing"));
+                        if (curAreas->getNumberOfNodes() != curSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " current area data has the wrong number of vertices"));
+                        if (newAreas->getNumberOfNodes() != newSphere->getNumberOfNodes()) return make_pair(true, AString(structName + " new area data has the wrong number of vertices"));
+                        break;
+                    default:
+                        break;
+                }
             }
         } else {//copying
             if (inModels.getSurfaceNumberOfNodes(surfList[i]) != outModels.getSurfaceNumberOfNodes(surfList[i])) return make_pair(true, AString(structName + " structure requires resampling spheres, does not match template"));
@@ -520,7 +567,8 @@ namespace
                             const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const float& voldilatemm,
                             const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
                             const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
-                            const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas)
+                            const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                            const SurfaceResamplingHelper* leftOperator, const SurfaceResamplingHelper* rightOperator, const SurfaceResamplingHelper* cerebOperator)
     {
         const CiftiXML& myInputXML = myCiftiIn->getCiftiXML(), &myOutXML = myCiftiOut->getCiftiXML();
         bool labelMode = (myInputXML.getMappingType(CiftiXML::ALONG_COLUMN) == CiftiMappingType::LABELS);
@@ -531,6 +579,7 @@ namespace
         {
             const SurfaceFile* curSphere = NULL, *newSphere = NULL;
             const MetricFile* curAreas = NULL, *newAreas = NULL;
+            const SurfaceResamplingHelper* surfOperator = NULL;
             switch (surfList[i])
             {
                 case StructureEnum::CORTEX_LEFT:
@@ -538,18 +587,21 @@ namespace
                     newSphere = newLeftSphere;
                     curAreas = curLeftAreas;
                     newAreas = newLeftAreas;
+                    surfOperator = leftOperator;
                     break;
                 case StructureEnum::CORTEX_RIGHT:
                     curSphere = curRightSphere;
                     newSphere = newRightSphere;
                     curAreas = curRightAreas;
                     newAreas = newRightAreas;
+                    surfOperator = rightOperator;
                     break;
                 case StructureEnum::CEREBELLUM:
                     curSphere = curCerebSphere;
                     newSphere = newCerebSphere;
                     curAreas = curCerebAreas;
                     newAreas = newCerebAreas;
+                    surfOperator = cerebOperator;
                     break;
                 default:
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
@@ -567,18 +619,23 @@ namespace
             myCache.copyMode = false;
             myCache.curSphere = curSphere;
             myCache.newSphere = newSphere;
-            const float* curAreasPtr = NULL, *newAreasPtr = NULL;
-            if (curAreas != NULL && newAreas != NULL)
-            {
-                curAreasPtr = curAreas->getValuePointerForColumn(0);
-                newAreasPtr = newAreas->getValuePointerForColumn(0);
-            }
             vector<float> tempRoi(curSphere->getNumberOfNodes(), 0.0f);
-            for (int j = 0; j < (int)myCache.inSurfMap.size(); ++j)
+            if (surfOperator != NULL)
             {
-                tempRoi[myCache.inSurfMap[j].m_surfaceNode] = 1.0f;
+                myCache.surfResamp = *surfOperator;//shares the weight storage, no copying
+            } else {
+                const float* curAreasPtr = NULL, *newAreasPtr = NULL;
+                if (curAreas != NULL && newAreas != NULL)
+                {
+                    curAreasPtr = curAreas->getValuePointerForColumn(0);
+                    newAreasPtr = newAreas->getValuePointerForColumn(0);
+                }
+                for (int j = 0; j < (int)myCache.inSurfMap.size(); ++j)
+                {
+                    tempRoi[myCache.inSurfMap[j].m_surfaceNode] = 1.0f;
+                }
+                myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data());//resampling is already a helper, so use it as such
             }
-            myCache.surfResamp = SurfaceResamplingHelper(mySurfMethod, curSphere, newSphere, curAreasPtr, newAreasPtr, tempRoi.data());//resampling is already a helper, so use it as such
             tempRoi.resize(newSphere->getNumberOfNodes());
             myCache.surfResamp.getResampleValidROI(tempRoi.data());
             myCache.surfDilateRoi.setNumberOfNodesAndColumns(newSphere->getNumberOfNodes(), 1);
@@ -712,13 +769,15 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
-                                               const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent) : AbstractAlgorithm(myProgObj)
+                                               const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                               const SurfaceResamplingHelper* leftOperator, const SurfaceResamplingHelper* rightOperator, const SurfaceResamplingHelper* cerebOperator) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
                                                 curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                                 curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                                                leftOperator, rightOperator, cerebOperator);
     if (myError.first) throw AlgorithmException(myError.second);
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     CiftiXML myOutXML = myInputXML;
@@ -733,6 +792,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         {
             const SurfaceFile* curSphere = NULL, *newSphere = NULL;
             const MetricFile* curAreas = NULL, *newAreas = NULL;
+            const SurfaceResamplingHelper* surfOperator = NULL;
             switch (surfList[i])
             {
                 case StructureEnum::CORTEX_LEFT:
@@ -740,24 +800,27 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     newSphere = newLeftSphere;
                     curAreas = curLeftAreas;
                     newAreas = newLeftAreas;
+                    surfOperator = leftOperator;
                     break;
                 case StructureEnum::CORTEX_RIGHT:
                     curSphere = curRightSphere;
                     newSphere = newRightSphere;
                     curAreas = curRightAreas;
                     newAreas = newRightAreas;
+                    surfOperator = rightOperator;
                     break;
                 case StructureEnum::CEREBELLUM:
                     curSphere = curCerebSphere;
                     newSphere = newCerebSphere;
                     curAreas = curCerebAreas;
                     newAreas = newCerebAreas;
+                    surfOperator = cerebOperator;
                     break;
                 default:
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfOperator);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
@@ -780,7 +843,8 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                           leftOperator, rightOperator, cerebOperator);
         int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
         vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
         for (int64_t row = 0; row < numRows; ++row)
@@ -836,13 +900,15 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                                                const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
                                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                                const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
-                                               const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent) : AbstractAlgorithm(myProgObj)
+                                               const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                               const SurfaceResamplingHelper* leftOperator, const SurfaceResamplingHelper* rightOperator, const SurfaceResamplingHelper* cerebOperator) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     pair<bool, AString> myError = checkForErrors(myCiftiIn, direction, myTemplate, templateDir, mySurfMethod,
                                                 curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                                                 curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                                                curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                                                leftOperator, rightOperator, cerebOperator);
     if (myError.first) throw AlgorithmException(myError.second);
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     CiftiXML myOutXML = myInputXML;
@@ -856,6 +922,7 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         {
             const SurfaceFile* curSphere = NULL, *newSphere = NULL;
             const MetricFile* curAreas = NULL, *newAreas = NULL;
+            const SurfaceResamplingHelper* surfOperator = NULL;
             switch (surfList[i])
             {
                 case StructureEnum::CORTEX_LEFT:
@@ -863,24 +930,27 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
                     newSphere = newLeftSphere;
                     curAreas = curLeftAreas;
                     newAreas = newLeftAreas;
+                    surfOperator = leftOperator;
                     break;
                 case StructureEnum::CORTEX_RIGHT:
                     curSphere = curRightSphere;
                     newSphere = newRightSphere;
                     curAreas = curRightAreas;
                     newAreas = newRightAreas;
+                    surfOperator = rightOperator;
                     break;
                 case StructureEnum::CEREBELLUM:
                     curSphere = curCerebSphere;
                     newSphere = newCerebSphere;
                     curAreas = curCerebAreas;
                     newAreas = newCerebAreas;
+                    surfOperator = cerebOperator;
                     break;
                 default:
                     throw AlgorithmException("unsupported surface structure: " + StructureEnum::toGuiName(surfList[i]));
                     break;
             }
-            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent);
+            processSurfaceComponent(myCiftiIn, direction, surfList[i], mySurfMethod, myCiftiOut, surfLargest, surfdilatemm, curSphere, newSphere, curAreas, newAreas, surfDilateMethod, surfDilateExponent, surfOperator);
         }
         for (int i = 0; i < (int)volList.size(); ++i)
         {
@@ -903,7 +973,8 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
         setupRowResampling(surfCache, volCache, myCiftiIn, myCiftiOut, mySurfMethod, voldilatemm,
                            curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
                            curRightSphere, newRightSphere, curRightAreas, newRightAreas,
-                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                           leftOperator, rightOperator, cerebOperator);
         int64_t numRows = myInputXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
         vector<float> inRow(myInputXML.getDimensionLength(CiftiXML::ALONG_ROW)), outRow(myOutXML.getDimensionLength(CiftiXML::ALONG_ROW));
         for (int64_t row = 0; row < numRows; ++row)
@@ -950,7 +1021,8 @@ AlgorithmCiftiResample::AlgorithmCiftiResample(ProgressObject* myProgObj, const
 void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                      const MetricFile* curAreas, const MetricFile* newAreas,
-                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent)
+                                                     const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                                     const SurfaceResamplingHelper* surfOperator)
 {
     const CiftiXML& myInputXML = myCiftiIn->getCiftiXML();
     if (myInputXML.getMappingType(1 - direction) == CiftiMappingType::LABELS)
@@ -961,7 +1033,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         LabelFile newLabel, newDilate, *newUse = &newLabel;
         if (curSphere != NULL)
         {
-            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest);
+            AlgorithmLabelResample(NULL, &origLabel, curSphere, newSphere, mySurfMethod, &newLabel, curAreas, newAreas, &origRoi, &resampleROI, surfLargest, surfOperator);
             origLabel.clear();//delete the data we no longer need to keep memory use down
             if (surfdilatemm > 0.0f)
             {
@@ -986,7 +1058,7 @@ void AlgorithmCiftiResample::processSurfaceComponent(const CiftiFile* myCiftiIn,
         MetricFile newMetric, newDilate, resampleROI, *newUse = &newMetric;
         if (curSphere != NULL)
         {
-            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest);
+            AlgorithmMetricResample(NULL, &origMetric, curSphere, newSphere, mySurfMethod, &newMetric, curAreas, newAreas, &origROI, &resampleROI, surfLargest, surfOperator);
             origMetric.clear();//ditto
             if (surfdilatemm > 0.0f)
             {
@@ -1098,3 +1170,214 @@ float AlgorithmCiftiResample::getSubAlgorithmWeight()
     //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
     return 0.0f;
 }
+
+namespace
+{
+    struct StreamingPass
+    {//one direction of the streaming resample, treated as resampling along rows of a (possibly transposed) matrix
+        map<StructureEnum::Enum, ResampleCache> surfCache, volCache;
+        vector<StructureEnum::Enum> surfList, volList;
+        CiftiFile inXMLHolder, outXMLHolder;//never get data, setupRowResampling only needs their XML
+    };
+    
+    void processStreamingRow(StreamingPass& myPass, const vector<float>& inRow, vector<float>& outRow, const VolumeFile::InterpType& myVolMethod,
+                             const bool& surfLargest, const float& voldilatemm, const float& surfdilatemm, const FloatMatrix* affine, const VolumeFile* warpfield,
+                             const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
+                             const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent)
+    {
+        const CiftiXML& myInputXML = myPass.inXMLHolder.getCiftiXML();
+        for (int i = 0; i < (int)myPass.surfList.size(); ++i)
+        {
+            map<StructureEnum::Enum, ResampleCache>::iterator iter = myPass.surfCache.find(myPass.surfList[i]);
+            CaretAssert(iter != myPass.surfCache.end());
+            processRowSurface(iter->second, inRow, outRow, myInputXML, surfdilatemm, surfLargest, 0, 0, surfDilateMethod, surfDilateExponent);//no label data, both dimensions are brain models
+        }
+        for (int i = 0; i < (int)myPass.volList.size(); ++i)
+        {
+            map<StructureEnum::Enum, ResampleCache>::iterator iter = myPass.volCache.find(myPass.volList[i]);
+            CaretAssert(iter != myPass.volCache.end());
+            ResampleCache& myCache = iter->second;
+            int inMapSize = (int)myCache.inVolMap.size(), outMapSize = (int)myCache.outVolMap.size();
+            for (int j = 0; j < inMapSize; ++j)
+            {
+                myCache.tempVol1->setValue(inRow[myCache.inVolMap[j].m_ciftiIndex], myCache.inVolMap[j].m_ijk[0] - myCache.inOffset[0],
+                                           myCache.inVolMap[j].m_ijk[1] - myCache.inOffset[1],
+                                           myCache.inVolMap[j].m_ijk[2] - myCache.inOffset[2]);
+            }
+            const VolumeFile* toResample = myCache.tempVol1;
+            if (voldilatemm > 0.0f)
+            {
+                myCache.volPadding.doPadding(myCache.tempVol1, myCache.tempVol2);
+                AlgorithmVolumeDilate(NULL, myCache.tempVol2, voldilatemm, volDilateMethod, myCache.tempVol3, myCache.volDilateRoi, NULL, -1, volDilateExponent);
+                toResample = myCache.tempVol3;
+            }
+            if (warpfield != NULL)
+            {
+                AlgorithmVolumeWarpfieldResample(NULL, toResample, warpfield, myCache.refDims, myCache.refSform, myVolMethod, myCache.tempVol2);
+            } else {
+                CaretAssert(affine != NULL);
+                AlgorithmVolumeAffineResample(NULL, toResample, *affine, myCache.refDims, myCache.refSform, myVolMethod, myCache.tempVol2);
+            }
+            for (int j = 0; j < outMapSize; ++j)
+            {
+                outRow[myCache.outVolMap[j].m_ciftiIndex] = myCache.tempVol2->getValue(myCache.outVolMap[j].m_ijk[0] - myCache.refOffset[0],
+                                                                                       myCache.outVolMap[j].m_ijk[1] - myCache.refOffset[1],
+                                                                                       myCache.outVolMap[j].m_ijk[2] - myCache.refOffset[2]);
+            }
+        }
+    }
+    
+    void tempFileWrite(QTemporaryFile& myFile, const int64_t& floatOffset, const float* data, const int64_t& count)
+    {
+        const qint64 numBytes = count * sizeof(float);
+        if (!myFile.seek(floatOffset * sizeof(float)) || myFile.write((const char*)data, numBytes) != numBytes)
+        {
+            throw AlgorithmException("failed to write temporary file '" + myFile.fileName() + "', check the free space in the temporary directory");
+        }
+    }
+    
+    void tempFileRead(QTemporaryFile& myFile, const int64_t& floatOffset, float* data, const int64_t& count)
+    {
+        const qint64 numBytes = count * sizeof(float);
+        if (!myFile.seek(floatOffset * sizeof(float)) || myFile.read((char*)data, numBytes) != numBytes)
+        {
+            throw AlgorithmException("failed to read temporary file '" + myFile.fileName() + "'");
+        }
+    }
+}
+
+void AlgorithmCiftiResample::resampleBothStreaming(const CiftiFile* myCiftiIn, const CiftiFile* myTemplate, const int& templateDir,
+                                                   const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const VolumeFile::InterpType& myVolMethod, CiftiFile* myCiftiOut,
+                                                   const bool& surfLargest, const float& voldilatemm, const float& surfdilatemm,
+                                                   const FloatMatrix* affine, const VolumeFile* warpfield,
+                                                   const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
+                                                   const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
+                                                   const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                                                   const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
+                                                   const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                                   const int64_t& memLimitBytes, const AString& tempDir)
+{
+    if ((affine == NULL) == (warpfield == NULL)) throw AlgorithmException("exactly one of affine or warpfield must be given to streaming resample");
+    const CiftiXML& inXML = myCiftiIn->getCiftiXML();
+    if (inXML.getNumberOfDimensions() != 2 ||
+        inXML.getMappingType(CiftiXML::ALONG_ROW) != CiftiMappingType::BRAIN_MODELS ||
+        inXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS)
+    {
+        throw AlgorithmException("streaming resample requires a 2D cifti file with brain models along both dimensions");
+    }
+    for (int dir = 0; dir < 2; ++dir)
+    {
+        pair<bool, AString> myError = checkForErrors(myCiftiIn, dir, myTemplate, templateDir, mySurfMethod,
+                                                     curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
+                                                     curRightSphere, newRightSphere, curRightAreas, newRightAreas,
+                                                     curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas);
+        if (myError.first) throw AlgorithmException(myError.second);
+    }
+    const CiftiMappingType& templateMap = *(myTemplate->getCiftiXML().getMap(templateDir));
+    //pass 1 resamples rows of the input into a temporary file stored as column blocks
+    //pass 2 resamples each column of a block, treating the transposed block as rows, into another blocked temporary file
+    //pass 3 reassembles output rows from the blocks
+    StreamingPass rowPass, colPass;
+    CiftiXML midXML = inXML;
+    midXML.setMap(CiftiXML::ALONG_ROW, templateMap);
+    CiftiXML outXML = midXML;
+    outXML.setMap(CiftiXML::ALONG_COLUMN, templateMap);
+    rowPass.inXMLHolder.setCiftiXML(inXML);
+    rowPass.outXMLHolder.setCiftiXML(midXML);
+    CiftiXML colInXML;//transposed intermediate
+    colInXML.setNumberOfDimensions(2);
+    colInXML.setMap(CiftiXML::ALONG_ROW, *(inXML.getMap(CiftiXML::ALONG_COLUMN)));
+    colInXML.setMap(CiftiXML::ALONG_COLUMN, templateMap);
+    CiftiXML colOutXML = colInXML;//transposed output
+    colOutXML.setMap(CiftiXML::ALONG_ROW, templateMap);
+    colPass.inXMLHolder.setCiftiXML(colInXML);
+    colPass.outXMLHolder.setCiftiXML(colOutXML);
+    StreamingPass* passes[2] = { &rowPass, &colPass };
+    for (int p = 0; p < 2; ++p)
+    {
+        const CiftiBrainModelsMap& outModels = passes[p]->outXMLHolder.getCiftiXML().getBrainModelsMap(CiftiXML::ALONG_ROW);
+        passes[p]->surfList = outModels.getSurfaceStructureList();
+        passes[p]->volList = outModels.getVolumeStructureList();
+        setupRowResampling(passes[p]->surfCache, passes[p]->volCache, &(passes[p]->inXMLHolder), &(passes[p]->outXMLHolder), mySurfMethod, voldilatemm,
+                           curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
+                           curRightSphere, newRightSphere, curRightAreas, newRightAreas,
+                           curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                           NULL, NULL, NULL);
+    }
+    const int64_t inRows = inXML.getDimensionLength(CiftiXML::ALONG_COLUMN), inCols = inXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    const int64_t outRows = outXML.getDimensionLength(CiftiXML::ALONG_COLUMN), outCols = outXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    //a column block must fit before and after resampling, a row group needs its rows plus a copy of one block of them
+    int64_t blockCols = max((int64_t)1, min(outCols, memLimitBytes / ((inRows + outRows) * (int64_t)sizeof(float))));
+    int64_t numBlocks = (outCols + blockCols - 1) / blockCols;
+    int64_t inGroupRows = max((int64_t)1, min(inRows, memLimitBytes / (2 * outCols * (int64_t)sizeof(float))));
+    int64_t outGroupRows = max((int64_t)1, min(outRows, memLimitBytes / (2 * outCols * (int64_t)sizeof(float))));
+    QTemporaryFile midFile(tempDir + "/wb_resample_mid_XXXXXX.tmp"), outTileFile(tempDir + "/wb_resample_out_XXXXXX.tmp");
+    if (!midFile.open() || !outTileFile.open()) throw AlgorithmException("failed to create temporary files in '" + tempDir + "'");
+    vector<float> inRow(inCols), outRow(outCols);
+    vector<float> groupBuf(max(inGroupRows, outGroupRows) * outCols), blockBuf(max(inGroupRows, outGroupRows) * blockCols);
+    for (int64_t rowStart = 0; rowStart < inRows; rowStart += inGroupRows)
+    {
+        int64_t groupSize = min(inGroupRows, inRows - rowStart);
+        for (int64_t r = 0; r < groupSize; ++r)
+        {
+            myCiftiIn->getRow(inRow.data(), rowStart + r);
+            processStreamingRow(rowPass, inRow, outRow, myVolMethod, surfLargest, voldilatemm, surfdilatemm, affine, warpfield,
+                                volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent);
+            copy(outRow.begin(), outRow.end(), groupBuf.begin() + r * outCols);
+        }
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {//block b of the intermediate starts at column (b * blockCols), and is stored as all input rows of that block in row-major order
+            int64_t colStart = b * blockCols, blockWidth = min(blockCols, outCols - colStart);
+            for (int64_t r = 0; r < groupSize; ++r)
+            {
+                copy(groupBuf.begin() + r * outCols + colStart, groupBuf.begin() + r * outCols + colStart + blockWidth, blockBuf.begin() + r * blockWidth);
+            }
+            tempFileWrite(midFile, colStart * inRows + rowStart * blockWidth, blockBuf.data(), groupSize * blockWidth);
+        }
+    }
+    groupBuf = vector<float>();//release memory before allocating the panels
+    blockBuf = vector<float>();
+    {
+        vector<float> inPanel(inRows * blockCols), outPanel(outRows * blockCols), colIn(inRows), colOut(outRows);
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            int64_t colStart = b * blockCols, blockWidth = min(blockCols, outCols - colStart);
+            tempFileRead(midFile, colStart * inRows, inPanel.data(), inRows * blockWidth);//one large sequential read per block
+            for (int64_t c = 0; c < blockWidth; ++c)
+            {
+                for (int64_t r = 0; r < inRows; ++r)
+                {
+                    colIn[r] = inPanel[r * blockWidth + c];
+                }
+                processStreamingRow(colPass, colIn, colOut, myVolMethod, surfLargest, voldilatemm, surfdilatemm, affine, warpfield,
+                                    volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent);
+                for (int64_t r = 0; r < outRows; ++r)
+                {
+                    outPanel[r * blockWidth + c] = colOut[r];
+                }
+            }
+            tempFileWrite(outTileFile, colStart * outRows, outPanel.data(), outRows * blockWidth);
+        }
+    }
+    midFile.remove();//free the disk space early, the output blocks are all that is needed now
+    myCiftiOut->setCiftiXML(outXML);
+    groupBuf.resize(outGroupRows * outCols);
+    blockBuf.resize(outGroupRows * blockCols);
+    for (int64_t rowStart = 0; rowStart < outRows; rowStart += outGroupRows)
+    {
+        int64_t groupSize = min(outGroupRows, outRows - rowStart);
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            int64_t colStart = b * blockCols, blockWidth = min(blockCols, outCols - colStart);
+            tempFileRead(outTileFile, colStart * outRows + rowStart * blockWidth, blockBuf.data(), groupSize * blockWidth);
+            for (int64_t r = 0; r < groupSize; ++r)
+            {
+                copy(blockBuf.begin() + r * blockWidth, blockBuf.begin() + (r + 1) * blockWidth, groupBuf.begin() + r * outCols + colStart);
+            }
+        }
+        for (int64_t r = 0; r < groupSize; ++r)
+        {
+            myCiftiOut->setRow(groupBuf.data() + r * outCols, rowStart + r);
+        }
+    }
+}
@@ -33,12 +33,15 @@
 
 namespace caret {
     
+    class SurfaceResamplingHelper;
+    
     class AlgorithmCiftiResample : public AbstractAlgorithm
     {
         AlgorithmCiftiResample();
         void processSurfaceComponent(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                      CiftiFile* myCiftiOut, const bool& surfLargest, const float& surfdilatemm, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
-                                     const MetricFile* curAreas, const MetricFile* newAreas, const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent);
+                                     const MetricFile* curAreas, const MetricFile* newAreas, const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                     const SurfaceResamplingHelper* surfOperator);
         void processVolumeWarpfield(const CiftiFile* myCiftiIn, const int& direction, const StructureEnum::Enum& myStruct, const VolumeFile::InterpType& myVolMethod,
                                     CiftiFile* myCiftiOut, const float& voldilatemm, const VolumeFile* warpfield,
                                     const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent);
@@ -54,7 +57,9 @@ namespace caret {
                                                        const SurfaceResamplingMethodEnum::Enum& mySurfMethod,
                                                        const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
                                                        const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
-                                                       const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas);
+                                                       const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                                                       const SurfaceResamplingHelper* leftOperator = NULL, const SurfaceResamplingHelper* rightOperator = NULL,
+                                                       const SurfaceResamplingHelper* cerebOperator = NULL);
         
         AlgorithmCiftiResample(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const int& direction, const CiftiFile* myTemplate, const int& templateDir,
                                const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const VolumeFile::InterpType& myVolMethod, CiftiFile* myCiftiOut,
@@ -64,7 +69,9 @@ namespace caret {
                                const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                const AlgorithmVolumeDilate::Method& volDilateMethod = AlgorithmVolumeDilate::WEIGHTED, const float& volDilateExponent = 2.0f,
-                               const AlgorithmMetricDilate::Method& surfDilateMethod = AlgorithmMetricDilate::WEIGHTED, const float& surfDilateExponent = 2.0f);
+                               const AlgorithmMetricDilate::Method& surfDilateMethod = AlgorithmMetricDilate::WEIGHTED, const float& surfDilateExponent = 2.0f,
+                               const SurfaceResamplingHelper* leftOperator = NULL, const SurfaceResamplingHelper* rightOperator = NULL,
+                               const SurfaceResamplingHelper* cerebOperator = NULL);
         
         AlgorithmCiftiResample(ProgressObject* myProgObj, const CiftiFile* myCiftiIn, const int& direction, const CiftiFile* myTemplate, const int& templateDir,
                                const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const VolumeFile::InterpType& myVolMethod, CiftiFile* myCiftiOut,
@@ -74,7 +81,22 @@ namespace caret {
                                const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
                                const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
                                const AlgorithmVolumeDilate::Method& volDilateMethod = AlgorithmVolumeDilate::WEIGHTED, const float& volDilateExponent = 2.0f,
-                               const AlgorithmMetricDilate::Method& surfDilateMethod = AlgorithmMetricDilate::WEIGHTED, const float& surfDilateExponent = 2.0f);
+                               const AlgorithmMetricDilate::Method& surfDilateMethod = AlgorithmMetricDilate::WEIGHTED, const float& surfDilateExponent = 2.0f,
+                               const SurfaceResamplingHelper* leftOperator = NULL, const SurfaceResamplingHelper* rightOperator = NULL,
+                               const SurfaceResamplingHelper* cerebOperator = NULL);
+        
+        ///resample both dimensions of a 2D file with brain models along both, holding only about memLimitBytes of matrix data in memory,
+        ///by going through temporary files in tempDir, specify exactly one of affine or warpfield for the volume components
+        static void resampleBothStreaming(const CiftiFile* myCiftiIn, const CiftiFile* myTemplate, const int& templateDir,
+                                          const SurfaceResamplingMethodEnum::Enum& mySurfMethod, const VolumeFile::InterpType& myVolMethod, CiftiFile* myCiftiOut,
+                                          const bool& surfLargest, const float& voldilatemm, const float& surfdilatemm,
+                                          const FloatMatrix* affine, const VolumeFile* warpfield,
+                                          const SurfaceFile* curLeftSphere, const SurfaceFile* newLeftSphere, const MetricFile* curLeftAreas, const MetricFile* newLeftAreas,
+                                          const SurfaceFile* curRightSphere, const SurfaceFile* newRightSphere, const MetricFile* curRightAreas, const MetricFile* newRightAreas,
+                                          const SurfaceFile* curCerebSphere, const SurfaceFile* newCerebSphere, const MetricFile* curCerebAreas, const MetricFile* newCerebAreas,
+                                          const AlgorithmVolumeDilate::Method& volDilateMethod, const float& volDilateExponent,
+                                          const AlgorithmMetricDilate::Method& surfDilateMethod, const float& surfDilateExponent,
+                                          const int64_t& memLimitBytes, const AString& tempDir);
         
         static OperationParameters* getParameters();
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
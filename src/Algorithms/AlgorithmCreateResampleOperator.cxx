@@ -0,0 +1,180 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmCreateResampleOperator.h"
+#include "AlgorithmException.h"
+
+#include "CaretLogger.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmCreateResampleOperator::getCommandSwitch()
+{
+    return "-create-resample-operator";
+}
+
+AString AlgorithmCreateResampleOperator::getShortDescription()
+{
+    return "PRECOMPUTE SURFACE RESAMPLING WEIGHTS";
+}
+
+OperationParameters* AlgorithmCreateResampleOperator::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addSurfaceParameter(1, "current-sphere", "a sphere surface with the mesh that the data is currently on");
+    
+    ret->addSurfaceParameter(2, "new-sphere", "a sphere surface that is in register with <current-sphere> and has the desired output mesh");
+    
+    ret->addStringParameter(3, "method", "the method name");
+    
+    ret->addStringParameter(4, "operator-out", "output - the filename to write the resampling operator to");//HACK: fake the output formatting, no file object for this
+    
+    OptionalParameter* areaSurfsOpt = ret->createOptionalParameter(5, "-area-surfs", "specify surfaces to do vertex area correction based on");
+    areaSurfsOpt->addSurfaceParameter(1, "current-area", "a relevant anatomical surface with <current-sphere> mesh");
+    areaSurfsOpt->addSurfaceParameter(2, "new-area", "a relevant anatomical surface with <new-sphere> mesh");
+    
+    OptionalParameter* areaMetricsOpt = ret->createOptionalParameter(6, "-area-metrics", "specify vertex area metrics to do area correction based on");
+    areaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for <current-sphere> mesh");
+    areaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for <new-sphere> mesh");
+    
+    OptionalParameter* roiOpt = ret->createOptionalParameter(7, "-current-roi", "use an input roi on the current mesh to exclude non-data vertices");
+    roiOpt->addMetricParameter(1, "roi-metric", "the roi, as a metric file");
+    
+    AString myHelpText =
+        AString("Computes the weights that -metric-resample, -label-resample and -cifti-resample would use for the given spheres and method, and saves them as a sparse matrix.  ") +
+        "Giving this file to the -operator option of those commands skips computing the weights, which is most of the time taken when resampling a small file.  " +
+        "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
+        "The weights depend on the method, area data, and roi, so an operator should only be used to resample data where those would be the same.  " +
+        "In particular, when using an operator with -cifti-resample, the roi must match the vertices the input cifti file uses for that structure, " +
+        "see -cifti-separate with -roi.  " +
+        "Only the vertex counts of the spheres are checked when an operator is applied.\n\n" +
+        "The <method> argument must be one of the following:\n\n";
+    
+    vector<SurfaceResamplingMethodEnum::Enum> allEnums;
+    SurfaceResamplingMethodEnum::getAllEnums(allEnums);
+    for (int i = 0; i < (int)allEnums.size(); ++i)
+    {
+        myHelpText += SurfaceResamplingMethodEnum::toName(allEnums[i]) + "\n";
+    }
+    
+    ret->setHelpText(myHelpText);
+    return ret;
+}
+
+void AlgorithmCreateResampleOperator::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    SurfaceFile* curSphere = myParams->getSurface(1);
+    SurfaceFile* newSphere = myParams->getSurface(2);
+    bool ok = false;
+    SurfaceResamplingMethodEnum::Enum myMethod = SurfaceResamplingMethodEnum::fromName(myParams->getString(3), &ok);
+    if (!ok)
+    {
+        throw AlgorithmException("invalid method name");
+    }
+    AString operatorOutName = myParams->getString(4);
+    MetricFile* curAreas = NULL, *newAreas = NULL;
+    MetricFile curAreasTemp, newAreasTemp;
+    OptionalParameter* areaSurfsOpt = myParams->getOptionalParameter(5);
+    if (areaSurfsOpt->m_present)
+    {
+        switch(myMethod)
+        {
+            case SurfaceResamplingMethodEnum::BARYCENTRIC:
+                CaretLogInfo("This method does not use area correction, -area-surfs is not needed");
+                break;
+            default:
+                break;
+        }
+        vector<float> nodeAreasTemp;
+        SurfaceFile* curAreaSurf = areaSurfsOpt->getSurface(1);
+        SurfaceFile* newAreaSurf = areaSurfsOpt->getSurface(2);
+        curAreaSurf->computeNodeAreas(nodeAreasTemp);
+        curAreasTemp.setNumberOfNodesAndColumns(curAreaSurf->getNumberOfNodes(), 1);
+        curAreasTemp.setValuesForColumn(0, nodeAreasTemp.data());
+        curAreas = &curAreasTemp;
+        newAreaSurf->computeNodeAreas(nodeAreasTemp);
+        newAreasTemp.setNumberOfNodesAndColumns(newAreaSurf->getNumberOfNodes(), 1);
+        newAreasTemp.setValuesForColumn(0, nodeAreasTemp.data());
+        newAreas = &newAreasTemp;
+    }
+    OptionalParameter* areaMetricsOpt = myParams->getOptionalParameter(6);
+    if (areaMetricsOpt->m_present)
+    {
+        if (areaSurfsOpt->m_present)
+        {
+            throw AlgorithmException("only one of -area-surfs and -area-metrics can be specified");
+        }
+        switch(myMethod)
+        {
+            case SurfaceResamplingMethodEnum::BARYCENTRIC:
+                CaretLogInfo("This method does not use area correction, -area-metrics is not needed");
+                break;
+            default:
+                break;
+        }
+        curAreas = areaMetricsOpt->getMetric(1);
+        newAreas = areaMetricsOpt->getMetric(2);
+    }
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(7);
+    MetricFile* currentRoi = NULL;
+    if (roiOpt->m_present)
+    {
+        currentRoi = roiOpt->getMetric(1);
+    }
+    AlgorithmCreateResampleOperator(myProgObj, curSphere, newSphere, myMethod, operatorOutName, curAreas, newAreas, currentRoi);
+}
+
+AlgorithmCreateResampleOperator::AlgorithmCreateResampleOperator(ProgressObject* myProgObj, const SurfaceFile* curSphere, const SurfaceFile* newSphere, const SurfaceResamplingMethodEnum::Enum& myMethod,
+                                                                 const AString& operatorOutName, const MetricFile* curAreas, const MetricFile* newAreas, const MetricFile* currentRoi) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    if (currentRoi != NULL && currentRoi->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("roi metric has different number of nodes than input sphere");
+    const float* curAreaData = NULL, *newAreaData = NULL;
+    switch (myMethod)
+    {
+        case SurfaceResamplingMethodEnum::BARYCENTRIC:
+            break;
+        default:
+            if (curAreas == NULL || newAreas == NULL) throw AlgorithmException("specified method does area correction, but no vertex area data given");
+            if (curSphere->getNumberOfNodes() != curAreas->getNumberOfNodes()) throw AlgorithmException("current vertex area data has different number of nodes than current sphere");
+            if (newSphere->getNumberOfNodes() != newAreas->getNumberOfNodes()) throw AlgorithmException("new vertex area data has different number of nodes than new sphere");
+            curAreaData = curAreas->getValuePointerForColumn(0);
+            newAreaData = newAreas->getValuePointerForColumn(0);
+    }
+    const float* roiCol = NULL;
+    if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
+    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    myHelp.writeOperator(operatorOutName);
+}
+
+float AlgorithmCreateResampleOperator::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmCreateResampleOperator::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
@@ -28,11 +28,108 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <set>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    //first order upwind solution of |grad u| = 1 from the smallest neighbor value along each axis, with possibly different spacing per axis
+    float eikonalUpdate(const float neighVals[3], const float spacing[3])
+    {
+        float vals[3] = { neighVals[0], neighVals[1], neighVals[2] }, spaces[3] = { spacing[0], spacing[1], spacing[2] };
+        for (int i = 1; i < 3; ++i)//insertion sort by neighbor value
+        {
+            for (int j = i; j > 0 && vals[j] < vals[j - 1]; --j)
+            {
+                swap(vals[j], vals[j - 1]);
+                swap(spaces[j], spaces[j - 1]);
+            }
+        }
+        float ret = vals[0] + spaces[0];//one axis
+        double sumWeight = 0.0, sumWeightVal = 0.0, sumWeightVal2 = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (ret <= vals[i]) break;//further axes are all upwind of the solution, so they don't contribute
+            double weight = 1.0 / (spaces[i] * spaces[i]);
+            sumWeight += weight;
+            sumWeightVal += weight * vals[i];
+            sumWeightVal2 += weight * vals[i] * vals[i];
+            if (i == 0) continue;
+            //solve sum(weight * (u - val)^2) = 1 over the axes used so far
+            double discriminant = sumWeightVal * sumWeightVal - sumWeight * (sumWeightVal2 - 1.0);
+            if (discriminant < 0.0) break;
+            ret = (float)((sumWeightVal + sqrt(discriminant)) / sumWeight);
+        }
+        return ret;
+    }
+    
+    //Gauss-Seidel sweeps in all 8 diagonal directions until nothing changes, voxels with (marked & 4) are fixed
+    //every voxel on a plane of constant i + j + k (in sweep order) only depends on the previous plane, so each plane is done in parallel
+    void fastSweepDistances(vector<float>& dist, const CaretArray<int>& marked, const vector<int64_t>& dims, const float spacing[3])
+    {
+        const int64_t jStride = dims[0], kStride = dims[0] * dims[1];
+        const int64_t numPlanes = dims[0] + dims[1] + dims[2] - 2;
+        const float tolerance = 0.0001f * min(min(spacing[0], spacing[1]), spacing[2]);
+        const int MAX_ROUNDS = 10;//first order sweeping normally converges in 2 or 3 rounds for distance functions
+        bool changed = true;
+        for (int round = 0; round < MAX_ROUNDS && changed; ++round)
+        {
+            changed = false;
+#pragma omp CARET_PAR
+            {
+                bool myChanged = false;
+                for (int direction = 0; direction < 8; ++direction)
+                {
+                    const bool flip[3] = { (direction & 1) != 0, (direction & 2) != 0, (direction & 4) != 0 };
+                    for (int64_t plane = 0; plane < numPlanes; ++plane)
+                    {
+                        int64_t kStart = max((int64_t)0, plane - (dims[0] - 1) - (dims[1] - 1)), kEnd = min(dims[2] - 1, plane) + 1;
+#pragma omp CARET_FOR schedule(static)
+                        for (int64_t ks = kStart; ks < kEnd; ++ks)
+                        {
+                            int64_t jStart = max((int64_t)0, plane - ks - (dims[0] - 1)), jEnd = min(dims[1] - 1, plane - ks) + 1;
+                            for (int64_t js = jStart; js < jEnd; ++js)
+                            {
+                                int64_t ijk[3] = { plane - ks - js, js, ks };//in sweep order
+                                for (int axis = 0; axis < 3; ++axis)
+                                {
+                                    if (flip[axis]) ijk[axis] = dims[axis] - 1 - ijk[axis];
+                                }
+                                int64_t index = ijk[0] + jStride * ijk[1] + kStride * ijk[2];
+                                if ((marked[index] & 4) != 0) continue;
+                                const int64_t strides[3] = { 1, jStride, kStride };
+                                float neighVals[3];
+                                for (int axis = 0; axis < 3; ++axis)
+                                {
+                                    neighVals[axis] = numeric_limits<float>::infinity();
+                                    if (ijk[axis] > 0) neighVals[axis] = dist[index - strides[axis]];
+                                    if (ijk[axis] < dims[axis] - 1) neighVals[axis] = min(neighVals[axis], dist[index + strides[axis]]);
+                                }
+                                if (neighVals[0] == numeric_limits<float>::infinity() &&
+                                    neighVals[1] == numeric_limits<float>::infinity() &&
+                                    neighVals[2] == numeric_limits<float>::infinity()) continue;
+                                float newVal = eikonalUpdate(neighVals, spacing);
+                                if (newVal < dist[index])
+                                {
+                                    if (dist[index] - newVal > tolerance) myChanged = true;
+                                    dist[index] = newVal;
+                                }
+                            }
+                        }//implicit barrier, the next plane needs this one finished
+                    }
+                }
+#pragma omp critical
+                {
+                    if (myChanged) changed = true;
+                }
+            }
+        }
+    }
+}
+
 AString AlgorithmCreateSignedDistanceVolume::getCommandSwitch()
 {
     return "-create-signed-distance-volume";
@@ -70,13 +167,21 @@ OperationParameters* AlgorithmCreateSignedDistanceVolume::getParameters()
     OptionalParameter* windingMethodOpt = ret->createOptionalParameter(8, "-winding", "winding method for point inside surface test");
     windingMethodOpt->addStringParameter(1, "method", "name of the method (default EVEN_ODD)");
     
+    ret->createOptionalParameter(10, "-fast-sweep", "use fast sweeping for the approximate region instead of dijkstra's method, and find inside/outside one voxel column at a time");
+    
     ret->setHelpText(
         AString("Computes the signed distance function of the surface.  Exact distance is calculated by finding the closest point on any surface triangle ") +
         "to the center of the voxel.  Approximate distance is calculated starting with these distances, using dijkstra's method with a neighborhood of voxels.  " +
         "Specifying too small of an exact distance may produce unexpected results.  Valid specifiers for winding methods are as follows:\n\n" +
         "EVEN_ODD (default)\nNEGATIVE\nNONZERO\nNORMALS\n\nThe NORMALS method uses the normals of triangles and edges, or the closest triangle hit by a ray from the point.  " +
         "This method may be slightly faster, but is only reliable for a closed surface that does not cross through itself.  All other methods count entry (positive) and " +
-        "exit (negative) crossings of a vertical ray from the point, then counts as inside if the total is odd, negative, or nonzero, respectively."
+        "exit (negative) crossings of a vertical ray from the point, then counts as inside if the total is odd, negative, or nonzero, respectively.\n\n" +
+        "With -fast-sweep, the approximate distance is instead a first order solution of the eikonal equation, computed by sweeping through the volume " +
+        "in alternating directions, which is much faster for large approximate limits (specify an extremely large -approx-limit to fill the entire volume), and " +
+        "-approx-neighborhood is ignored.  The crossings are counted along rays in the direction of the third voxel axis, one ray per column of voxels, " +
+        "so the winding methods give the same result as without -fast-sweep for closed surfaces.  " +
+        "With NORMALS, the exact region uses the normals as usual, but the approximate region is signed by the NONZERO method.  " +
+        "This option requires the voxel axes to be orthogonal."
     );
     return ret;
 }
@@ -144,11 +249,13 @@ void AlgorithmCreateSignedDistanceVolume::useParameters(OperationParameters* myP
     {
         myRoiOut = roiOutOpt->getOutputVolume(1);
     }
-    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding);
+    bool fastSweep = myParams->getOptionalParameter(10)->m_present;
+    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding, fastSweep);
 }
 
 AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(ProgressObject* myProgObj, const SurfaceFile* mySurf, VolumeFile* myVolOut, VolumeFile* myRoiOut, const float& fillValue,
-                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding) : AbstractAlgorithm(myProgObj)
+                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding,
+                                                                         const bool& fastSweep) : AbstractAlgorithm(myProgObj)
 {
     if (exactLim <= 0.0f)
     {
@@ -271,6 +378,7 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
     }
     myProgress.reportProgress(markweight);
     myProgress.setTask("computing exact distances");
+    bool signFromColumns = fastSweep && myWinding != SignedDistanceHelper::NORMALS;//the sign comes later for the whole volume at once
 #pragma omp CARET_PAR
     {
         CaretPointer<SignedDistanceHelper> myDist = mySurf->getSignedDistanceHelper();
@@ -280,13 +388,88 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
         for (int i = 0; i < numExact; i += 3)
         {
             myVolOut->indexToSpace(exactVoxelList.data() + i, thisCoord);
-            myVolOut->setValue(myDist->dist(thisCoord, myWinding), exactVoxelList.data() + i);
+            if (signFromColumns)
+            {
+                myVolOut->setValue(myDist->unsignedDist(thisCoord), exactVoxelList.data() + i);
+            } else {
+                myVolOut->setValue(myDist->dist(thisCoord, myWinding), exactVoxelList.data() + i);
+            }
             volMarked[myVolOut->getIndex(exactVoxelList.data() + i)] |= 22;//set marked to have valid value (positive and negative), and frozen
         }
     }
     myProgress.reportProgress(markweight + exactweight);
-    if (approxLim > exactLim)
+    if (fastSweep)
     {
+        myProgress.setTask("sweeping distances in extended region");
+        vector<float> sweepDist(frameSize, numeric_limits<float>::infinity());
+        int numExact = (int)exactVoxelList.size();
+        for (int i = 0; i < numExact; i += 3)
+        {
+            sweepDist[myVolOut->getIndex(exactVoxelList.data() + i)] = abs(myVolOut->getValue(exactVoxelList.data() + i));
+        }
+        if (approxLim > exactLim)
+        {
+            float orthTol = 0.0001f;
+            if (abs(ivec.dot(jvec)) > orthTol * ivec.length() * jvec.length() ||
+                abs(ivec.dot(kvec)) > orthTol * ivec.length() * kvec.length() ||
+                abs(jvec.dot(kvec)) > orthTol * jvec.length() * kvec.length())
+            {
+                throw AlgorithmException("-fast-sweep requires a volume space with orthogonal voxel axes");
+            }
+            float spacing[3] = { ivec.length(), jvec.length(), kvec.length() };
+            fastSweepDistances(sweepDist, volMarked, myDims, spacing);
+        }
+        myProgress.reportProgress(markweight + exactweight + approxweight * 0.5f);
+        myProgress.setTask("finding inside and outside");
+        SignedDistanceHelper::WindingLogic columnWinding = myWinding;
+        if (columnWinding == SignedDistanceHelper::NORMALS) columnWinding = SignedDistanceHelper::NONZERO;
+        int64_t numColumns = myDims[0] * myDims[1];
+#pragma omp CARET_PAR
+        {
+            CaretPointer<SignedDistanceHelper> myDist = mySurf->getSignedDistanceHelper();
+            vector<pair<float, int> > crossings;
+#pragma omp CARET_FOR schedule(dynamic)
+            for (int64_t column = 0; column < numColumns; ++column)
+            {
+                int64_t colijk[3] = { column % myDims[0], column / myDims[0], 0 };
+                bool needed = false;
+                for (colijk[2] = 0; colijk[2] < myDims[2]; ++colijk[2])
+                {
+                    int64_t index = myVolOut->getIndex(colijk);
+                    if ((volMarked[index] & 4) != 0 ? signFromColumns : sweepDist[index] <= approxLim)
+                    {
+                        needed = true;
+                        break;
+                    }
+                }
+                if (!needed) continue;
+                Vector3D start;
+                colijk[2] = 0;
+                myVolOut->indexToSpace(colijk, start);
+                myDist->rayCrossings(start, kvec, crossings);//distance along the ray is in units of kvec, so it compares directly to the k index
+                int crossCount = 0, nextCrossing = (int)crossings.size() - 1;
+                for (colijk[2] = myDims[2] - 1; colijk[2] >= 0; --colijk[2])
+                {
+                    while (nextCrossing >= 0 && crossings[nextCrossing].first > colijk[2])
+                    {
+                        crossCount += crossings[nextCrossing].second;
+                        --nextCrossing;
+                    }
+                    int64_t index = myVolOut->getIndex(colijk);
+                    if ((volMarked[index] & 4) != 0)
+                    {
+                        if (signFromColumns)
+                        {
+                            myVolOut->setValue(sweepDist[index] * SignedDistanceHelper::windingSign(crossCount, columnWinding), colijk);
+                        }
+                    } else if (sweepDist[index] <= approxLim) {
+                        myVolOut->setValue(sweepDist[index] * SignedDistanceHelper::windingSign(crossCount, columnWinding), colijk);
+                        volMarked[index] |= 4;//now has a valid value, for the roi
+                    }
+                }
+            }
+        }
+    } else if (approxLim > exactLim) {
         myProgress.setTask("approximating distances in extended region");
         int faceNeigh[] = { 1, 0, 0, 
                             -1, 0, 0,
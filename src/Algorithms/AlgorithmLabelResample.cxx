@@ -70,9 +70,14 @@ OperationParameters* AlgorithmLabelResample::getParameters()
     
     ret->createOptionalParameter(10, "-largest", "use only the label of the vertex with the largest weight");
     
+    OptionalParameter* operatorOpt = ret->createOptionalParameter(11, "-operator", "use precomputed resampling weights");
+    operatorOpt->addStringParameter(1, "operator-file", "a resampling operator made by -create-resample-operator from these spheres");
+    
     AString myHelpText =
         AString("Resamples a label file, given two spherical surfaces that are in register.  ") +
-        "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
+        "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.  " +
+        "When -operator is specified, the weights are read from the operator file instead, the <method>, area and -current-roi options are not used, " +
+        "and the spheres are only used to check the vertex counts.\n\n" +
         "The ADAP_BARY_AREA method is recommended for label data, because it should be better at resolving vertices that are near multiple labels, or in case of downsampling.  " +
         "Midthickness surfaces are recommended for the vertex areas for most data.\n\n" +
         "The -largest option results in nearest vertex behavior when used with BARYCENTRIC, as it uses the value of the source vertex that has the largest weight.\n\n" +
@@ -157,42 +162,64 @@ void AlgorithmLabelResample::useParameters(OperationParameters* myParams, Progre
         validRoiOut = validRoiOutOpt->getOutputMetric(1);
     }
     bool largest = myParams->getOptionalParameter(10)->m_present;
-    AlgorithmLabelResample(myProgObj, labelIn, curSphere, newSphere, myMethod, labelOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    OptionalParameter* operatorOpt = myParams->getOptionalParameter(11);
+    if (operatorOpt->m_present)
+    {
+        if (areaSurfsOpt->m_present || areaMetricsOpt->m_present || roiOpt->m_present)
+        {
+            throw AlgorithmException("-operator already contains area correction and roi, do not specify -area-surfs, -area-metrics, or -current-roi with it");
+        }
+        SurfaceResamplingHelper myOperator;
+        myOperator.readOperator(operatorOpt->getString(1));
+        AlgorithmLabelResample(myProgObj, labelIn, curSphere, newSphere, myMethod, labelOut, NULL, NULL, NULL, validRoiOut, largest, &myOperator);
+    } else {
+        AlgorithmLabelResample(myProgObj, labelIn, curSphere, newSphere, myMethod, labelOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    }
 }
 
 AlgorithmLabelResample::AlgorithmLabelResample(ProgressObject* myProgObj, const LabelFile* labelIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                const SurfaceResamplingMethodEnum::Enum& myMethod, LabelFile* labelOut, const MetricFile* curAreas,
-                                               const MetricFile* newAreas, const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest) : AbstractAlgorithm(myProgObj)
+                                               const MetricFile* newAreas, const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest,
+                                               const SurfaceResamplingHelper* precomputed) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (labelIn->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("input label file has different number of nodes than input sphere");
-    const float* curAreaData = NULL, *newAreaData = NULL;
-    switch (myMethod)
-    {
-        case SurfaceResamplingMethodEnum::BARYCENTRIC:
-            break;
-        default:
-            if (curAreas == NULL || newAreas == NULL) throw AlgorithmException("specified method does area correction, but no vertex area data given");
-            if (curSphere->getNumberOfNodes() != curAreas->getNumberOfNodes()) throw AlgorithmException("current vertex area data has different number of nodes than current sphere");
-            if (newSphere->getNumberOfNodes() != newAreas->getNumberOfNodes()) throw AlgorithmException("new vertex area data has different number of nodes than new sphere");
-            curAreaData = curAreas->getValuePointerForColumn(0);
-            newAreaData = newAreas->getValuePointerForColumn(0);
-    }
     int numColumns = labelIn->getNumberOfColumns(), numNewNodes = newSphere->getNumberOfNodes();
     labelOut->setNumberOfNodesAndColumns(numNewNodes, numColumns);
     labelOut->setStructure(labelIn->getStructure());
     *labelOut->getLabelTable() = *labelIn->getLabelTable();
     int32_t unusedLabel = labelIn->getLabelTable()->getUnassignedLabelKey();
     vector<int32_t> colScratch(numNewNodes, unusedLabel);
-    const float* roiCol = NULL;
-    if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
-    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    SurfaceResamplingHelper myHelpStorage;
+    const SurfaceResamplingHelper* myHelp = precomputed;
+    if (myHelp == NULL)
+    {
+        const float* curAreaData = NULL, *newAreaData = NULL;
+        switch (myMethod)
+        {
+            case SurfaceResamplingMethodEnum::BARYCENTRIC:
+                break;
+            default:
+                if (curAreas == NULL || newAreas == NULL) throw AlgorithmException("specified method does area correction, but no vertex area data given");
+                if (curSphere->getNumberOfNodes() != curAreas->getNumberOfNodes()) throw AlgorithmException("current vertex area data has different number of nodes than current sphere");
+                if (newSphere->getNumberOfNodes() != newAreas->getNumberOfNodes()) throw AlgorithmException("new vertex area data has different number of nodes than new sphere");
+                curAreaData = curAreas->getValuePointerForColumn(0);
+                newAreaData = newAreas->getValuePointerForColumn(0);
+        }
+        const float* roiCol = NULL;
+        if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
+        myHelpStorage = SurfaceResamplingHelper(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+        myHelp = &myHelpStorage;
+    } else {
+        if (myHelp->getNumberOfInputNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("resampling operator has different number of input vertices than current sphere");
+        if (myHelp->getNumberOfOutputNodes() != newSphere->getNumberOfNodes()) throw AlgorithmException("resampling operator has different number of output vertices than new sphere");
+    }
     if (validRoiOut != NULL)
     {
         validRoiOut->setNumberOfNodesAndColumns(numNewNodes, 1);
         validRoiOut->setStructure(labelIn->getStructure());
         vector<float> scratch(numNewNodes);
-        myHelp.getResampleValidROI(scratch.data());
+        myHelp->getResampleValidROI(scratch.data());
         validRoiOut->setValuesForColumn(0, scratch.data());
     }
     for (int i = 0; i < numColumns; ++i)
@@ -200,9 +227,9 @@ AlgorithmLabelResample::AlgorithmLabelResample(ProgressObject* myProgObj, const
         labelOut->setColumnName(i, labelIn->getColumnName(i));
         if (largest)
         {
-            myHelp.resampleLargest(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
+            myHelp->resampleLargest(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
         } else {
-            myHelp.resamplePopular(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
+            myHelp->resamplePopular(labelIn->getLabelKeyPointerForColumn(i), colScratch.data(), unusedLabel);
         }
         labelOut->setLabelKeysForColumn(i, colScratch.data());
     }
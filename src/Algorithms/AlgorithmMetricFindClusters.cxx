@@ -22,11 +22,14 @@
 #include "AlgorithmException.h"
 
 #include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "ConnectedComponentHelper.h"
 #include "GeodesicHelper.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
@@ -152,12 +155,23 @@ namespace
         double area;
     };
     
-    void processColumn(const float* data, const float* roiData, const float* nodeAreas, TopologyHelper* myTopoHelp, GeodesicHelper* myGeoHelp,
-                       const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
-                       float* outData, int& markVal)
+    struct SurfaceNeighbors
+    {
+        const TopologyHelper* m_helper;
+        SurfaceNeighbors(const TopologyHelper* myHelper) : m_helper(myHelper) { }
+        void operator()(const int64_t& node, vector<int64_t>& neighOut) const
+        {
+            const vector<int32_t>& neighbors = m_helper->getNodeNeighbors(node);
+            neighOut.assign(neighbors.begin(), neighbors.end());
+        }
+    };
+    
+    void findClusters(const float* data, const float* roiData, const float* nodeAreas, TopologyHelper* myTopoHelp, GeodesicHelper* myGeoHelp,
+                      const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
+                      vector<Cluster>& clusters, const bool& parallel)
     {
         int numNodes = myTopoHelp->getNumberOfNodes();
-        vector<int> marked(numNodes, 0);
+        vector<char> marked(numNodes, 0);
         if (lessThan)
         {
             for (int i = 0; i < numNodes; ++i)
@@ -176,41 +190,34 @@ namespace
                 }
             }
         }
-        vector<Cluster> clusters;
+        vector<int64_t> clusterIndices;
+        SurfaceNeighbors myNeighbors(myTopoHelp);
+        int64_t numFound = ConnectedComponentHelper::labelComponents(numNodes, marked.data(), myNeighbors, clusterIndices, parallel);
+        vector<Cluster> found(numFound);//found in the same order as flood filling from each unvisited vertex in order, so the output labels don't change
+        for (int i = 0; i < numNodes; ++i)
+        {
+            if (clusterIndices[i] != -1)
+            {
+                Cluster& thisCluster = found[clusterIndices[i]];
+                thisCluster.members.push_back(i);
+                thisCluster.area += nodeAreas[i];
+            }
+        }
+        clusters.clear();
         float biggestSize = 0.0f;
         int biggestCluster = -1;
-        for (int i = 0; i < numNodes; ++i)
+        for (int64_t i = 0; i < numFound; ++i)
         {
-            if (marked[i])
+            if (found[i].area > minArea)
             {
-                Cluster newCluster;
-                newCluster.members.push_back(i);
-                marked[i] = 0;//unmark it when added to list to prevent multiples
-                for (int index = 0; index < (int)newCluster.members.size(); ++index)//NOTE: vector grows inside loop
-                {
-                    int node = newCluster.members[index];//keep list around so we can put it into the output immediately if it is large enough
-                    newCluster.area += nodeAreas[node];
-                    const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(node);
-                    int numNeigh = (int)neighbors.size();
-                    for (int n = 0; n < numNeigh; ++n)
-                    {
-                        const int32_t& neighbor = neighbors[n];
-                        if (marked[neighbor])
-                        {
-                            newCluster.members.push_back(neighbor);
-                            marked[neighbor] = 0;
-                        }
-                    }
-                }
-                if (newCluster.area > minArea)
+                if (found[i].area > biggestSize)
                 {
-                    if (newCluster.area > biggestSize)
-                    {
-                        biggestSize = newCluster.area;
-                        biggestCluster = (int)clusters.size();
-                    }
-                    clusters.push_back(newCluster);
+                    biggestSize = found[i].area;
+                    biggestCluster = (int)clusters.size();
                 }
+                clusters.push_back(Cluster());
+                clusters.back().members.swap(found[i].members);
+                clusters.back().area = found[i].area;
             }
         }
         vector<int32_t> pathScratch;
@@ -248,6 +255,10 @@ namespace
                 }
             }
         }
+    }
+    
+    void markClusters(const vector<Cluster>& clusters, float* outData, int& markVal)
+    {
         for (size_t i = 0; i < clusters.size(); ++i)
         {
             if (markVal == 0)
@@ -315,19 +326,48 @@ AlgorithmMetricFindClusters::AlgorithmMetricFindClusters(ProgressObject* myProgO
             myGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
         }
     }
-    vector<int> toSearch;
     int markVal = startVal;//give each cluster a different value, including across maps
     if (columnNum == -1)
     {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, numCols);
         myMetricOut->setStructure(mySurf->getStructure());
-        for (int c = 0; c < numCols; ++c)
+        int batchSize = 1;//do several columns concurrently, but limit how many columns of cluster lists are held at once
+#ifdef CARET_OMP
+        batchSize = omp_get_max_threads();
+#endif
+        bool parallelCols = (numCols > 1 && batchSize > 1);//when there are multiple columns, do them concurrently, and do each column's labeling serially
+        vector<float> outData(numNodes);
+        for (int batchStart = 0; batchStart < numCols; batchStart += batchSize)
         {
-            myMetricOut->setColumnName(c, myMetric->getColumnName(c));
-            vector<float> outData(numNodes, 0.0f);
-            const float* data = myMetric->getValuePointerForColumn(c);
-            processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
-            myMetricOut->setValuesForColumn(c, outData.data());
+            int batchEnd = min(batchStart + batchSize, numCols);
+            vector<vector<Cluster> > colClusters(batchEnd - batchStart);
+#pragma omp CARET_PAR if(parallelCols)
+            {
+                CaretPointer<TopologyHelper> threadTopoHelp = mySurf->getTopologyHelper();
+                CaretPointer<GeodesicHelper> threadGeoHelp;
+                if (distanceCutoff > 0.0f)
+                {
+                    if (myAreas == NULL)
+                    {
+                        threadGeoHelp = mySurf->getGeodesicHelper();
+                    } else {
+                        threadGeoHelp.grabNew(new GeodesicHelper(myGeoBase));
+                    }
+                }
+#pragma omp CARET_FOR schedule(dynamic)
+                for (int c = batchStart; c < batchEnd; ++c)
+                {
+                    const float* data = myMetric->getValuePointerForColumn(c);
+                    findClusters(data, roiData, nodeAreas, threadTopoHelp, threadGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, colClusters[c - batchStart], !parallelCols);
+                }
+            }
+            for (int c = batchStart; c < batchEnd; ++c)//cluster values are assigned in column order, so they don't depend on the number of threads
+            {
+                myMetricOut->setColumnName(c, myMetric->getColumnName(c));
+                outData.assign(numNodes, 0.0f);
+                markClusters(colClusters[c - batchStart], outData.data(), markVal);
+                myMetricOut->setValuesForColumn(c, outData.data());
+            }
         }
     } else {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
@@ -335,7 +375,9 @@ AlgorithmMetricFindClusters::AlgorithmMetricFindClusters(ProgressObject* myProgO
         myMetricOut->setColumnName(0, myMetric->getColumnName(columnNum));
         vector<float> outData(numNodes, 0.0f);
         const float* data = myMetric->getValuePointerForColumn(columnNum);
-        processColumn(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, outData.data(), markVal);
+        vector<Cluster> clusters;
+        findClusters(data, roiData, nodeAreas, myTopoHelp, myGeoHelp, threshVal, minArea, lessThan, areaRatio, distanceCutoff, clusters, true);
+        markClusters(clusters, outData.data(), markVal);
         myMetricOut->setValuesForColumn(0, outData.data());
     }
     if (endVal != NULL) *endVal = markVal;
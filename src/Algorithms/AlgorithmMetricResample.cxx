@@ -27,6 +27,8 @@
 #include "SurfaceFile.h"
 #include "SurfaceResamplingHelper.h"
 
+#include <algorithm>
+
 using namespace caret;
 using namespace std;
 
@@ -69,9 +71,14 @@ OperationParameters* AlgorithmMetricResample::getParameters()
     
     ret->createOptionalParameter(10, "-largest", "use only the value of the vertex with the largest weight");
     
+    OptionalParameter* operatorOpt = ret->createOptionalParameter(11, "-operator", "use precomputed resampling weights");
+    operatorOpt->addStringParameter(1, "operator-file", "a resampling operator made by -create-resample-operator from these spheres");
+    
     AString myHelpText =
         AString("Resamples a metric file, given two spherical surfaces that are in register.  ") +
-        "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.\n\n" +
+        "If ADAP_BARY_AREA is used, exactly one of -area-surfs or -area-metrics must be specified.  " +
+        "When -operator is specified, the weights are read from the operator file instead, the <method>, area and -current-roi options are not used, " +
+        "and the spheres are only used to check the vertex counts.\n\n" +
         "The ADAP_BARY_AREA method is recommended for ordinary metric data, because it should use all data while downsampling, unlike BARYCENTRIC.  " +
         "The recommended areas option for most data is individual midthicknesses for individual data, and averaged vertex area metrics from individual midthicknesses for group average data.\n\n"
         "The -current-roi option only masks the input, the output may be slightly dilated in comparison, consider using -metric-mask on the output " +
@@ -159,54 +166,99 @@ void AlgorithmMetricResample::useParameters(OperationParameters* myParams, Progr
         validRoiOut = validRoiOutOpt->getOutputMetric(1);
     }
     bool largest = myParams->getOptionalParameter(10)->m_present;
-    AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    OptionalParameter* operatorOpt = myParams->getOptionalParameter(11);
+    if (operatorOpt->m_present)
+    {
+        if (areaSurfsOpt->m_present || areaMetricsOpt->m_present || roiOpt->m_present)
+        {
+            throw AlgorithmException("-operator already contains area correction and roi, do not specify -area-surfs, -area-metrics, or -current-roi with it");
+        }
+        SurfaceResamplingHelper myOperator;
+        myOperator.readOperator(operatorOpt->getString(1));
+        AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, NULL, NULL, NULL, validRoiOut, largest, &myOperator);
+    } else {
+        AlgorithmMetricResample(myProgObj, metricIn, curSphere, newSphere, myMethod, metricOut, curAreas, newAreas, currentRoi, validRoiOut, largest);
+    }
 }
 
 AlgorithmMetricResample::AlgorithmMetricResample(ProgressObject* myProgObj, const MetricFile* metricIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere,
                                                  const SurfaceResamplingMethodEnum::Enum& myMethod, MetricFile* metricOut, const MetricFile* curAreas, const MetricFile* newAreas,
-                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest) : AbstractAlgorithm(myProgObj)
+                                                 const MetricFile* currentRoi, MetricFile* validRoiOut, const bool& largest,
+                                                 const SurfaceResamplingHelper* precomputed) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (metricIn->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("input metric has different number of nodes than input sphere");
     if (currentRoi != NULL && currentRoi->getNumberOfNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("roi metric has different number of nodes than input sphere");
-    const float* curAreaData = NULL, *newAreaData = NULL;
-    switch (myMethod)
-    {
-        case SurfaceResamplingMethodEnum::BARYCENTRIC:
-            break;
-        default:
-            if (curAreas == NULL || newAreas == NULL) throw AlgorithmException("specified method does area correction, but no vertex area data given");
-            if (curSphere->getNumberOfNodes() != curAreas->getNumberOfNodes()) throw AlgorithmException("current vertex area data has different number of nodes than current sphere");
-            if (newSphere->getNumberOfNodes() != newAreas->getNumberOfNodes()) throw AlgorithmException("new vertex area data has different number of nodes than new sphere");
-            curAreaData = curAreas->getValuePointerForColumn(0);
-            newAreaData = newAreas->getValuePointerForColumn(0);
-    }
     int numColumns = metricIn->getNumberOfColumns(), numNewNodes = newSphere->getNumberOfNodes();
     metricOut->setNumberOfNodesAndColumns(numNewNodes, numColumns);
     metricOut->setStructure(metricIn->getStructure());
     vector<float> colScratch(numNewNodes, 0.0f);
-    const float* roiCol = NULL;
-    if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
-    SurfaceResamplingHelper myHelp(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+    SurfaceResamplingHelper myHelpStorage;
+    const SurfaceResamplingHelper* myHelp = precomputed;
+    if (myHelp == NULL)
+    {
+        const float* curAreaData = NULL, *newAreaData = NULL;
+        switch (myMethod)
+        {
+            case SurfaceResamplingMethodEnum::BARYCENTRIC:
+                break;
+            default:
+                if (curAreas == NULL || newAreas == NULL) throw AlgorithmException("specified method does area correction, but no vertex area data given");
+                if (curSphere->getNumberOfNodes() != curAreas->getNumberOfNodes()) throw AlgorithmException("current vertex area data has different number of nodes than current sphere");
+                if (newSphere->getNumberOfNodes() != newAreas->getNumberOfNodes()) throw AlgorithmException("new vertex area data has different number of nodes than new sphere");
+                curAreaData = curAreas->getValuePointerForColumn(0);
+                newAreaData = newAreas->getValuePointerForColumn(0);
+        }
+        const float* roiCol = NULL;
+        if (currentRoi != NULL) roiCol = currentRoi->getValuePointerForColumn(0);
+        myHelpStorage = SurfaceResamplingHelper(myMethod, curSphere, newSphere, curAreaData, newAreaData, roiCol);
+        myHelp = &myHelpStorage;
+    } else {
+        if (myHelp->getNumberOfInputNodes() != curSphere->getNumberOfNodes()) throw AlgorithmException("resampling operator has different number of input vertices than current sphere");
+        if (myHelp->getNumberOfOutputNodes() != newSphere->getNumberOfNodes()) throw AlgorithmException("resampling operator has different number of output vertices than new sphere");
+    }
     if (validRoiOut != NULL)
     {
         validRoiOut->setNumberOfNodesAndColumns(numNewNodes, 1);
         validRoiOut->setStructure(metricIn->getStructure());
         vector<float> scratch(numNewNodes);
-        myHelp.getResampleValidROI(scratch.data());
+        myHelp->getResampleValidROI(scratch.data());
         validRoiOut->setValuesForColumn(0, scratch.data());
     }
     for (int i = 0; i < numColumns; ++i)
     {
         metricOut->setColumnName(i, metricIn->getColumnName(i));
         *metricOut->getPaletteColorMapping(i) = *metricIn->getPaletteColorMapping(i);
+    }
+    const int BLOCK_COLUMNS = 16;//resample several columns per pass over the weights, interleaved so the inner loop is over columns
+    int numOldNodes = curSphere->getNumberOfNodes();
+    int firstBlockSize = min(BLOCK_COLUMNS, numColumns);
+    vector<float> inBlock((int64_t)numOldNodes * firstBlockSize), outBlock((int64_t)numNewNodes * firstBlockSize);
+    for (int blockStart = 0; blockStart < numColumns; blockStart += BLOCK_COLUMNS)
+    {
+        int blockSize = min(BLOCK_COLUMNS, numColumns - blockStart);
+        for (int c = 0; c < blockSize; ++c)
+        {
+            const float* inCol = metricIn->getValuePointerForColumn(blockStart + c);
+            for (int j = 0; j < numOldNodes; ++j)
+            {
+                inBlock[(int64_t)j * blockSize + c] = inCol[j];
+            }
+        }
         if (largest)
         {
-            myHelp.resampleLargest(metricIn->getValuePointerForColumn(i), colScratch.data());
+            myHelp->resampleLargestBlock(inBlock.data(), outBlock.data(), blockSize);
         } else {
-            myHelp.resampleNormal(metricIn->getValuePointerForColumn(i), colScratch.data());
+            myHelp->resampleNormalBlock(inBlock.data(), outBlock.data(), blockSize);
+        }
+        for (int c = 0; c < blockSize; ++c)
+        {
+            for (int j = 0; j < numNewNodes; ++j)
+            {
+                colScratch[j] = outBlock[(int64_t)j * blockSize + c];
+            }
+            metricOut->setValuesForColumn(blockStart + c, colScratch.data());
         }
-        metricOut->setValuesForColumn(i, colScratch.data());
     }
 }
 
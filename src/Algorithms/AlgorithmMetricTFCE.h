@@ -30,8 +30,7 @@ namespace caret {
     class AlgorithmMetricTFCE : public AbstractAlgorithm
     {
         AlgorithmMetricTFCE();
-        void processColumn(const SurfaceFile* mySurf, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
-        void tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
+        static void tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -42,6 +41,8 @@ namespace caret {
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
         static AString getShortDescription();
+        ///does TFCE on one column, without touching any files, so that callers can reuse the topology helper and areas (for instance, across permutations)
+        static void processColumn(TopologyHelper* myHelper, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
     };
 
     typedef TemplateAutoOperation<AlgorithmMetricTFCE> AutoAlgorithmMetricTFCE;
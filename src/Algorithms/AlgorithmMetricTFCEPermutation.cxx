@@ -0,0 +1,366 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "FileInformation.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmMetricTFCEPermutation::getCommandSwitch()
+{
+    return "-metric-tfce-permutation";
+}
+
+AString AlgorithmMetricTFCEPermutation::getShortDescription()
+{
+    return "PERMUTATION TEST WITH TFCE ON A METRIC FILE";
+}
+
+OperationParameters* AlgorithmMetricTFCEPermutation::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+
+    ret->addSurfaceParameter(1, "surface", "the surface to compute on");
+
+    ret->addMetricParameter(2, "metric-in", "the subject data, one column per subject");
+
+    ret->addMetricOutputParameter(3, "tfce-out", "output - the TFCE enhanced t-statistic of the unpermuted data");
+
+    ret->addMetricOutputParameter(4, "p-out", "output - the FWER-corrected p-values");
+
+    OptionalParameter* permOpt = ret->createOptionalParameter(5, "-num-permutations", "set the number of permutations");
+    permOpt->addIntegerParameter(1, "number", "the number of permutations, including the unpermuted data (default 1000)");
+
+    OptionalParameter* groupOpt = ret->createOptionalParameter(6, "-groups", "do a two-sample test instead of a one-sample test");
+    groupOpt->addStringParameter(1, "group-file", "a text file containing a 0 or 1 for each column of <metric-in>");
+
+    OptionalParameter* roiOpt = ret->createOptionalParameter(7, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addMetricParameter(1, "roi-metric", "the area to run TFCE on, as a metric");
+
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(8, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "E", "exponent for cluster area (default 1.0)");
+    paramsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+
+    OptionalParameter* corrAreaOpt = ret->createOptionalParameter(9, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+
+    OptionalParameter* seedOpt = ret->createOptionalParameter(10, "-seed", "set the seed for generating permutations");
+    seedOpt->addIntegerParameter(1, "seed", "the seed value (default 0)");
+
+    OptionalParameter* nullOpt = ret->createOptionalParameter(11, "-null-distribution", "output the maximum statistics of every permutation");
+    nullOpt->addStringParameter(1, "text-out", "output - text file name");
+
+    ret->setHelpText(
+        AString("Computes a t-statistic at every vertex, enhances it with TFCE (see -metric-tfce), and builds the null distribution of the maximum TFCE value by permutation.  ") +
+        "Without -groups, a one-sample test is done by randomly flipping the sign of each subject's data.  " +
+        "With -groups, a two-sample test (group 1 minus group 0, pooled variance) is done by randomly permuting the group labels.  " +
+        "The first permutation is always the unpermuted data, and it is included in the null distribution.\n\n" +
+        "The surface, topology and vertex areas are set up once and reused for all permutations, and permutations are processed in parallel.  " +
+        "Positive and negative TFCE values are tested separately against the null distribution of the maximum positive and maximum negative values, " +
+        "so <p-out> contains, at each vertex, the FWER-corrected p-value for the tail matching the sign of <tfce-out>.\n\n" +
+        "The <group-file> must contain one 0 or 1 per column of <metric-in>, separated by whitespace.  " +
+        "The text file output by -null-distribution contains one line per permutation, with the maximum positive TFCE value and the magnitude of the most negative TFCE value."
+    );
+    return ret;
+}
+
+void AlgorithmMetricTFCEPermutation::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    SurfaceFile* mySurf = myParams->getSurface(1);
+    MetricFile* myMetric = myParams->getMetric(2);
+    MetricFile* myTfceOut = myParams->getOutputMetric(3);
+    MetricFile* myPvalOut = myParams->getOutputMetric(4);
+    int numPermutations = 1000;
+    OptionalParameter* permOpt = myParams->getOptionalParameter(5);
+    if (permOpt->m_present)
+    {
+        numPermutations = (int)permOpt->getInteger(1);
+    }
+    vector<int> groups;
+    OptionalParameter* groupOpt = myParams->getOptionalParameter(6);
+    if (groupOpt->m_present)
+    {
+        AString groupFileName = groupOpt->getString(1);
+        FileInformation textFileInfo(groupFileName);
+        if (!textFileInfo.exists())
+        {
+            throw AlgorithmException("group file doesn't exist");
+        }
+        fstream groupFile(groupFileName.toLocal8Bit().constData(), fstream::in);
+        if (!groupFile.good())
+        {
+            throw AlgorithmException("error reading group file");
+        }
+        int temp;
+        while (groupFile >> temp)
+        {
+            groups.push_back(temp);
+        }
+        if (groups.empty()) throw AlgorithmException("group file contains no group labels");
+    }
+    MetricFile* myRoi = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(7);
+    if (roiOpt->m_present)
+    {
+        myRoi = roiOpt->getMetric(1);
+    }
+    float param_e = 1.0f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(8);
+    if (paramsOpt->m_present)
+    {
+        param_e = (float)paramsOpt->getDouble(1);
+        param_h = (float)paramsOpt->getDouble(2);
+    }
+    MetricFile* corrAreaMetric = NULL;
+    OptionalParameter* corrAreaOpt = myParams->getOptionalParameter(9);
+    if (corrAreaOpt->m_present)
+    {
+        corrAreaMetric = corrAreaOpt->getMetric(1);
+    }
+    int seed = 0;
+    OptionalParameter* seedOpt = myParams->getOptionalParameter(10);
+    if (seedOpt->m_present)
+    {
+        seed = (int)seedOpt->getInteger(1);
+    }
+    OptionalParameter* nullOpt = myParams->getOptionalParameter(11);
+    vector<float> nullDist;
+    ofstream nullFile;
+    if (nullOpt->m_present)
+    {
+        nullFile.open(nullOpt->getString(1).toLocal8Bit().constData());
+        if (!nullFile) throw AlgorithmException("failed to open text file for output");
+    }
+    AlgorithmMetricTFCEPermutation(myProgObj, mySurf, myMetric, myTfceOut, myPvalOut, numPermutations, groups, myRoi, param_e, param_h, corrAreaMetric, seed,
+                                   (nullOpt->m_present ? &nullDist : NULL));
+    if (nullOpt->m_present)
+    {
+        for (int i = 0; i < (int)nullDist.size(); i += 2)
+        {
+            nullFile << nullDist[i] << " " << nullDist[i + 1] << endl;
+        }
+        if (!nullFile) throw AlgorithmException("error writing null distribution text file");
+    }
+}
+
+namespace
+{
+    //design is the sign flip (0 or 1) for each subject in a one-sample test, or the permuted group label in a two-sample test
+    //subjData is vertex-major, so the subjects of a vertex are contiguous
+    void computeTStats(const float* subjData, const double* totalSum, const double* totalSumSq, const int& numNodes, const int& numSubj,
+                       const vector<char>& design, const bool& twoSample, const float* roiData, float* statOut)
+    {
+        for (int node = 0; node < numNodes; ++node)
+        {
+            statOut[node] = 0.0f;
+            if (roiData != NULL && !(roiData[node] > 0.0f)) continue;
+            const float* nodeData = subjData + ((int64_t)node) * numSubj;
+            double partSum = 0.0, partSumSq = 0.0;
+            int partCount = 0;
+            for (int s = 0; s < numSubj; ++s)
+            {
+                if (design[s] != 0)
+                {
+                    partSum += nodeData[s];
+                    partSumSq += ((double)nodeData[s]) * nodeData[s];
+                    ++partCount;
+                }
+            }
+            double tstat = 0.0;
+            if (twoSample)
+            {//sum of squares for each group is needed for pooled variance, but the total is invariant, so only accumulate group 1
+                int otherCount = numSubj - partCount;
+                double otherSum = totalSum[node] - partSum, otherSumSq = totalSumSq[node] - partSumSq;
+                double mean1 = partSum / partCount, mean0 = otherSum / otherCount;
+                double pooledVar = ((partSumSq - partSum * mean1) + (otherSumSq - otherSum * mean0)) / (numSubj - 2);
+                if (pooledVar > 0.0)
+                {
+                    tstat = (mean1 - mean0) / sqrt(pooledVar * (1.0 / partCount + 1.0 / otherCount));
+                }
+            } else {//sign flipping doesn't change the sum of squares, only the sum
+                double flippedSum = totalSum[node] - 2.0 * partSum;
+                double variance = (totalSumSq[node] - flippedSum * flippedSum / numSubj) / (numSubj - 1);
+                if (variance > 0.0)
+                {
+                    tstat = (flippedSum / numSubj) / sqrt(variance / numSubj);
+                }
+            }
+            statOut[node] = (float)tstat;
+        }
+    }
+}
+
+AlgorithmMetricTFCEPermutation::AlgorithmMetricTFCEPermutation(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myTfceOut, MetricFile* myPvalOut,
+                                                               const int& numPermutations, const vector<int>& groups, const MetricFile* myRoi,
+                                                               const float& param_e, const float& param_h, const MetricFile* corrAreaMetric, const int& seed,
+                                                               vector<float>* nullOut) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    int numNodes = mySurf->getNumberOfNodes();
+    if (myMetric->getNumberOfNodes() != numNodes) throw AlgorithmException("metric and surface have different number of vertices");
+    if (myRoi != NULL && myRoi->getNumberOfNodes() != numNodes) throw AlgorithmException("roi metric and surface have different number of vertices");
+    if (corrAreaMetric != NULL && corrAreaMetric->getNumberOfNodes() != numNodes) throw AlgorithmException("corrected area metric and surface have different number of vertices");
+    if (numPermutations < 1) throw AlgorithmException("number of permutations must be positive");
+    int numSubj = myMetric->getNumberOfColumns();
+    bool twoSample = !groups.empty();
+    if (twoSample)
+    {
+        if ((int)groups.size() != numSubj) throw AlgorithmException("group file has " + AString::number(groups.size()) + " labels, but input metric has " + AString::number(numSubj) + " columns");
+        int groupCount[2] = { 0, 0 };
+        for (int s = 0; s < numSubj; ++s)
+        {
+            if (groups[s] != 0 && groups[s] != 1) throw AlgorithmException("group labels must be 0 or 1");
+            ++groupCount[groups[s]];
+        }
+        if (groupCount[0] < 1 || groupCount[1] < 1 || numSubj < 3) throw AlgorithmException("two-sample test requires at least one subject in each group, and at least 3 subjects total");
+    } else {
+        if (numSubj < 2) throw AlgorithmException("one-sample test requires at least 2 columns in the input metric");
+    }
+    const float* roiData = NULL, *areaData = NULL;
+    vector<float> surfAreaData;
+    if (corrAreaMetric == NULL)
+    {
+        mySurf->computeNodeAreas(surfAreaData);
+        areaData = surfAreaData.data();
+    } else {
+        areaData = corrAreaMetric->getValuePointerForColumn(0);
+    }
+    if (myRoi != NULL) roiData = myRoi->getValuePointerForColumn(0);
+    vector<float> subjData(((int64_t)numNodes) * numSubj);//transpose, so that the per-vertex statistics walk contiguous memory
+    for (int s = 0; s < numSubj; ++s)
+    {
+        const float* colData = myMetric->getValuePointerForColumn(s);
+        for (int node = 0; node < numNodes; ++node)
+        {
+            subjData[((int64_t)node) * numSubj + s] = colData[node];
+        }
+    }
+    vector<double> totalSum(numNodes, 0.0), totalSumSq(numNodes, 0.0);
+    for (int node = 0; node < numNodes; ++node)
+    {
+        const float* nodeData = subjData.data() + ((int64_t)node) * numSubj;
+        for (int s = 0; s < numSubj; ++s)
+        {
+            totalSum[node] += nodeData[s];
+            totalSumSq[node] += ((double)nodeData[s]) * nodeData[s];
+        }
+    }
+    vector<vector<char> > designs(numPermutations, vector<char>(numSubj, 0));//generate all permutations up front, so the result doesn't depend on the number of threads
+    mt19937 myRand(seed);
+    for (int s = 0; s < numSubj; ++s)
+    {
+        if (twoSample) designs[0][s] = (char)groups[s];//first permutation is the unpermuted data, for one-sample that is no flips
+    }
+    for (int p = 1; p < numPermutations; ++p)
+    {
+        if (twoSample)
+        {
+            designs[p] = designs[0];
+            shuffle(designs[p].begin(), designs[p].end(), myRand);
+        } else {
+            for (int s = 0; s < numSubj; ++s)
+            {
+                designs[p][s] = (char)(myRand() & 1);
+            }
+        }
+    }
+    vector<float> maxPos(numPermutations, 0.0f), maxNeg(numPermutations, 0.0f), observedTfce(numNodes, 0.0f);
+#pragma omp CARET_PAR
+    {
+        CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
+        vector<float> statScratch(numNodes), tfceScratch(numNodes);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int p = 0; p < numPermutations; ++p)
+        {
+            computeTStats(subjData.data(), totalSum.data(), totalSumSq.data(), numNodes, numSubj, designs[p], twoSample, roiData, statScratch.data());
+            AlgorithmMetricTFCE::processColumn(myHelper, statScratch.data(), tfceScratch.data(), roiData, param_e, param_h, areaData);
+            float thisPos = 0.0f, thisNeg = 0.0f;
+            for (int node = 0; node < numNodes; ++node)
+            {
+                if (tfceScratch[node] > thisPos) thisPos = tfceScratch[node];
+                if (-tfceScratch[node] > thisNeg) thisNeg = -tfceScratch[node];
+            }
+            maxPos[p] = thisPos;
+            maxNeg[p] = thisNeg;
+            if (p == 0)
+            {
+                observedTfce = tfceScratch;
+            }
+        }
+    }
+    vector<float> sortedPos = maxPos, sortedNeg = maxNeg;
+    sort(sortedPos.begin(), sortedPos.end());
+    sort(sortedNeg.begin(), sortedNeg.end());
+    vector<float> pvals(numNodes, 1.0f);
+    for (int node = 0; node < numNodes; ++node)
+    {
+        float val = observedTfce[node];
+        if (val > 0.0f)
+        {//count of null maxima >= val, using the sorted list
+            int64_t numGreaterEqual = sortedPos.end() - lower_bound(sortedPos.begin(), sortedPos.end(), val);
+            pvals[node] = ((float)numGreaterEqual) / numPermutations;
+        } else if (val < 0.0f) {
+            int64_t numGreaterEqual = sortedNeg.end() - lower_bound(sortedNeg.begin(), sortedNeg.end(), -val);
+            pvals[node] = ((float)numGreaterEqual) / numPermutations;
+        }
+    }
+    myTfceOut->setNumberOfNodesAndColumns(numNodes, 1);
+    myTfceOut->setStructure(mySurf->getStructure());
+    myTfceOut->setValuesForColumn(0, observedTfce.data());
+    myTfceOut->setMapName(0, "TFCE t-statistic");
+    myPvalOut->setNumberOfNodesAndColumns(numNodes, 1);
+    myPvalOut->setStructure(mySurf->getStructure());
+    myPvalOut->setValuesForColumn(0, pvals.data());
+    myPvalOut->setMapName(0, "FWER p-value");
+    if (nullOut != NULL)
+    {
+        nullOut->resize(numPermutations * 2);
+        for (int p = 0; p < numPermutations; ++p)
+        {
+            (*nullOut)[p * 2] = maxPos[p];
+            (*nullOut)[p * 2 + 1] = maxNeg[p];
+        }
+    }
+}
+
+float AlgorithmMetricTFCEPermutation::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmMetricTFCEPermutation::getSubAlgorithmWeight()
+{
+    return 0.0f;
+}
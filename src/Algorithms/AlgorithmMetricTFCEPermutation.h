@@ -0,0 +1,53 @@
+#ifndef __ALGORITHM_METRIC_TFCE_PERMUTATION_H__
+#define __ALGORITHM_METRIC_TFCE_PERMUTATION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AbstractAlgorithm.h"
+
+#include <vector>
+
+namespace caret {
+
+    class AlgorithmMetricTFCEPermutation : public AbstractAlgorithm
+    {
+        AlgorithmMetricTFCEPermutation();
+    protected:
+        static float getSubAlgorithmWeight();
+        static float getAlgorithmInternalWeight();
+    public:
+        ///groups must be empty for a one-sample sign-flip test, or contain a 0 or 1 for every column of myMetric for a two-sample test
+        ///nullOut, if not NULL, receives the maximum positive and maximum negative (as a positive number) TFCE value from each permutation, interleaved
+        AlgorithmMetricTFCEPermutation(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myTfceOut, MetricFile* myPvalOut,
+                                       const int& numPermutations = 1000, const std::vector<int>& groups = std::vector<int>(), const MetricFile* myRoi = NULL,
+                                       const float& param_e = 1.0f, const float& param_h = 2.0f, const MetricFile* corrAreaMetric = NULL, const int& seed = 0,
+                                       std::vector<float>* nullOut = NULL);
+        static OperationParameters* getParameters();
+        static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
+        static AString getCommandSwitch();
+        static AString getShortDescription();
+    };
+
+    typedef TemplateAutoOperation<AlgorithmMetricTFCEPermutation> AutoAlgorithmMetricTFCEPermutation;
+
+}
+
+#endif //__ALGORITHM_METRIC_TFCE_PERMUTATION_H__
@@ -57,9 +57,13 @@ OperationParameters* AlgorithmVolumeAffineResample::getParameters()
     flirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the affine");
     flirtOpt->addStringParameter(2, "target-volume", "the target volume used when generating the affine");
     
+    ret->createOptionalParameter(7, "-prefiltered", "the input volume contains cubic spline coefficients");
+    
     ret->setHelpText(
         AString("Resample a volume file with an affine transformation.  ") +
         "The recommended methods are CUBIC (cubic spline) for most data, and ENCLOSING_VOXEL for label data.  "
+        "If you will resample the same volume several times with CUBIC, you can compute the spline coefficients once with -volume-spline-prefilter, " +
+        "and use that output as the input here with -prefiltered.  "
         "The parameter <method> must be one of:\n\n" +
         "CUBIC\nENCLOSING_VOXEL\nTRILINEAR"
     );
@@ -74,6 +78,7 @@ void AlgorithmVolumeAffineResample::useParameters(OperationParameters* myParams,
     AString method = myParams->getString(4);
     VolumeFile* outVol = myParams->getOutputVolume(5);
     OptionalParameter* flirtOpt = myParams->getOptionalParameter(6);
+    bool inputPrefiltered = myParams->getOptionalParameter(7)->m_present;
     AffineFile myAffine;
     if (flirtOpt->m_present)
     {
@@ -97,13 +102,15 @@ void AlgorithmVolumeAffineResample::useParameters(OperationParameters* myParams,
     refSpaceIO.openRead(refSpaceName);
     vector<int64_t> refDims = refSpaceIO.getDimensions();
     if (refDims.size() < 3) refDims.resize(3, 1);
-    AlgorithmVolumeAffineResample(myProgObj, inVol, affMat, refDims.data(), refSpaceIO.getHeader().getSForm(), myMethod, outVol);
+    AlgorithmVolumeAffineResample(myProgObj, inVol, affMat, refDims.data(), refSpaceIO.getHeader().getSForm(), myMethod, outVol, inputPrefiltered);
 }
 
 AlgorithmVolumeAffineResample::AlgorithmVolumeAffineResample(ProgressObject* myProgObj, const VolumeFile* inVol, const FloatMatrix& myAffine,
-                                                             const int64_t refDims[3], const vector<vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol) : AbstractAlgorithm(myProgObj)
+                                                             const int64_t refDims[3], const vector<vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol,
+                                                             const bool& inputPrefiltered) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
+    if (inputPrefiltered && myMethod != VolumeFile::CUBIC) throw AlgorithmException("prefiltered input can only be used with cubic resampling");
     int64_t affRows, affColumns;
     myAffine.getDimensions(affRows, affColumns);
     if (affRows < 3 || affRows > 4 || affColumns != 4) throw AlgorithmException("input matrix is not an affine matrix");
@@ -147,26 +154,46 @@ AlgorithmVolumeAffineResample::AlgorithmVolumeAffineResample(ProgressObject* myP
         {
             if (myMethod == VolumeFile::CUBIC)
             {
-                inVol->validateSpline(b, c);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
-            }
+                inVol->validateSpline(b, c, inputPrefiltered);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
 #pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t k = 0; k < outDims[2]; ++k)
-            {
-                for (int64_t j = 0; j < outDims[1]; ++j)
+                for (int64_t k = 0; k < outDims[2]; ++k)
                 {
-                    for (int64_t i = 0; i < outDims[0]; ++i)
+                    vector<float> rowCoords(outDims[0] * 3), rowValues(outDims[0]);
+                    for (int64_t j = 0; j < outDims[1]; ++j)
                     {
-                        Vector3D outCoord, inCoord;
-                        outVol->indexToSpace(i, j, k, outCoord);
-                        inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
-                        float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
-                        outVol->setValue(interpVal, i, j, k, b, c);
+                        for (int64_t i = 0; i < outDims[0]; ++i)
+                        {
+                            Vector3D outCoord, inCoord;
+                            outVol->indexToSpace(i, j, k, outCoord);
+                            inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
+                            rowCoords[i * 3] = inCoord[0];
+                            rowCoords[i * 3 + 1] = inCoord[1];
+                            rowCoords[i * 3 + 2] = inCoord[2];
+                        }
+                        inVol->interpolateValuesCubic(rowCoords.data(), rowValues.data(), outDims[0], b, c);//a whole row at a time, to evaluate splines in groups
+                        for (int64_t i = 0; i < outDims[0]; ++i)
+                        {
+                            outVol->setValue(rowValues[i], i, j, k, b, c);
+                        }
                     }
                 }
-            }
-            if (myMethod == VolumeFile::CUBIC)
-            {
                 inVol->freeSpline(b, c);//release memory we no longer need, if we allocated it
+            } else {
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t k = 0; k < outDims[2]; ++k)
+                {
+                    for (int64_t j = 0; j < outDims[1]; ++j)
+                    {
+                        for (int64_t i = 0; i < outDims[0]; ++i)
+                        {
+                            Vector3D outCoord, inCoord;
+                            outVol->indexToSpace(i, j, k, outCoord);
+                            inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
+                            float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
+                            outVol->setValue(interpVal, i, j, k, b, c);
+                        }
+                    }
+                }
             }
         }
     }
@@ -23,12 +23,15 @@
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CaretPointer.h"
 #include "CaretPointLocator.h"
+#include "ConnectedComponentHelper.h"
 #include "VolumeFile.h"
-#include "VoxelIJK.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <vector>
 
 using namespace caret;
@@ -72,6 +75,9 @@ OperationParameters* AlgorithmVolumeFindClusters::getParameters()
     OptionalParameter* startOpt = ret->createOptionalParameter(8, "-start", "start labeling clusters from a value other than 1");
     startOpt->addIntegerParameter(1, "startval", "the value to give the first cluster found");
     
+    OptionalParameter* connectOpt = ret->createOptionalParameter(11, "-connectivity", "set which voxels are considered neighbors");
+    connectOpt->addIntegerParameter(1, "neighbors", "6 for shared faces, 18 for shared faces or edges, 26 for shared faces, edges or corners (default 6)");
+    
     ret->setHelpText(
         AString("Outputs a volume with nonzero integers for all voxels within a large enough cluster, and zeros elsewhere.  ") +
         "The integers denote cluster membership (by default, first cluster found will use value 1, second cluster 2, etc).  " +
@@ -130,28 +136,77 @@ void AlgorithmVolumeFindClusters::useParameters(OperationParameters* myParams, P
             throw AlgorithmException("distance cutoff must be positive");
         }
     }
-    AlgorithmVolumeFindClusters(myProgObj, volIn, threshValue, minVolume, volOut, lessThan, myRoi, subvolNum, startVal, NULL, sizeRatio, distaceCutoff);
+    OptionalParameter* connectOpt = myParams->getOptionalParameter(11);
+    int connectivity = 6;
+    if (connectOpt->m_present)
+    {
+        connectivity = (int)connectOpt->getInteger(1);
+    }
+    AlgorithmVolumeFindClusters(myProgObj, volIn, threshValue, minVolume, volOut, lessThan, myRoi, subvolNum, startVal, NULL, sizeRatio, distaceCutoff, connectivity);
 }
 
 namespace
 {
-    void processSubvol(const float* inFrame, VolumeFile* volOut, const int64_t& outSubvol, const int64_t& outComponent, const float& threshValue, const float& minVolume,
-                       const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, int& markVal)
+    struct VoxelNeighbors
     {
-        vector<int64_t> dims = volOut->getDimensions();
+        int64_t m_dims[3];
+        vector<int> m_offsets;//triples of i, j, k offsets
+        VoxelNeighbors(const vector<int64_t>& dims, const int& connectivity)
+        {
+            m_dims[0] = dims[0];
+            m_dims[1] = dims[1];
+            m_dims[2] = dims[2];
+            int maxManhattan = 1;//6: faces, 18: faces and edges, 26: faces, edges and corners
+            if (connectivity == 18) maxManhattan = 2;
+            if (connectivity == 26) maxManhattan = 3;
+            for (int k = -1; k <= 1; ++k)
+            {
+                for (int j = -1; j <= 1; ++j)
+                {
+                    for (int i = -1; i <= 1; ++i)
+                    {
+                        int manhattan = abs(i) + abs(j) + abs(k);
+                        if (manhattan > 0 && manhattan <= maxManhattan)
+                        {
+                            m_offsets.push_back(i);
+                            m_offsets.push_back(j);
+                            m_offsets.push_back(k);
+                        }
+                    }
+                }
+            }
+        }
+        void operator()(const int64_t& index, vector<int64_t>& neighOut) const
+        {
+            neighOut.clear();
+            int64_t ijk[3];
+            indexToIJK(index, ijk);
+            const int64_t jstep = m_dims[0], kstep = m_dims[0] * m_dims[1];
+            for (int n = 0; n < (int)m_offsets.size(); n += 3)
+            {
+                int64_t ni = ijk[0] + m_offsets[n], nj = ijk[1] + m_offsets[n + 1], nk = ijk[2] + m_offsets[n + 2];
+                if (ni < 0 || nj < 0 || nk < 0 || ni >= m_dims[0] || nj >= m_dims[1] || nk >= m_dims[2]) continue;
+                neighOut.push_back(ni + nj * jstep + nk * kstep);
+            }
+        }
+        void indexToIJK(const int64_t& index, int64_t ijkOut[3]) const
+        {
+            ijkOut[0] = index % m_dims[0];
+            ijkOut[1] = (index / m_dims[0]) % m_dims[1];
+            ijkOut[2] = index / (m_dims[0] * m_dims[1]);
+        }
+    };
+    
+    //clusters are lists of frame indices, in the order a flood fill in index order would find them
+    void findClusters(const float* inFrame, const VolumeSpace& mySpace, const float& threshValue, const float& minVolume,
+                      const bool& lessThan, const float* roiFrame, const float& sizeRatio, const float& distanceCutoff, const int& connectivity, vector<vector<int64_t> >& clusters, const bool& parallel)
+    {
+        const int64_t* dims = mySpace.getDims();
         int64_t frameSize = dims[0] * dims[1] * dims[2];
-        const VolumeSpace& mySpace = volOut->getVolumeSpace();
         Vector3D ivec, jvec, kvec, origin;
         mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
         float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
         int64_t minVoxels = (int64_t)ceil(minVolume / voxelVolume);
-        vector<VoxelIJK> neighbors;
-        neighbors.push_back(VoxelIJK(1, 0, 0));
-        neighbors.push_back(VoxelIJK(-1, 0, 0));
-        neighbors.push_back(VoxelIJK(0, 1, 0));
-        neighbors.push_back(VoxelIJK(0, -1, 0));
-        neighbors.push_back(VoxelIJK(0, 0, 1));
-        neighbors.push_back(VoxelIJK(0, 0, -1));
         vector<char> marked(frameSize, 0);
         if (lessThan)
         {
@@ -171,51 +226,31 @@ namespace
                 }
             }
         }
-        vector<vector<VoxelIJK> > clusters;
+        VoxelNeighbors myNeighbors(vector<int64_t>(dims, dims + 3), connectivity);
+        vector<int64_t> clusterIndices;
+        int64_t numFound = ConnectedComponentHelper::labelComponents(frameSize, marked.data(), myNeighbors, clusterIndices, parallel);
+        vector<vector<int64_t> > found(numFound);
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            if (clusterIndices[i] != -1)
+            {
+                found[clusterIndices[i]].push_back(i);
+            }
+        }
+        clusters.clear();
         size_t biggestCount = 0;
         int64_t biggestCluster = -1;
-        for (int64_t k = 0; k < dims[2]; ++k)
+        for (int64_t i = 0; i < numFound; ++i)
         {
-            for (int64_t j = 0; j < dims[1]; ++j)
+            if ((int64_t)found[i].size() >= minVoxels)
             {
-                for (int64_t i = 0; i < dims[0]; ++i)
+                if (found[i].size() > biggestCount)
                 {
-                    int64_t myIndex = mySpace.getIndex(i, j, k);
-                    if (marked[myIndex])
-                    {
-                        vector<VoxelIJK> voxelList;
-                        voxelList.push_back(VoxelIJK(i, j, k));
-                        marked[myIndex] = 0;//don't let voxels get duplicated in the list
-                        for (int64_t index = 0; index < (int64_t)voxelList.size(); ++index)//NOTE: vector grows inside loop
-                        {
-                            const VoxelIJK& thisVoxel = voxelList[index];
-                            for (int n = 0; n < (int)neighbors.size(); ++n)
-                            {
-                                VoxelIJK neighVox(thisVoxel.m_ijk[0] + neighbors[n].m_ijk[0],
-                                                    thisVoxel.m_ijk[1] + neighbors[n].m_ijk[1],
-                                                    thisVoxel.m_ijk[2] + neighbors[n].m_ijk[2]);
-                                if (mySpace.indexValid(neighVox.m_ijk))
-                                {
-                                    int64_t neighIndex = mySpace.getIndex(neighVox.m_ijk);
-                                    if (marked[neighIndex])
-                                    {
-                                        voxelList.push_back(neighVox);
-                                        marked[neighIndex] = 0;
-                                    }
-                                }
-                            }
-                        }
-                        if ((int64_t)voxelList.size() >= minVoxels)
-                        {
-                            if (voxelList.size() > biggestCount)
-                            {
-                                biggestCount = voxelList.size();
-                                biggestCluster = (int64_t)clusters.size();
-                            }
-                            clusters.push_back(voxelList);
-                        }
-                    }
+                    biggestCount = found[i].size();
+                    biggestCluster = (int64_t)clusters.size();
                 }
+                clusters.push_back(vector<int64_t>());
+                clusters.back().swap(found[i]);
             }
         }
         if (!clusters.empty()) CaretAssert(biggestCluster != -1);
@@ -228,13 +263,15 @@ namespace
                 biggestCoords.reserve(biggestCount * 3);
                 for (size_t i = 0; i < clusters[biggestCluster].size(); ++i)
                 {
+                    int64_t ijk[3];
                     float thisCoord[3];
-                    mySpace.indexToSpace(clusters[biggestCluster][i].m_ijk, thisCoord);
+                    myNeighbors.indexToIJK(clusters[biggestCluster][i], ijk);
+                    mySpace.indexToSpace(ijk, thisCoord);
                     biggestCoords.push_back(thisCoord[0]);
                     biggestCoords.push_back(thisCoord[1]);
                     biggestCoords.push_back(thisCoord[2]);
                 }
-                myLocator.grabNew(new CaretPointLocator(biggestCoords.data(), biggestCoords.size()));
+                myLocator.grabNew(new CaretPointLocator(biggestCoords.data(), biggestCoords.size() / 3));
             }
             for (size_t i = 0; i < clusters.size(); ++i)
             {
@@ -250,8 +287,10 @@ namespace
                         erase = true;//erase unless we find a point close enough to the biggest cluster
                         for (size_t j = 0; j < clusters[i].size(); ++j)
                         {
+                            int64_t ijk[3];
                             float thisCoord[3];
-                            mySpace.indexToSpace(clusters[i][j].m_ijk, thisCoord);
+                            myNeighbors.indexToIJK(clusters[i][j], ijk);
+                            mySpace.indexToSpace(ijk, thisCoord);
                             int32_t ret = myLocator->closestPointLimited(thisCoord, distanceCutoff);
                             if (ret == -1)
                             {
@@ -269,6 +308,10 @@ namespace
                 }
             }
         }
+    }
+    
+    void markClusters(const vector<vector<int64_t> >& clusters, float* outFrame, int& markVal)
+    {
         for (size_t i = 0; i < clusters.size(); ++i)
         {
             if (markVal == 0)
@@ -280,7 +323,7 @@ namespace
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
             for (size_t index = 0; index < clusters[i].size(); ++index)
             {
-                volOut->setValue(tempVal, clusters[i][index].m_ijk, outSubvol, outComponent);
+                outFrame[clusters[i][index]] = tempVal;
             }
             ++markVal;
         }
@@ -289,13 +332,17 @@ namespace
 
 AlgorithmVolumeFindClusters::AlgorithmVolumeFindClusters(ProgressObject* myProgObj, const VolumeFile* volIn, const float& threshValue, const float& minVolume, VolumeFile* volOut,
                                                          const bool& lessThan, const VolumeFile* myRoi, const int& subvolNum, const int& startVal, int* endVal,
-                                                         const float& sizeRatio, const float& distanceCutoff) : AbstractAlgorithm(myProgObj)
+                                                         const float& sizeRatio, const float& distanceCutoff, const int& connectivity) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     if (startVal == 0)
     {
         throw AlgorithmException("0 is not a valid cluster marking start value");
     }
+    if (connectivity != 6 && connectivity != 18 && connectivity != 26)
+    {
+        throw AlgorithmException("connectivity must be 6, 18, or 26");
+    }
     const VolumeSpace& mySpace = volIn->getVolumeSpace();
     const float* roiFrame = NULL;
     if (myRoi != NULL)
@@ -305,27 +352,52 @@ AlgorithmVolumeFindClusters::AlgorithmVolumeFindClusters(ProgressObject* myProgO
     }
     vector<int64_t> dims = volIn->getDimensions();
     int markVal = startVal;
+    vector<int64_t> inSubvols, inComponents, outSubvols;//list all frames to do, in the order their clusters get numbered
     if (subvolNum == -1)
     {
         volOut->reinitialize(volIn->getOriginalDimensions(), volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
             for (int64_t s = 0; s < dims[3]; ++s)
             {
-                const float* inFrame = volIn->getFrame(s, c);
-                processSubvol(inFrame, volOut, s, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
+                inSubvols.push_back(s);
+                inComponents.push_back(c);
+                outSubvols.push_back(s);
             }
         }
     } else {
         vector<int64_t> outDims = volIn->getOriginalDimensions();
         outDims.resize(3);
         volOut->reinitialize(outDims, volIn->getSform(), dims[4]);
-        volOut->setValueAllVoxels(0.0f);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
-            const float* inFrame = volIn->getFrame(subvolNum, c);
-            processSubvol(inFrame, volOut, 0, c, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, markVal);
+            inSubvols.push_back(subvolNum);
+            inComponents.push_back(c);
+            outSubvols.push_back(0);
+        }
+    }
+    int64_t numFrames = (int64_t)inSubvols.size();
+    int64_t batchSize = 1;//do several frames concurrently, but limit how many frames of cluster lists are held at once
+#ifdef CARET_OMP
+    batchSize = omp_get_max_threads();
+#endif
+    bool parallelFrames = (numFrames > 1 && batchSize > 1);
+    vector<float> outFrame(dims[0] * dims[1] * dims[2]);
+    for (int64_t batchStart = 0; batchStart < numFrames; batchStart += batchSize)
+    {
+        int64_t batchEnd = min(batchStart + batchSize, numFrames);
+        vector<vector<vector<int64_t> > > frameClusters(batchEnd - batchStart);
+#pragma omp CARET_PARFOR schedule(dynamic) if(parallelFrames)
+        for (int64_t f = batchStart; f < batchEnd; ++f)
+        {
+            const float* inFrame = volIn->getFrame(inSubvols[f], inComponents[f]);
+            findClusters(inFrame, mySpace, threshValue, minVolume, lessThan, roiFrame, sizeRatio, distanceCutoff, connectivity, frameClusters[f - batchStart], !parallelFrames);
+        }
+        for (int64_t f = batchStart; f < batchEnd; ++f)//cluster values are assigned in frame order, so they don't depend on the number of threads
+        {
+            outFrame.assign(outFrame.size(), 0.0f);
+            markClusters(frameClusters[f - batchStart], outFrame.data(), markVal);
+            volOut->setFrame(outFrame.data(), outSubvols[f], inComponents[f]);
         }
     }
     if (endVal != NULL) *endVal = markVal;
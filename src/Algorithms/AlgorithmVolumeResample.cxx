@@ -0,0 +1,275 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmVolumeResample.h"
+#include "AffineFile.h"
+#include "AlgorithmException.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "GiftiLabelTable.h"
+#include "NiftiIO.h"
+#include "Vector3D.h"
+#include "WarpfieldFile.h"
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmVolumeResample::getCommandSwitch()
+{
+    return "-volume-resample";
+}
+
+AString AlgorithmVolumeResample::getShortDescription()
+{
+    return "RESAMPLE VOLUME USING A CHAIN OF TRANSFORMS";
+}
+
+OperationParameters* AlgorithmVolumeResample::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addVolumeParameter(1, "volume-in", "volume to resample");
+    
+    ret->addStringParameter(2, "volume-space", "a volume file in the volume space you want for the output");
+    
+    ret->addStringParameter(3, "method", "the resampling method");
+    
+    ret->addVolumeOutputParameter(4, "volume-out", "the output volume");
+    
+    ParameterComponent* transformOpt = ret->createRepeatableParameter(5, "-transform", "add a transform to the chain");
+    transformOpt->addStringParameter(1, "type", "AFFINE or WARPFIELD");
+    transformOpt->addStringParameter(2, "transform-file", "the affine or warpfield file");
+    OptionalParameter* flirtOpt = transformOpt->createOptionalParameter(3, "-flirt", "MUST be used if the affine is a flirt affine");
+    flirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the affine");
+    flirtOpt->addStringParameter(2, "target-volume", "the target volume used when generating the affine");
+    OptionalParameter* fnirtOpt = transformOpt->createOptionalParameter(4, "-fnirt", "MUST be used if using a fnirt warpfield");
+    fnirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the warpfield");
+    
+    ret->createOptionalParameter(6, "-prefiltered", "the input volume contains cubic spline coefficients");
+    
+    ret->setHelpText(
+        AString("Resample a volume file through a chain of affines and warpfields, in the order specified, so the first transform is applied to the input volume.  ") +
+        "The chain is composed into a single mapping from each output voxel to a location in the input volume, so the data is only interpolated once, " +
+        "and no intermediate volumes are written.  " +
+        "The result is the same as running -volume-warpfield-resample and -volume-affine-resample in sequence, minus the extra interpolation blur of each intermediate step.  " +
+        "If no transforms are specified, the input is simply resampled into the new volume space.  " +
+        "Output voxels whose chain passes outside of a warpfield get an unassigned or zero value.\n\n" +
+        "The recommended methods are CUBIC (cubic spline) for most data, and ENCLOSING_VOXEL for label data.  " +
+        "The parameter <method> must be one of:\n\n" +
+        "CUBIC\nENCLOSING_VOXEL\nTRILINEAR"
+    );
+    return ret;
+}
+
+void AlgorithmVolumeResample::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    VolumeFile* inVol = myParams->getVolume(1);
+    AString refSpaceName = myParams->getString(2);
+    AString method = myParams->getString(3);
+    VolumeFile* outVol = myParams->getOutputVolume(4);
+    const vector<ParameterComponent*>& transformInstances = *(myParams->getRepeatableParameterInstances(5));
+    bool inputPrefiltered = myParams->getOptionalParameter(6)->m_present;
+    VolumeFile::InterpType myMethod = VolumeFile::CUBIC;
+    if (method == "CUBIC")
+    {
+        myMethod = VolumeFile::CUBIC;
+    } else if (method == "TRILINEAR") {
+        myMethod = VolumeFile::TRILINEAR;
+    } else if (method == "ENCLOSING_VOXEL") {
+        myMethod = VolumeFile::ENCLOSING_VOXEL;
+    } else {
+        throw AlgorithmException("unrecognized interpolation method");
+    }
+    vector<CaretPointer<WarpfieldFile> > warpfields;//keep them in memory until the algorithm is done
+    vector<TransformStep> transforms;
+    for (int i = 0; i < (int)transformInstances.size(); ++i)
+    {
+        AString type = transformInstances[i]->getString(1);
+        AString fileName = transformInstances[i]->getString(2);
+        OptionalParameter* flirtOpt = transformInstances[i]->getOptionalParameter(3);
+        OptionalParameter* fnirtOpt = transformInstances[i]->getOptionalParameter(4);
+        if (type == "AFFINE")
+        {
+            if (fnirtOpt->m_present) throw AlgorithmException("-fnirt specified for an affine transform");
+            AffineFile myAffine;
+            if (flirtOpt->m_present)
+            {
+                myAffine.readFlirt(fileName, flirtOpt->getString(1), flirtOpt->getString(2));
+            } else {
+                myAffine.readWorld(fileName);
+            }
+            transforms.push_back(TransformStep(FloatMatrix(myAffine.getMatrix())));
+        } else if (type == "WARPFIELD") {
+            if (flirtOpt->m_present) throw AlgorithmException("-flirt specified for a warpfield transform");
+            CaretPointer<WarpfieldFile> myWarpfield(new WarpfieldFile());
+            if (fnirtOpt->m_present)
+            {
+                myWarpfield->readFnirt(fileName, fnirtOpt->getString(1));
+            } else {
+                myWarpfield->readWorld(fileName);
+            }
+            warpfields.push_back(myWarpfield);
+            transforms.push_back(TransformStep(myWarpfield->getWarpfield()));
+        } else {
+            throw AlgorithmException("unrecognized transform type '" + type + "'");
+        }
+    }
+    NiftiIO refSpaceIO;
+    refSpaceIO.openRead(refSpaceName);
+    vector<int64_t> refDims = refSpaceIO.getDimensions();
+    if (refDims.size() < 3) refDims.resize(3, 1);
+    AlgorithmVolumeResample(myProgObj, inVol, transforms, refDims.data(), refSpaceIO.getHeader().getSForm(), myMethod, outVol, inputPrefiltered);
+}
+
+AlgorithmVolumeResample::AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const vector<TransformStep>& transforms,
+                                                 const int64_t refDims[3], const vector<vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol,
+                                                 const bool& inputPrefiltered) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    if (inputPrefiltered && myMethod != VolumeFile::CUBIC) throw AlgorithmException("prefiltered input can only be used with cubic resampling");
+    int numSteps = (int)transforms.size();
+    vector<FloatMatrix> targetToSource(numSteps);//for affine steps, we need the inverse
+    for (int s = 0; s < numSteps; ++s)
+    {
+        if (transforms[s].m_warpfield != NULL)
+        {
+            vector<int64_t> warpDims;
+            transforms[s].m_warpfield->getDimensions(warpDims);
+            if (warpDims[3] != 3 || warpDims[4] != 1) throw AlgorithmException("provided warpfield volume has wrong number of subvolumes or components");
+        } else {
+            int64_t affRows, affColumns;
+            transforms[s].m_affine.getDimensions(affRows, affColumns);
+            if (affRows < 3 || affRows > 4 || affColumns != 4) throw AlgorithmException("input matrix is not an affine matrix");
+            FloatMatrix temp = transforms[s].m_affine;
+            temp.resize(4, 4);
+            temp[3][0] = 0.0f;
+            temp[3][1] = 0.0f;
+            temp[3][2] = 0.0f;
+            temp[3][3] = 1.0f;
+            targetToSource[s] = temp.inverse();
+        }
+    }
+    vector<int64_t> outDims = inVol->getOriginalDimensions();
+    if (outDims.size() < 3) throw AlgorithmException("input must have 3 spatial dimensions");
+    outDims[0] = refDims[0];
+    outDims[1] = refDims[1];
+    outDims[2] = refDims[2];
+    int64_t numMaps = inVol->getNumberOfMaps(), numComponents = inVol->getNumberOfComponents();
+    outVol->reinitialize(outDims, refSform, numComponents, inVol->getType());
+    bool isLabel = inVol->isMappedWithLabelTable();
+    if (isLabel)
+    {
+        if (myMethod != VolumeFile::ENCLOSING_VOXEL)
+        {
+            CaretLogWarning("using interpolation type other than ENCLOSING_VOXEL on a label volume");
+        }
+        for (int64_t i = 0; i < numMaps; ++i)
+        {
+            *(outVol->getMapLabelTable(i)) = *(inVol->getMapLabelTable(i));
+        }
+    }
+    for (int64_t i = 0; i < numMaps; ++i)
+    {
+        outVol->setMapName(i, inVol->getMapName(i));
+    }
+    const int64_t frameSize = outDims[0] * outDims[1] * outDims[2];
+    vector<float> sourceCoords(frameSize * 3);//the composed transform is the same for every frame, so evaluate it once
+    vector<char> sourceValid(frameSize);
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t k = 0; k < outDims[2]; ++k)
+    {
+        for (int64_t j = 0; j < outDims[1]; ++j)
+        {
+            for (int64_t i = 0; i < outDims[0]; ++i)
+            {
+                int64_t outIndex = i + outDims[0] * (j + outDims[1] * k);
+                Vector3D coord;
+                outVol->indexToSpace(i, j, k, coord);
+                bool valid = true;
+                for (int s = numSteps - 1; s >= 0; --s)//pull back from the output space, so the last transform is undone first
+                {
+                    if (transforms[s].m_warpfield != NULL)
+                    {
+                        Vector3D displacement;
+                        displacement[0] = transforms[s].m_warpfield->interpolateValue(coord, VolumeFile::TRILINEAR, &valid, 0);
+                        if (!valid) break;
+                        displacement[1] = transforms[s].m_warpfield->interpolateValue(coord, VolumeFile::TRILINEAR, NULL, 1);
+                        displacement[2] = transforms[s].m_warpfield->interpolateValue(coord, VolumeFile::TRILINEAR, NULL, 2);
+                        coord += displacement;
+                    } else {
+                        const FloatMatrix& myInverse = targetToSource[s];
+                        Vector3D temp;
+                        for (int r = 0; r < 3; ++r)
+                        {
+                            temp[r] = myInverse[r][0] * coord[0] + myInverse[r][1] * coord[1] + myInverse[r][2] * coord[2] + myInverse[r][3];
+                        }
+                        coord = temp;
+                    }
+                }
+                sourceValid[outIndex] = valid;
+                for (int r = 0; r < 3; ++r)
+                {
+                    sourceCoords[outIndex * 3 + r] = (valid ? coord[r] : 0.0f);//leave invalid points somewhere harmless, their value gets replaced
+                }
+            }
+        }
+    }
+    vector<float> outFrame(frameSize);
+    for (int64_t c = 0; c < numComponents; ++c)
+    {
+        for (int64_t b = 0; b < numMaps; ++b)
+        {
+            float invalidVal = VolumeFile::INVALID_INTERP_VALUE;
+            if (isLabel) invalidVal = inVol->getMapLabelTable(b)->getUnassignedLabelKey();
+            if (myMethod == VolumeFile::CUBIC)
+            {
+                inVol->validateSpline(b, c, inputPrefiltered);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
+                const int64_t rowSize = outDims[0];
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t rowStart = 0; rowStart < frameSize; rowStart += rowSize)
+                {
+                    inVol->interpolateValuesCubic(sourceCoords.data() + rowStart * 3, outFrame.data() + rowStart, rowSize, b, c);
+                }
+                inVol->freeSpline(b, c);//release memory we no longer need, if we allocated it
+            } else {
+#pragma omp CARET_PARFOR schedule(dynamic, 1024)
+                for (int64_t i = 0; i < frameSize; ++i)
+                {
+                    outFrame[i] = inVol->interpolateValue(sourceCoords.data() + i * 3, myMethod, NULL, b, c);
+                }
+            }
+            for (int64_t i = 0; i < frameSize; ++i)
+            {
+                if (!sourceValid[i]) outFrame[i] = invalidVal;
+            }
+            outVol->setFrame(outFrame.data(), b, c);
+        }
+    }
+}
+
+float AlgorithmVolumeResample::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmVolumeResample::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
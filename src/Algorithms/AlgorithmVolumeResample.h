@@ -0,0 +1,61 @@
+#ifndef __ALGORITHM_VOLUME_RESAMPLE_H__
+#define __ALGORITHM_VOLUME_RESAMPLE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AbstractAlgorithm.h"
+#include "FloatMatrix.h"
+#include "VolumeFile.h"
+
+#include <vector>
+
+namespace caret {
+    
+    class AlgorithmVolumeResample : public AbstractAlgorithm
+    {
+        AlgorithmVolumeResample();
+    protected:
+        static float getSubAlgorithmWeight();
+        static float getAlgorithmInternalWeight();
+    public:
+        ///one step of a transform chain, in the same conventions as -volume-affine-resample and -volume-warpfield-resample
+        struct TransformStep
+        {
+            const VolumeFile* m_warpfield;//NULL means this step is the affine
+            FloatMatrix m_affine;//source to target, world coordinates
+            TransformStep(const FloatMatrix& affine) : m_warpfield(NULL), m_affine(affine) { }
+            TransformStep(const VolumeFile* warpfield) : m_warpfield(warpfield) { }
+        };
+        ///transforms are applied in order, the first one applies to the input volume
+        AlgorithmVolumeResample(ProgressObject* myProgObj, const VolumeFile* inVol, const std::vector<TransformStep>& transforms,
+                                const int64_t refDims[3], const std::vector<std::vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol,
+                                const bool& inputPrefiltered = false);
+        static OperationParameters* getParameters();
+        static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
+        static AString getCommandSwitch();
+        static AString getShortDescription();
+    };
+
+    typedef TemplateAutoOperation<AlgorithmVolumeResample> AutoAlgorithmVolumeResample;
+
+}
+
+#endif //__ALGORITHM_VOLUME_RESAMPLE_H__
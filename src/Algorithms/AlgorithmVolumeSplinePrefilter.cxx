@@ -0,0 +1,119 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmVolumeSplinePrefilter.h"
+#include "AlgorithmException.h"
+#include "CaretLogger.h"
+#include "VolumeFile.h"
+#include "VolumeSpline.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmVolumeSplinePrefilter::getCommandSwitch()
+{
+    return "-volume-spline-prefilter";
+}
+
+AString AlgorithmVolumeSplinePrefilter::getShortDescription()
+{
+    return "COMPUTE CUBIC SPLINE COEFFICIENTS OF A VOLUME";
+}
+
+OperationParameters* AlgorithmVolumeSplinePrefilter::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addVolumeParameter(1, "volume-in", "the volume to prefilter");
+    
+    ret->addVolumeOutputParameter(2, "volume-out", "the output spline coefficient volume");
+    
+    OptionalParameter* subvolSelect = ret->createOptionalParameter(3, "-subvolume", "select a single subvolume");
+    subvolSelect->addStringParameter(1, "subvol", "the subvolume number or name");
+    
+    ret->setHelpText(
+        AString("Cubic spline resampling first has to deconvolve each frame to get the spline coefficients, which is repeated every time a frame is resampled.  ") +
+        "This command saves the coefficients as a volume, so that commands that do cubic resampling can use them directly with their -prefiltered option, " +
+        "to save time when the same volume is resampled more than once.  " +
+        "The output is not useful for anything else, and looks like a slightly sharpened version of the input.  " +
+        "Non-numeric input values are treated as zero."
+    );
+    return ret;
+}
+
+void AlgorithmVolumeSplinePrefilter::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    VolumeFile* volumeIn = myParams->getVolume(1);
+    VolumeFile* volumeOut = myParams->getOutputVolume(2);
+    int64_t subvolNum = -1;
+    OptionalParameter* subvolSelect = myParams->getOptionalParameter(3);
+    if (subvolSelect->m_present)
+    {
+        subvolNum = volumeIn->getMapIndexFromNameOrNumber(subvolSelect->getString(1));
+        if (subvolNum < 0) throw AlgorithmException("invalid subvolume specified");
+    }
+    AlgorithmVolumeSplinePrefilter(myProgObj, volumeIn, volumeOut, subvolNum);
+}
+
+AlgorithmVolumeSplinePrefilter::AlgorithmVolumeSplinePrefilter(ProgressObject* myProgObj, const VolumeFile* volumeIn, VolumeFile* volumeOut, const int64_t& subvolNum) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    vector<int64_t> myDims;
+    volumeIn->getDimensions(myDims);
+    if (subvolNum < -1 || subvolNum >= myDims[3]) throw AlgorithmException("invalid subvolume specified");
+    if (volumeIn->getType() == SubvolumeAttributes::LABEL) throw AlgorithmException("label volumes can't be meaningfully prefiltered for cubic resampling");
+    vector<int64_t> outDims = volumeIn->getOriginalDimensions();
+    if (subvolNum != -1)
+    {
+        outDims.resize(3);
+    }
+    volumeOut->reinitialize(outDims, volumeIn->getSform(), myDims[4], volumeIn->getType());
+    int64_t startFrame = 0, endFrame = myDims[3];
+    if (subvolNum != -1)
+    {
+        startFrame = subvolNum;
+        endFrame = subvolNum + 1;
+    }
+    for (int64_t c = 0; c < myDims[4]; ++c)
+    {
+        for (int64_t b = startFrame; b < endFrame; ++b)
+        {
+            VolumeSpline mySpline(volumeIn->getFrame(b, c), myDims.data());//deconvolution is parallel internally
+            if (mySpline.ignoredNonNumeric())
+            {
+                CaretLogWarning("ignored non-numeric input value in volume '" + volumeIn->getFileName() + "', frame #" + AString::number(b + 1));
+            }
+            volumeOut->setFrame(mySpline.getCoefficients(), b - startFrame, c);
+            volumeOut->setMapName(b - startFrame, volumeIn->getMapName(b));
+        }
+    }
+}
+
+float AlgorithmVolumeSplinePrefilter::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmVolumeSplinePrefilter::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
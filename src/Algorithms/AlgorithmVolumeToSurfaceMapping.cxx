@@ -33,12 +33,179 @@
 #include "AlgorithmSurfaceToSurface3dDistance.h"
 #include "AlgorithmCreateSignedDistanceVolume.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    void mapFrame(const VolumeFile* myVolume, const SurfaceFile* mySurface, const VolumeFile::InterpType& myMethod, const int64_t& brick, const int64_t& component,
+                  const bool& inputPrefiltered, float* valuesOut)
+    {
+        int64_t numNodes = mySurface->getNumberOfNodes();
+        if (myMethod == VolumeFile::CUBIC)
+        {
+            myVolume->validateSpline(brick, component, inputPrefiltered);//to do spline deconvolution in parallel
+            const float* coordData = mySurface->getCoordinateData();
+            const int64_t CHUNK_SIZE = 1024;
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t chunkStart = 0; chunkStart < numNodes; chunkStart += CHUNK_SIZE)
+            {//spline evaluation is done in groups of points, and the coordinates are already in the right layout
+                myVolume->interpolateValuesCubic(coordData + chunkStart * 3, valuesOut + chunkStart, min(CHUNK_SIZE, numNodes - chunkStart), brick, component);
+            }
+            myVolume->freeSpline(brick, component);//release memory we no longer need, if we allocated it
+        } else {
+#pragma omp CARET_PARFOR
+            for (int64_t node = 0; node < numNodes; ++node)
+            {
+                valuesOut[node] = myVolume->interpolateValue(mySurface->getCoordinate(node), myMethod, NULL, brick, component);
+            }
+        }
+    }
+
+    ///vertex to voxel weights flattened into one array, with voxels as indices within a frame, so that a block of frames can be mapped in one pass over the weights
+    struct SparseWeights
+    {
+        vector<int64_t> m_rowStart;//weights of vertex i are [m_rowStart[i], m_rowStart[i + 1])
+        vector<int64_t> m_voxelIndex;
+        vector<float> m_weight;
+        SparseWeights(const vector<vector<VoxelWeight> >& myWeights, const VolumeSpace& volSpace)
+        {
+            int64_t numNodes = (int64_t)myWeights.size();
+            m_rowStart.resize(numNodes + 1);
+            m_rowStart[0] = 0;
+            for (int64_t node = 0; node < numNodes; ++node)
+            {
+                m_rowStart[node + 1] = m_rowStart[node] + (int64_t)myWeights[node].size();
+            }
+            m_voxelIndex.resize(m_rowStart[numNodes]);
+            m_weight.resize(m_rowStart[numNodes]);
+            for (int64_t node = 0; node < numNodes; ++node)
+            {
+                int64_t base = m_rowStart[node];
+                int numVoxels = (int)myWeights[node].size();
+                for (int voxel = 0; voxel < numVoxels; ++voxel)
+                {
+                    const VoxelWeight& thisWeight = myWeights[node][voxel];
+                    m_voxelIndex[base + voxel] = volSpace.getIndex(thisWeight.ijk[0], thisWeight.ijk[1], thisWeight.ijk[2]);
+                    m_weight[base + voxel] = thisWeight.weight;
+                }
+            }
+        }
+    };
+    
+    ///maps every requested brick/component pair to the metric column of the same position, a block of frames at a time
+    ///normalize divides by the total weight of each vertex (ribbon), otherwise the weights must already sum to 1 (myelin style)
+    void mapFramesWeighted(const SparseWeights& weights, const VolumeFile* myVolume, const vector<int64_t>& bricks, const vector<int64_t>& components,
+                           const bool& normalize, MetricFile* myMetricOut)
+    {
+        const int FRAME_BLOCK = 16;//enough to reuse each weight many times, while keeping a vertex's accumulators in registers
+        int64_t numNodes = (int64_t)weights.m_rowStart.size() - 1;
+        int64_t numColumns = (int64_t)bricks.size();
+        CaretAssert((int64_t)components.size() == numColumns);
+        vector<float> blockOut(numNodes * FRAME_BLOCK);
+        for (int64_t blockStart = 0; blockStart < numColumns; blockStart += FRAME_BLOCK)
+        {
+            int blockSize = (int)min((int64_t)FRAME_BLOCK, numColumns - blockStart);
+            const float* frames[FRAME_BLOCK];
+            for (int f = 0; f < blockSize; ++f)
+            {
+                frames[f] = myVolume->getFrame(bricks[blockStart + f], components[blockStart + f]);//no copying, the frames are already in memory
+            }
+#pragma omp CARET_PARFOR schedule(dynamic, 256)
+            for (int64_t node = 0; node < numNodes; ++node)
+            {
+                const int64_t rowEnd = weights.m_rowStart[node + 1];
+                if (normalize)
+                {//accumulate the same way the per-frame loop did, so results don't change
+                    float accum[FRAME_BLOCK];
+                    float totalWeight = 0.0f;
+                    for (int f = 0; f < blockSize; ++f) accum[f] = 0.0f;
+                    for (int64_t w = weights.m_rowStart[node]; w < rowEnd; ++w)
+                    {
+                        const float thisWeight = weights.m_weight[w];
+                        const int64_t voxIndex = weights.m_voxelIndex[w];
+                        totalWeight += thisWeight;
+                        for (int f = 0; f < blockSize; ++f)
+                        {
+                            accum[f] += thisWeight * frames[f][voxIndex];
+                        }
+                    }
+                    for (int f = 0; f < blockSize; ++f)
+                    {
+                        blockOut[f * numNodes + node] = (totalWeight != 0.0f ? accum[f] / totalWeight : 0.0f);
+                    }
+                } else {
+                    double accum[FRAME_BLOCK];
+                    for (int f = 0; f < blockSize; ++f) accum[f] = 0.0;
+                    for (int64_t w = weights.m_rowStart[node]; w < rowEnd; ++w)
+                    {
+                        const float thisWeight = weights.m_weight[w];
+                        const int64_t voxIndex = weights.m_voxelIndex[w];
+                        for (int f = 0; f < blockSize; ++f)
+                        {
+                            accum[f] += thisWeight * frames[f][voxIndex];
+                        }
+                    }
+                    for (int f = 0; f < blockSize; ++f)
+                    {
+                        blockOut[f * numNodes + node] = accum[f];
+                    }
+                }
+            }
+            for (int f = 0; f < blockSize; ++f)
+            {
+                myMetricOut->setValuesForColumn(blockStart + f, blockOut.data() + f * numNodes);
+            }
+        }
+    }
+    
+    ///names the output columns and maps every selected frame with normalized ribbon weights
+    void mapFramesRibbon(const vector<vector<VoxelWeight> >& myWeights, const VolumeFile* myVolume, const int64_t& mySubVol, MetricFile* myMetricOut)
+    {
+        vector<int64_t> myVolDims;
+        myVolume->getDimensions(myVolDims);
+        vector<int64_t> bricks, components;//in output column order
+        if (mySubVol == -1)
+        {
+            for (int64_t i = 0; i < myVolDims[3]; ++i)
+            {
+                for (int64_t j = 0; j < myVolDims[4]; ++j)
+                {
+                    int64_t thisCol = i * myVolDims[4] + j;
+                    AString metricLabel = myVolume->getMapName(i);
+                    if (myVolDims[4] != 1)
+                    {
+                        metricLabel += " component " + AString::number(j);
+                    }
+                    metricLabel += " ribbon constrained";
+                    myMetricOut->setColumnName(thisCol, metricLabel);
+                    bricks.push_back(i);
+                    components.push_back(j);
+                }
+            }
+        } else {
+            for (int64_t j = 0; j < myVolDims[4]; ++j)
+            {
+                AString metricLabel = myVolume->getMapName(mySubVol);
+                if (myVolDims[4] != 1)
+                {
+                    metricLabel += " component " + AString::number(j);
+                }
+                metricLabel += " ribbon constrained";
+                int64_t thisCol = j;
+                myMetricOut->setColumnName(thisCol, metricLabel);
+                bricks.push_back(mySubVol);
+                components.push_back(j);
+            }
+        }
+        mapFramesWeighted(SparseWeights(myWeights, myVolume->getVolumeSpace()), myVolume, bricks, components, true, myMetricOut);
+    }
+}
+
 AString AlgorithmVolumeToSurfaceMapping::getCommandSwitch()
 {
     return "-volume-to-surface-mapping";
@@ -62,7 +229,8 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     
     ret->createOptionalParameter(5, "-enclosing", "use value of the enclosing voxel");
     
-    ret->createOptionalParameter(8, "-cubic", "use cubic splines");
+    OptionalParameter* cubicOpt = ret->createOptionalParameter(8, "-cubic", "use cubic splines");
+    cubicOpt->createOptionalParameter(1, "-prefiltered", "the input volume contains cubic spline coefficients, from -volume-spline-prefilter");
     
     OptionalParameter* ribbonOpt = ret->createOptionalParameter(6, "-ribbon-constrained", "use ribbon constrained mapping algorithm");
     ribbonOpt->addSurfaceParameter(1, "inner-surf", "the inner surface of the ribbon");
@@ -72,6 +240,7 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     OptionalParameter* ribbonSubdiv = ribbonOpt->createOptionalParameter(4, "-voxel-subdiv", "voxel divisions while estimating voxel weights");
     ribbonSubdiv->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3");
     ribbonOpt->createOptionalParameter(7, "-thin-columns", "use non-overlapping polyhedra");
+    ribbonOpt->createOptionalParameter(9, "-exact-overlap", "compute the exact volume of intersection instead of subdividing voxels");
     OptionalParameter* gaussianOpt = ribbonOpt->createOptionalParameter(8, "-gaussian", "reduce weight to voxels that aren't near <surface>");
     gaussianOpt->addDoubleParameter(1, "scale", "value to multiply the local thickness by, to get the gaussian sigma");
     OptionalParameter* ribbonWeights = ribbonOpt->createOptionalParameter(5, "-output-weights", "write the voxel weights for a vertex to a volume file");
@@ -79,6 +248,11 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     ribbonWeights->addVolumeOutputParameter(2, "weights-out", "volume to write the weights to");
     OptionalParameter* ribbonWeightsText = ribbonOpt->createOptionalParameter(6, "-output-weights-text", "write the voxel weights for all vertices to a text file");
     ribbonWeightsText->addStringParameter(1, "text-out", "output - the output text filename");//fake the output formatting
+    OptionalParameter* ribbonOperatorOut = ribbonOpt->createOptionalParameter(10, "-output-operator", "save the voxel weights of all vertices, for use with -operator");
+    ribbonOperatorOut->addStringParameter(1, "operator-out", "output - the operator filename");//fake the output formatting
+    
+    OptionalParameter* operatorOpt = ret->createOptionalParameter(10, "-operator", "use ribbon constrained weights saved by -output-operator");
+    operatorOpt->addStringParameter(1, "operator-file", "the operator file, computed for the volume space of <volume> and a surface with the vertex count of <surface>");
     
     OptionalParameter* myelinStyleOpt = ret->createOptionalParameter(9, "-myelin-style", "use the method from myelin mapping");
     myelinStyleOpt->addVolumeParameter(1, "ribbon-roi", "an roi volume of the cortical ribbon for this hemisphere");
@@ -100,7 +274,10 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
         "voxels that don't have a positive value in the mask.  The subdivision number specifies how it approximates the amount of the volume the polyhedron " +
         "intersects, by splitting each voxel into NxNxN pieces, and checking whether the center of each piece is inside the polyhedron.  If you have very large " +
         "voxels, consider increasing this if you get zeros in your output.  " +
-        "The -gaussian option makes it act more like the myelin method, where the distance of a voxel from <surface> is used to downweight the voxel.\n\n" +
+        "If -exact-overlap is specified, the intersection volume of each polyhedron with each voxel is computed analytically instead, and -voxel-subdiv is ignored.  " +
+        "The -gaussian option makes it act more like the myelin method, where the distance of a voxel from <surface> is used to downweight the voxel.  " +
+        "The -output-operator option saves the final voxel weights, so that later runs on other volumes in the same volume space can use -operator instead of " +
+        "-ribbon-constrained and skip computing them.\n\n" +
         "The myelin style method uses part of the caret5 myelin mapping command to do the mapping: for each surface vertex, take all voxels that are in a cylinder " +
         "with radius and height equal to cortical thickness, centered on the vertex and aligned with the surface normal, and that are also within the ribbon ROI, " +
         "and apply a gaussian kernel with the specified sigma to them to get the weights to use.  " +
@@ -120,6 +297,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
     OptionalParameter* cubicOpt = myParams->getOptionalParameter(8);
     OptionalParameter* ribbonOpt = myParams->getOptionalParameter(6);
     OptionalParameter* myelinStyleOpt = myParams->getOptionalParameter(9);
+    OptionalParameter* operatorOpt = myParams->getOptionalParameter(10);
     int64_t mySubVol = -1;
     OptionalParameter* subvolumeSelect = myParams->getOptionalParameter(7);
     if (subvolumeSelect->m_present)
@@ -177,6 +355,15 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
         haveMethod = true;
         myMethod = MYELIN_STYLE;
     }
+    if (operatorOpt->m_present)
+    {
+        if (haveMethod)
+        {
+            throw AlgorithmException("more than one mapping method specified");
+        }
+        haveMethod = true;
+        myMethod = RIBBON_OPERATOR;
+    }
     if (!haveMethod)
     {
         throw AlgorithmException("no mapping method specified");
@@ -186,7 +373,8 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
         case TRILINEAR:
         case ENCLOSING_VOXEL:
         case CUBIC:
-            AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, volInterpMethod, mySubVol);//because we have separate constructors
+            AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, volInterpMethod, mySubVol,
+                                            myMethod == CUBIC && cubicOpt->getOptionalParameter(1)->m_present);//because we have separate constructors
             break;
         case RIBBON_CONSTRAINED:
         {
@@ -209,6 +397,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                 }
             }
             bool thinColumns = ribbonOpt->getOptionalParameter(7)->m_present;
+            bool exactOverlap = ribbonOpt->getOptionalParameter(9)->m_present;
             float gaussScale = -1.0f;
             OptionalParameter* gaussianOpt = ribbonOpt->getOptionalParameter(8);
             if (gaussianOpt->m_present)
@@ -224,8 +413,15 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                 weightsOutVertex = (int)ribbonWeights->getInteger(1);
                 weightsOut = ribbonWeights->getOutputVolume(2);
             }
+            OptionalParameter* ribbonOperatorOut = ribbonOpt->getOptionalParameter(10);
+            vector<vector<VoxelWeight> > operatorWeights;
             AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, innerSurf, outerSurf, myRoiVol, subdivisions, thinColumns,
-                                            mySubVol, gaussScale, weightsOutVertex, weightsOut);
+                                            mySubVol, gaussScale, weightsOutVertex, weightsOut, exactOverlap,
+                                            (ribbonOperatorOut->m_present ? &operatorWeights : NULL));
+            if (ribbonOperatorOut->m_present)
+            {
+                RibbonMappingHelper::writeOperator(ribbonOperatorOut->getString(1), operatorWeights, myVolume->getVolumeSpace());
+            }
             OptionalParameter* ribbonWeightsText = ribbonOpt->getOptionalParameter(6);
             if (ribbonWeightsText->m_present)
             {//do this after the algorithm, to let it do the error condition checking
@@ -234,7 +430,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
                 vector<vector<VoxelWeight> > myWeights;
                 const float* roiFrame = NULL;
                 if (myRoiVol != NULL) roiFrame = myRoiVol->getFrame();
-                AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, subdivisions, thinColumns, mySurface, gaussScale);
+                AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, subdivisions, thinColumns, exactOverlap, mySurface, gaussScale);
                 for (int i = 0; i < (int)myWeights.size(); ++i)
                 {
                     outFile << i << ", " << myWeights[i].size();
@@ -260,6 +456,14 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
             AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, roi, thickness, sigma, mySubVol, oldCutoffBug);
             break;
         }
+        case RIBBON_OPERATOR:
+        {
+            vector<vector<VoxelWeight> > myWeights;
+            VolumeSpace weightsSpace;
+            RibbonMappingHelper::readOperator(operatorOpt->getString(1), myWeights, weightsSpace);
+            AlgorithmVolumeToSurfaceMapping(myProgObj, myVolume, mySurface, myMetricOut, myWeights, weightsSpace, mySubVol);
+            break;
+        }
         default:
             throw AlgorithmException("this method not yet implemented");
     }
@@ -267,9 +471,10 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
 
 //interpolation mapping
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
-                                                                 const VolumeFile::InterpType& myMethod, const int64_t& mySubVol) : AbstractAlgorithm(myProgObj)
+                                                                 const VolumeFile::InterpType& myMethod, const int64_t& mySubVol, const bool& inputPrefiltered) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
+    if (inputPrefiltered && myMethod != VolumeFile::CUBIC) throw AlgorithmException("prefiltered input can only be used with cubic interpolation");
     vector<int64_t> myVolDims;
     myVolume->getDimensions(myVolDims);
     if (mySubVol >= myVolDims[3] || mySubVol < -1)
@@ -306,10 +511,6 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
         {
             for (int64_t j = 0; j < myVolDims[4]; ++j)
             {
-                if (myMethod == VolumeFile::CUBIC)
-                {
-                    myVolume->validateSpline(i, j);//to do spline deconvolution in parallel
-                }
                 AString metricLabel = myVolume->getMapName(i);
                 if (myVolDims[4] != 1)
                 {
@@ -318,25 +519,13 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
                 metricLabel += methodName;
                 int64_t thisCol = i * myVolDims[4] + j;
                 myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    myArray[node] = myVolume->interpolateValue(mySurface->getCoordinate(node), myMethod, NULL, i, j);
-                }
-                if (myMethod == VolumeFile::CUBIC)
-                {
-                    myVolume->freeSpline(i, j);//release memory we no longer need, if we allocated it
-                }
+                mapFrame(myVolume, mySurface, myMethod, i, j, inputPrefiltered, myArray.data());
                 myMetricOut->setValuesForColumn(thisCol, myArray.data());
             }
         }
     } else {
         for (int64_t j = 0; j < myVolDims[4]; ++j)
         {
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                myVolume->validateSpline(mySubVol, j);//to do spline deconvolution in parallel
-            }
             AString metricLabel = myVolume->getMapName(mySubVol);
             if (myVolDims[4] != 1)
             {
@@ -345,15 +534,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
             metricLabel += methodName;
             int64_t thisCol = j;
             myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                myArray[node] = myVolume->interpolateValue(mySurface->getCoordinate(node), myMethod, NULL, mySubVol, j);
-            }
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                myVolume->freeSpline(mySubVol, j);//release memory we no longer need, if we allocated it
-            }
+            mapFrame(myVolume, mySurface, myMethod, mySubVol, j, inputPrefiltered, myArray.data());
             myMetricOut->setValuesForColumn(thisCol, myArray.data());
         }
     }
@@ -363,7 +544,8 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
 AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                                                  const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const VolumeFile* roiVol,
                                                                  const int32_t& subdivisions, const bool& thinColumns, const int64_t& mySubVol, const float& gaussScale,
-                                                                 const int& weightsOutVertex, VolumeFile* weightsOut) : AbstractAlgorithm(myProgObj)
+                                                                 const int& weightsOutVertex, VolumeFile* weightsOut, const bool& exactOverlap,
+                                                                 vector<vector<VoxelWeight> >* ribbonWeightsOut) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
     vector<int64_t> myVolDims;
@@ -400,7 +582,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
     vector<vector<VoxelWeight> > myWeights;
     const float* roiFrame = NULL;
     if (roiVol != NULL) roiFrame = roiVol->getFrame();
-    precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, subdivisions, thinColumns, mySurface, gaussScale);
+    precomputeWeightsRibbon(myWeights, myVolume->getVolumeSpace(), innerSurf, outerSurf, roiFrame, subdivisions, thinColumns, exactOverlap, mySurface, gaussScale);
     if (weightsOut != NULL)
     {
         weightsOut->setValueAllVoxels(0.0f);
@@ -411,84 +593,52 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
             weightsOut->setValue(vertexWeights[i].weight, vertexWeights[i].ijk);
         }
     }
-    CaretArray<float> myScratchArray(numNodes);
-    float* myScratch = myScratchArray.getArray();
+    mapFramesRibbon(myWeights, myVolume, mySubVol, myMetricOut);
+    if (ribbonWeightsOut != NULL)
+    {
+        ribbonWeightsOut->swap(myWeights);
+    }
+}
+
+//ribbon mapping with weights from a ribbon operator file
+AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
+                                                                 const vector<vector<VoxelWeight> >& precomputedWeights, const VolumeSpace& weightsSpace,
+                                                                 const int64_t& mySubVol) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    vector<int64_t> myVolDims;
+    myVolume->getDimensions(myVolDims);
+    if (mySubVol >= myVolDims[3] || mySubVol < -1)
+    {
+        throw AlgorithmException("invalid subvolume specified");
+    }
+    if (!myVolume->getVolumeSpace().matches(weightsSpace))
+    {
+        throw AlgorithmException("ribbon mapping operator was computed for a different volume space than the input volume");
+    }
+    int64_t numNodes = mySurface->getNumberOfNodes();
+    if ((int64_t)precomputedWeights.size() != numNodes)
+    {
+        throw AlgorithmException("ribbon mapping operator has different number of vertices than the surface");
+    }
+    int64_t numColumns;
     if (mySubVol == -1)
     {
-        for (int64_t i = 0; i < myVolDims[3]; ++i)
-        {
-            for (int64_t j = 0; j < myVolDims[4]; ++j)
-            {
-                int64_t thisCol = i * myVolDims[4] + j;
-                AString metricLabel = myVolume->getMapName(i);
-                if (myVolDims[4] != 1)
-                {
-                    metricLabel += " component " + AString::number(j);
-                }
-                metricLabel += " ribbon constrained";
-                myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, i, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                    }
-                }
-                myMetricOut->setValuesForColumn(thisCol, myScratch);
-            }
-        }
+        numColumns = myVolDims[3] * myVolDims[4];
     } else {
-        for (int64_t j = 0; j < myVolDims[4]; ++j)
-        {
-            AString metricLabel = myVolume->getMapName(mySubVol);
-            if (myVolDims[4] != 1)
-            {
-                metricLabel += " component " + AString::number(j);
-            }
-            metricLabel += " ribbon constrained";
-            int64_t thisCol = j;
-            myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                    myScratch[node] = 0.0f;
-                    float totalWeight = 0.0f;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        float thisWeight = myWeights[node][voxel].weight;
-                        totalWeight += thisWeight;
-                        myScratch[node] += thisWeight * myVolume->getValue(myWeights[node][voxel].ijk, mySubVol, j);
-                    }
-                    if (totalWeight != 0.0f)
-                    {
-                        myScratch[node] /= totalWeight;
-                    } else {
-                        myScratch[node] = 0.0f;
-                    }
-            }
-            myMetricOut->setValuesForColumn(thisCol, myScratch);
-        }
+        numColumns = myVolDims[4];
     }
+    myMetricOut->setNumberOfNodesAndColumns(numNodes, numColumns);
+    myMetricOut->setStructure(mySurface->getStructure());
+    mapFramesRibbon(precomputedWeights, myVolume, mySubVol, myMetricOut);
 }
 
 void AlgorithmVolumeToSurfaceMapping::precomputeWeightsRibbon(vector<vector<VoxelWeight> >& myWeights, const VolumeSpace& volSpace,
                                                               const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const float* roiFrame,
-                                                              const int& subdivisions, const bool& thinColumns, const SurfaceFile* gaussSurf, const float& gaussScale)
+                                                              const int& subdivisions, const bool& thinColumns, const bool& exactOverlap,
+                                                              const SurfaceFile* gaussSurf, const float& gaussScale)
 {
-    RibbonMappingHelper::computeWeightsRibbon(myWeights, volSpace, innerSurf, outerSurf, roiFrame, subdivisions, thinColumns);
+    RibbonMappingHelper::computeWeightsRibbon(myWeights, volSpace, innerSurf, outerSurf, roiFrame, subdivisions, thinColumns, exactOverlap);
     if (gaussScale > 0.0f)
     {
         VolumeFile signedDistVol;
@@ -542,7 +692,7 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
     myMetricOut->setStructure(mySurface->getStructure());
     vector<vector<VoxelWeight> > myWeights;
     precomputeWeightsMyelin(myWeights, mySurface, roiVol, thickness, sigma, oldCutoffBug);
-    vector<float> myScratch(numNodes);
+    vector<int64_t> bricks, components;//in output column order
     if (mySubVol == -1)
     {
         for (int64_t i = 0; i < myVolDims[3]; ++i)
@@ -557,18 +707,8 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
                 }
                 metricLabel += " myelin style";
                 myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-                for (int64_t node = 0; node < numNodes; ++node)
-                {
-                    double accum = 0.0;
-                    int numVoxels = (int)myWeights[node].size();
-                    for (int voxel = 0; voxel < numVoxels; ++voxel)
-                    {
-                        accum += myWeights[node][voxel].weight * myVolume->getValue(myWeights[node][voxel].ijk, i, j);//weights have already been normalized in precompute, for this method
-                    }
-                    myScratch[node] = accum;
-                }
-                myMetricOut->setValuesForColumn(thisCol, myScratch.data());
+                bricks.push_back(i);
+                components.push_back(j);
             }
         }
     } else {
@@ -582,20 +722,11 @@ AlgorithmVolumeToSurfaceMapping::AlgorithmVolumeToSurfaceMapping(ProgressObject*
             metricLabel += " myelin style";
             int64_t thisCol = j;
             myMetricOut->setColumnName(thisCol, metricLabel);
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t node = 0; node < numNodes; ++node)
-            {
-                double accum = 0.0;
-                int numVoxels = (int)myWeights[node].size();
-                for (int voxel = 0; voxel < numVoxels; ++voxel)
-                {
-                    accum += myWeights[node][voxel].weight * myVolume->getValue(myWeights[node][voxel].ijk, mySubVol, j);//weights have already been normalized in precompute, for this method
-                }
-                myScratch[node] = accum;
-            }
-            myMetricOut->setValuesForColumn(thisCol, myScratch.data());
+            bricks.push_back(mySubVol);
+            components.push_back(j);
         }
     }
+    mapFramesWeighted(SparseWeights(myWeights, myVolume->getVolumeSpace()), myVolume, bricks, components, false, myMetricOut);//weights have already been normalized in precompute, for this method
 }
 
 void AlgorithmVolumeToSurfaceMapping::precomputeWeightsMyelin(vector<vector<VoxelWeight> >& myWeights, const SurfaceFile* mySurface, const VolumeFile* roiVol,
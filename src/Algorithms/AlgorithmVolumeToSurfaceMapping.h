@@ -37,26 +37,31 @@ namespace caret {
         static void precomputeWeightsMyelin(std::vector<std::vector<VoxelWeight> >& myWeights, const SurfaceFile* mySurface, const VolumeFile* roiVol,
                                             const MetricFile* thickness, const float& sigma, const bool& oldCutoffBug);
         static void precomputeWeightsRibbon(std::vector<std::vector<VoxelWeight> >& myWeights, const VolumeSpace& volSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
-                                            const float* roiFrame, const int& subdivisions, const bool& thinColumns, const SurfaceFile* gaussSurf, const float& gaussScale);
+                                            const float* roiFrame, const int& subdivisions, const bool& thinColumns, const bool& exactOverlap,
+                                            const SurfaceFile* gaussSurf, const float& gaussScale);
         enum Method
         {
             TRILINEAR,
             ENCLOSING_VOXEL,
             RIBBON_CONSTRAINED,
             CUBIC,
-            MYELIN_STYLE
+            MYELIN_STYLE,
+            RIBBON_OPERATOR
         };
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
     public:
         AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut, const VolumeFile::InterpType& myMethod,
-                                        const int64_t& mySubVol = -1);
+                                        const int64_t& mySubVol = -1, const bool& inputPrefiltered = false);
         AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                         const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
                                         const VolumeFile* roiVol = NULL, const int32_t& subdivisions = 3, const bool& thinColumns = false,
                                         const int64_t& mySubVol = -1, const float& gaussScale = -1.0f,
-                                        const int& weightsOutVertex = -1, VolumeFile* weightsOut = NULL);
+                                        const int& weightsOutVertex = -1, VolumeFile* weightsOut = NULL, const bool& exactOverlap = false,
+                                        std::vector<std::vector<VoxelWeight> >* ribbonWeightsOut = NULL);
+        AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
+                                        const std::vector<std::vector<VoxelWeight> >& precomputedWeights, const VolumeSpace& weightsSpace, const int64_t& mySubVol = -1);
         AlgorithmVolumeToSurfaceMapping(ProgressObject* myProgObj, const VolumeFile* myVolume, const SurfaceFile* mySurface, MetricFile* myMetricOut,
                                         const VolumeFile* roiVol, const MetricFile* thickness, const float& sigma, const int64_t& mySubVol = -1, const bool& oldCutoffBug = false);
         static OperationParameters* getParameters();
@@ -56,9 +56,13 @@ OperationParameters* AlgorithmVolumeWarpfieldResample::getParameters()
     OptionalParameter* fnirtOpt = ret->createOptionalParameter(6, "-fnirt", "MUST be used if using a fnirt warpfield");
     fnirtOpt->addStringParameter(1, "source-volume", "the source volume used when generating the warpfield");
     
+    ret->createOptionalParameter(7, "-prefiltered", "the input volume contains cubic spline coefficients");
+    
     ret->setHelpText(
         AString("Resample a volume file with a warpfield.  ") +
         "The recommended methods are CUBIC (cubic spline) for most data, and ENCLOSING_VOXEL for label data.  "
+        "If you will resample the same volume several times with CUBIC, you can compute the spline coefficients once with -volume-spline-prefilter, " +
+        "and use that output as the input here with -prefiltered.  "
         "The parameter <method> must be one of:\n\n" +
         "CUBIC\nENCLOSING_VOXEL\nTRILINEAR"
     );
@@ -73,6 +77,7 @@ void AlgorithmVolumeWarpfieldResample::useParameters(OperationParameters* myPara
     AString method = myParams->getString(4);
     VolumeFile* outVol = myParams->getOutputVolume(5);
     OptionalParameter* fnirtOpt = myParams->getOptionalParameter(6);
+    bool inputPrefiltered = myParams->getOptionalParameter(7)->m_present;
     WarpfieldFile myWarpfield;
     if (fnirtOpt->m_present)
     {
@@ -95,13 +100,15 @@ void AlgorithmVolumeWarpfieldResample::useParameters(OperationParameters* myPara
     refSpaceIO.openRead(refSpaceName);
     vector<int64_t> refDims = refSpaceIO.getDimensions();
     if (refDims.size() < 3) refDims.resize(3, 1);
-    AlgorithmVolumeWarpfieldResample(myProgObj, inVol, myWarpfield.getWarpfield(), refDims.data(), refSpaceIO.getHeader().getSForm(), myMethod, outVol);
+    AlgorithmVolumeWarpfieldResample(myProgObj, inVol, myWarpfield.getWarpfield(), refDims.data(), refSpaceIO.getHeader().getSForm(), myMethod, outVol, inputPrefiltered);
 }
 
 AlgorithmVolumeWarpfieldResample::AlgorithmVolumeWarpfieldResample(ProgressObject* myProgObj, const VolumeFile* inVol, const VolumeFile* warpfield,
-                                                                   const int64_t refDims[3], const vector<vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol) : AbstractAlgorithm(myProgObj)
+                                                                   const int64_t refDims[3], const vector<vector<float> >& refSform, const VolumeFile::InterpType& myMethod, VolumeFile* outVol,
+                                                                   const bool& inputPrefiltered) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
+    if (inputPrefiltered && myMethod != VolumeFile::CUBIC) throw AlgorithmException("prefiltered input can only be used with cubic resampling");
     vector<int64_t> warpDims;
     warpfield->getDimensions(warpDims);
     if (warpDims[3] != 3 || warpDims[4] != 1) throw AlgorithmException("provided warpfield volume has wrong number of subvolumes or components");
@@ -133,35 +140,66 @@ AlgorithmVolumeWarpfieldResample::AlgorithmVolumeWarpfieldResample(ProgressObjec
         {
             if (myMethod == VolumeFile::CUBIC)
             {
-                inVol->validateSpline(b, c);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
-            }
+                inVol->validateSpline(b, c, inputPrefiltered);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
 #pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t k = 0; k < outDims[2]; ++k)
-            {
-                for (int64_t j = 0; j < outDims[1]; ++j)
+                for (int64_t k = 0; k < outDims[2]; ++k)
                 {
-                    for (int64_t i = 0; i < outDims[0]; ++i)
+                    vector<float> rowCoords(outDims[0] * 3), rowValues(outDims[0]);
+                    vector<char> rowValid(outDims[0]);
+                    for (int64_t j = 0; j < outDims[1]; ++j)
                     {
-                        Vector3D outCoord, inCoord, displacement;
-                        outVol->indexToSpace(i, j, k, outCoord);
-                        bool validDisplacement = false;
-                        displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
-                        if (validDisplacement)
+                        for (int64_t i = 0; i < outDims[0]; ++i)
+                        {
+                            Vector3D outCoord, displacement;
+                            outVol->indexToSpace(i, j, k, outCoord);
+                            bool validDisplacement = false;
+                            displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
+                            rowValid[i] = validDisplacement;
+                            if (validDisplacement)
+                            {
+                                displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
+                                displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
+                            } else {
+                                displacement = Vector3D();//sample somewhere harmless, the value gets replaced
+                            }
+                            Vector3D inCoord = outCoord + displacement;
+                            rowCoords[i * 3] = inCoord[0];
+                            rowCoords[i * 3 + 1] = inCoord[1];
+                            rowCoords[i * 3 + 2] = inCoord[2];
+                        }
+                        inVol->interpolateValuesCubic(rowCoords.data(), rowValues.data(), outDims[0], b, c);//a whole row at a time, to evaluate splines in groups
+                        for (int64_t i = 0; i < outDims[0]; ++i)
                         {
-                            displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
-                            displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
-                            inCoord = outCoord + displacement;
-                            float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
-                            outVol->setValue(interpVal, i, j, k, b, c);
-                        } else {
-                            outVol->setValue(VolumeFile::INVALID_INTERP_VALUE, i, j, k, b, c);
+                            outVol->setValue(rowValid[i] ? rowValues[i] : VolumeFile::INVALID_INTERP_VALUE, i, j, k, b, c);
                         }
                     }
                 }
-            }
-            if (myMethod == VolumeFile::CUBIC)
-            {
                 inVol->freeSpline(b, c);//release memory we no longer need, if we allocated it
+            } else {
+#pragma omp CARET_PARFOR schedule(dynamic)
+                for (int64_t k = 0; k < outDims[2]; ++k)
+                {
+                    for (int64_t j = 0; j < outDims[1]; ++j)
+                    {
+                        for (int64_t i = 0; i < outDims[0]; ++i)
+                        {
+                            Vector3D outCoord, inCoord, displacement;
+                            outVol->indexToSpace(i, j, k, outCoord);
+                            bool validDisplacement = false;
+                            displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
+                            if (validDisplacement)
+                            {
+                                displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
+                                displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
+                                inCoord = outCoord + displacement;
+                                float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
+                                outVol->setValue(interpVal, i, j, k, b, c);
+                            } else {
+                                outVol->setValue(VolumeFile::INVALID_INTERP_VALUE, i, j, k, b, c);
+                            }
+                        }
+                    }
+                }
             }
         }
     }
@@ -53,6 +53,7 @@
 #include "EventBrowserTabGet.h"
 #include "EventManager.h"
 #include "EventOpenGLObjectToWindowTransform.h"
+#include "FrameProfiler.h"
 #include "GraphicsEngineDataOpenGL.h"
 #include "GraphicsPrimitiveV3f.h"
 #include "GraphicsPrimitiveV3fC4f.h"
@@ -481,6 +482,8 @@ BrainOpenGLAnnotationDrawingFixedPipeline::drawModelSpaceAnnotationsOnVolumeSlic
                                                                                   const Plane& plane,
                                                                                   const float sliceThickness)
 {
+    FrameProfiler::Scope profileScope("drawAnnotations");
+    
     CaretAssert(inputs);
     m_inputs = inputs;
     m_surfaceViewScaling = 1.0f;
@@ -527,6 +530,8 @@ BrainOpenGLAnnotationDrawingFixedPipeline::drawAnnotations(Inputs* inputs,
                                                            const Surface* surfaceDisplayed,
                                                            const float surfaceViewScaling)
 {
+    FrameProfiler::Scope profileScope("drawAnnotations");
+    
     CaretAssert(inputs);
     m_inputs = inputs;
     m_surfaceViewScaling = surfaceViewScaling;
@@ -38,6 +38,7 @@
 #include "AnnotationColorBar.h"
 #include "AnnotationManager.h"
 #include "AnnotationPointSizeText.h"
+#include "ApplicationInformation.h"
 #include "Border.h"
 #include "BorderFile.h"
 #include "Brain.h"
@@ -47,6 +48,7 @@
 #include "BrainOpenGLPrimitiveDrawing.h"
 #include "BrainOpenGLVolumeObliqueSliceDrawing.h"
 #include "BrainOpenGLVolumeSliceDrawing.h"
+#include "BrainOpenGLVolumeSliceTextureCache.h"
 #include "BrainOpenGLShapeCone.h"
 #include "BrainOpenGLShapeCube.h"
 #include "BrainOpenGLShapeCylinder.h"
@@ -96,10 +98,12 @@
 #include "FiberTrajectoryMapProperties.h"
 #include "FociFile.h"
 #include "Focus.h"
+#include "FrameProfiler.h"
 #include "GapsAndMargins.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GraphicsEngineDataOpenGL.h"
+#include "GraphicsOpenGLSurfaceBuffers.h"
 #include "GraphicsPrimitiveV3fC4ub.h"
 #include "GraphicsPrimitiveV3f.h"
 #include "GraphicsShape.h"
@@ -138,7 +142,9 @@
 #include "PaletteScalarAndColor.h"
 #include "Plane.h"
 #include "SessionManager.h"
+#include "SignedDistanceHelper.h"
 #include "Surface.h"
+#include "SurfaceLevelsOfDetail.h"
 #include "SurfaceMontageViewport.h"
 #include "SurfaceNodeColoring.h"
 #include "SurfaceProjectedItem.h"
@@ -170,6 +176,7 @@ BrainOpenGLFixedPipeline::BrainOpenGLFixedPipeline(BrainOpenGLTextRenderInterfac
     this->initializeMembersBrainOpenGL();
     this->colorIdentification   = new IdentificationWithColor();
     m_annotationDrawing.grabNew(new BrainOpenGLAnnotationDrawingFixedPipeline(this));
+    m_volumeSliceTextureCache.grabNew(new BrainOpenGLVolumeSliceTextureCache());
     
     m_shapeSphere = NULL;
     m_shapeCone   = NULL;
@@ -540,6 +547,44 @@ void
 BrainOpenGLFixedPipeline::drawModelsImplementation(const int32_t windowIndex,
                                                    Brain* brain,
                                      const std::vector<const BrainOpenGLViewportContent*>& viewportContents)
+{
+    {
+        FrameProfiler::Frame profileFrame;
+        FrameProfiler::Scope profileScope("drawModels");
+        drawModelsAndAnnotations(windowIndex,
+                                 brain,
+                                 viewportContents);
+    }
+    
+    /*
+     * Timings overlay is drawn after the frame ends so that
+     * its text is not included in the timings.  It is only
+     * drawn when requested from the Develop menu and never
+     * when profiling images from the command line.
+     */
+    if (DeveloperFlagsEnum::isFlag(DeveloperFlagsEnum::DEVELOPER_FLAG_FRAME_PROFILER)
+        && ( ! viewportContents.empty())) {
+        int windowViewport[4];
+        viewportContents[0]->getWindowViewport(windowViewport);
+        drawFrameProfilerTimings(windowViewport);
+        this->checkForOpenGLError(NULL, "After drawing frame profiler timings");
+    }
+}
+
+/**
+ * Draw models and annotations in their respective viewports.
+ *
+ * @param windowIndex
+ *    Index of window for drawing
+ * @param brain
+ *    The brain (must be valid!)
+ * @param viewportContents
+ *    Viewport info for drawing.
+ */
+void
+BrainOpenGLFixedPipeline::drawModelsAndAnnotations(const int32_t windowIndex,
+                                                   Brain* brain,
+                                                   const std::vector<const BrainOpenGLViewportContent*>& viewportContents)
 {
     m_brain = brain;
     m_windowIndex = windowIndex;
@@ -825,6 +870,76 @@ BrainOpenGLFixedPipeline::drawTabHighlighting(const float width,
     }
 }
 
+/**
+ * Draw the frame profiler's timings of the frame just drawn in
+ * the top left corner of the window.
+ *
+ * @param windowViewport
+ *    Viewport (x, y, w, h).
+ */
+void
+BrainOpenGLFixedPipeline::drawFrameProfilerTimings(const int windowViewport[4])
+{
+    const std::vector<AString> timingLines = FrameProfiler::get()->getLastFrameTimings();
+    if (timingLines.empty()) {
+        return;
+    }
+    
+    glViewport(windowViewport[0],
+               windowViewport[1],
+               windowViewport[2],
+               windowViewport[3]);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, windowViewport[2], 0.0, windowViewport[3], -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    
+    AnnotationPointSizeText annotationText(AnnotationAttributesDefaultTypeEnum::NORMAL);
+    annotationText.setHorizontalAlignment(AnnotationTextAlignHorizontalEnum::LEFT);
+    annotationText.setVerticalAlignment(AnnotationTextAlignVerticalEnum::TOP);
+    annotationText.setFontPointSize(AnnotationTextFontPointSizeEnum::SIZE10);
+    annotationText.setTextColor(CaretColorEnum::CUSTOM);
+    annotationText.setCustomTextColor(m_foregroundColorFloat);
+    annotationText.setBackgroundColor(CaretColorEnum::CUSTOM);
+    annotationText.setCustomBackgroundColor(m_backgroundColorFloat);
+    
+    double lineHeight = 14.0;
+    if (getTextRenderer() != NULL) {
+        annotationText.setText("Xy");
+        double textWidth = 0.0;
+        double textHeight = 0.0;
+        getTextRenderer()->getTextWidthHeightInPixels(annotationText,
+                                                      BrainOpenGLTextRenderInterface::DrawingFlags(),
+                                                      windowViewport[2],
+                                                      windowViewport[3],
+                                                      textWidth,
+                                                      textHeight);
+        if (textHeight > 0.0) {
+            lineHeight = textHeight * 1.2;
+        }
+    }
+    
+    double y = windowViewport[3] - 5.0;
+    for (const auto& line : timingLines) {
+        if (y < lineHeight) {
+            break;
+        }
+        annotationText.setText(line);
+        drawTextAtViewportCoords(5.0,
+                                 y,
+                                 annotationText);
+        y -= lineHeight;
+    }
+    
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
 /**
  * Draw the chart coordinate space annotations.
  *
@@ -900,6 +1015,8 @@ BrainOpenGLFixedPipeline::drawChartCoordinateSpaceAnnotations(const BrainOpenGLV
 void
 BrainOpenGLFixedPipeline::drawSpacerAnnotations(const BrainOpenGLViewportContent* tabContent)
 {
+    FrameProfiler::Scope profileScope("drawSpacerAnnotations");
+    
     if (tabContent->getSpacerTabContent() == NULL) {
         return;
     }
@@ -958,6 +1075,8 @@ BrainOpenGLFixedPipeline::drawSpacerAnnotations(const BrainOpenGLViewportContent
 void
 BrainOpenGLFixedPipeline::drawTabAnnotations(const BrainOpenGLViewportContent* tabContent)
 {
+    FrameProfiler::Scope profileScope("drawTabAnnotations");
+    
     if (tabContent->getBrowserTabContent() == NULL) {
         return;
     }
@@ -1012,6 +1131,8 @@ BrainOpenGLFixedPipeline::drawTabAnnotations(const BrainOpenGLViewportContent* t
 void
 BrainOpenGLFixedPipeline::drawWindowAnnotations(const int windowViewport[4])
 {
+    FrameProfiler::Scope profileScope("drawWindowAnnotations");
+    
     CaretAssertMessage(m_brain, "m_brain must NOT be NULL for drawing window annotations.");
     
     /*
@@ -1077,6 +1198,8 @@ void
 BrainOpenGLFixedPipeline::drawModelInternal(Mode mode,
                                const BrainOpenGLViewportContent* viewportContent)
 {
+    FrameProfiler::Scope profileScope((mode == MODE_IDENTIFICATION) ? "identification" : "drawModel");
+    
     ElapsedTimer et;
     et.start();
     
@@ -1918,6 +2041,8 @@ BrainOpenGLFixedPipeline::drawSurface(Surface* surface,
                                       const float* nodeColoringRGBA,
                                       const bool drawAnnotationsInModelSpaceFlag)
 {
+    FrameProfiler::Scope profileScope("drawSurface");
+    
     const DisplayPropertiesSurface* dps = m_brain->getDisplayPropertiesSurface();
     
     glMatrixMode(GL_MODELVIEW);
@@ -1946,7 +2071,8 @@ BrainOpenGLFixedPipeline::drawSurface(Surface* surface,
                     glEnable(GL_POLYGON_OFFSET_FILL);
                     disableLighting();
                     this->drawSurfaceTrianglesWithVertexArrays(surface,
-                                                               NULL);
+                                                               NULL,
+                                                               false);
                     glDisable(GL_POLYGON_OFFSET_FILL);
                     
                     /*
@@ -1956,7 +2082,8 @@ BrainOpenGLFixedPipeline::drawSurface(Surface* surface,
                     setLineWidth(dps->getLinkSize());
                     glPolygonMode(GL_FRONT, GL_LINE);
                     this->drawSurfaceTrianglesWithVertexArrays(surface,
-                                                               nodeColoringRGBA);
+                                                               nodeColoringRGBA,
+                                                               false);
                     glPolygonMode(GL_FRONT, GL_FILL);
                     break;
                 case SurfaceDrawingTypeEnum::DRAW_AS_NODES:
@@ -1982,8 +2109,14 @@ BrainOpenGLFixedPipeline::drawSurface(Surface* surface,
                         glPolygonOffset(factor, units);
                     }
 
+                    /*
+                     * Images made by commands are always full resolution
+                     * so they do not depend upon when simplification finishes
+                     */
                     this->drawSurfaceTrianglesWithVertexArrays(surface,
-                                                               nodeColoringRGBA);
+                                                               nodeColoringRGBA,
+                                                               (ApplicationInformation::getApplicationType()
+                                                                == ApplicationTypeEnum::APPLICATION_TYPE_GRAPHICAL_USER_INTERFACE));
                     
                     if (borderAboveSurfaceOffset != 0.0) {
                         glDisable(GL_POLYGON_OFFSET_FILL);
@@ -2154,30 +2287,14 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             break;
     }
     
-    if (isSelect) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    }
-    
-    uint8_t rgba[4];
-    
-    glBegin(GL_TRIANGLES);
-    for (int32_t i = 0; i < numTriangles; i++) {
-        const int32_t i3 = i * 3;
-        const int32_t n1 = triangles[i3];
-        const int32_t n2 = triangles[i3+1];
-        const int32_t n3 = triangles[i3+2];
-        
-        if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
-        }
-        else {
+    if ( ! isSelect) {
+        glBegin(GL_TRIANGLES);
+        for (int32_t i = 0; i < numTriangles; i++) {
+            const int32_t i3 = i * 3;
+            const int32_t n1 = triangles[i3];
+            const int32_t n2 = triangles[i3+1];
+            const int32_t n3 = triangles[i3+2];
+            
             glColor4fv(&nodeColoringRGBA[n1*4]);
             glNormal3fv(&normals[n1*3]);
             glVertex3fv(&coordinates[n1*3]);
@@ -2188,17 +2305,19 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             glNormal3fv(&normals[n3*3]);
             glVertex3fv(&coordinates[n3*3]);
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
+        /*
+         * Find the triangle under the mouse by casting a ray through
+         * the surface instead of drawing triangles in identification colors
+         */
         int32_t triangleIndex = -1;
         float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         triangleIndex,
-                                         depth);
+        this->getSurfaceTriangleUnderMouse(surface,
+                                           triangleIndex,
+                                           depth);
         
         
         if (triangleIndex >= 0) {
@@ -2411,6 +2530,128 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
     }
 }
 
+/**
+ * Find the surface triangle under the mouse by intersecting the line through
+ * the mouse position, from the near to the far clipping plane, with the
+ * surface's triangles.  The current OpenGL transformations are used so the
+ * result matches the triangle that would be drawn at the mouse position,
+ * including the effect of clipping planes and back-face culling.
+ *
+ * @param surface
+ *    Surface that is searched.
+ * @param triangleIndexOut
+ *    Output with index of triangle or -1 if no triangle is under the mouse.
+ * @param depthOut
+ *    Output with screen depth, in the range of the depth buffer, of the
+ *    point on the triangle under the mouse.
+ */
+void
+BrainOpenGLFixedPipeline::getSurfaceTriangleUnderMouse(const Surface* surface,
+                                                       int32_t& triangleIndexOut,
+                                                       float& depthOut)
+{
+    triangleIndexOut = -1;
+    depthOut = -1.0;
+    
+    GLdouble modelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelviewMatrix);
+    GLdouble projectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    double nearXYZ[3];
+    double farXYZ[3];
+    if ( ! gluUnProject(this->mouseX, this->mouseY, 0.0,
+                        modelviewMatrix, projectionMatrix, viewport,
+                        &nearXYZ[0], &nearXYZ[1], &nearXYZ[2])) {
+        return;
+    }
+    if ( ! gluUnProject(this->mouseX, this->mouseY, 1.0,
+                        modelviewMatrix, projectionMatrix, viewport,
+                        &farXYZ[0], &farXYZ[1], &farXYZ[2])) {
+        return;
+    }
+    const float startXYZ[3] = {
+        (float)nearXYZ[0],
+        (float)nearXYZ[1],
+        (float)nearXYZ[2]
+    };
+    const float directionXYZ[3] = {
+        (float)(farXYZ[0] - nearXYZ[0]),
+        (float)(farXYZ[1] - nearXYZ[1]),
+        (float)(farXYZ[2] - nearXYZ[2])
+    };
+    
+    std::vector<SignedDistanceHelper::SegmentHit> hits;
+    surface->getSignedDistanceHelper()->segmentHits(startXYZ,
+                                                    directionXYZ,
+                                                    hits);
+    
+    const StructureEnum::Enum structure = surface->getStructure();
+    const bool clippingFlag = m_clippingPlaneGroup->isSurfaceSelected();
+    const bool cullingFlag = (glIsEnabled(GL_CULL_FACE) == GL_TRUE);
+    GLint cullFace = GL_BACK;
+    glGetIntegerv(GL_CULL_FACE_MODE, &cullFace);
+    GLint frontFace = GL_CCW;
+    glGetIntegerv(GL_FRONT_FACE, &frontFace);
+    
+    const int32_t numHits = static_cast<int32_t>(hits.size());
+    for (int32_t iHit = 0; iHit < numHits; iHit++) {
+        const SignedDistanceHelper::SegmentHit& hit = hits[iHit];
+        const float hitXYZ[3] = {
+            startXYZ[0] + hit.distance * directionXYZ[0],
+            startXYZ[1] + hit.distance * directionXYZ[1],
+            startXYZ[2] + hit.distance * directionXYZ[2]
+        };
+        if (clippingFlag) {
+            if ( ! isCoordinateInsideClippingPlanesForStructure(structure, hitXYZ)) {
+                continue;
+            }
+        }
+        
+        if (cullingFlag) {
+            /*
+             * Facing is decided by the winding of the triangle on the screen,
+             * as in OpenGL, so mirroring transformations are handled
+             */
+            const int32_t* triangleNodes = surface->getTriangle(hit.triangle);
+            double windowXYZ[3][3];
+            bool projectedFlag = true;
+            for (int32_t k = 0; k < 3; k++) {
+                const float* xyz = surface->getCoordinate(triangleNodes[k]);
+                if ( ! gluProject(xyz[0], xyz[1], xyz[2],
+                                  modelviewMatrix, projectionMatrix, viewport,
+                                  &windowXYZ[k][0], &windowXYZ[k][1], &windowXYZ[k][2])) {
+                    projectedFlag = false;
+                }
+            }
+            if (projectedFlag) {
+                const double signedArea = ((windowXYZ[1][0] - windowXYZ[0][0]) * (windowXYZ[2][1] - windowXYZ[0][1])
+                                           - (windowXYZ[2][0] - windowXYZ[0][0]) * (windowXYZ[1][1] - windowXYZ[0][1]));
+                const bool frontFacingFlag = ((frontFace == GL_CCW) ? (signedArea > 0.0) : (signedArea < 0.0));
+                if (cullFace == GL_FRONT_AND_BACK) {
+                    continue;
+                }
+                if (frontFacingFlag == (cullFace == GL_FRONT)) {
+                    continue;
+                }
+            }
+        }
+        
+        double windowX = 0.0;
+        double windowY = 0.0;
+        double windowZ = 0.0;
+        if (gluProject(hitXYZ[0], hitXYZ[1], hitXYZ[2],
+                       modelviewMatrix, projectionMatrix, viewport,
+                       &windowX, &windowY, &windowZ)) {
+            triangleIndexOut = hit.triangle;
+            depthOut = windowZ;
+            return;
+        }
+    }
+}
+
 /**
  * During projection mode, set the projected data.  If the 
  * projection data is already set, it will be overridden
@@ -2549,17 +2790,138 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
 }
 
 
+/**
+ * Get the level of detail for drawing a surface with the current
+ * transformations and viewport.  The level has about as many triangles
+ * as pixels in the screen area covered by the surface's bounding box,
+ * since drawing more triangles does not change the image.
+ *
+ * @param surface
+ *    Surface that is drawn.
+ * @param levelsOfDetail
+ *    The surface's levels of detail.
+ * @return
+ *    Index of the level or negative to draw at full resolution.
+ */
+int32_t
+BrainOpenGLFixedPipeline::getSurfaceLevelOfDetailIndex(const Surface* surface,
+                                                       const SurfaceLevelsOfDetail* levelsOfDetail)
+{
+    CaretAssert(levelsOfDetail);
+    if (levelsOfDetail->getNumberOfLevels() <= 0) {
+        return -1;
+    }
+    
+    GLdouble modelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelviewMatrix);
+    GLdouble projectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    const BoundingBox* boundingBox = surface->getBoundingBox();
+    const float* minXYZ = boundingBox->getMinXYZ();
+    const float* maxXYZ = boundingBox->getMaxXYZ();
+    
+    double minWindowXY[2] = {  std::numeric_limits<double>::max(),  std::numeric_limits<double>::max() };
+    double maxWindowXY[2] = { -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+    for (int32_t iCorner = 0; iCorner < 8; iCorner++) {
+        const double x = ((iCorner & 1) ? maxXYZ[0] : minXYZ[0]);
+        const double y = ((iCorner & 2) ? maxXYZ[1] : minXYZ[1]);
+        const double z = ((iCorner & 4) ? maxXYZ[2] : minXYZ[2]);
+        double windowXYZ[3];
+        if ( ! gluProject(x, y, z,
+                          modelviewMatrix, projectionMatrix, viewport,
+                          &windowXYZ[0], &windowXYZ[1], &windowXYZ[2])) {
+            return -1;
+        }
+        for (int32_t i = 0; i < 2; i++) {
+            minWindowXY[i] = std::min(minWindowXY[i], windowXYZ[i]);
+            maxWindowXY[i] = std::max(maxWindowXY[i], windowXYZ[i]);
+        }
+    }
+    
+    const double numberOfPixels = ((maxWindowXY[0] - minWindowXY[0])
+                                   * (maxWindowXY[1] - minWindowXY[1]));
+    if (numberOfPixels >= std::numeric_limits<int32_t>::max()) {
+        return -1;
+    }
+    
+    return levelsOfDetail->getLevelForNumberOfTriangles(static_cast<int32_t>(numberOfPixels));
+}
+
 /**
  * Draw a surface triangles with vertex arrays.
+ * When buffer objects are supported, the arrays are kept in the surface's
+ * buffers and client memory is used only if they cannot be created.
  * @param surface
  *    Surface that is drawn.
  * @param nodeColoringRGBA
  *    RGBA coloring for the nodes.
+ * @param levelOfDetailFlag
+ *    If true, draw the surface's simplified triangles when the surface
+ *    is small on the screen.
  */
 void 
 BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
-                                                               const float* nodeColoringRGBA)
+                                                               const float* nodeColoringRGBA,
+                                                               const bool levelOfDetailFlag)
 {
+    const int32_t* triangles = surface->getTriangle(0);
+    int32_t numTriangles = surface->getNumberOfTriangles();
+    
+    const SurfaceLevelsOfDetail* levelsOfDetail = NULL;
+    int32_t levelIndex = -1;
+    if (levelOfDetailFlag) {
+        levelsOfDetail = surface->getLevelsOfDetail();
+        if (levelsOfDetail != NULL) {
+            levelIndex = getSurfaceLevelOfDetailIndex(surface,
+                                                      levelsOfDetail);
+            if (levelIndex >= 0) {
+                triangles    = levelsOfDetail->getLevelTriangles(levelIndex);
+                numTriangles = levelsOfDetail->getLevelNumberOfTriangles(levelIndex);
+            }
+        }
+    }
+    
+    /*
+     * Keep the surface in buffer objects so that only a changed
+     * coloring is sent to the graphics card when the view changes
+     */
+    if (isVertexBuffersSupported()) {
+        GraphicsOpenGLSurfaceBuffers* surfaceBuffers = surface->getGraphicsOpenGLSurfaceBuffers();
+        if (surfaceBuffers->loadGeometry(getContextSharingGroupPointer(),
+                                         surface->getGeometryModificationCount(),
+                                         surface->getCoordinate(0),
+                                         surface->getNormalVector(0),
+                                         surface->getNumberOfNodes(),
+                                         surface->getTriangle(0),
+                                         surface->getNumberOfTriangles())) {
+            bool colorsValid = true;
+            if (nodeColoringRGBA != NULL) {
+                colorsValid = surfaceBuffers->loadColors(nodeColoringRGBA,
+                                                         surface->getNodeColoringModificationCount());
+            }
+            else {
+                glColor3fv(m_backgroundColorFloat);
+            }
+            if (levelIndex >= 0) {
+                if ( ! surfaceBuffers->loadLevelOfDetailTriangles(levelIndex,
+                                                                  triangles,
+                                                                  numTriangles)) {
+                    levelIndex   = -1;
+                    triangles    = surface->getTriangle(0);
+                    numTriangles = surface->getNumberOfTriangles();
+                }
+            }
+            if (colorsValid) {
+                surfaceBuffers->drawTriangles(nodeColoringRGBA,
+                                              levelIndex);
+                return;
+            }
+        }
+    }
+    
     glEnableClientState(GL_VERTEX_ARRAY);
     if (nodeColoringRGBA != NULL) {
         glEnableClientState(GL_COLOR_ARRAY);
@@ -2582,11 +2944,10 @@ BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* su
                     0, 
                     reinterpret_cast<const GLvoid*>(surface->getNormalVector(0)));
     
-    const int numTriangles = surface->getNumberOfTriangles();
     glDrawElements(GL_TRIANGLES, 
                    (3 * numTriangles), 
                    GL_UNSIGNED_INT,
-                   reinterpret_cast<const GLvoid*>(surface->getTriangle(0)));
+                   reinterpret_cast<const GLvoid*>(triangles));
     
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_COLOR_ARRAY);
@@ -3752,6 +4113,8 @@ BrainOpenGLFixedPipeline::drawVolumeModel(BrowserTabContent* browserTabContent,
                                   ModelVolume* volumeModel,
                                   const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawVolumeModel");
+    
     /*
      * Determine volumes that are to be drawn
      */
@@ -5098,6 +5461,8 @@ BrainOpenGLFixedPipeline::drawSurfaceMontageModel(BrowserTabContent* browserTabC
                                                   ModelSurfaceMontage* surfaceMontageModel,
                                                   const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawSurfaceMontageModel");
+    
     const int32_t tabIndex = browserTabContent->getTabNumber();
     
     std::vector<SurfaceMontageViewport*> montageViewports;
@@ -5192,6 +5557,8 @@ BrainOpenGLFixedPipeline::drawWholeBrainModel(BrowserTabContent* browserTabConte
                                       ModelWholeBrain* wholeBrainModel,
                                       const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawWholeBrainModel");
+    
     const int32_t tabNumberIndex = browserTabContent->getTabNumber();
     
     Surface* leftSurface = wholeBrainModel->getSelectedSurface(StructureEnum::CORTEX_LEFT,
@@ -5435,6 +5802,8 @@ BrainOpenGLFixedPipeline::drawChartOneData(BrowserTabContent* browserTabContent,
                     ModelChart* chartModel,
                     const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawChartOneData");
+    
     
     CaretAssert(browserTabContent);
     CaretAssert(chartModel);
@@ -5525,6 +5894,8 @@ BrainOpenGLFixedPipeline::drawChartTwoData(const BrainOpenGLViewportContent* vie
                                            ModelChartTwo* chartModel,
                                            const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawChartTwoData");
+    
     
     CaretAssert(browserTabContent);
     CaretAssert(chartModel);
@@ -53,6 +53,7 @@ namespace caret {
     class BrainOpenGLShapeRing;
     class BrainOpenGLShapeSphere;
     class BrainOpenGLViewportContent;
+    class BrainOpenGLVolumeSliceTextureCache;
     class BrowserTabContent;
     class CaretMappableDataFile;
     class ClippingPlaneGroup;
@@ -75,6 +76,7 @@ namespace caret {
     class Palette;
     class PaletteColorMapping;
     class SurfaceFile;
+    class SurfaceLevelsOfDetail;
     class SurfaceMontageConfigurationCerebellar;
     class SurfaceMontageConfigurationCerebral;
     class SurfaceMontageConfigurationFlatMaps;
@@ -205,11 +207,19 @@ namespace caret {
                               const float* nodeColoringRGBA);
         
         void drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
-                                                  const float* nodeColoringRGBA);
+                                                  const float* nodeColoringRGBA,
+                                                  const bool levelOfDetailFlag);
+        
+        int32_t getSurfaceLevelOfDetailIndex(const Surface* surface,
+                                             const SurfaceLevelsOfDetail* levelsOfDetail);
         
         void drawSurfaceTriangles(Surface* surface,
                                   const float* nodeColoringRGBA);
         
+        void getSurfaceTriangleUnderMouse(const Surface* surface,
+                                          int32_t& triangleIndexOut,
+                                          float& depthOut);
+        
         void drawSurfaceNodeAttributes(Surface* surface);
         
         void drawSurfaceBorderBeingDrawn(const Surface* surface);
@@ -510,6 +520,12 @@ namespace caret {
                                  const float height,
                                  const float rgb[3]);
         
+        void drawModelsAndAnnotations(const int32_t windowIndex,
+                                      Brain* brain,
+                                      const std::vector<const BrainOpenGLViewportContent*>& viewportContents);
+        
+        void drawFrameProfilerTimings(const int windowViewport[4]);
+        
         /** Index of window */
         int32_t m_windowIndex = -1;
         
@@ -598,6 +614,9 @@ namespace caret {
         
         CaretPointer<BrainOpenGLAnnotationDrawingFixedPipeline> m_annotationDrawing;
         
+        /** Textures of orthogonal volume slices, kept between frames */
+        CaretPointer<BrainOpenGLVolumeSliceTextureCache> m_volumeSliceTextureCache;
+        
         std::vector<AnnotationColorBar*> m_annotationColorBarsForDrawing;
         
         /** Some graphics using annotations for some elements so user can select and edit them */
@@ -45,6 +45,7 @@
 #include "ElapsedTimer.h"
 #include "FociFile.h"
 #include "Focus.h"
+#include "FrameProfiler.h"
 #include "GapsAndMargins.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
@@ -125,6 +126,8 @@ BrainOpenGLVolumeObliqueSliceDrawing::draw(BrainOpenGLFixedPipeline* fixedPipeli
                                            const VolumeSliceInterpolationEdgeEffectsMaskingEnum::Enum obliqueSliceMaskingType,
                                            const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawVolumeSlices");
+    
     CaretAssert(sliceProjectionType == VolumeSliceProjectionTypeEnum::VOLUME_SLICE_PROJECTION_OBLIQUE);
     
     if (volumeDrawInfo.empty()) {
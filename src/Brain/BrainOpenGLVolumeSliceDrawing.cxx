@@ -33,6 +33,7 @@
 #include "BrainOpenGLAnnotationDrawingFixedPipeline.h"
 #include "BrainOpenGLPrimitiveDrawing.h"
 #include "BrainOpenGLViewportContent.h"
+#include "BrainOpenGLVolumeSliceTextureCache.h"
 #include "BrainordinateRegionOfInterest.h"
 #include "BrowserTabContent.h"
 #include "CaretAssert.h"
@@ -46,10 +47,12 @@
 #include "ElapsedTimer.h"
 #include "FociFile.h"
 #include "Focus.h"
+#include "FrameProfiler.h"
 #include "GapsAndMargins.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GraphicsEngineDataOpenGL.h"
+#include "GraphicsOpenGLTextureName.h"
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsUtilitiesOpenGL.h"
 #include "GroupAndNameHierarchyModel.h"
@@ -126,6 +129,8 @@ BrainOpenGLVolumeSliceDrawing::draw(BrainOpenGLFixedPipeline* fixedPipelineDrawi
                                   const VolumeSliceProjectionTypeEnum::Enum sliceProjectionType,
                                   const int32_t viewport[4])
 {
+    FrameProfiler::Scope profileScope("drawVolumeSlices");
+    
     if (volumeDrawInfo.empty()) {
         return;
     }
@@ -3745,6 +3750,25 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
         }
     }
     
+    /*
+     * Except for identification, which needs a color for each voxel,
+     * draw the slice as one quadrilateral textured with the voxel colors.
+     */
+    if ( ! m_identificationModeFlag) {
+        if (drawOrthogonalSliceVoxelsTexture(sliceNormalVector,
+                                             coordinate,
+                                             rowStep,
+                                             columnStep,
+                                             numberOfColumns,
+                                             numberOfRows,
+                                             sliceRGBA,
+                                             volumeInterface,
+                                             mapIndex,
+                                             sliceOpacity)) {
+            return;
+        }
+    }
+    
     /*
      * There are two ways to draw the voxels.
      *
@@ -3820,6 +3844,143 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
     
 }
 
+/**
+ * Draw the voxels in an orthogonal slice as a single quadrilateral
+ * textured with the voxel colors.
+ *
+ * Only one vertex per corner of the slice is sent to OpenGL, instead
+ * of four vertices per voxel, and nearest filtering keeps each voxel
+ * a solid square.  Voxels that are not displayed are given an alpha of
+ * zero and discarded by the alpha test so that, as when drawing quads,
+ * they do not hide voxels in the layers below.  The texture is kept by
+ * the fixed pipeline drawing between frames and is only uploaded again
+ * when the slice's coloring changes.
+ *
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param coordinate
+ *    Coordinate of first voxel in the slice (bottom left as begin viewed)
+ * @param rowStep
+ *    Three-dimensional step to next row.
+ * @param columnStep
+ *    Three-dimensional step to next column.
+ * @param numberOfColumns
+ *    Number of columns in the slice.
+ * @param numberOfRows
+ *    Number of rows in the slice.
+ * @param sliceRGBA
+ *    RGBA coloring for voxels in the slice.
+ * @param volumeInterface
+ *    Volume being drawn.
+ * @param mapIndex
+ *    Selected map in the volume being drawn.
+ * @param sliceOpacity
+ *    Opacity from the overlay.
+ * @return
+ *    True if the slice was drawn, false if a texture could not be
+ *    used and the voxels should be drawn as quads.
+ */
+bool
+BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxelsTexture(const float sliceNormalVector[3],
+                                                                const float coordinate[3],
+                                                                const float rowStep[3],
+                                                                const float columnStep[3],
+                                                                const int64_t numberOfColumns,
+                                                                const int64_t numberOfRows,
+                                                                const std::vector<uint8_t>& sliceRGBA,
+                                                                const VolumeMappableInterface* volumeInterface,
+                                                                const int32_t mapIndex,
+                                                                const uint8_t sliceOpacity)
+{
+    if ((numberOfColumns <= 0)
+        || (numberOfRows <= 0)) {
+        return false;
+    }
+    
+    /*
+     * Texture dimensions must be a power of two prior to OpenGL 2.0
+     */
+    int64_t textureWidth = 1;
+    while (textureWidth < numberOfColumns) {
+        textureWidth *= 2;
+    }
+    int64_t textureHeight = 1;
+    while (textureHeight < numberOfRows) {
+        textureHeight *= 2;
+    }
+    GLint maximumTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+    if ((textureWidth > maximumTextureSize)
+        || (textureHeight > maximumTextureSize)) {
+        return false;
+    }
+    
+    BrainOpenGLVolumeSliceTextureCache* textureCache = m_fixedPipelineDrawing->m_volumeSliceTextureCache;
+    GraphicsOpenGLTextureName* textureName = textureCache->getSliceTexture(m_fixedPipelineDrawing->getContextSharingGroupPointer(),
+                                                                           volumeInterface,
+                                                                           mapIndex,
+                                                                           sliceNormalVector,
+                                                                           coordinate,
+                                                                           numberOfColumns,
+                                                                           numberOfRows,
+                                                                           textureWidth,
+                                                                           textureHeight,
+                                                                           sliceRGBA,
+                                                                           sliceOpacity);
+    if (textureName == NULL) {
+        return false;
+    }
+    
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    glBindTexture(GL_TEXTURE_2D, textureName->getTextureName());
+    
+    /*
+     * Texture colors replace lighting, the same as the unlit voxel colors
+     */
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    
+    const float maxS = static_cast<float>(numberOfColumns) / static_cast<float>(textureWidth);
+    const float maxT = static_cast<float>(numberOfRows) / static_cast<float>(textureHeight);
+    const float bottomRight[3] = {
+        coordinate[0] + (numberOfColumns * columnStep[0]),
+        coordinate[1] + (numberOfColumns * columnStep[1]),
+        coordinate[2] + (numberOfColumns * columnStep[2])
+    };
+    const float topLeft[3] = {
+        coordinate[0] + (numberOfRows * rowStep[0]),
+        coordinate[1] + (numberOfRows * rowStep[1]),
+        coordinate[2] + (numberOfRows * rowStep[2])
+    };
+    const float topRight[3] = {
+        bottomRight[0] + (numberOfRows * rowStep[0]),
+        bottomRight[1] + (numberOfRows * rowStep[1]),
+        bottomRight[2] + (numberOfRows * rowStep[2])
+    };
+    
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0, 0.0);
+    glVertex3fv(coordinate);
+    glTexCoord2f(maxS, 0.0);
+    glVertex3fv(bottomRight);
+    glTexCoord2f(maxS, maxT);
+    glVertex3fv(topRight);
+    glTexCoord2f(0.0, maxT);
+    glVertex3fv(topLeft);
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glPopAttrib();
+    
+    return true;
+}
+
 /**
  * Draw the voxels in an orthogonal slice with single quads.
  *
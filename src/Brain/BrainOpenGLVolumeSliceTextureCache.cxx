@@ -0,0 +1,316 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+#include "BrainOpenGLVolumeSliceTextureCache.h"
+#undef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+
+#include <algorithm>
+#include <cmath>
+
+#include "CaretAssert.h"
+#include "CaretOpenGLInclude.h"
+#include "EventGraphicsOpenGLCreateTextureName.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLTextureName.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::BrainOpenGLVolumeSliceTextureCache
+ * \brief Textures for orthogonal volume slices that persist between frames.
+ * \ingroup Brain
+ *
+ * Each slice drawn as a texture keeps its texture until the slice is
+ * not drawn for a while.  A texture is uploaded again only when the
+ * coloring of its slice differs from the coloring last uploaded, so
+ * redrawing an unchanged slice (rotating, panning, another window
+ * redrawing) does not send the slice to OpenGL again.
+ */
+
+/**
+ * Constructor.
+ */
+BrainOpenGLVolumeSliceTextureCache::BrainOpenGLVolumeSliceTextureCache()
+: CaretObject()
+{
+
+}
+
+/**
+ * Destructor.
+ */
+BrainOpenGLVolumeSliceTextureCache::~BrainOpenGLVolumeSliceTextureCache()
+{
+}
+
+/**
+ * Order slice keys for use in a map.
+ *
+ * @param rhs
+ *    Key compared to this key.
+ * @return
+ *    True if this key is before the other key.
+ */
+bool
+BrainOpenGLVolumeSliceTextureCache::SliceKey::operator<(const SliceKey& rhs) const
+{
+    if (m_openglContextPointer != rhs.m_openglContextPointer) {
+        return (m_openglContextPointer < rhs.m_openglContextPointer);
+    }
+    if (m_volumeInterface != rhs.m_volumeInterface) {
+        return (m_volumeInterface < rhs.m_volumeInterface);
+    }
+    if (m_mapIndex != rhs.m_mapIndex) {
+        return (m_mapIndex < rhs.m_mapIndex);
+    }
+    if (m_sliceAxis != rhs.m_sliceAxis) {
+        return (m_sliceAxis < rhs.m_sliceAxis);
+    }
+    for (int32_t i = 0; i < 3; i++) {
+        if (m_firstVoxelCoordinate[i] != rhs.m_firstVoxelCoordinate[i]) {
+            return (m_firstVoxelCoordinate[i] < rhs.m_firstVoxelCoordinate[i]);
+        }
+    }
+    return false;
+}
+
+/**
+ * Get the texture containing the coloring of a slice.  If the slice
+ * has no texture, one is created, and if the slice's coloring differs
+ * from the coloring in the texture, the texture is updated.
+ *
+ * Must be called while the OpenGL context is current.
+ *
+ * @param openglContextPointer
+ *    Pointer to the OpenGL context (sharing group) that will draw the texture.
+ * @param volumeInterface
+ *    Volume being drawn.
+ * @param mapIndex
+ *    Selected map in the volume being drawn.
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param firstVoxelCoordinate
+ *    Coordinate of first voxel in the slice.
+ * @param numberOfColumns
+ *    Number of columns in the slice.
+ * @param numberOfRows
+ *    Number of rows in the slice.
+ * @param textureWidth
+ *    Width of the texture, at least the number of columns.
+ * @param textureHeight
+ *    Height of the texture, at least the number of rows.
+ * @param sliceRGBA
+ *    RGBA coloring for voxels in the slice.
+ * @param sliceOpacity
+ *    Opacity from the overlay.
+ * @return
+ *    The texture or NULL if a texture could not be created.
+ */
+GraphicsOpenGLTextureName*
+BrainOpenGLVolumeSliceTextureCache::getSliceTexture(void* openglContextPointer,
+                                                    const VolumeMappableInterface* volumeInterface,
+                                                    const int32_t mapIndex,
+                                                    const float sliceNormalVector[3],
+                                                    const float firstVoxelCoordinate[3],
+                                                    const int64_t numberOfColumns,
+                                                    const int64_t numberOfRows,
+                                                    const int64_t textureWidth,
+                                                    const int64_t textureHeight,
+                                                    const std::vector<uint8_t>& sliceRGBA,
+                                                    const uint8_t sliceOpacity)
+{
+    CaretAssert(numberOfColumns <= textureWidth);
+    CaretAssert(numberOfRows <= textureHeight);
+    CaretAssert(static_cast<int64_t>(sliceRGBA.size()) >= (numberOfColumns * numberOfRows * 4));
+
+    SliceKey key;
+    key.m_openglContextPointer = openglContextPointer;
+    key.m_volumeInterface      = volumeInterface;
+    key.m_mapIndex             = mapIndex;
+    key.m_sliceAxis = 0;
+    for (int32_t i = 1; i < 3; i++) {
+        if (std::fabs(sliceNormalVector[i]) > std::fabs(sliceNormalVector[key.m_sliceAxis])) {
+            key.m_sliceAxis = i;
+        }
+    }
+    for (int32_t i = 0; i < 3; i++) {
+        key.m_firstVoxelCoordinate[i] = firstVoxelCoordinate[i];
+    }
+
+    SliceTexture& sliceTexture = m_sliceTextures[key];
+    sliceTexture.m_lastUsed = ++m_useCounter;
+
+    if (sliceTexture.m_textureName == NULL) {
+        EventGraphicsOpenGLCreateTextureName createEvent;
+        EventManager::get()->sendEvent(createEvent.getPointer());
+        sliceTexture.m_textureName.reset(createEvent.getOpenGLTextureName());
+        if (sliceTexture.m_textureName == NULL) {
+            m_sliceTextures.erase(key);
+            return NULL;
+        }
+        sliceTexture.m_textureWidth = 0;
+    }
+
+    /*
+     * The coloring of a slice changes with the palette, thresholding,
+     * label display, or a volume file's data so compare the coloring
+     * with the coloring in the texture.
+     */
+    const int64_t sliceRgbaCount = numberOfColumns * numberOfRows * 4;
+    const bool sameColoringFlag = ((sliceTexture.m_textureWidth == textureWidth)
+                                   && (sliceTexture.m_textureHeight == textureHeight)
+                                   && (sliceTexture.m_numberOfColumns == numberOfColumns)
+                                   && (sliceTexture.m_numberOfRows == numberOfRows)
+                                   && (sliceTexture.m_sliceOpacity == sliceOpacity)
+                                   && std::equal(sliceRGBA.begin(),
+                                                 sliceRGBA.begin() + sliceRgbaCount,
+                                                 sliceTexture.m_sliceRGBA.begin()));
+    if ( ! sameColoringFlag) {
+        sliceTexture.m_numberOfColumns = numberOfColumns;
+        sliceTexture.m_numberOfRows    = numberOfRows;
+        sliceTexture.m_textureWidth    = textureWidth;
+        sliceTexture.m_textureHeight   = textureHeight;
+        sliceTexture.m_sliceOpacity    = sliceOpacity;
+        sliceTexture.m_sliceRGBA.assign(sliceRGBA.begin(),
+                                        sliceRGBA.begin() + sliceRgbaCount);
+        uploadSliceTexture(sliceTexture,
+                           sliceRGBA,
+                           sliceOpacity);
+    }
+
+    GraphicsOpenGLTextureName* textureName = sliceTexture.m_textureName.get();
+
+    removeLeastRecentlyUsedTextures();
+
+    return textureName;
+}
+
+/**
+ * Copy a slice's coloring into the texture image and send it to OpenGL.
+ * The texture image is padded to the texture size and voxels that are
+ * not displayed have zero alpha.
+ *
+ * @param sliceTexture
+ *    Texture and its size.
+ * @param sliceRGBA
+ *    RGBA coloring for voxels in the slice.
+ * @param sliceOpacity
+ *    Opacity from the overlay.
+ */
+void
+BrainOpenGLVolumeSliceTextureCache::uploadSliceTexture(SliceTexture& sliceTexture,
+                                                       const std::vector<uint8_t>& sliceRGBA,
+                                                       const uint8_t sliceOpacity)
+{
+    const int64_t numberOfColumns = sliceTexture.m_numberOfColumns;
+    const int64_t numberOfRows    = sliceTexture.m_numberOfRows;
+    const int64_t textureWidth    = sliceTexture.m_textureWidth;
+    const int64_t textureHeight   = sliceTexture.m_textureHeight;
+
+    m_textureRGBA.assign(textureWidth * textureHeight * 4, 0);
+    for (int64_t jRow = 0; jRow < numberOfRows; jRow++) {
+        for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
+            const int64_t sliceRgbaOffset = (4 * (iCol
+                                                  + (numberOfColumns * jRow)));
+            CaretAssertVectorIndex(sliceRGBA, sliceRgbaOffset + 3);
+            if (sliceRGBA[sliceRgbaOffset + 3] > 0) {
+                const int64_t textureOffset = (4 * (iCol
+                                                    + (textureWidth * jRow)));
+                m_textureRGBA[textureOffset]     = sliceRGBA[sliceRgbaOffset];
+                m_textureRGBA[textureOffset + 1] = sliceRGBA[sliceRgbaOffset + 1];
+                m_textureRGBA[textureOffset + 2] = sliceRGBA[sliceRgbaOffset + 2];
+                m_textureRGBA[textureOffset + 3] = sliceOpacity;
+            }
+        }
+    }
+
+    glPushAttrib(GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, sliceTexture.m_textureName->getTextureName());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RGBA,
+                 textureWidth,
+                 textureHeight,
+                 0,
+                 GL_RGBA,
+                 GL_UNSIGNED_BYTE,
+                 &m_textureRGBA[0]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glPopClientAttrib();
+    glPopAttrib();
+
+    m_numberOfTextureUploads++;
+}
+
+/**
+ * Delete the textures of the least recently drawn slices so that
+ * no more than the maximum number of textures remain.
+ */
+void
+BrainOpenGLVolumeSliceTextureCache::removeLeastRecentlyUsedTextures()
+{
+    while (static_cast<int32_t>(m_sliceTextures.size()) > s_maximumNumberOfTextures) {
+        std::map<SliceKey, SliceTexture>::iterator oldestIter = m_sliceTextures.begin();
+        for (std::map<SliceKey, SliceTexture>::iterator iter = m_sliceTextures.begin();
+             iter != m_sliceTextures.end();
+             iter++) {
+            if (iter->second.m_lastUsed < oldestIter->second.m_lastUsed) {
+                oldestIter = iter;
+            }
+        }
+        m_sliceTextures.erase(oldestIter);
+    }
+}
+
+/**
+ * @return Number of times a slice's coloring has been sent to OpenGL.
+ */
+int64_t
+BrainOpenGLVolumeSliceTextureCache::getNumberOfTextureUploads() const
+{
+    return m_numberOfTextureUploads;
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+BrainOpenGLVolumeSliceTextureCache::toString() const
+{
+    return ("BrainOpenGLVolumeSliceTextureCache: "
+            + AString::number(m_sliceTextures.size())
+            + " textures, "
+            + AString::number(m_numberOfTextureUploads)
+            + " uploads");
+}
+
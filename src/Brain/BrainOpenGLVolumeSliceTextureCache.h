@@ -0,0 +1,132 @@
+#ifndef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
+#define __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CaretObject.h"
+
+namespace caret {
+
+    class GraphicsOpenGLTextureName;
+    class VolumeMappableInterface;
+
+    class BrainOpenGLVolumeSliceTextureCache : public CaretObject {
+
+    public:
+        BrainOpenGLVolumeSliceTextureCache();
+
+        virtual ~BrainOpenGLVolumeSliceTextureCache();
+
+        GraphicsOpenGLTextureName* getSliceTexture(void* openglContextPointer,
+                                                   const VolumeMappableInterface* volumeInterface,
+                                                   const int32_t mapIndex,
+                                                   const float sliceNormalVector[3],
+                                                   const float firstVoxelCoordinate[3],
+                                                   const int64_t numberOfColumns,
+                                                   const int64_t numberOfRows,
+                                                   const int64_t textureWidth,
+                                                   const int64_t textureHeight,
+                                                   const std::vector<uint8_t>& sliceRGBA,
+                                                   const uint8_t sliceOpacity);
+
+        int64_t getNumberOfTextureUploads() const;
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+    private:
+        BrainOpenGLVolumeSliceTextureCache(const BrainOpenGLVolumeSliceTextureCache&);
+
+        BrainOpenGLVolumeSliceTextureCache& operator=(const BrainOpenGLVolumeSliceTextureCache&);
+
+        /**
+         * Identifies a slice: the OpenGL context, the volume and map,
+         * the slice axis, and the coordinate of the slice's first voxel.
+         */
+        class SliceKey {
+        public:
+            bool operator<(const SliceKey& rhs) const;
+
+            void* m_openglContextPointer = NULL;
+
+            const VolumeMappableInterface* m_volumeInterface = NULL;
+
+            int32_t m_mapIndex = -1;
+
+            int32_t m_sliceAxis = -1;
+
+            float m_firstVoxelCoordinate[3];
+        };
+
+        /**
+         * A texture and the coloring that was last uploaded to it
+         */
+        class SliceTexture {
+        public:
+            std::unique_ptr<GraphicsOpenGLTextureName> m_textureName;
+
+            int64_t m_numberOfColumns = 0;
+
+            int64_t m_numberOfRows = 0;
+
+            int64_t m_textureWidth = 0;
+
+            int64_t m_textureHeight = 0;
+
+            std::vector<uint8_t> m_sliceRGBA;
+
+            uint8_t m_sliceOpacity = 0;
+
+            int64_t m_lastUsed = 0;
+        };
+
+        void uploadSliceTexture(SliceTexture& sliceTexture,
+                                const std::vector<uint8_t>& sliceRGBA,
+                                const uint8_t sliceOpacity);
+
+        void removeLeastRecentlyUsedTextures();
+
+        // ADD_NEW_MEMBERS_HERE
+
+        std::map<SliceKey, SliceTexture> m_sliceTextures;
+
+        /** padded texture image, kept to avoid reallocating for each upload */
+        std::vector<uint8_t> m_textureRGBA;
+
+        int64_t m_useCounter = 0;
+
+        int64_t m_numberOfTextureUploads = 0;
+
+        static const int32_t s_maximumNumberOfTextures;
+    };
+
+#ifdef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+    /** Textures of least recently drawn slices are deleted to stay within this count */
+    const int32_t BrainOpenGLVolumeSliceTextureCache::s_maximumNumberOfTextures = 32;
+#endif // __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+
+} // namespace
+#endif  //__BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
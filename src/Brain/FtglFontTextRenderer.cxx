@@ -69,6 +69,7 @@
 #include "FtglFontTextRenderer.h"
 #undef __FTGL_FONT_TEXT_RENDERER_DECLARE__
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -83,10 +84,13 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretOpenGLInclude.h"
+#include "FrameProfiler.h"
+#include "FtglGlyphAtlas.h"
 #include "GraphicsEngineDataOpenGL.h"
 #include "GraphicsOpenGLError.h"
 #include "GraphicsPrimitiveV3f.h"
 #include "GraphicsPrimitiveV3fN3f.h"
+#include "GraphicsPrimitiveV3fT3f.h"
 #include "GraphicsShape.h"
 #include "GraphicsUtilitiesOpenGL.h"
 #include "MathFunctions.h"
@@ -125,16 +129,16 @@ static const bool drawCrosshairsAtFontStartingCoordinate = false;
 FtglFontTextRenderer::FtglFontTextRenderer()
 : BrainOpenGLTextRenderInterface()
 {
-    m_defaultFont = NULL;
+    m_defaultFontData = NULL;
     AnnotationPointSizeText defaultAnnotationText(AnnotationAttributesDefaultTypeEnum::NORMAL);
     defaultAnnotationText.setFontPointSize(AnnotationTextFontPointSizeEnum::SIZE14);
     defaultAnnotationText.setFont(AnnotationTextFontNameEnum::VERA);
     defaultAnnotationText.setItalicStyleEnabled(false);
     defaultAnnotationText.setBoldStyleEnabled(false);
     defaultAnnotationText.setUnderlineStyleEnabled(false);
-    m_defaultFont = getFont(defaultAnnotationText,
-                            FtglFontTypeEnum::TEXTURE,
-                            true);
+    m_defaultFontData = getFontData(defaultAnnotationText,
+                                    FtglFontTypeEnum::TEXTURE,
+                                    true);
     m_depthTestingStatus = DEPTH_TEST_NO;
     BrainOpenGL::getMinMaxLineWidth(m_lineWidthMinimum,
                                     m_lineWidthMaximum);
@@ -153,7 +157,7 @@ FtglFontTextRenderer::~FtglFontTextRenderer()
     m_fontNameToFontMap.clear();
     
     /*
-     * Do not delete "m_defaultFont" since it points to a font
+     * Do not delete "m_defaultFontData" since it points to a font
      * in m_fontNameToFontMap.  Doing so would cause
      * a double delete.
      */
@@ -165,7 +169,7 @@ FtglFontTextRenderer::~FtglFontTextRenderer()
 bool
 FtglFontTextRenderer::isValid() const
 {
-    return (m_defaultFont != NULL);
+    return (m_defaultFontData != NULL);
 }
 
 /*
@@ -181,14 +185,14 @@ FtglFontTextRenderer::isValid() const
  * @param creatingDefaultFontFlag
  *    True if creating the default font.
  * @return
- *    The FTGL font.  If there are errors this value will
- *    be NULL.
+ *    Data containing the FTGL font.  If there are errors this
+ *    value will be NULL.
  */
-FTFont*
-FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
-                              const FtglFontTypeEnum ftglFontType,
-                              const float heightOrWidthForPercentageSizeText,
-                              const bool creatingDefaultFontFlag)
+FtglFontTextRenderer::FontData*
+FtglFontTextRenderer::getFontData(const AnnotationText& annotationText,
+                                  const FtglFontTypeEnum ftglFontType,
+                                  const float heightOrWidthForPercentageSizeText,
+                                  const bool creatingDefaultFontFlag)
 {
     int32_t viewportWidth  = m_viewportWidth;
     int32_t viewportHeight = m_viewportHeight;
@@ -254,7 +258,7 @@ FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
         annotationText.setFontTooSmallWhenLastDrawn(tooSmallFlag
                                                     && tooSmallTextHeightValidFlag);
         
-        return fontData->m_font;
+        return fontData;
     }
     
     /*
@@ -280,7 +284,7 @@ FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
         annotationText.setFontTooSmallWhenLastDrawn(tooSmallFlag
                                                     && tooSmallTextHeightValidFlag);
         
-        return fontData->m_font;
+        return fontData;
     }
     else {
         /*
@@ -313,7 +317,7 @@ FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
      * Failed so use the default font.
      */
     annotationText.setFontTooSmallWhenLastDrawn(false);
-    return m_defaultFont;
+    return m_defaultFontData;
 }
 
 
@@ -328,18 +332,18 @@ FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
  * @param creatingDefaultFontFlag
  *    True if creating the default font.
  * @return
- *    The FTGL font.  If there are errors this value will
- *    be NULL.
+ *    Data containing the FTGL font.  If there are errors this
+ *    value will be NULL.
  */
-FTFont*
-FtglFontTextRenderer::getFont(const AnnotationText& annotationText,
-                              const FtglFontTypeEnum ftglFontType,
-                              const bool creatingDefaultFontFlag)
+FtglFontTextRenderer::FontData*
+FtglFontTextRenderer::getFontData(const AnnotationText& annotationText,
+                                  const FtglFontTypeEnum ftglFontType,
+                                  const bool creatingDefaultFontFlag)
 {
-    return getFont(annotationText,
-                   ftglFontType,
-                   -1.0, // negative indicates invalid height for percentage text
-                   creatingDefaultFontFlag);
+    return getFontData(annotationText,
+                       ftglFontType,
+                       -1.0, // negative indicates invalid height for percentage text
+                       creatingDefaultFontFlag);
 }
 
 /**
@@ -378,10 +382,10 @@ void
 FtglFontTextRenderer::drawTextAtViewportCoordinatesInternal(const AnnotationText& annotationText,
                                                             const TextStringGroup& textStringGroup)
 {
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::TEXTURE,
-                           false);
-    if (! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::TEXTURE,
+                                     false);
+    if (! fontData) {
         return;
     }
 
@@ -481,6 +485,62 @@ FtglFontTextRenderer::drawTextAtViewportCoordinatesInternal(const AnnotationText
     glTranslated(rotationPointXYZ[0], rotationPointXYZ[1], rotationPointXYZ[2]);
     glRotated(rotationAngle, 0.0, 0.0, -1.0);
     
+    /*
+     * All characters are drawn in one call using the glyph atlas.
+     * If the atlas is not available or a character does not fit
+     * in the atlas, FTGL draws the text one character at a time.
+     */
+    FtglGlyphAtlas* glyphAtlas = fontData->getGlyphAtlas();
+    bool glyphAtlasFlag = (glyphAtlas != NULL);
+    std::vector<float> glyphXYZ;
+    std::vector<float> glyphTextureSTR;
+    for (std::vector<TextString*>::const_iterator iter = textStringGroup.m_textStrings.begin();
+         (iter != textStringGroup.m_textStrings.end()) && glyphAtlasFlag;
+         iter++) {
+        const TextString* ts = *iter;
+        
+        double x = ts->m_viewportX;
+        double y = ts->m_viewportY;
+        double z = ts->m_viewportZ;
+        
+        for (std::vector<TextCharacter*>::const_iterator charIter = ts->m_characters.begin();
+             charIter != ts->m_characters.end();
+             charIter++) {
+            const TextCharacter* tc = *charIter;
+            x += tc->m_offsetX;
+            y += tc->m_offsetY;
+            z += tc->m_offsetZ;
+            
+            if ( ! glyphAtlas->addCharacterVertices(tc->m_character,
+                                                    x - rotationPointXYZ[0],
+                                                    y - rotationPointXYZ[1],
+                                                    z - rotationPointXYZ[2],
+                                                    glyphXYZ,
+                                                    glyphTextureSTR)) {
+                glyphAtlasFlag = false;
+                break;
+            }
+        }
+    }
+    if (glyphAtlasFlag
+        && ( ! glyphXYZ.empty())) {
+        GraphicsPrimitiveV3fT3f* glyphPrimitive = glyphAtlas->getPrimitive();
+        glyphPrimitive->replaceVertices(glyphXYZ,
+                                        glyphTextureSTR);
+        
+        /*
+         * Same blending as FTGL texture fonts.  The atlas
+         * texture is modulated by the text color.
+         */
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        applyTextColoring(annotationText);
+        GraphicsEngineDataOpenGL::draw(glyphPrimitive);
+        glPopAttrib();
+    }
+    
+    FTFont* font = fontData->m_font;
     for (std::vector<TextString*>::const_iterator iter = textStringGroup.m_textStrings.begin();
          iter != textStringGroup.m_textStrings.end();
          iter++) {
@@ -500,6 +560,10 @@ FtglFontTextRenderer::drawTextAtViewportCoordinatesInternal(const AnnotationText
             y += tc->m_offsetY;
             z += tc->m_offsetZ;
             
+            if (glyphAtlasFlag) {
+                continue;
+            }
+            
             const double offsetX = x - rotationPointXYZ[0];
             const double offsetY = y - rotationPointXYZ[1];
             const double offsetZ = z - rotationPointXYZ[2];
@@ -780,14 +844,16 @@ FtglFontTextRenderer::drawTextAtViewportCoordsInternal(const DepthTestEnum depth
                                                        const AnnotationText& annotationText,
                                                        const DrawingFlags& flags)
 {
+    FrameProfiler::Scope profileScope("drawText");
+    
     if (annotationText.getText().isEmpty()) {
         return;
     }
     
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::TEXTURE,
-                           false);
-    if ( ! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::TEXTURE,
+                                     false);
+    if ( ! fontData) {
         return;
     }
     
@@ -800,7 +866,7 @@ FtglFontTextRenderer::drawTextAtViewportCoordsInternal(const DepthTestEnum depth
     
     TextStringGroup tsg(annotationText,
                         flags,
-                        font,
+                        fontData,
                         viewportX,
                         viewportY,
                         viewportZ,
@@ -857,10 +923,10 @@ FtglFontTextRenderer::getBoundsForTextAtViewportCoords(const AnnotationText& ann
     m_viewportWidth  = viewportWidth;
     m_viewportHeight = viewportHeight;
     
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::TEXTURE,
-                           false);
-    if ( ! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::TEXTURE,
+                                     false);
+    if ( ! fontData) {
         return;
     }
     
@@ -874,7 +940,7 @@ FtglFontTextRenderer::getBoundsForTextAtViewportCoords(const AnnotationText& ann
     
     TextStringGroup textStringGroup(annotationText,
                                     flags,
-                                    font,
+                                    fontData,
                                     viewportX,
                                     viewportY,
                                     viewportZ,
@@ -974,10 +1040,10 @@ FtglFontTextRenderer::getBoundsWithoutMarginForTextAtViewportCoords(const Annota
     m_viewportWidth  = viewportWidth;
     m_viewportHeight = viewportHeight;
     
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::TEXTURE,
-                           false);
-    if ( ! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::TEXTURE,
+                                     false);
+    if ( ! fontData) {
         return;
     }
     
@@ -991,7 +1057,7 @@ FtglFontTextRenderer::getBoundsWithoutMarginForTextAtViewportCoords(const Annota
     
     TextStringGroup textStringGroup(annotationText,
                                     flags,
-                                    font,
+                                    fontData,
                                     viewportX,
                                     viewportY,
                                     viewportZ,
@@ -1197,6 +1263,8 @@ FtglFontTextRenderer::drawTextAtModelCoordsFacingUser(const double modelX,
                                                       const AnnotationText& annotationText,
                                                       const DrawingFlags& flags)
 {
+    FrameProfiler::Scope profileScope("drawText");
+    
     setViewportHeight();
     
     m_depthTestingStatus = DEPTH_TEST_YES;
@@ -1288,11 +1356,11 @@ FtglFontTextRenderer::getBoundsForTextInModelSpace(const AnnotationText& annotat
     std::fill(topRightOut,    topRightOut + 3,    0.0f);
     std::fill(topLeftOut,     topLeftOut + 3,     0.0f);
     
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::POLYGON,
-                           heightOrWidthForPercentageSizeText,
-                           false);
-    if (! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::POLYGON,
+                                     heightOrWidthForPercentageSizeText,
+                                     false);
+    if (! fontData) {
         return;
     }
     
@@ -1305,7 +1373,7 @@ FtglFontTextRenderer::getBoundsForTextInModelSpace(const AnnotationText& annotat
     
     TextStringGroup textStringGroup(annotationText,
                                     flags,
-                                    font,
+                                    fontData,
                                     0.0,
                                     0.0,
                                     0.0,
@@ -1376,11 +1444,11 @@ FtglFontTextRenderer::drawTextInModelSpace(const AnnotationText& annotationText,
                                            const float* /*normalVector[3]*/,
                                            const DrawingFlags& flags)
 {
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::POLYGON,
-                           heightOrWidthForPercentageSizeText,
-                           false);
-    if (! font) {
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::POLYGON,
+                                     heightOrWidthForPercentageSizeText,
+                                     false);
+    if (! fontData) {
         return;
     }
     
@@ -1409,7 +1477,7 @@ FtglFontTextRenderer::drawTextInModelSpace(const AnnotationText& annotationText,
                                                                                   0.0));
     TextStringGroup tsg(annotationText,
                         flags,
-                        font,
+                        fontData,
                         0.0,
                         0.0,
                         0.0,
@@ -1436,13 +1504,16 @@ FtglFontTextRenderer::drawTextInModelSpaceInternal(const AnnotationText& annotat
                                                    const TextStringGroup& textStringGroup,
                                                    const float heightOrWidthForPercentageSizeText)
 {
-    FTFont* font = getFont(annotationText,
-                           FtglFontTypeEnum::POLYGON,
-                           heightOrWidthForPercentageSizeText,
-                           false);
-    if (! font) {
+    FrameProfiler::Scope profileScope("drawText");
+    
+    FontData* fontData = getFontData(annotationText,
+                                     FtglFontTypeEnum::POLYGON,
+                                     heightOrWidthForPercentageSizeText,
+                                     false);
+    if (! fontData) {
         return;
     }
+    FTFont* font = fontData->m_font;
     
     if (annotationText.getText().isEmpty()) {
         return;
@@ -1739,6 +1810,95 @@ FtglFontTextRenderer::FontData::~FontData()
     }
 }
 
+/**
+ * @return The glyph atlas for drawing this font's text in one
+ * call.  NULL if the font is not a texture font or the atlas
+ * could not be created.
+ */
+FtglGlyphAtlas*
+FtglFontTextRenderer::FontData::getGlyphAtlas()
+{
+    if ( ! m_glyphAtlasCreatedFlag) {
+        m_glyphAtlasCreatedFlag = true;
+        
+        if (m_valid
+            && (m_ftglFontType == FtglFontTypeEnum::TEXTURE)) {
+            m_glyphAtlas.reset(new FtglGlyphAtlas(m_fontData,
+                                                  m_font->FaceSize()));
+            if ( ! m_glyphAtlas->isValid()) {
+                m_glyphAtlas.reset();
+            }
+        }
+    }
+    
+    return m_glyphAtlas.get();
+}
+
+/**
+ * Create a text string.  Layouts of text strings are cached since
+ * getting the bounds and advance of each character from FTGL is
+ * slow and the same text is drawn and measured many times.
+ *
+ * @param textString
+ *     The text string.
+ * @param textDrawingSpace
+ *     Text drawn in space.
+ * @param orientation
+ *     Orientation of the text string.
+ * @param underlineThickness
+ *     Thickness of underline for the text.
+ * @param outlineThickness
+ *     Thickness of outline for the text.
+ * @return
+ *     A new text string at the origin.  Caller must delete it.
+ */
+FtglFontTextRenderer::TextString*
+FtglFontTextRenderer::FontData::newTextString(const QString& textString,
+                                              const TextDrawingSpace textDrawingSpace,
+                                              const AnnotationTextOrientationEnum::Enum orientation,
+                                              const double underlineThickness,
+                                              const double outlineThickness)
+{
+    CaretAssert(m_font);
+    
+    const TextStringKey key(textString,
+                            static_cast<int32_t>(textDrawingSpace),
+                            static_cast<int32_t>(orientation),
+                            underlineThickness,
+                            outlineThickness);
+    
+    auto iter = m_textStringCache.find(key);
+    if (iter == m_textStringCache.end()) {
+        /*
+         * Text such as coordinates changes often so
+         * limit the size of the cache
+         */
+        if (static_cast<int32_t>(m_textStringCache.size()) >= s_maximumNumberOfCachedTextStrings) {
+            m_textStringCache.clear();
+        }
+        
+        std::unique_ptr<TextString> ts(new TextString(textString,
+                                                      textDrawingSpace,
+                                                      orientation,
+                                                      underlineThickness,
+                                                      outlineThickness,
+                                                      m_font));
+        iter = m_textStringCache.insert(std::make_pair(key,
+                                                       std::move(ts))).first;
+    }
+    
+    return new TextString(*iter->second);
+}
+
+/**
+ * @return Number of text string layouts in the cache.
+ */
+int32_t
+FtglFontTextRenderer::FontData::getNumberOfCachedTextStrings() const
+{
+    return static_cast<int32_t>(m_textStringCache.size());
+}
+
 /**
  * @return Name of the text renderer.
  */
@@ -1931,6 +2091,32 @@ m_stringGlyphsMaxY(0.0)
     setGlyphBounds();
 }
 
+/**
+ * Copy constructor.
+ *
+ * @param obj
+ *     Text string that is copied.
+ */
+FtglFontTextRenderer::TextString::TextString(const TextString& obj)
+: m_textDrawingSpace(obj.m_textDrawingSpace),
+m_underlineThickness(obj.m_underlineThickness),
+m_outlineThickness(obj.m_outlineThickness),
+m_viewportX(obj.m_viewportX),
+m_viewportY(obj.m_viewportY),
+m_viewportZ(obj.m_viewportZ),
+m_stringGlyphsMinX(obj.m_stringGlyphsMinX),
+m_stringGlyphsMaxX(obj.m_stringGlyphsMaxX),
+m_stringGlyphsMinY(obj.m_stringGlyphsMinY),
+m_stringGlyphsMaxY(obj.m_stringGlyphsMaxY)
+{
+    m_characters.reserve(obj.m_characters.size());
+    for (std::vector<TextCharacter*>::const_iterator iter = obj.m_characters.begin();
+         iter != obj.m_characters.end();
+         iter++) {
+        m_characters.push_back(new TextCharacter(**iter));
+    }
+}
+
 /**
  * Destructor.
  */
@@ -2185,7 +2371,7 @@ FtglFontTextRenderer::TextString::getTextBoundsInViewportCoordinates(double& vie
  *
  * @param annotationText
  *    The text annotation.
- * @param font
+ * @param fontData
  *    Font used for drawing the annotation.
  * @param viewportX
  *    X-coordinate in the viewport.
@@ -2200,14 +2386,14 @@ FtglFontTextRenderer::TextString::getTextBoundsInViewportCoordinates(double& vie
  */
 FtglFontTextRenderer::TextStringGroup::TextStringGroup(const AnnotationText& annotationText,
                                                        const DrawingFlags& flags,
-                                                       FTFont* font,
+                                                       FontData* fontData,
                                                        const double viewportX,
                                                        const double viewportY,
                                                        const double viewportZ,
                                                        const double rotationAngle,
                                                        const double lineThicknessForViewportHeight)
 : m_annotationText(annotationText),
-m_font(font),
+m_font(fontData->m_font),
 m_viewportX(viewportX),
 m_viewportY(viewportY),
 m_viewportZ(viewportZ),
@@ -2219,7 +2405,7 @@ m_viewportBoundsMinY(0.0),
 m_viewportBoundsMaxY(0.0),
 m_textDrawingSpace(TextDrawingSpace::VIEWPORT)
 {
-    CaretAssert(font);
+    CaretAssert(m_font);
     
     m_textDrawingSpace = TextDrawingSpace::VIEWPORT;
     if (m_annotationText.isInSurfaceSpaceWithTangentOffset()) {
@@ -2240,7 +2426,7 @@ m_textDrawingSpace(TextDrawingSpace::VIEWPORT)
      */
     if (annotationText.isUnderlineStyleEnabled()) {
         if (annotationText.getOrientation() == AnnotationTextOrientationEnum::HORIZONTAL) {
-            m_underlineThickness = std::max((font->FaceSize() / 14.0),
+            m_underlineThickness = std::max((m_font->FaceSize() / 14.0),
                                         1.0);
         }
     }
@@ -2267,12 +2453,11 @@ m_textDrawingSpace(TextDrawingSpace::VIEWPORT)
     const int32_t textListSize = textList.size();
     
     for (int32_t i = 0; i < textListSize; i++) {
-        TextString* ts = new TextString(textList.at(i),
-                                        m_textDrawingSpace,
-                                        annotationText.getOrientation(),
-                                        m_underlineThickness,
-                                        outlineThickness,
-                                        font);
+        TextString* ts = fontData->newTextString(textList.at(i),
+                                                 m_textDrawingSpace,
+                                                 annotationText.getOrientation(),
+                                                 m_underlineThickness,
+                                                 outlineThickness);
         m_textStrings.push_back(ts);
     }
     
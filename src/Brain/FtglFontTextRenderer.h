@@ -25,7 +25,10 @@
 /*LICENSE_END*/
 
 #include <map>
+#include <memory>
 #include <set>
+#include <tuple>
+#include <vector>
 
 #include "AnnotationTextAlignHorizontalEnum.h"
 #include "AnnotationTextOrientationEnum.h"
@@ -35,6 +38,8 @@ class FTFont;
 
 namespace caret {
 
+    class FtglGlyphAtlas;
+    
     class FtglFontTextRenderer : public BrainOpenGLTextRenderInterface {
         
     public:
@@ -113,6 +118,9 @@ namespace caret {
         virtual AString getName() const;
         
     private:
+        /** Compares cached text string layouts with uncached layouts */
+        friend class FtglTextTest;
+        
         enum DepthTestEnum {
             DEPTH_TEST_NO,
             DEPTH_TEST_YES
@@ -134,14 +142,18 @@ namespace caret {
                                               const AnnotationText& annotationText,
                                               const DrawingFlags& flags);
         
-        FTFont* getFont(const AnnotationText& annotationText,
-                        const FtglFontTypeEnum ftglFontType,
-                        const bool creatingDefaultFontFlag);
+        class FontData;
+        
+        class TextString;
         
-        FTFont* getFont(const AnnotationText& annotationText,
-                        const FtglFontTypeEnum ftglFontType,
-                        const float heightOrWidthForPercentageSizeText,
-                        const bool creatingDefaultFontFlag);
+        FontData* getFontData(const AnnotationText& annotationText,
+                              const FtglFontTypeEnum ftglFontType,
+                              const bool creatingDefaultFontFlag);
+        
+        FontData* getFontData(const AnnotationText& annotationText,
+                              const FtglFontTypeEnum ftglFontType,
+                              const float heightOrWidthForPercentageSizeText,
+                              const bool creatingDefaultFontFlag);
         
         void drawUnderline(const double lineStartX,
                            const double lineEndX,
@@ -171,6 +183,20 @@ namespace caret {
                                                  const float heightOrWidthForPercentageSizeText,
                                                  const float modelSpaceScaling) const;
         
+        /**
+         * Drawing space of text
+         */
+        enum class TextDrawingSpace {
+            /**
+             * Drawn in model space coordinates
+             */
+            MODEL,
+            /**
+             * Drawn in viewport coordinates
+             */
+            VIEWPORT
+        };
+        
         class FontData {
         public:
             FontData();
@@ -184,6 +210,16 @@ namespace caret {
             
             void initialize(const AString& fontFileName);
             
+            FtglGlyphAtlas* getGlyphAtlas();
+            
+            TextString* newTextString(const QString& textString,
+                                      const TextDrawingSpace textDrawingSpace,
+                                      const AnnotationTextOrientationEnum::Enum orientation,
+                                      const double underlineThickness,
+                                      const double outlineThickness);
+            
+            int32_t getNumberOfCachedTextStrings() const;
+            
             FtglFontTypeEnum m_ftglFontType = FtglFontTypeEnum::TEXTURE;
             
             QByteArray m_fontData;
@@ -191,20 +227,17 @@ namespace caret {
             FTFont* m_font;
             
             bool m_valid;
-        };
-        
-        /**
-         * Drawing space of text
-         */
-        enum class TextDrawingSpace {
-            /**
-             * Drawn in model space coordinates
-             */
-            MODEL,
-            /**
-             * Drawn in viewport coordinates
-             */
-            VIEWPORT
+            
+        private:
+            typedef std::tuple<QString, int32_t, int32_t, double, double> TextStringKey;
+            
+            /** Created when first needed, after m_fontData so it is destroyed first */
+            std::unique_ptr<FtglGlyphAtlas> m_glyphAtlas;
+            
+            bool m_glyphAtlasCreatedFlag = false;
+            
+            /** Layouts of text strings, at the origin, for copying */
+            std::map<TextStringKey, std::unique_ptr<TextString>> m_textStringCache;
         };
         
         /**
@@ -256,6 +289,8 @@ namespace caret {
                        const double outlineThickness,
                        FTFont* font);
             
+            TextString(const TextString& obj);
+            
             ~TextString();
             
             void print(const AString& offsetString);
@@ -286,6 +321,8 @@ namespace caret {
             double m_stringGlyphsMaxY;
             
         private:
+            TextString& operator=(const TextString&);
+            
             void initializeTextCharacterOffsets(const AnnotationTextOrientationEnum::Enum orientation);
             
         };
@@ -297,7 +334,7 @@ namespace caret {
         public:
             TextStringGroup(const AnnotationText& annotationText,
                             const DrawingFlags& flags,
-                            FTFont* font,
+                            FontData* fontData,
                             const double viewportX,
                             const double viewportY,
                             const double viewportZ,
@@ -370,7 +407,7 @@ namespace caret {
          * The default font.  DO NOT delete it since it points to
          * a font in "m_fontNameToFontMap".
          */
-        FTFont* m_defaultFont;
+        FontData* m_defaultFontData;
         
         /**
          * Map for caching fonts
@@ -408,11 +445,13 @@ namespace caret {
         
         static const double s_textMarginSize;
         static const double s_modelSpaceMarginPercentage;
+        static const int32_t s_maximumNumberOfCachedTextStrings;
     };
     
 #ifdef __FTGL_FONT_TEXT_RENDERER_DECLARE__
     const double FtglFontTextRenderer::s_textMarginSize = 3.0;
     const double FtglFontTextRenderer::s_modelSpaceMarginPercentage = 0.2;
+    const int32_t FtglFontTextRenderer::s_maximumNumberOfCachedTextStrings = 2000;
 #endif // __FTGL_FONT_TEXT_RENDERER_DECLARE__
 
 } // namespace
@@ -0,0 +1,397 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#ifdef HAVE_FREETYPE
+
+#define __FTGL_GLYPH_ATLAS_DECLARE__
+#include "FtglGlyphAtlas.h"
+#undef __FTGL_GLYPH_ATLAS_DECLARE__
+
+#include <algorithm>
+#include <cmath>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "GraphicsPrimitiveV3fT3f.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::FtglGlyphAtlas 
+ * \brief Glyph images of a texture font packed into one texture
+ * \ingroup Brain
+ *
+ * FTGL draws each character of a texture font as a separate quad
+ * and binds the texture of each character, so drawing text requires
+ * many OpenGL calls.  The atlas rasterizes glyphs with FreeType, in
+ * the same way and at the same size as the FTGL texture font, and
+ * packs them in rows into one image so that all characters of a text
+ * string are drawn with one primitive.
+ *
+ * The atlas image is white with each glyph's coverage in the alpha
+ * component.  Its primitive modulates the image with the current
+ * color, so text of any color is drawn with the same texture.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param fontData
+ *     Data of the font file (must remain valid for life of atlas).
+ * @param faceSize
+ *     Size of the font's characters in points.
+ */
+FtglGlyphAtlas::FtglGlyphAtlas(const QByteArray& fontData,
+                               const unsigned int faceSize)
+: CaretObject()
+{
+    if (fontData.isEmpty()
+        || (faceSize == 0)) {
+        return;
+    }
+    
+    FT_Library library = NULL;
+    if (FT_Init_FreeType(&library) != 0) {
+        CaretLogWarning("Unable to initialize FreeType for glyph atlas.");
+        return;
+    }
+    m_library = library;
+    
+    FT_Face face = NULL;
+    if (FT_New_Memory_Face(library,
+                           reinterpret_cast<const FT_Byte*>(fontData.constData()),
+                           fontData.size(),
+                           0,
+                           &face) != 0) {
+        CaretLogWarning("Unable to create FreeType face for glyph atlas.");
+        return;
+    }
+    m_face = face;
+    
+    /*
+     * Same size and resolution as FTGL's FTFont::FaceSize()
+     */
+    if (FT_Set_Char_Size(face,
+                         0,
+                         faceSize * 64,
+                         72,
+                         72) != 0) {
+        CaretLogWarning("Unable to set FreeType size for glyph atlas.");
+        return;
+    }
+    
+    /*
+     * Dimensions are a power of two as required for mipmaps
+     */
+    m_width  = s_width;
+    m_height = s_initialHeight;
+    m_coverage.resize(m_width * m_height, 0);
+    m_packX = s_glyphPadding;
+    m_packY = s_glyphPadding;
+    
+    m_validFlag = true;
+}
+
+/**
+ * Destructor.
+ */
+FtglGlyphAtlas::~FtglGlyphAtlas()
+{
+    if (m_face != NULL) {
+        FT_Done_Face(m_face);
+        m_face = NULL;
+    }
+    if (m_library != NULL) {
+        FT_Done_FreeType(m_library);
+        m_library = NULL;
+    }
+}
+
+/**
+ * Get the glyph for a character, adding it to the atlas if needed.
+ *
+ * @param character
+ *     The character.
+ * @return
+ *     The glyph.  Glyph is not in the atlas if it could not be
+ *     rasterized or there is no space for it.
+ */
+const FtglGlyphAtlas::Glyph&
+FtglGlyphAtlas::getGlyph(const wchar_t character)
+{
+    std::map<wchar_t, Glyph>::iterator iter = m_glyphs.find(character);
+    if (iter != m_glyphs.end()) {
+        return iter->second;
+    }
+    
+    Glyph& glyph = m_glyphs[character];
+    
+    /*
+     * Same flags and render mode as FTGL's FTTextureFont
+     */
+    const FT_UInt glyphIndex = FT_Get_Char_Index(m_face,
+                                                 static_cast<FT_ULong>(character));
+    if (FT_Load_Glyph(m_face,
+                      glyphIndex,
+                      FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP) != 0) {
+        return glyph;
+    }
+    FT_GlyphSlot slot = m_face->glyph;
+    if (FT_Render_Glyph(slot,
+                        FT_RENDER_MODE_NORMAL) != 0) {
+        return glyph;
+    }
+    
+    const FT_Bitmap& bitmap = slot->bitmap;
+    glyph.m_width   = static_cast<int32_t>(bitmap.width);
+    glyph.m_height  = static_cast<int32_t>(bitmap.rows);
+    glyph.m_cornerX = slot->bitmap_left;
+    glyph.m_cornerY = slot->bitmap_top;
+    
+    /*
+     * Glyphs without an image, such as space, are drawn by
+     * advancing only and are always "in" the atlas
+     */
+    if ((glyph.m_width <= 0)
+        || (glyph.m_height <= 0)) {
+        glyph.m_width  = 0;
+        glyph.m_height = 0;
+        glyph.m_inAtlasFlag = true;
+        return glyph;
+    }
+    
+    if ((glyph.m_width + (2 * s_glyphPadding)) > m_width) {
+        return glyph;
+    }
+    
+    /*
+     * Start a new row when the glyph does not fit in the current row
+     */
+    if ((m_packX + glyph.m_width + s_glyphPadding) > m_width) {
+        m_packX = s_glyphPadding;
+        m_packY += (m_packRowHeight + s_glyphPadding);
+        m_packRowHeight = 0;
+    }
+    
+    /*
+     * Double the height of the atlas when the glyph does not fit.
+     * Existing glyphs keep their pixel positions.
+     */
+    while ((m_packY + glyph.m_height + s_glyphPadding) > m_height) {
+        if ((m_height * 2) > s_maximumHeight) {
+            return glyph;
+        }
+        m_height *= 2;
+        m_coverage.resize(m_width * m_height, 0);
+    }
+    
+    glyph.m_atlasX = m_packX;
+    glyph.m_atlasY = m_packY;
+    
+    /*
+     * Pitch is negative if the bitmap's rows are stored bottom to top
+     */
+    for (int32_t iRow = 0; iRow < glyph.m_height; iRow++) {
+        const unsigned char* bitmapRow = ((bitmap.pitch >= 0)
+                                          ? (bitmap.buffer + (iRow * bitmap.pitch))
+                                          : (bitmap.buffer + ((glyph.m_height - 1 - iRow) * (- bitmap.pitch))));
+        uint8_t* atlasRow = &m_coverage[((glyph.m_atlasY + iRow) * m_width) + glyph.m_atlasX];
+        for (int32_t iCol = 0; iCol < glyph.m_width; iCol++) {
+            atlasRow[iCol] = bitmapRow[iCol];
+        }
+    }
+    
+    m_packX += (glyph.m_width + s_glyphPadding);
+    m_packRowHeight = std::max(m_packRowHeight,
+                               glyph.m_height);
+    glyph.m_inAtlasFlag = true;
+    ++m_modificationCount;
+    
+    return glyph;
+}
+
+/**
+ * Add the vertices of two triangles that draw a character.
+ *
+ * @param character
+ *     The character.
+ * @param x
+ *     X-coordinate of the character's pen position.
+ * @param y
+ *     Y-coordinate of the character's pen position.
+ * @param z
+ *     Z-coordinate of the character.
+ * @param xyzOut
+ *     Coordinates of the vertices are added to this.
+ * @param textureSTROut
+ *     Texture coordinates of the vertices are added to this.
+ * @return
+ *     True if successful, false if the character is not in the atlas
+ *     and must be drawn by other means.
+ */
+bool
+FtglGlyphAtlas::addCharacterVertices(const wchar_t character,
+                                     const double x,
+                                     const double y,
+                                     const double z,
+                                     std::vector<float>& xyzOut,
+                                     std::vector<float>& textureSTROut)
+{
+    CaretAssert(m_validFlag);
+    
+    const Glyph& glyph = getGlyph(character);
+    if ( ! glyph.m_inAtlasFlag) {
+        return false;
+    }
+    if ((glyph.m_width <= 0)
+        || (glyph.m_height <= 0)) {
+        return true;
+    }
+    
+    /*
+     * Same placement as FTGL's FTTextureGlyph
+     */
+    const float left   = static_cast<float>(std::floor(x + glyph.m_cornerX));
+    const float top    = static_cast<float>(std::floor(y + glyph.m_cornerY));
+    const float right  = left + glyph.m_width;
+    const float bottom = top - glyph.m_height;
+    const float zf     = static_cast<float>(z);
+    
+    const float sLeft   = static_cast<float>(glyph.m_atlasX) / m_width;
+    const float sRight  = static_cast<float>(glyph.m_atlasX + glyph.m_width) / m_width;
+    const float tTop    = static_cast<float>(glyph.m_atlasY) / m_height;
+    const float tBottom = static_cast<float>(glyph.m_atlasY + glyph.m_height) / m_height;
+    
+    const float xyz[6][3] = {
+        { left,  top,    zf },
+        { left,  bottom, zf },
+        { right, bottom, zf },
+        { left,  top,    zf },
+        { right, bottom, zf },
+        { right, top,    zf }
+    };
+    const float st[6][2] = {
+        { sLeft,  tTop    },
+        { sLeft,  tBottom },
+        { sRight, tBottom },
+        { sLeft,  tTop    },
+        { sRight, tBottom },
+        { sRight, tTop    }
+    };
+    for (int32_t i = 0; i < 6; i++) {
+        xyzOut.insert(xyzOut.end(), xyz[i], xyz[i] + 3);
+        textureSTROut.push_back(st[i][0]);
+        textureSTROut.push_back(st[i][1]);
+        textureSTROut.push_back(0.0f);
+    }
+    
+    return true;
+}
+
+/**
+ * Get the primitive for drawing characters.  Its texture is updated
+ * if glyphs were added to the atlas.  Set the color of the text as
+ * the current color before drawing the primitive.
+ *
+ * @return
+ *     Primitive owned by the atlas whose vertices may be replaced.
+ */
+GraphicsPrimitiveV3fT3f*
+FtglGlyphAtlas::getPrimitive()
+{
+    CaretAssert(m_validFlag);
+    
+    if (m_primitiveModificationCount != m_modificationCount) {
+        const int32_t numberOfPixels = m_width * m_height;
+        std::vector<uint8_t> imageRGBA(numberOfPixels * 4, 255);
+        for (int32_t i = 0; i < numberOfPixels; i++) {
+            imageRGBA[(i * 4) + 3] = m_coverage[i];
+        }
+        
+        if (m_primitive) {
+            m_primitive->replaceTextureImage(&imageRGBA[0],
+                                             m_width,
+                                             m_height);
+        }
+        else {
+            m_primitive.reset(GraphicsPrimitive::newPrimitiveV3fT3f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLES,
+                                                                    &imageRGBA[0],
+                                                                    m_width,
+                                                                    m_height));
+            m_primitive->setUsageTypeCoordinates(GraphicsPrimitive::UsageType::MODIFIED_MANY_DRAWN_MANY_TIMES);
+            m_primitive->setUsageTypeTextureCoordinates(GraphicsPrimitive::UsageType::MODIFIED_MANY_DRAWN_MANY_TIMES);
+            m_primitive->setTextureEnvironmentMode(GraphicsPrimitive::TextureEnvironmentMode::MODULATE);
+        }
+        m_primitiveModificationCount = m_modificationCount;
+    }
+    
+    return m_primitive.get();
+}
+
+/**
+ * Get the coverage of a pixel in the atlas image.
+ *
+ * @param x
+ *     Column of the pixel.
+ * @param y
+ *     Row of the pixel (row zero is texture coordinate T zero).
+ * @return
+ *     Coverage, zero to 255.
+ */
+uint8_t
+FtglGlyphAtlas::getCoverage(const int32_t x,
+                            const int32_t y) const
+{
+    CaretAssert((x >= 0) && (x < m_width));
+    CaretAssert((y >= 0) && (y < m_height));
+    return m_coverage[(y * m_width) + x];
+}
+
+/**
+ * @return Number of characters whose glyphs have been requested,
+ * including those without an image and those that did not fit.
+ */
+int32_t
+FtglGlyphAtlas::getNumberOfGlyphs() const
+{
+    return static_cast<int32_t>(m_glyphs.size());
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString 
+FtglGlyphAtlas::toString() const
+{
+    return ("FtglGlyphAtlas "
+            + AString::number(m_width)
+            + "x"
+            + AString::number(m_height)
+            + " glyphs="
+            + AString::number(m_glyphs.size()));
+}
+
+#endif // HAVE_FREETYPE
@@ -0,0 +1,152 @@
+#ifndef __FTGL_GLYPH_ATLAS_H__
+#define __FTGL_GLYPH_ATLAS_H__
+
+#ifdef HAVE_FREETYPE
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+
+#include "CaretObject.h"
+
+struct FT_FaceRec_;
+struct FT_LibraryRec_;
+
+namespace caret {
+
+    class GraphicsPrimitiveV3fT3f;
+
+    class FtglGlyphAtlas : public CaretObject {
+
+    public:
+        FtglGlyphAtlas(const QByteArray& fontData,
+                       const unsigned int faceSize);
+
+        virtual ~FtglGlyphAtlas();
+
+        /** @return True if the atlas was created and glyphs may be added */
+        bool isValid() const { return m_validFlag; }
+
+        bool addCharacterVertices(const wchar_t character,
+                                  const double x,
+                                  const double y,
+                                  const double z,
+                                  std::vector<float>& xyzOut,
+                                  std::vector<float>& textureSTROut);
+
+        GraphicsPrimitiveV3fT3f* getPrimitive();
+
+        /** @return Width of the atlas image in pixels */
+        int32_t getWidth() const { return m_width; }
+
+        /** @return Height of the atlas image in pixels */
+        int32_t getHeight() const { return m_height; }
+
+        uint8_t getCoverage(const int32_t x,
+                            const int32_t y) const;
+
+        int32_t getNumberOfGlyphs() const;
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+    private:
+        /**
+         * Location of a glyph's image in the atlas
+         */
+        class Glyph {
+        public:
+            int32_t m_atlasX = 0;
+            int32_t m_atlasY = 0;
+            int32_t m_width  = 0;
+            int32_t m_height = 0;
+            /* Top left of image relative to the pen */
+            int32_t m_cornerX = 0;
+            int32_t m_cornerY = 0;
+            /* False if the glyph did not fit in the atlas */
+            bool m_inAtlasFlag = false;
+        };
+
+        FtglGlyphAtlas(const FtglGlyphAtlas&);
+
+        FtglGlyphAtlas& operator=(const FtglGlyphAtlas&);
+
+        const Glyph& getGlyph(const wchar_t character);
+
+        // ADD_NEW_MEMBERS_HERE
+
+        FT_LibraryRec_* m_library = NULL;
+
+        FT_FaceRec_* m_face = NULL;
+
+        bool m_validFlag = false;
+
+        /** Coverage (alpha) of each pixel in the atlas */
+        std::vector<uint8_t> m_coverage;
+
+        int32_t m_width  = 0;
+
+        int32_t m_height = 0;
+
+        /** Position for next glyph with glyphs packed in rows */
+        int32_t m_packX = 0;
+
+        int32_t m_packY = 0;
+
+        int32_t m_packRowHeight = 0;
+
+        /** Incremented when a glyph is added */
+        int64_t m_modificationCount = 0;
+
+        std::map<wchar_t, Glyph> m_glyphs;
+
+        /** Draws the atlas image with the current color */
+        std::unique_ptr<GraphicsPrimitiveV3fT3f> m_primitive;
+
+        /** Modification count when the primitive's texture was last updated */
+        int64_t m_primitiveModificationCount = -1;
+
+        static const int32_t s_width;
+
+        static const int32_t s_initialHeight;
+
+        static const int32_t s_maximumHeight;
+
+        static const int32_t s_glyphPadding;
+    };
+
+#ifdef __FTGL_GLYPH_ATLAS_DECLARE__
+    const int32_t FtglGlyphAtlas::s_width = 512;
+    const int32_t FtglGlyphAtlas::s_initialHeight = 128;
+    const int32_t FtglGlyphAtlas::s_maximumHeight = 4096;
+    const int32_t FtglGlyphAtlas::s_glyphPadding = 2;
+#endif // __FTGL_GLYPH_ATLAS_DECLARE__
+
+} // namespace
+
+#endif // HAVE_FREETYPE
+
+#endif  //__FTGL_GLYPH_ATLAS_H__
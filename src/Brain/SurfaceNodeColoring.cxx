@@ -23,6 +23,8 @@
 #include "SurfaceNodeColoring.h"
 #undef __SURFACE_NODE_COLORING_DECLARE__
 
+#include <algorithm>
+
 #include "Brain.h"
 #include "BrainordinateRegionOfInterest.h"
 #include "BrainStructure.h"
@@ -30,6 +32,7 @@
 #include "EventBrowserTabGet.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CaretPreferences.h"
 #include "CiftiBrainordinateDataSeriesFile.h"
 #include "CiftiBrainordinateLabelFile.h"
@@ -44,6 +47,7 @@
 #include "DisplayPropertiesLabels.h"
 #include "EventManager.h"
 #include "EventModelSurfaceGet.h"
+#include "FrameProfiler.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GroupAndNameHierarchyGroup.h"
@@ -112,6 +116,8 @@ SurfaceNodeColoring::colorSurfaceNodes(Model* model,
                                        Surface* surface,
                                        const int32_t browserTabIndex)
 {
+    FrameProfiler::Scope profileScope("colorSurfaceNodes");
+    
     CaretAssert(surface);
 
     ModelSurface* surfaceModel = dynamic_cast<ModelSurface*>(model);
@@ -305,6 +311,7 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
     /*
      * Default color.
      */
+#pragma omp CARET_PARFOR schedule(static)
     for (int32_t i = 0; i < numNodes; i++) {
         const int32_t i4 = i * 4;
         rgbaNodeColors[i4] = 0.70;
@@ -518,10 +525,9 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
                         CaretColorEnum::toRGBAFloat(outlineColor, outlineRGBA);
                         
                         CaretPointer<TopologyHelper> topologyHelper = surface->getTopologyHelper();
-                        std::vector<float> rgbaCopy(numNodes * 4);
-                        for (int32_t i = 0; i < (numNodes*4); i++) {
-                            rgbaCopy[i] = overlayRGBV[i];
-                        }
+                        std::vector<float> rgbaCopy(overlayRGBV,
+                                                    overlayRGBV + (numNodes * 4));
+#pragma omp CARET_PARFOR schedule(dynamic, 4096)
                         for (int32_t i = 0; i < numNodes; i++) {
                             const int32_t i4 = i * 4;
                             CaretAssertVectorIndex(rgbaCopy, i4 + 3);
@@ -564,6 +570,7 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
                 const float opacity = overlay->getOpacity();
                 const float oneMinusOpacity = 1.0 - opacity;
                 
+#pragma omp CARET_PARFOR schedule(static)
                 for (int32_t i = 0; i < numNodes; i++) {
                     const int32_t i4 = i * 4;
                     const float valid = overlayRGBV[i4 + 3];
@@ -612,6 +619,7 @@ SurfaceNodeColoring::colorSurfaceNodes(const DisplayPropertiesLabels* displayPro
      */
     const float opacity = brain->getDisplayPropertiesSurface()->getOpacity();
     if (opacity < 1.0) {
+#pragma omp CARET_PARFOR schedule(static)
         for (int32_t i = 0; i < numNodes; i++) {
             const int32_t i4 = i * 4;
             rgbaNodeColors[i4+3] = opacity;
@@ -886,6 +894,40 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
         return false;
     }
     
+    colorMetricMap(metricFile,
+                   displayColumn,
+                   numberOfNodes,
+                   rgbv);
+    
+    return true;
+}
+
+/**
+ * Color a metric map with its palette.  The coloring of a map is kept
+ * and copied when the map is colored again with the same data and
+ * palette settings.
+ *
+ * @param metricFile
+ *    Metric file that is selected.
+ * @param displayColumn
+ *    Index of the selected map.
+ * @param numberOfNodes
+ *    Number of nodes in surface.
+ * @param rgbv
+ *    Color components set by this method.
+ *    Red, green, blue, valid.  If the valid component is
+ *    zero, it indicates that the map did not assign
+ *    any coloring to the node.
+ */
+void
+SurfaceNodeColoring::colorMetricMap(MetricFile* metricFile,
+                                    const int32_t displayColumn,
+                                    const int32_t numberOfNodes,
+                                    float* rgbv)
+{
+    CaretAssert(metricFile);
+    CaretAssertArrayIndex("metricFile", metricFile->getNumberOfMaps(), displayColumn);
+    
     PaletteColorMapping* paletteColorMapping = metricFile->getPaletteColorMapping(displayColumn);
     
     bool useThreshMapFileFlag = false;
@@ -906,6 +948,8 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
     const float* metricDisplayData = metricFile->getValuePointerForColumn(displayColumn);
     float* metricThresholdData = const_cast<float*>(metricDisplayData);
     PaletteColorMapping* thresholdPaletteColorMapping = paletteColorMapping;
+    const MetricFile* thresholdMetricFile = NULL;
+    int32_t thresholdMetricMapIndex = -1;
     
     if (useThreshMapFileFlag) {
         const CaretMappableDataFileAndMapSelectionModel* threshFileModel = metricFile->getMapThresholdFileSelectionModel(displayColumn);
@@ -920,11 +964,62 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
                     metricThresholdData = const_cast<float*>(threshMetricFile->getValuePointerForColumn(threshMapIndex));
                     thresholdPaletteColorMapping = const_cast<PaletteColorMapping*>(threshMapFile->getMapPaletteColorMapping(threshMapIndex));
                     CaretAssert(thresholdPaletteColorMapping);
+                    thresholdMetricFile     = threshMetricFile;
+                    thresholdMetricMapIndex = threshMapIndex;
                 }
             }
         }
     }
     
+    /*
+     * Palette coloring is the costly part of coloring a surface, so the
+     * coloring of a map is kept and used again, such as when another overlay
+     * changes, until the map's palette settings change.  A reloaded file
+     * keeps the map unique identifiers read from the file, so the generation
+     * of the file's data arrays identifies the data that was colored.  Data
+     * may be edited without changing any settings, so a file with unsaved
+     * changes is always colored.
+     */
+    const std::pair<const MetricFile*, int32_t> mapColoringKey(metricFile,
+                                                               displayColumn);
+    const AString mapUniqueID = metricFile->getMapUniqueID(displayColumn);
+    const AString thresholdMapUniqueID = ((thresholdMetricFile != NULL)
+                                          ? thresholdMetricFile->getMapUniqueID(thresholdMetricMapIndex)
+                                          : AString(""));
+    const int64_t dataArraysGeneration = metricFile->getDataArraysGeneration();
+    const int64_t thresholdDataArraysGeneration = ((thresholdMetricFile != NULL)
+                                                   ? thresholdMetricFile->getDataArraysGeneration()
+                                                   : -1);
+    bool reuseColoringFlag = true;
+    if (metricFile->isModifiedExcludingPaletteColorMapping()) {
+        reuseColoringFlag = false;
+    }
+    if (thresholdMetricFile != NULL) {
+        if (thresholdMetricFile->isModifiedExcludingPaletteColorMapping()) {
+            reuseColoringFlag = false;
+        }
+    }
+    if (reuseColoringFlag) {
+        std::map<std::pair<const MetricFile*, int32_t>, MetricMapColoring>::const_iterator iter = m_metricMapColorings.find(mapColoringKey);
+        if (iter != m_metricMapColorings.end()) {
+            const MetricMapColoring& mapColoring = iter->second;
+            if ((static_cast<int64_t>(mapColoring.m_rgba.size()) == (static_cast<int64_t>(numberOfNodes) * 4))
+                && (mapColoring.m_mapUniqueID == mapUniqueID)
+                && (mapColoring.m_dataArraysGeneration == dataArraysGeneration)
+                && (mapColoring.m_paletteNormalizationMode == metricFile->getPaletteNormalizationMode())
+                && (mapColoring.m_paletteColorMapping == *paletteColorMapping)
+                && (mapColoring.m_thresholdMetricFile == thresholdMetricFile)
+                && (mapColoring.m_thresholdMapUniqueID == thresholdMapUniqueID)
+                && (mapColoring.m_thresholdDataArraysGeneration == thresholdDataArraysGeneration)
+                && (mapColoring.m_thresholdPaletteColorMapping == *thresholdPaletteColorMapping)) {
+                std::copy(mapColoring.m_rgba.begin(),
+                          mapColoring.m_rgba.end(),
+                          rgbv);
+                return;
+            }
+        }
+    }
+    
     /*
      * Invalidate all coloring.
      */
@@ -962,7 +1057,32 @@ SurfaceNodeColoring::assignMetricColoring(const BrainStructure* brainStructure,
                                                       rgbv);
     }
     
-    return true;
+    if (reuseColoringFlag) {
+        /*
+         * Colorings of maps no longer displayed are never removed
+         * individually, so start over rather than let them accumulate.
+         */
+        const int32_t maximumNumberOfMapColorings = 16;
+        if ((m_metricMapColorings.find(mapColoringKey) == m_metricMapColorings.end())
+            && (static_cast<int32_t>(m_metricMapColorings.size()) >= maximumNumberOfMapColorings)) {
+            m_metricMapColorings.clear();
+        }
+        
+        MetricMapColoring& mapColoring = m_metricMapColorings[mapColoringKey];
+        mapColoring.m_mapUniqueID                   = mapUniqueID;
+        mapColoring.m_dataArraysGeneration          = dataArraysGeneration;
+        mapColoring.m_paletteColorMapping           = *paletteColorMapping;
+        mapColoring.m_paletteNormalizationMode      = metricFile->getPaletteNormalizationMode();
+        mapColoring.m_thresholdMetricFile           = thresholdMetricFile;
+        mapColoring.m_thresholdMapUniqueID          = thresholdMapUniqueID;
+        mapColoring.m_thresholdDataArraysGeneration = thresholdDataArraysGeneration;
+        mapColoring.m_thresholdPaletteColorMapping  = *thresholdPaletteColorMapping;
+        mapColoring.m_rgba.assign(rgbv,
+                                  rgbv + (static_cast<int64_t>(numberOfNodes) * 4));
+    }
+    else {
+        m_metricMapColorings.erase(mapColoringKey);
+    }
 }
 
 /**
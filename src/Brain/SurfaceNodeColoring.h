@@ -21,11 +21,16 @@
  */
 /*LICENSE_END*/
 
+#include <map>
+#include <vector>
+
 #include "CaretColorEnum.h"
 #include "CaretObject.h"
 #include "CaretPointer.h"
 #include "DisplayGroupEnum.h"
 #include "LabelDrawingTypeEnum.h"
+#include "PaletteColorMapping.h"
+#include "PaletteNormalizationModeEnum.h"
 
 namespace caret {
 
@@ -63,6 +68,11 @@ namespace caret {
                                  Surface* surface,
                                  const int32_t browserTabIndex);
         
+        void colorMetricMap(MetricFile* metricFile,
+                            const int32_t displayColumn,
+                            const int32_t numberOfNodes,
+                            float* rgbv);
+        
     private:
         SurfaceNodeColoring(const SurfaceNodeColoring&);
 
@@ -167,6 +177,33 @@ namespace caret {
         void showBrainordinateHighlightRegionOfInterest(const Brain* brain,
                                                         const Surface* surface,
                                                         float* rgbaNodeColors);
+        
+        /**
+         * Palette coloring of a metric map and the settings that produced it.
+         */
+        class MetricMapColoring {
+        public:
+            AString m_mapUniqueID;
+            
+            int64_t m_dataArraysGeneration = -1;
+            
+            PaletteColorMapping m_paletteColorMapping;
+            
+            PaletteNormalizationModeEnum::Enum m_paletteNormalizationMode = PaletteNormalizationModeEnum::NORMALIZATION_SELECTED_MAP_DATA;
+            
+            const MetricFile* m_thresholdMetricFile = NULL;
+            
+            AString m_thresholdMapUniqueID;
+            
+            int64_t m_thresholdDataArraysGeneration = -1;
+            
+            PaletteColorMapping m_thresholdPaletteColorMapping;
+            
+            std::vector<float> m_rgba;
+        };
+        
+        /** Palette coloring of metric maps, keyed by file and map index */
+        std::map<std::pair<const MetricFile*, int32_t>, MetricMapColoring> m_metricMapColorings;
     };
     
 #ifdef __SURFACE_NODE_COLORING_DECLARE__
@@ -60,6 +60,7 @@
 #include "AlgorithmCiftiSmoothing.h"
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmCiftiVectorOperation.h"
+#include "AlgorithmCreateResampleOperator.h"
 #include "AlgorithmCreateSignedDistanceVolume.h"
 #include "AlgorithmFiberDotProducts.h"
 #include "AlgorithmFociResample.h"
@@ -89,6 +90,7 @@
 #include "AlgorithmMetricROIsToBorder.h"
 #include "AlgorithmMetricSmoothing.h"
 #include "AlgorithmMetricTFCE.h"
+#include "AlgorithmMetricTFCEPermutation.h"
 #include "AlgorithmMetricToVolumeMapping.h"
 #include "AlgorithmMetricVectorOperation.h"
 #include "AlgorithmMetricVectorTowardROI.h"
@@ -130,8 +132,10 @@
 #include "AlgorithmVolumeParcelSmoothing.h"
 #include "AlgorithmVolumeReduce.h"
 #include "AlgorithmVolumeRemoveIslands.h"
+#include "AlgorithmVolumeResample.h"
 #include "AlgorithmVolumeROIsFromExtrema.h"
 #include "AlgorithmVolumeSmoothing.h"
+#include "AlgorithmVolumeSplinePrefilter.h"
 #include "AlgorithmVolumeTFCE.h"
 #include "AlgorithmVolumeToSurfaceMapping.h"
 #include "AlgorithmVolumeVectorOperation.h"
@@ -322,6 +326,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiSmoothing()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiTranspose()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCiftiVectorOperation()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCreateResampleOperator()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmCreateSignedDistanceVolume()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmFiberDotProducts()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmFociResample()));
@@ -351,6 +356,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricROIsToBorder()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricSmoothing()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricTFCE()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricTFCEPermutation()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricToVolumeMapping()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricVectorOperation()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmMetricVectorTowardROI()));
@@ -392,8 +398,10 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeParcelSmoothing()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeReduce()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeRemoveIslands()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeResample()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeROIsFromExtrema()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeSmoothing()));
+    this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeSplinePrefilter()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeTFCE()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeToSurfaceMapping()));
     this->commandOperations.push_back(new CommandParser(new AutoAlgorithmVolumeVectorOperation()));
@@ -0,0 +1,172 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct CenterCompare
+    {
+        const float* m_centers;
+        int m_axis;
+        CenterCompare(const float* centers, const int& axis) : m_centers(centers), m_axis(axis) { }
+        bool operator()(const int32_t& left, const int32_t& right) const
+        {
+            return m_centers[left * 3 + m_axis] < m_centers[right * 3 + m_axis];
+        }
+    };
+}
+
+float BoundingVolumeHierarchy::Node::distSquaredToPoint(const float point[3]) const
+{
+    float ret = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float below = m_min[i] - point[i], above = point[i] - m_max[i];//at most one of these is positive
+        float diff = max(max(below, above), 0.0f);
+        ret += diff * diff;
+    }
+    return ret;
+}
+
+bool BoundingVolumeHierarchy::Node::rayIntersects(const float start[3], const float direction[3]) const
+{
+    float curlow = 0.0f, curhigh = 0.0f;
+    bool first = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (direction[i] != 0.0f)
+        {
+            float templow = (m_min[i] - start[i]) / direction[i];//compute the range of t over which this line lies between the planes for this axis
+            float temphigh = (m_max[i] - start[i]) / direction[i];
+            if (direction[i] < 0.0f) swap(templow, temphigh);
+            if (first)
+            {
+                first = false;
+                curlow = templow;
+                curhigh = temphigh;
+            } else {
+                if (templow > curlow) curlow = templow;//intersect the ranges
+                if (temphigh < curhigh) curhigh = temphigh;
+            }
+            if (curhigh < curlow || curhigh < 0.0f) return false;//if intersection is null or has no positive range, false
+        } else {
+            if (start[i] < m_min[i] || start[i] > m_max[i]) return false;
+        }
+    }
+    return true;
+}
+
+bool BoundingVolumeHierarchy::Node::lineSegmentIntersects(const float start[3], const float direction[3]) const
+{
+    float curlow = 0.0f, curhigh = 0.0f;
+    bool first = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (direction[i] != 0.0f)
+        {
+            float templow = (m_min[i] - start[i]) / direction[i];
+            float temphigh = (m_max[i] - start[i]) / direction[i];
+            if (direction[i] < 0.0f) swap(templow, temphigh);
+            if (first)
+            {
+                first = false;
+                curlow = templow;
+                curhigh = temphigh;
+            } else {
+                if (templow > curlow) curlow = templow;
+                if (temphigh < curhigh) curhigh = temphigh;
+            }
+            if (curhigh < curlow || curhigh < 0.0f || curlow > 1.0f) return false;//the segment is the range [0, 1] of t
+        } else {
+            if (start[i] < m_min[i] || start[i] > m_max[i]) return false;
+        }
+    }
+    return true;
+}
+
+void BoundingVolumeHierarchy::build(const float* itemMins, const float* itemMaxs, const int32_t& numItems, const int maxLeafSize)
+{
+    CaretAssert(maxLeafSize > 0);
+    m_nodes.clear();
+    m_itemOrder.resize(numItems);
+    if (numItems < 1) return;
+    vector<float> centers(numItems * 3);
+    for (int32_t i = 0; i < numItems; ++i)
+    {
+        m_itemOrder[i] = i;
+        for (int j = 0; j < 3; ++j)
+        {
+            centers[i * 3 + j] = (itemMins[i * 3 + j] + itemMaxs[i * 3 + j]) * 0.5f;
+        }
+    }
+    m_nodes.reserve(2 * (numItems / maxLeafSize + 1));//binary tree, the number of leaves is at most this
+    buildNode(centers, itemMins, itemMaxs, 0, numItems, maxLeafSize);
+}
+
+int32_t BoundingVolumeHierarchy::buildNode(vector<float>& centers, const float* itemMins, const float* itemMaxs, const int32_t& start, const int32_t& end, const int& maxLeafSize)
+{
+    int32_t ret = (int32_t)m_nodes.size();
+    m_nodes.push_back(Node());
+    Node myNode;
+    float centerMin[3], centerMax[3];
+    for (int j = 0; j < 3; ++j)
+    {
+        int32_t first = m_itemOrder[start];
+        myNode.m_min[j] = itemMins[first * 3 + j];
+        myNode.m_max[j] = itemMaxs[first * 3 + j];
+        centerMin[j] = centerMax[j] = centers[first * 3 + j];
+    }
+    for (int32_t i = start + 1; i < end; ++i)
+    {
+        int32_t item = m_itemOrder[i];
+        for (int j = 0; j < 3; ++j)
+        {
+            myNode.m_min[j] = min(myNode.m_min[j], itemMins[item * 3 + j]);
+            myNode.m_max[j] = max(myNode.m_max[j], itemMaxs[item * 3 + j]);
+            centerMin[j] = min(centerMin[j], centers[item * 3 + j]);
+            centerMax[j] = max(centerMax[j], centers[item * 3 + j]);
+        }
+    }
+    int axis = 0;//split along the longest extent of the item centers
+    for (int j = 1; j < 3; ++j)
+    {
+        if (centerMax[j] - centerMin[j] > centerMax[axis] - centerMin[axis]) axis = j;
+    }
+    if (end - start <= maxLeafSize || centerMax[axis] <= centerMin[axis])//identical centers can't be separated, so make a big leaf instead
+    {
+        myNode.m_start = start;
+        myNode.m_count = end - start;
+        m_nodes[ret] = myNode;
+        return ret;
+    }
+    int32_t middle = start + (end - start) / 2;
+    nth_element(m_itemOrder.begin() + start, m_itemOrder.begin() + middle, m_itemOrder.begin() + end, CenterCompare(centers.data(), axis));
+    buildNode(centers, itemMins, itemMaxs, start, middle, maxLeafSize);//left child is always ret + 1
+    myNode.m_start = buildNode(centers, itemMins, itemMaxs, middle, end, maxLeafSize);
+    myNode.m_count = 0;
+    m_nodes[ret] = myNode;
+    return ret;
+}
@@ -0,0 +1,138 @@
+#ifndef __BOUNDING_VOLUME_HIERARCHY_H__
+#define __BOUNDING_VOLUME_HIERARCHY_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include <vector>
+#include "stdint.h"
+
+namespace caret
+{
+    ///static bounding volume hierarchy over items with axis-aligned bounding boxes (points or triangles), stored as one contiguous node array
+    ///unlike Oct, every item is in exactly one leaf, so queries never need to check for duplicates, and the leaves can be laid out so that
+    ///the items of a leaf are contiguous in whatever arrays the user keeps in getItemOrder() order
+    class BoundingVolumeHierarchy
+    {
+    public:
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int32_t m_start;//leaf: first position in item order, inner: index of the right child (the left child is always the next node)
+            int32_t m_count;//leaf: number of items, inner: 0
+            bool isLeaf() const { return m_count > 0; }
+            float distSquaredToPoint(const float point[3]) const;
+            bool rayIntersects(const float start[3], const float direction[3]) const;
+            bool lineSegmentIntersects(const float start[3], const float direction[3]) const;//direction is end - start
+        };
+    private:
+        std::vector<Node> m_nodes;
+        std::vector<int32_t> m_itemOrder;
+        int32_t buildNode(std::vector<float>& centers, const float* itemMins, const float* itemMaxs, const int32_t& start, const int32_t& end, const int& maxLeafSize);
+    public:
+        ///itemMins and itemMaxs are 3 floats per item, for points they can be the same array
+        void build(const float* itemMins, const float* itemMaxs, const int32_t& numItems, const int maxLeafSize = 4);
+        bool isEmpty() const { return m_nodes.empty(); }
+        const Node& getNode(const int32_t& index) const { CaretAssertVectorIndex(m_nodes, index); return m_nodes[index]; }
+        ///item indices, grouped by leaf, a leaf node covers positions [m_start, m_start + m_count)
+        const std::vector<int32_t>& getItemOrder() const { return m_itemOrder; }
+
+        ///visits leaves in near-first order, skipping any node farther than bestDist2 (squared distance), which the leaf function may lower
+        ///leafFunc must be callable as leafFunc(const Node& leaf, float& bestDist2)
+        template <typename LeafFunc>
+        void nearestSearch(const float point[3], LeafFunc& leafFunc, float bestDist2) const;
+
+        ///visits every leaf whose box, and all of whose ancestor boxes, pass nodeTest(const Node&), calling leafFunc(const Node& leaf)
+        template <typename NodeTest, typename LeafFunc>
+        void traverse(const NodeTest& nodeTest, LeafFunc& leafFunc) const;
+    };
+
+    template <typename LeafFunc>
+    void BoundingVolumeHierarchy::nearestSearch(const float point[3], LeafFunc& leafFunc, float bestDist2) const
+    {
+        if (m_nodes.empty()) return;
+        const int STACK_SIZE = 64;//median splits halve the item count, so depth can't get near this with int32 items
+        int32_t stackNode[STACK_SIZE];
+        float stackDist[STACK_SIZE];
+        int stackTop = 0;
+        int32_t curNode = 0;
+        float curDist2 = m_nodes[0].distSquaredToPoint(point);
+        while (true)
+        {
+            if (curDist2 <= bestDist2)
+            {
+                const Node& thisNode = m_nodes[curNode];
+                if (thisNode.isLeaf())
+                {
+                    leafFunc(thisNode, bestDist2);
+                } else {
+                    int32_t left = curNode + 1, right = thisNode.m_start;
+                    float leftDist2 = m_nodes[left].distSquaredToPoint(point), rightDist2 = m_nodes[right].distSquaredToPoint(point);
+                    CaretAssert(stackTop < STACK_SIZE);
+                    if (leftDist2 <= rightDist2)//descend into the nearer child, save the other for later
+                    {
+                        stackNode[stackTop] = right;
+                        stackDist[stackTop] = rightDist2;
+                        curNode = left;
+                        curDist2 = leftDist2;
+                    } else {
+                        stackNode[stackTop] = left;
+                        stackDist[stackTop] = leftDist2;
+                        curNode = right;
+                        curDist2 = rightDist2;
+                    }
+                    ++stackTop;
+                    continue;
+                }
+            }
+            if (stackTop == 0) break;
+            --stackTop;
+            curNode = stackNode[stackTop];
+            curDist2 = stackDist[stackTop];
+        }
+    }
+
+    template <typename NodeTest, typename LeafFunc>
+    void BoundingVolumeHierarchy::traverse(const NodeTest& nodeTest, LeafFunc& leafFunc) const
+    {
+        if (m_nodes.empty()) return;
+        const int STACK_SIZE = 64;
+        int32_t stackNode[STACK_SIZE];
+        int stackTop = 0;
+        stackNode[stackTop++] = 0;
+        while (stackTop > 0)
+        {
+            const Node& thisNode = m_nodes[stackNode[--stackTop]];
+            if (!nodeTest(thisNode)) continue;
+            if (thisNode.isLeaf())
+            {
+                leafFunc(thisNode);
+            } else {
+                CaretAssert(stackTop + 2 <= STACK_SIZE);
+                stackNode[stackTop++] = thisNode.m_start;
+                stackNode[stackTop++] = (int32_t)(&thisNode - m_nodes.data()) + 1;
+            }
+        }
+    }
+}
+
+#endif //__BOUNDING_VOLUME_HIERARCHY_H__
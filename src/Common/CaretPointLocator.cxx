@@ -19,54 +19,47 @@
 /*LICENSE_END*/
 
 #include "CaretPointLocator.h"
-#include "CaretHeap.h"
-#include <cmath>
+
+#include <limits>
 
 using namespace caret;
 using namespace std;
 
-void CaretPointLocator::addPoint(Oct<LeafVector<Point> >* thisOct, const float point[3], const int64_t index, const int32_t pointSet)
+void CaretPointLocator::rebuildTree()
 {
-    if (thisOct->m_leaf)
+    int64_t numPoints = (int64_t)m_indices.size();
+    CaretAssert(numPoints < numeric_limits<int32_t>::max());
+    m_tree.build(m_coords.data(), m_coords.data(), (int32_t)numPoints, NUM_POINTS_LEAF);
+    const vector<int32_t>& order = m_tree.getItemOrder();
+    m_leafX.resize(numPoints);
+    m_leafY.resize(numPoints);
+    m_leafZ.resize(numPoints);
+    m_leafIndex.resize(numPoints);
+    m_leafSet.resize(numPoints);
+    for (int64_t i = 0; i < numPoints; ++i)
     {
-        thisOct->m_data.m_vector->push_back(Point(point, index, pointSet));
-        int curSize = (int)thisOct->m_data.m_vector->size();
-        if (curSize > NUM_POINTS_SPLIT)
-        {//test that not all points are the same, or that they have some minimum percentage spread, or...
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            Vector3D minBox = myVecRef[0].m_point, maxBox = myVecRef[0].m_point, tempvec;
-            tempvec[0] = thisOct->m_bounds[0][2] - thisOct->m_bounds[0][0];
-            tempvec[1] = thisOct->m_bounds[1][2] - thisOct->m_bounds[1][0];
-            tempvec[2] = thisOct->m_bounds[2][2] - thisOct->m_bounds[2][0];
-            float diagonal = tempvec.length();
-            bool safeToSplit = false;
-            for (int i = 1; i < curSize; ++i)
-            {//this will slow down if lots of stuff is continuously put in an Oct that is far too big - use random sampling?
-                if (myVecRef[i].m_point[0] < minBox[0]) minBox[0] = myVecRef[i].m_point[0];
-                if (myVecRef[i].m_point[1] < minBox[1]) minBox[1] = myVecRef[i].m_point[1];
-                if (myVecRef[i].m_point[2] < minBox[2]) minBox[2] = myVecRef[i].m_point[2];
-                if (myVecRef[i].m_point[0] > maxBox[0]) maxBox[0] = myVecRef[i].m_point[0];
-                if (myVecRef[i].m_point[1] > maxBox[1]) maxBox[1] = myVecRef[i].m_point[1];
-                if (myVecRef[i].m_point[2] > maxBox[2]) maxBox[2] = myVecRef[i].m_point[2];
-                tempvec = minBox - maxBox;
-                if (tempvec.length() > 0.01f * diagonal)//make sure points aren't all identical, would go to infinity recursively
-                {
-                    safeToSplit = true;
-                    break;
-                }
-            }
-            if (safeToSplit)
-            {
-                thisOct->makeChildren();
-                for (int i = 0; i < curSize; ++i)
-                {
-                    addPoint(thisOct->containingChild(myVecRef[i].m_point), myVecRef[i].m_point, myVecRef[i].m_index, myVecRef[i].m_mySet);
-                }
-                thisOct->m_data.freeData();
-            }
-        }
+        int64_t item = order[i];
+        m_leafX[i] = m_coords[item * 3];
+        m_leafY[i] = m_coords[item * 3 + 1];
+        m_leafZ[i] = m_coords[item * 3 + 2];
+        m_leafIndex[i] = m_indices[item];
+        m_leafSet[i] = m_sets[item];
+    }
+}
+
+void CaretPointLocator::fillInfo(const int32_t& leafPos, LocatorInfo* infoOut) const
+{
+    if (infoOut == NULL) return;
+    if (leafPos < 0)
+    {
+        infoOut->whichSet = -1;
+        infoOut->index = -1;
     } else {
-        addPoint(thisOct->containingChild(point), point, index, pointSet);
+        infoOut->whichSet = m_leafSet[leafPos];
+        infoOut->index = m_leafIndex[leafPos];
+        infoOut->coords[0] = m_leafX[leafPos];
+        infoOut->coords[1] = m_leafY[leafPos];
+        infoOut->coords[2] = m_leafZ[leafPos];
     }
 }
 
@@ -75,279 +68,141 @@ int32_t CaretPointLocator::addPointSet(const float* coordsIn, const int64_t numC
     CaretMutexLocker locked(&m_modifyMutex);
     int32_t setNum = newIndex();
     if (numCoords < 1) return setNum;
-    if (m_tree == NULL)
-    {
-        Vector3D minBox, maxBox;
-        minBox = maxBox = coordsIn;//hack - first triple
-        for (int64_t i = 1; i < numCoords; ++i)
-        {
-            int64_t i3 = i * 3;
-            if (coordsIn[i3] < minBox[0]) minBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] < minBox[1]) minBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] < minBox[2]) minBox[2] = coordsIn[i3 + 2];
-            if (coordsIn[i3] > maxBox[0]) maxBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] > maxBox[1]) maxBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] > maxBox[2]) maxBox[2] = coordsIn[i3 + 2];
-        }
-        m_tree = new Oct<LeafVector<Point> >(minBox, maxBox);
-    }
+    m_coords.insert(m_coords.end(), coordsIn, coordsIn + numCoords * 3);
     for (int64_t i = 0; i < numCoords; ++i)
     {
-        int64_t i3 = i * 3;
-        m_tree = m_tree->makeContains(coordsIn + i3);//make new root if needed
-        addPoint(m_tree, coordsIn + i3, i, setNum);//and add the point
+        m_indices.push_back(i);
+        m_sets.push_back(setNum);
     }
+    rebuildTree();
     return setNum;
 }
 
 CaretPointLocator::CaretPointLocator(const float* coordsIn, const int64_t numCoords)
 {
     m_nextSetIndex = 1;//next set will be set #1
-    m_tree = NULL;
     if (numCoords >= 1)
     {
-        Vector3D minBox, maxBox;
-        minBox = maxBox = coordsIn;//hack - first triple
-        for (int64_t i = 1; i < numCoords; ++i)
-        {
-            int64_t i3 = i * 3;
-            if (coordsIn[i3] < minBox[0]) minBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] < minBox[1]) minBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] < minBox[2]) minBox[2] = coordsIn[i3 + 2];
-            if (coordsIn[i3] > maxBox[0]) maxBox[0] = coordsIn[i3];
-            if (coordsIn[i3 + 1] > maxBox[1]) maxBox[1] = coordsIn[i3 + 1];
-            if (coordsIn[i3 + 2] > maxBox[2]) maxBox[2] = coordsIn[i3 + 2];
-        }
-        m_tree = new Oct<LeafVector<Point> >(minBox, maxBox);
+        m_coords.assign(coordsIn, coordsIn + numCoords * 3);
+        m_indices.resize(numCoords);
+        m_sets.assign(numCoords, 0);//this is set #0
         for (int64_t i = 0; i < numCoords; ++i)
         {
-            int64_t i3 = i * 3;
-            addPoint(m_tree, coordsIn + i3, i, 0);//this is set #0
+            m_indices[i] = i;
         }
+        rebuildTree();
     }
 }
 
-CaretPointLocator::CaretPointLocator(const float minBounds[3], const float maxBounds[3])
+CaretPointLocator::CaretPointLocator(const float[3], const float[3])
 {
     m_nextSetIndex = 0;
-    m_tree = new Oct<LeafVector<Point> >(minBounds, maxBounds);
 }
 
 int64_t CaretPointLocator::closestPoint(const float target[3], LocatorInfo* infoOut) const
 {
-    if (m_tree == NULL) return -1;
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;
-    bool first = true;
-    float bestDist2 = -1.0f, bestDist = -1.0f, tempf, curDist = m_tree->distToPoint(target);
-    Vector3D bestPoint;
-    int64_t bestIndex = -1;
-    int32_t bestSet = -1;
-    myHeap.push(m_tree, curDist);
-    while (curDist < bestDist || first)
-    {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop();
-        if (thisOct->m_leaf)
-        {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
-            {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < bestDist2 || first)
-                {
-                    first = false;
-                    bestDist2 = tempf;
-                    bestPoint = myVecRef[i].m_point;
-                    bestSet = myVecRef[i].m_mySet;
-                    bestIndex = myVecRef[i].m_index;
-                }
-            }
-            bestDist = sqrt(bestDist2);
-        } else {
-            for (int ii = 0; ii < 2; ++ii)
-            {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distToPoint(target);
-                        if (tempf < bestDist || first)
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
-                }
-            }
-        }
-        if (myHeap.isEmpty())
-        {
-            break;//allows us to use top() without violating an assertion
-        }
-        myHeap.top(&curDist);//get the key for the next item
-    }
-    if (infoOut != NULL)
-    {
-        infoOut->whichSet = bestSet;
-        infoOut->coords = bestPoint;
-        infoOut->index = bestIndex;
-    }
-    return bestIndex;
+    return closestPointLimited(target, numeric_limits<float>::infinity(), infoOut);
 }
 
 int64_t CaretPointLocator::closestPointLimited(const float target[3], const float& maxDist, LocatorInfo* infoOut) const
 {
-    if (m_tree == NULL) return -1;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist;
-    if (curDist2 > maxDist2)
+    struct ClosestLeaf
     {
-        if (infoOut != NULL)
+        const CaretPointLocator* m_this;
+        const float* m_target;
+        int32_t m_bestPos;
+        void operator()(const BoundingVolumeHierarchy::Node& leaf, float& bestDist2)
         {
-            infoOut->whichSet = -1;
-            infoOut->index = -1;
-        }
-        return -1;
-    }
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;
-    bool first = true;
-    float bestDist2 = -1.0f, tempf;
-    Vector3D bestPoint;
-    int64_t bestIndex = -1;
-    int32_t bestSet = -1;
-    myHeap.push(m_tree, curDist2);
-    while (curDist2 < bestDist2 || first)
-    {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop();
-        if (thisOct->m_leaf)
-        {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
+            const float* xData = m_this->m_leafX.data(), *yData = m_this->m_leafY.data(), *zData = m_this->m_leafZ.data();
+            const int32_t end = leaf.m_start + leaf.m_count;
+            for (int32_t i = leaf.m_start; i < end; ++i)
             {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < bestDist2 || (first && tempf <= maxDist2))
+                float dx = xData[i] - m_target[0], dy = yData[i] - m_target[1], dz = zData[i] - m_target[2];
+                float tempf = dx * dx + dy * dy + dz * dz;
+                if (tempf < bestDist2 || (m_bestPos == -1 && tempf <= bestDist2))
                 {
-                    first = false;
                     bestDist2 = tempf;
-                    bestPoint = myVecRef[i].m_point;
-                    bestSet = myVecRef[i].m_mySet;
-                    bestIndex = myVecRef[i].m_index;
-                }
-            }
-        } else {
-            for (int ii = 0; ii < 2; ++ii)
-            {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf < bestDist2 || (first && tempf <= maxDist2))
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
+                    m_bestPos = i;
                 }
             }
         }
-        if (myHeap.isEmpty())
-        {
-            break;//allows us to use top() without violating an assertion
-        }
-        myHeap.top(&curDist2);//get the key for the next item
-    }
-    if (infoOut != NULL)
-    {
-        infoOut->whichSet = bestSet;
-        infoOut->coords = bestPoint;
-        infoOut->index = bestIndex;
-    }
-    return bestIndex;
+    } myLeafFunc;
+    myLeafFunc.m_this = this;
+    myLeafFunc.m_target = target;
+    myLeafFunc.m_bestPos = -1;
+    m_tree.nearestSearch(target, myLeafFunc, maxDist * maxDist);
+    fillInfo(myLeafFunc.m_bestPos, infoOut);
+    if (myLeafFunc.m_bestPos == -1) return -1;
+    return m_leafIndex[myLeafFunc.m_bestPos];
 }
 
 set<LocatorInfo> CaretPointLocator::pointsInRange(const float target[3], const float& maxDist) const
 {
-    set<LocatorInfo> ret;
-    if (m_tree == NULL) return ret;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist;
-    if (curDist2 > maxDist2) return ret;
-    vector<Oct<LeafVector<Point> >*> myStack;//since we don't need the points sorted by distance
-    myStack.push_back(m_tree);
-    while (!myStack.empty())
+    struct RangeTest
+    {
+        const float* m_target;
+        float m_maxDist2;
+        bool operator()(const BoundingVolumeHierarchy::Node& node) const { return node.distSquaredToPoint(m_target) <= m_maxDist2; }
+    } myTest;
+    myTest.m_target = target;
+    myTest.m_maxDist2 = maxDist * maxDist;
+    struct RangeLeaf
     {
-        Oct<LeafVector<Point> >* thisOct = myStack.back();
-        myStack.pop_back();
-        if (thisOct->m_leaf)
+        const CaretPointLocator* m_this;
+        const float* m_target;
+        float m_maxDist2;
+        set<LocatorInfo> m_found;
+        void operator()(const BoundingVolumeHierarchy::Node& leaf)
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
+            const int32_t end = leaf.m_start + leaf.m_count;
+            for (int32_t i = leaf.m_start; i < end; ++i)
             {
-                float tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf <= maxDist2)
+                float dx = m_this->m_leafX[i] - m_target[0], dy = m_this->m_leafY[i] - m_target[1], dz = m_this->m_leafZ[i] - m_target[2];
+                if (dx * dx + dy * dy + dz * dz <= m_maxDist2)
                 {
-                    ret.insert(LocatorInfo(myVecRef[i].m_index, myVecRef[i].m_mySet, myVecRef[i].m_point));
-                }
-            }
-        } else {
-            for (int ii = 0; ii < 2; ++ii)
-            {
-                for (int ij = 0; ij < 2; ++ij)
-                {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        float tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf <= maxDist2)
-                        {
-                            myStack.push_back(thisOct->m_children[ii][ij][ik]);
-                        }
-                    }
+                    LocatorInfo tempInfo(-1, -1, Vector3D());
+                    m_this->fillInfo(i, &tempInfo);
+                    m_found.insert(tempInfo);
                 }
             }
         }
-    }
-    return ret;
+    } myLeafFunc;
+    myLeafFunc.m_this = this;
+    myLeafFunc.m_target = target;
+    myLeafFunc.m_maxDist2 = myTest.m_maxDist2;
+    m_tree.traverse(myTest, myLeafFunc);
+    return myLeafFunc.m_found;
 }
 
 bool CaretPointLocator::anyInRange(const float target[3], const float& maxDist) const
 {
-    if (m_tree == NULL) return false;
-    float curDist2 = m_tree->distSquaredToPoint(target), maxDist2 = maxDist * maxDist, tempf;
-    if (curDist2 > maxDist2) return false;
-    CaretSimpleMinHeap<Oct<LeafVector<Point> >*, float> myHeap;//closer octs are more likely to contain a close enough point
-    myHeap.push(m_tree, curDist2);
-    while (!myHeap.isEmpty())
+    struct AnyLeaf
     {
-        Oct<LeafVector<Point> >* thisOct = myHeap.pop(&curDist2);
-        if (thisOct->m_leaf)
+        const CaretPointLocator* m_this;
+        const float* m_target;
+        float m_maxDist2;
+        bool m_found;
+        void operator()(const BoundingVolumeHierarchy::Node& leaf, float& bestDist2)
         {
-            vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-            int curSize = (int)myVecRef.size();
-            for (int i = 0; i < curSize; ++i)
-            {
-                tempf = MathFunctions::distanceSquared3D(myVecRef[i].m_point, target);
-                if (tempf < maxDist2)
-                {
-                    return true;
-                }
-            }
-        } else {
-            for (int ii = 0; ii < 2; ++ii)
+            const int32_t end = leaf.m_start + leaf.m_count;
+            for (int32_t i = leaf.m_start; i < end; ++i)
             {
-                for (int ij = 0; ij < 2; ++ij)
+                float dx = m_this->m_leafX[i] - m_target[0], dy = m_this->m_leafY[i] - m_target[1], dz = m_this->m_leafZ[i] - m_target[2];
+                if (dx * dx + dy * dy + dz * dz < m_maxDist2)
                 {
-                    for (int ik = 0; ik < 2; ++ik)
-                    {
-                        tempf = thisOct->m_children[ii][ij][ik]->distSquaredToPoint(target);
-                        if (tempf <= maxDist2)
-                        {
-                            myHeap.push(thisOct->m_children[ii][ij][ik], tempf);
-                        }
-                    }
+                    m_found = true;
+                    bestDist2 = -1.0f;//nothing is closer than this, so the search stops
+                    return;
                 }
             }
         }
-    }
-    return false;
+    } myLeafFunc;//the nearest search visits closer leaves first, which are more likely to contain a close enough point
+    myLeafFunc.m_this = this;
+    myLeafFunc.m_target = target;
+    myLeafFunc.m_maxDist2 = maxDist * maxDist;
+    myLeafFunc.m_found = false;
+    m_tree.nearestSearch(target, myLeafFunc, myLeafFunc.m_maxDist2);
+    return myLeafFunc.m_found;
 }
 
 int32_t CaretPointLocator::newIndex()
@@ -366,48 +221,25 @@ void CaretPointLocator::removePointSet(int32_t whichSet)
 {
     CaretMutexLocker locked(&m_modifyMutex);
     m_unusedIndexes.push_back(whichSet);
-    removeSetHelper(m_tree, whichSet);
-}
-
-void CaretPointLocator::removeSetHelper(Oct<LeafVector<CaretPointLocator::Point> >* thisOct, int32_t thisSet)
-{
-    if (thisOct == NULL) return;
-    if (thisOct->m_leaf)
+    int64_t numPoints = (int64_t)m_indices.size(), numKept = 0;
+    for (int64_t i = 0; i < numPoints; ++i)
     {
-        vector<Point>& myVecRef = *(thisOct->m_data.m_vector);
-        int curSize = (int)myVecRef.size();
-        bool match = false;
-        for (int i = 0; i < curSize; ++i)//make sure something gets removed, so we don't have to do an allocation if it isn't needed
-        {
-            if (myVecRef[i].m_mySet == thisSet)
-            {
-                match = true;
-                break;
-            }
-        }
-        if (match)
+        if (m_sets[i] != whichSet)
         {
-            vector<Point> tempvec;
-            tempvec.reserve(curSize - 1);//because at least one is getting removed
-            for (int i = 0; i < curSize; ++i)
+            if (numKept != i)
             {
-                if (myVecRef[i].m_mySet != thisSet)
-                {
-                    tempvec.push_back(myVecRef[i]);
-                }
-            }
-            myVecRef = tempvec;
-        }
-    } else {
-        for (int ii = 0; ii < 2; ++ii)
-        {
-            for (int ij = 0; ij < 2; ++ij)
-            {
-                for (int ik = 0; ik < 2; ++ik)
-                {
-                    removeSetHelper(thisOct->m_children[ii][ij][ik], thisSet);
-                }
+                m_coords[numKept * 3] = m_coords[i * 3];
+                m_coords[numKept * 3 + 1] = m_coords[i * 3 + 1];
+                m_coords[numKept * 3 + 2] = m_coords[i * 3 + 2];
+                m_indices[numKept] = m_indices[i];
+                m_sets[numKept] = m_sets[i];
             }
+            ++numKept;
         }
     }
+    if (numKept == numPoints) return;
+    m_coords.resize(numKept * 3);
+    m_indices.resize(numKept);
+    m_sets.resize(numKept);
+    rebuildTree();
 }
@@ -22,8 +22,8 @@
  */
 /*LICENSE_END*/
 
+#include "BoundingVolumeHierarchy.h"
 #include "CaretMutex.h"
-#include "OctTree.h"
 #include "Vector3D.h"
 
 #include <set>
@@ -51,33 +51,28 @@ namespace caret {
     
     class CaretPointLocator
     {
-        struct Point
-        {
-            Vector3D m_point;
-            int64_t m_index;
-            int32_t m_mySet;
-            Point(const float point[3], const int64_t index, const int32_t mySet)
-            {
-                m_point = point;
-                m_index = index;
-                m_mySet = mySet;
-            }
-        };
         CaretMutex m_modifyMutex;//thread safety, don't let multiple threads modify the point sets at once
-        Oct<LeafVector<Point> >* m_tree;
+        BoundingVolumeHierarchy m_tree;
+        std::vector<float> m_coords;//all points, in the order they were added, used for rebuilding
+        std::vector<int64_t> m_indices;
+        std::vector<int32_t> m_sets;
+        std::vector<float> m_leafX, m_leafY, m_leafZ;//copies in tree leaf order, separate arrays so the leaf loops vectorize
+        std::vector<int64_t> m_leafIndex;
+        std::vector<int32_t> m_leafSet;
         int32_t m_nextSetIndex;
         std::vector<int32_t> m_unusedIndexes;
-        void addPoint(Oct<LeafVector<Point> >* thisOct, const float point[3], const int64_t index, const int32_t pointSet);
         int32_t newIndex();
-        static const int NUM_POINTS_SPLIT = 100;
-        void removeSetHelper(Oct<LeafVector<Point> >* thisOct, const int32_t thisSet);
+        void rebuildTree();
+        void fillInfo(const int32_t& leafPos, LocatorInfo* infoOut) const;
+        static const int NUM_POINTS_LEAF = 8;
         CaretPointLocator();
     public:
-        ///make an empty point locator with given bounding box (bounding box can expand later, but may be less efficient
+        ///make an empty point locator - the bounds are no longer needed, they are only kept for compatibility
         CaretPointLocator(const float minBounds[3], const float maxBounds[3]);
         ///make a point locator with the bounding box of this point set, and use this point set as set #0
         CaretPointLocator(const float* coordsIn, const int64_t numCoords);
         ///add a point set, SAVE THE RETURN VALUE because it is how you identify which point set found points belong to
+        ///rebuilds the whole tree, so adding many small sets is slow
         int32_t addPointSet(const float* coordsIn, const int64_t numCoords);
         ///remove a point set by its set number
         void removePointSet(const int32_t whichSet);
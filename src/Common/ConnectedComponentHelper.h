@@ -0,0 +1,146 @@
+#ifndef __CONNECTED_COMPONENT_HELPER_H__
+#define __CONNECTED_COMPONENT_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+
+#include <vector>
+#include "stdint.h"
+
+namespace caret
+{
+    ///connected component labeling with union-find, done on contiguous blocks of element indices in parallel, then merged across block boundaries
+    ///every union links the larger root under the smaller, so a parent always has a lower index than its child, which makes the final labeling a single ascending pass
+    ///and numbers the clusters in order of their lowest element, the same order that a flood fill started from each unvisited element in index order would find them
+    class ConnectedComponentHelper
+    {
+        static int64_t findRoot(std::vector<int64_t>& parent, int64_t elem)
+        {
+            while (parent[elem] != elem)
+            {
+                parent[elem] = parent[parent[elem]];//path halving, only ever makes the parent index smaller
+                elem = parent[elem];
+            }
+            return elem;
+        }
+        static void unite(std::vector<int64_t>& parent, const int64_t& first, const int64_t& second)
+        {
+            int64_t root1 = findRoot(parent, first), root2 = findRoot(parent, second);
+            if (root1 < root2)
+            {
+                parent[root2] = root1;
+            } else if (root2 < root1) {
+                parent[root1] = root2;
+            }
+        }
+    public:
+        ///clusterOut receives the cluster index of each marked element, and -1 for unmarked elements, returns the number of clusters
+        ///getNeighbors must be callable from multiple threads as getNeighbors(elem, std::vector<int64_t>& neighOut)
+        ///set parallel to false when the caller is already running several of these at once
+        template <typename NeighborFunc>
+        static int64_t labelComponents(const int64_t& numElements, const char* marked, const NeighborFunc& getNeighbors, std::vector<int64_t>& clusterOut, const bool& parallel = true);
+        ///same, but with a given number of blocks, which are processed in parallel when openmp is available, mainly so tests can exercise the merge across blocks
+        template <typename NeighborFunc>
+        static int64_t labelComponentsInBlocks(const int64_t& numElements, const char* marked, const NeighborFunc& getNeighbors, std::vector<int64_t>& clusterOut, const int& numBlocks);
+    };
+
+    template <typename NeighborFunc>
+    int64_t ConnectedComponentHelper::labelComponents(const int64_t& numElements, const char* marked, const NeighborFunc& getNeighbors, std::vector<int64_t>& clusterOut, const bool& parallel)
+    {
+        int numBlocks = 1;
+#ifdef CARET_OMP
+        if (parallel) numBlocks = omp_get_max_threads();
+#endif
+        if (numBlocks > numElements / 1024 + 1) numBlocks = (int)(numElements / 1024 + 1);//don't bother splitting tiny problems
+        return labelComponentsInBlocks(numElements, marked, getNeighbors, clusterOut, numBlocks);
+    }
+    
+    template <typename NeighborFunc>
+    int64_t ConnectedComponentHelper::labelComponentsInBlocks(const int64_t& numElements, const char* marked, const NeighborFunc& getNeighbors, std::vector<int64_t>& clusterOut, const int& numBlocksIn)
+    {
+        std::vector<int64_t> parent(numElements, -1);
+        int numBlocks = numBlocksIn;
+        if (numBlocks > numElements) numBlocks = (int)numElements;
+        if (numBlocks < 1) numBlocks = 1;
+        std::vector<int64_t> blockStart(numBlocks + 1);
+        for (int b = 0; b <= numBlocks; ++b)
+        {
+            blockStart[b] = (numElements * b) / numBlocks;
+        }
+        std::vector<std::vector<int64_t> > crossEdges(numBlocks);//pairs of elements, flattened
+#pragma omp CARET_PARFOR schedule(static, 1) if(numBlocks > 1)
+        for (int b = 0; b < numBlocks; ++b)
+        {//within a block, parents never leave the block, so the blocks don't interact
+            std::vector<int64_t> neighbors;
+            const int64_t start = blockStart[b], end = blockStart[b + 1];
+            for (int64_t i = start; i < end; ++i)
+            {
+                if (marked[i]) parent[i] = i;
+            }
+            for (int64_t i = start; i < end; ++i)
+            {
+                if (!marked[i]) continue;
+                getNeighbors(i, neighbors);
+                int numNeigh = (int)neighbors.size();
+                for (int n = 0; n < numNeigh; ++n)
+                {
+                    const int64_t& neigh = neighbors[n];
+                    if (!marked[neigh]) continue;
+                    if (neigh >= start && neigh < end)
+                    {
+                        if (neigh < i) unite(parent, i, neigh);//each edge only needs to be processed once
+                    } else if (neigh < start) {//only record the edge from the higher block
+                        crossEdges[b].push_back(i);
+                        crossEdges[b].push_back(neigh);
+                    }
+                }
+            }
+        }
+        for (int b = 1; b < numBlocks; ++b)
+        {
+            int64_t numCross = (int64_t)crossEdges[b].size();
+            for (int64_t e = 0; e < numCross; e += 2)
+            {
+                unite(parent, crossEdges[b][e], crossEdges[b][e + 1]);
+            }
+        }
+        clusterOut.resize(numElements);
+        int64_t numClusters = 0;
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            if (parent[i] == -1)
+            {
+                clusterOut[i] = -1;
+            } else if (parent[i] == i) {
+                clusterOut[i] = numClusters;
+                ++numClusters;
+            } else {
+                CaretAssert(parent[i] < i);
+                clusterOut[i] = clusterOut[parent[i]];//parent was already labeled, since it has a lower index
+            }
+        }
+        return numClusters;
+    }
+}
+
+#endif //__CONNECTED_COMPONENT_HELPER_H__
@@ -36,7 +36,8 @@ public:
      */
     enum Enum {
         DEVELOPER_FLAG_UNUSED,
-        DEVELOPER_FLAG_FLIP_PALETTE_NOT_DATA
+        DEVELOPER_FLAG_FLIP_PALETTE_NOT_DATA,
+        DEVELOPER_FLAG_FRAME_PROFILER
     };
 
     ~DeveloperFlagsEnum();
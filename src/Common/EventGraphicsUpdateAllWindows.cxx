@@ -25,7 +25,7 @@ using namespace caret;
 /**
  * \class caret::EventGraphicsUpdateAllWindows 
  * \brief Event for updating all Window gui elements.
- * \ingroup GuiQt
+ * \ingroup Common
  */
 
 /**
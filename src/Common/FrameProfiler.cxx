@@ -0,0 +1,378 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __FRAME_PROFILER_DECLARE__
+#include "FrameProfiler.h"
+#undef __FRAME_PROFILER_DECLARE__
+
+#include <algorithm>
+#include <fstream>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "DataFileException.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::FrameProfiler
+ * \brief Times the stages of drawing graphics
+ * \ingroup Common
+ *
+ * Stages are timed by placing a FrameProfiler::Scope at the start of
+ * the code that performs the stage.  Stages within a stage are nested
+ * under it.  When profiling is disabled, a scope only tests a flag.
+ *
+ * The timings of the last frame (between beginFrame() and endFrame())
+ * may be displayed, the timings of each stage are accumulated over all
+ * frames, and all stages may be written as a Chrome trace (viewable at
+ * chrome://tracing).
+ *
+ * Stages must only be timed in the main thread.
+ */
+
+/**
+ * @return The frame profiler.
+ */
+FrameProfiler*
+FrameProfiler::get()
+{
+    static FrameProfiler s_frameProfiler;
+    return &s_frameProfiler;
+}
+
+/**
+ * Enable or disable profiling.  Timings are cleared when
+ * profiling is enabled.
+ *
+ * @param enabledFlag
+ *     New status.
+ */
+void
+FrameProfiler::setEnabled(const bool enabledFlag)
+{
+    if (enabledFlag
+        && ( ! s_enabledFlag)) {
+        get()->clear();
+    }
+    s_enabledFlag = enabledFlag;
+}
+
+/**
+ * Constructor.
+ */
+FrameProfiler::FrameProfiler()
+: CaretObject()
+{
+    m_timer.start();
+}
+
+/**
+ * Destructor.
+ */
+FrameProfiler::~FrameProfiler()
+{
+}
+
+/**
+ * Begin a frame.  Stages that begin before the frame ends
+ * are the last frame's stages.
+ */
+void
+FrameProfiler::beginFrame()
+{
+    if ( ! s_enabledFlag) {
+        return;
+    }
+    
+    /*
+     * A frame may begin within a stage whose event must remain valid
+     */
+    if (m_depth == 0) {
+        m_frameEvents.clear();
+    }
+    m_frameFirstEventIndex = static_cast<int64_t>(m_frameEvents.size());
+    m_frameFirstDepth = m_depth;
+    m_frameActiveFlag = true;
+}
+
+/**
+ * End a frame.
+ */
+void
+FrameProfiler::endFrame()
+{
+    if ( ! s_enabledFlag) {
+        return;
+    }
+    
+    m_lastFrameEvents.clear();
+    for (int64_t i = m_frameFirstEventIndex; i < static_cast<int64_t>(m_frameEvents.size()); i++) {
+        Event event = m_frameEvents[i];
+        event.m_depth = std::max(event.m_depth - m_frameFirstDepth,
+                                 0);
+        m_lastFrameEvents.push_back(event);
+    }
+    
+    if (m_depth == 0) {
+        m_frameEvents.clear();
+    }
+    m_frameFirstEventIndex = 0;
+    m_frameFirstDepth = 0;
+    m_frameActiveFlag = false;
+}
+
+/**
+ * Clear all timings.
+ */
+void
+FrameProfiler::clear()
+{
+    m_frameEvents.clear();
+    m_lastFrameEvents.clear();
+    m_traceEvents.clear();
+    m_stageTimings.clear();
+    m_depth = 0;
+    m_frameFirstEventIndex = 0;
+    m_frameFirstDepth = 0;
+    m_frameActiveFlag = false;
+}
+
+/**
+ * Begin timing a stage.
+ *
+ * @param stageName
+ *     Name of the stage.
+ * @return
+ *     Index identifying the stage.
+ */
+int64_t
+FrameProfiler::beginStage(const char* stageName)
+{
+    CaretAssert(stageName);
+
+    Event event;
+    event.m_stageName = stageName;
+    event.m_depth     = m_depth;
+    event.m_startMilliseconds    = m_timer.getElapsedTimeMilliseconds();
+    event.m_durationMilliseconds = 0.0;
+    m_frameEvents.push_back(event);
+
+    ++m_depth;
+
+    return static_cast<int64_t>(m_frameEvents.size() - 1);
+}
+
+/**
+ * End timing a stage.
+ *
+ * @param eventIndex
+ *     Index returned when the stage began.
+ */
+void
+FrameProfiler::endStage(const int64_t eventIndex)
+{
+    /*
+     * Profiling may have been cleared while the stage was timed
+     */
+    if (eventIndex >= static_cast<int64_t>(m_frameEvents.size())) {
+        return;
+    }
+
+    Event& event = m_frameEvents[eventIndex];
+    event.m_durationMilliseconds = (m_timer.getElapsedTimeMilliseconds()
+                                    - event.m_startMilliseconds);
+    m_depth = event.m_depth;
+
+    StageTiming& timing = m_stageTimings[event.m_stageName];
+    timing.m_count++;
+    timing.m_totalMilliseconds += event.m_durationMilliseconds;
+    timing.m_maximumMilliseconds = std::max(timing.m_maximumMilliseconds,
+                                            event.m_durationMilliseconds);
+
+    if (static_cast<int64_t>(m_traceEvents.size()) < s_maximumNumberOfTraceEvents) {
+        m_traceEvents.push_back(event);
+    }
+    
+    /*
+     * Stages outside of a frame are only needed until they complete
+     */
+    if ((m_depth == 0)
+        && ( ! m_frameActiveFlag)) {
+        m_frameEvents.clear();
+    }
+}
+
+/**
+ * @return Timings of the stages in the last frame, one line per stage
+ * indented by nesting.  Stages with the same name in the same enclosing
+ * stage, such as drawing of each text annotation, are combined.
+ */
+std::vector<AString>
+FrameProfiler::getLastFrameTimings() const
+{
+    /*
+     * Combine stages by their names and the names of enclosing stages
+     */
+    std::vector<AString> paths;
+    std::vector<int32_t> depths;
+    std::vector<double> milliseconds;
+    std::vector<int64_t> counts;
+    std::map<AString, int32_t> pathIndices;
+
+    std::vector<AString> pathStack;
+    for (const auto& event : m_lastFrameEvents) {
+        pathStack.resize(event.m_depth);
+        const AString path = ((event.m_depth > 0)
+                              ? (pathStack.back() + "/" + event.m_stageName)
+                              : AString(event.m_stageName));
+        pathStack.push_back(path);
+
+        std::map<AString, int32_t>::iterator iter = pathIndices.find(path);
+        if (iter == pathIndices.end()) {
+            pathIndices.insert(std::make_pair(path,
+                                              static_cast<int32_t>(paths.size())));
+            paths.push_back(event.m_stageName);
+            depths.push_back(event.m_depth);
+            milliseconds.push_back(event.m_durationMilliseconds);
+            counts.push_back(1);
+        }
+        else {
+            milliseconds[iter->second] += event.m_durationMilliseconds;
+            counts[iter->second]++;
+        }
+    }
+
+    std::vector<AString> linesOut;
+    for (int32_t i = 0; i < static_cast<int32_t>(paths.size()); i++) {
+        AString line = (AString("  ").repeated(depths[i])
+                        + paths[i]
+                        + " "
+                        + AString::number(milliseconds[i], 'f', 2)
+                        + " ms");
+        if (counts[i] > 1) {
+            line += (" ("
+                     + AString::number(counts[i])
+                     + ")");
+        }
+        linesOut.push_back(line);
+    }
+
+    return linesOut;
+}
+
+/**
+ * @return Text containing the accumulated timings of each stage,
+ * in order of decreasing total time.
+ */
+AString
+FrameProfiler::getStageTimingsText() const
+{
+    std::vector<std::pair<double, const char*>> totalsAndNames;
+    for (const auto& nameTiming : m_stageTimings) {
+        totalsAndNames.push_back(std::make_pair(nameTiming.second.m_totalMilliseconds,
+                                                nameTiming.first));
+    }
+    std::sort(totalsAndNames.begin(),
+              totalsAndNames.end(),
+              [](const std::pair<double, const char*>& a,
+                 const std::pair<double, const char*>& b) { return (a.first > b.first); });
+
+    AString text = ("Stage                                      Count    Total (ms)     Mean (ms)      Max (ms)\n");
+    for (const auto& totalName : totalsAndNames) {
+        const StageTiming& timing = m_stageTimings.find(totalName.second)->second;
+        CaretAssert(timing.m_count > 0);
+        text += (AString(totalName.second).leftJustified(40)
+                 + AString::number(timing.m_count).rightJustified(8)
+                 + AString::number(timing.m_totalMilliseconds, 'f', 3).rightJustified(14)
+                 + AString::number(timing.m_totalMilliseconds / timing.m_count, 'f', 3).rightJustified(14)
+                 + AString::number(timing.m_maximumMilliseconds, 'f', 3).rightJustified(14)
+                 + "\n");
+    }
+
+    return text;
+}
+
+/**
+ * Write all stages that have completed, since profiling was enabled or
+ * cleared, as a Chrome trace JSON file.
+ *
+ * @param fileName
+ *     Name of the file.
+ * @throw DataFileException
+ *     If there is an error writing the file.
+ */
+void
+FrameProfiler::writeChromeTrace(const AString& fileName) const
+{
+    std::ofstream traceFile(fileName.toLocal8Bit().constData());
+    if ( ! traceFile) {
+        throw DataFileException(fileName,
+                                "Unable to open for writing.");
+    }
+
+    if (static_cast<int64_t>(m_traceEvents.size()) >= s_maximumNumberOfTraceEvents) {
+        CaretLogWarning("Frame profiler trace is limited to the first "
+                        + AString::number(s_maximumNumberOfTraceEvents)
+                        + " stages.");
+    }
+
+    traceFile << "{\"traceEvents\":[\n";
+    bool firstFlag = true;
+    for (const auto& event : m_traceEvents) {
+        AString name(event.m_stageName);
+        name.replace("\\", "\\\\");
+        name.replace("\"", "\\\"");
+
+        if ( ! firstFlag) {
+            traceFile << ",\n";
+        }
+        firstFlag = false;
+
+        /*
+         * Times are in microseconds
+         */
+        traceFile << "{\"name\":\"" << name.toStdString()
+                  << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                  << ",\"ts\":" << AString::number(event.m_startMilliseconds * 1000.0, 'f', 1).toStdString()
+                  << ",\"dur\":" << AString::number(event.m_durationMilliseconds * 1000.0, 'f', 1).toStdString()
+                  << "}";
+    }
+    traceFile << "\n]}\n";
+
+    if ( ! traceFile) {
+        throw DataFileException(fileName,
+                                "Error while writing.");
+    }
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+FrameProfiler::toString() const
+{
+    return "FrameProfiler";
+}
+
@@ -0,0 +1,203 @@
+#ifndef __FRAME_PROFILER_H__
+#define __FRAME_PROFILER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "CaretObject.h"
+#include "ElapsedTimer.h"
+
+namespace caret {
+
+    class FrameProfiler : public CaretObject {
+
+    public:
+        /**
+         * Times the enclosing block, when profiling is enabled, as a
+         * stage nested within any enclosing stage.
+         */
+        class Scope {
+        public:
+            /**
+             * Constructor.
+             *
+             * @param stageName
+             *     Name of the stage, which must be a string literal.
+             */
+            Scope(const char* stageName)
+            : m_eventIndex(-1)
+            {
+                if (s_enabledFlag) {
+                    m_eventIndex = get()->beginStage(stageName);
+                }
+            }
+
+            ~Scope()
+            {
+                if (m_eventIndex >= 0) {
+                    get()->endStage(m_eventIndex);
+                }
+            }
+
+        private:
+            Scope(const Scope&);
+
+            Scope& operator=(const Scope&);
+
+            int64_t m_eventIndex;
+        };
+
+        /**
+         * Begins a frame that ends with the enclosing block.  Declare
+         * before any Scope in the same block so the frame ends last.
+         */
+        class Frame {
+        public:
+            Frame()
+            {
+                get()->beginFrame();
+            }
+
+            ~Frame()
+            {
+                get()->endFrame();
+            }
+
+        private:
+            Frame(const Frame&);
+
+            Frame& operator=(const Frame&);
+        };
+
+        static FrameProfiler* get();
+
+        /** @return True if profiling is enabled */
+        static inline bool isEnabled() { return s_enabledFlag; }
+
+        static void setEnabled(const bool enabledFlag);
+
+        virtual ~FrameProfiler();
+
+        void beginFrame();
+
+        void endFrame();
+
+        void clear();
+
+        std::vector<AString> getLastFrameTimings() const;
+
+        AString getStageTimingsText() const;
+
+        void writeChromeTrace(const AString& fileName) const;
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+    private:
+        /**
+         * A timed stage
+         */
+        class Event {
+        public:
+            const char* m_stageName;
+
+            int32_t m_depth;
+
+            double m_startMilliseconds;
+
+            double m_durationMilliseconds;
+        };
+
+        /**
+         * Accumulated times of a stage
+         */
+        class StageTiming {
+        public:
+            int64_t m_count = 0;
+
+            double m_totalMilliseconds = 0.0;
+
+            double m_maximumMilliseconds = 0.0;
+        };
+
+        /**
+         * Compares stage names by content since the same name in
+         * different files may be at different addresses
+         */
+        class StageNameLess {
+        public:
+            bool operator()(const char* a, const char* b) const {
+                return (std::strcmp(a, b) < 0);
+            }
+        };
+
+        FrameProfiler();
+
+        FrameProfiler(const FrameProfiler&);
+
+        FrameProfiler& operator=(const FrameProfiler&);
+
+        int64_t beginStage(const char* stageName);
+
+        void endStage(const int64_t eventIndex);
+
+        ElapsedTimer m_timer;
+
+        /** Stages since the frame began, in the order they began */
+        std::vector<Event> m_frameEvents;
+
+        std::vector<Event> m_lastFrameEvents;
+
+        /** Completed stages of all frames, for the trace */
+        std::vector<Event> m_traceEvents;
+
+        std::map<const char*, StageTiming, StageNameLess> m_stageTimings;
+
+        int32_t m_depth = 0;
+
+        bool m_frameActiveFlag = false;
+
+        /** Index of the current frame's first stage in m_frameEvents */
+        int64_t m_frameFirstEventIndex = 0;
+
+        /** Nesting depth when the current frame began */
+        int32_t m_frameFirstDepth = 0;
+
+        static bool s_enabledFlag;
+
+        static const int64_t s_maximumNumberOfTraceEvents;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __FRAME_PROFILER_DECLARE__
+    bool FrameProfiler::s_enabledFlag = false;
+
+    const int64_t FrameProfiler::s_maximumNumberOfTraceEvents = 1000000;
+#endif // __FRAME_PROFILER_DECLARE__
+
+} // namespace
+#endif  //__FRAME_PROFILER_H__
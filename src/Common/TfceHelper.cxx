@@ -0,0 +1,101 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TfceHelper.h"
+
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+TfceHelper::TfceHelper(const float& param_e, const float& param_h)
+{
+    m_param_e = param_e;
+    m_integrated_h = param_h + 1.0;//integral(x^h) = (x^(h + 1))/(h + 1) + C
+}
+
+int64_t TfceHelper::findRoot(const int64_t& elem)
+{
+    CaretAssertVectorIndex(m_parent, elem);
+    CaretAssert(m_parent[elem] != -1);
+    int64_t root = elem;
+    double pathSum = 0.0;//sum of offsets strictly below the root
+    while (m_parent[root] != root)
+    {
+        pathSum += m_offset[root];
+        root = m_parent[root];
+    }
+    int64_t cur = elem;
+    while (m_parent[cur] != root && cur != root)//path compression - each element's new offset is the sum from itself to just below the root
+    {
+        int64_t next = m_parent[cur];
+        double oldOffset = m_offset[cur];
+        m_offset[cur] = pathSum;
+        m_parent[cur] = root;
+        pathSum -= oldOffset;
+        cur = next;
+    }
+    return root;
+}
+
+void TfceHelper::updateRoot(const int64_t& root, const float& bottomVal)
+{
+    CaretAssert(m_parent[root] == root);
+    if (bottomVal != m_lastVal[root])//skip computing if there is no difference
+    {
+        CaretAssert(bottomVal < m_lastVal[root]);
+        double newSlice = pow(m_extent[root], m_param_e) * (pow((double)m_lastVal[root], m_integrated_h) - pow((double)bottomVal, m_integrated_h)) / m_integrated_h;
+        m_offset[root] += newSlice;//adding to the root adds to every member of the cluster
+        m_lastVal[root] = bottomVal;
+    }
+}
+
+void TfceHelper::addElement(const int64_t& elem, const float& value, const double& extent)
+{
+    int numTouching = (int)m_touchingRoots.size();
+    if (numTouching == 0)//make new cluster
+    {
+        m_parent[elem] = elem;
+        m_offset[elem] = 0.0;
+        m_extent[elem] = extent;
+        m_lastVal[elem] = value;
+        m_size[elem] = 1;
+        return;
+    }
+    int64_t mergedRoot = m_touchingRoots[0];//use the biggest cluster as the merged root, to keep the trees shallow
+    for (int i = 0; i < numTouching; ++i)
+    {
+        updateRoot(m_touchingRoots[i], value);//recalculate to align cluster bottoms
+        if (m_size[m_touchingRoots[i]] > m_size[mergedRoot]) mergedRoot = m_touchingRoots[i];
+    }
+    for (int i = 0; i < numTouching; ++i)
+    {
+        int64_t thisRoot = m_touchingRoots[i];
+        if (thisRoot == mergedRoot) continue;
+        m_parent[thisRoot] = mergedRoot;
+        m_offset[thisRoot] -= m_offset[mergedRoot];//keep the path sums of its members unchanged
+        m_extent[mergedRoot] += m_extent[thisRoot];
+        m_size[mergedRoot] += m_size[thisRoot];
+    }
+    m_parent[elem] = mergedRoot;
+    m_offset[elem] = -m_offset[mergedRoot];//the new element has integrated nothing yet
+    m_extent[mergedRoot] += extent;
+    m_size[mergedRoot] += 1;
+}
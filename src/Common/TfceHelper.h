@@ -0,0 +1,113 @@
+#ifndef __TFCE_HELPER_H__
+#define __TFCE_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "stdint.h"
+
+namespace caret
+{
+    ///exact TFCE integral for positive values on an arbitrary neighbor graph, using union-find so that merging clusters never touches their members
+    ///each element stores its integrated value as an offset from its parent, and a root's offset is the integral of its whole cluster, so the
+    ///area^E * h^H slices are only ever added to cluster roots, and the per-element result is the sum of offsets along the path to the root
+    class TfceHelper
+    {
+        std::vector<int64_t> m_parent;//-1 means not yet above threshold
+        std::vector<double> m_offset;
+        std::vector<double> m_extent;//only valid on roots
+        std::vector<float> m_lastVal;//only valid on roots
+        std::vector<int64_t> m_size;//only valid on roots, for union by size
+        std::vector<int64_t> m_touchingRoots, m_neighScratch;
+        double m_param_e, m_integrated_h;
+
+        int64_t findRoot(const int64_t& elem);
+        void updateRoot(const int64_t& root, const float& bottomVal);
+        void addElement(const int64_t& elem, const float& value, const double& extent);
+    public:
+        TfceHelper(const float& param_e, const float& param_h);
+
+        ///adds the TFCE integral of the positive values in data to accumData, elements that are not positive in data are ignored
+        ///extents may be NULL to use constExtent for every element (voxels), getNeighbors must be callable as getNeighbors(elem, std::vector<int64_t>& neighOut)
+        template <typename NeighborFunc>
+        void addPositive(const int64_t& numElements, const float* data, const float* extents, const float& constExtent, NeighborFunc& getNeighbors, double* accumData);
+    };
+
+    template <typename NeighborFunc>
+    void TfceHelper::addPositive(const int64_t& numElements, const float* data, const float* extents, const float& constExtent, NeighborFunc& getNeighbors, double* accumData)
+    {
+        m_parent.assign(numElements, -1);//other arrays are written before they are read, only need the space
+        m_offset.resize(numElements);
+        m_extent.resize(numElements);
+        m_lastVal.resize(numElements);
+        m_size.resize(numElements);
+        std::vector<std::pair<float, int64_t> > sorted;
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            if (data[i] > 0.0f)
+            {
+                sorted.push_back(std::make_pair(data[i], i));
+            }
+        }
+        std::sort(sorted.begin(), sorted.end(), std::greater<std::pair<float, int64_t> >());//sorting once is cheaper than a heap, we never change keys
+        int64_t numSorted = (int64_t)sorted.size();
+        for (int64_t i = 0; i < numSorted; ++i)
+        {
+            const int64_t& elem = sorted[i].second;
+            const float& value = sorted[i].first;
+            m_touchingRoots.clear();
+            getNeighbors(elem, m_neighScratch);
+            int numNeigh = (int)m_neighScratch.size();
+            for (int j = 0; j < numNeigh; ++j)
+            {
+                if (m_parent[m_neighScratch[j]] == -1) continue;
+                int64_t root = findRoot(m_neighScratch[j]);
+                if (std::find(m_touchingRoots.begin(), m_touchingRoots.end(), root) == m_touchingRoots.end())
+                {
+                    m_touchingRoots.push_back(root);
+                }
+            }
+            addElement(elem, value, (extents == NULL ? constExtent : extents[elem]));
+        }
+        for (int64_t i = 0; i < numSorted; ++i)//include the to-zero slice in every cluster that still exists
+        {
+            const int64_t& elem = sorted[i].second;
+            if (m_parent[elem] == elem) updateRoot(elem, 0.0f);
+        }
+        for (int64_t i = 0; i < numSorted; ++i)
+        {
+            const int64_t& elem = sorted[i].second;
+            int64_t root = findRoot(elem);//after compression, every element is either the root or directly under it
+            if (root == elem)
+            {
+                accumData[elem] += m_offset[elem];
+            } else {
+                accumData[elem] += m_offset[elem] + m_offset[root];
+            }
+        }
+    }
+}
+
+#endif //__TFCE_HELPER_H__
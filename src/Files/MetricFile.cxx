@@ -32,10 +32,14 @@
 #include "PaletteColorMapping.h"
 #include "SceneClass.h"
 
+#include <atomic>
 #include <limits>
 
 using namespace caret;
 
+/** Source of data arrays generations, unique across all metric files */
+static std::atomic<int64_t> s_dataArraysGenerationCounter(0);
+
 /**
  * Constructor.
  */
@@ -95,6 +99,17 @@ void MetricFile::writeFile(const AString& filename)
     caret::GiftiTypeFile::writeFile(filename);
 }
 
+/**
+ * @return Generation of the file's data arrays.  It changes whenever
+ * the data arrays are replaced, such as when the file is read again,
+ * even if the map unique identifiers read from the file are unchanged.
+ */
+int64_t
+MetricFile::getDataArraysGeneration() const
+{
+    return m_dataArraysGeneration;
+}
+
 /**
  * Clear the surface file.
  */
@@ -114,6 +129,7 @@ void
 MetricFile::validateDataArraysAfterReading()
 {
     this->columnDataPointers.clear();
+    m_dataArraysGeneration = ++s_dataArraysGenerationCounter;
 
     this->initializeMembersMetricFile();
         
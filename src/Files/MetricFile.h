@@ -98,6 +98,8 @@ namespace caret {
         
         //override writeFile in order to check filename against type of file
         virtual void writeFile(const AString& filename);
+        
+        int64_t getDataArraysGeneration() const;
 
     protected:
         /**
@@ -120,6 +122,9 @@ namespace caret {
     private:
         /** Points to actual data in each Gifti Data Array */
         std::vector<float*> columnDataPointers;
+        
+        /** Changes whenever the data arrays are replaced, such as when the file is read */
+        int64_t m_dataArraysGeneration = 0;
 
         bool m_chartingEnabledForTab[BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS];
     };
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <limits>
+#include <memory>
 
 //#include <QRunnable>
 //#include <QSemaphore>
@@ -38,6 +39,7 @@
 #include "GroupAndNameHierarchyItem.h"
 #include "Palette.h"
 #include "PaletteColorMapping.h"
+#include "PaletteLookupTable.h"
 #include "MathFunctions.h"
 
 using namespace caret;
@@ -92,6 +94,9 @@ static const float negativeThresholdGreenColor[] = {
  *    true type is provided by the previous parameter colorDataType.
  * @param ignoreThresholding
  *    If true, skip all threshold testing
+ * @param paletteIn
+ *    Palette for coloring.  If NULL, the palette selected in
+ *    the palette color mapping is used.
  */
 void
 NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* statistics,
@@ -102,13 +107,16 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                                                      const int64_t numberOfScalars,
                                                      const ColorDataType colorDataType,
                                                      void* rgbaOutPointer,
-                                                     const bool ignoreThresholding)
+                                                     const bool ignoreThresholding,
+                                                     const Palette* paletteIn)
 {
     if (numberOfScalars <= 0) {
         return;
     }
     
-    const Palette* palette = paletteColorMapping->getPalette();
+    const Palette* palette = ((paletteIn != NULL)
+                              ? paletteIn
+                              : paletteColorMapping->getPalette());
     CaretAssert(palette);
     
     CaretAssert(statistics);
@@ -197,6 +205,16 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                              rgbaNegativeOne);
     const bool rgbaNegativeOneValid = (rgbaNegativeOne[3] > 0.0);
     
+    /*
+     * When there are more scalars than lookup table bins, building
+     * the table is much faster than searching the palette for each scalar.
+     */
+    std::unique_ptr<PaletteLookupTable> paletteLookupTable;
+    if (numberOfScalars > PaletteLookupTable::NUMBER_OF_BINS) {
+        paletteLookupTable.reset(new PaletteLookupTable(palette,
+                                                        interpolateFlag));
+    }
+    
     /*
      * Color all scalars.
      */
@@ -294,9 +312,15 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
              * Color scalar using palette
              */
             float rgba[4];
-            palette->getPaletteColor(normalValue,
-                                     interpolateFlag,
-                                     rgba);
+            if (paletteLookupTable) {
+                paletteLookupTable->getPaletteColor(normalValue,
+                                                    rgba);
+            }
+            else {
+                palette->getPaletteColor(normalValue,
+                                         interpolateFlag,
+                                         rgba);
+            }
             if (rgba[3] > 0.0f) {
                 rgbaOut[0] = rgba[0];
                 rgbaOut[1] = rgba[1];
@@ -423,7 +447,8 @@ NodeAndVoxelColoring::colorScalarsWithPalette(const FastStatistics* statistics,
                                    numberOfScalars,
                                    COLOR_TYPE_FLOAT,
                                    (void*)rgbaOut,
-                                   ignoreThresholding);
+                                   ignoreThresholding,
+                                   NULL);
 }
 
 /**
@@ -469,7 +494,62 @@ NodeAndVoxelColoring::colorScalarsWithPalette(const FastStatistics* statistics,
                                    numberOfScalars,
                                    COLOR_TYPE_UNSIGNED_BTYE,
                                    (void*)rgbaOut,
-                                   ignoreThresholding);
+                                   ignoreThresholding,
+                                   NULL);
+}
+
+/**
+ * Color scalars using the given palette.
+ *
+ * The palette selected in a palette color mapping is found with an event,
+ * which may only be sent from the main thread.  Threads other than the
+ * main thread get the palette from getPalette() in the main thread and
+ * color with this method.
+ *
+ * @param statistics
+ *    Descriptive statistics for min/max values.
+ * @param paletteColorMapping
+ *    Specifies mapping of scalars to palette colors.
+ * @param palette
+ *    Palette used for coloring.
+ * @param scalarValues
+ *    Scalars that are used to color the values.
+ *    Number of elements is 'numberOfScalars'.
+ * @param thresholdPaletteColorMapping
+ *    Specifies thresholding for thresholding scalars.
+ * @param thresholdValues
+ *    Thresholds for inhibiting coloring.
+ *    Number of elements is 'numberOfScalars'.
+ * @param numberOfScalars
+ *    Number of scalars and thresholds.
+ * @param rgbaOut
+ *    RGBA Colors that are output.
+ *    Number of elements is 'numberOfScalars' * 4.
+ * @param ignoreThresholding
+ *    If true, skip all threshold testing
+ */
+void
+NodeAndVoxelColoring::colorScalarsWithPalette(const FastStatistics* statistics,
+                                              const PaletteColorMapping* paletteColorMapping,
+                                              const Palette* palette,
+                                              const float* scalarValues,
+                                              const PaletteColorMapping* thresholdPaletteColorMapping,
+                                              const float* thresholdValues,
+                                              const int64_t numberOfScalars,
+                                              uint8_t* rgbaOut,
+                                              const bool ignoreThresholding)
+{
+    CaretAssert(palette);
+    colorScalarsWithPalettePrivate(statistics,
+                                   paletteColorMapping,
+                                   scalarValues,
+                                   thresholdPaletteColorMapping,
+                                   thresholdValues,
+                                   numberOfScalars,
+                                   COLOR_TYPE_UNSIGNED_BTYE,
+                                   (void*)rgbaOut,
+                                   ignoreThresholding,
+                                   palette);
 }
 
 /**
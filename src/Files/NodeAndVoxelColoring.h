@@ -31,6 +31,7 @@
 namespace caret {
     class FastStatistics;
     class GiftiLabelTable;
+    class Palette;
     class PaletteColorMapping;
     
     class NodeAndVoxelColoring {
@@ -54,6 +55,16 @@ namespace caret {
                                             uint8_t* rgbaOut,
                                             const bool ignoreThresholding = false);
         
+        static void colorScalarsWithPalette(const FastStatistics* statistics,
+                                            const PaletteColorMapping* paletteColorMapping,
+                                            const Palette* palette,
+                                            const float* scalars,
+                                            const PaletteColorMapping* thresholdPaletteColorMapping,
+                                            const float* scalarThresholds,
+                                            const int64_t numberOfScalars,
+                                            uint8_t* rgbaOut,
+                                            const bool ignoreThresholding);
+        
         static void colorScalarsWithRGBA(const float* redComponents,
                                          const float* greenComponents,
                                          const float* blueComponents,
@@ -115,7 +126,8 @@ namespace caret {
                                                    const int64_t numberOfScalars,
                                                    const ColorDataType colorDataType,
                                                    void* rgbaOutPointer,
-                                                   const bool ignoreThresholding);
+                                                   const bool ignoreThresholding,
+                                                   const Palette* paletteIn);
         
         static void colorIndicesWithLabelTableForDisplayGroupTabPrivate(const GiftiLabelTable* labelTable,
                                                       const float* labelIndices,
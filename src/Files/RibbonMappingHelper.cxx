@@ -19,7 +19,7 @@
 /*LICENSE_END*/
 
 /*
- * For the function TriInfi::vertRayHit():
+ * For the function TriInfo::vertRayHitBatch():
  * Original copyright for PNPOLY, though my version is entirely rewritten and modified
  * Source: http://www.ecse.rpi.edu/Homepages/wrf/Research/Short_Notes/pnpoly.html
  */
@@ -47,6 +47,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 
 #include "RibbonMappingHelper.h"
 
+#include "ByteOrderEnum.h"
+#include "ByteSwapping.h"
+#include "CaretAssert.h"
+#include "CaretBinaryFile.h"
 #include "CaretException.h"
 #include "FloatMatrix.h"
 #include "MathFunctions.h"
@@ -54,6 +58,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "TopologyHelper.h"
 #include "VolumeSpace.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -63,19 +68,66 @@ using namespace std;
 namespace
 {
     
+    const char OPERATOR_MAGIC[8] = { 'w', 'b', 'r', 'i', 'b', 'b', 'o', 'p' };
+    const int32_t OPERATOR_VERSION = 1;
+    
+    //when the file size isn't known (compressed), grow the array as data arrives, so a corrupt count runs out of data before it can cause a huge allocation
+    template <typename T>
+    void readOperatorArray(CaretBinaryFile& myFile, vector<T>& arrayOut, const int64_t& count, const bool& sizeChecked)
+    {
+        if (sizeChecked)
+        {
+            arrayOut.resize(count);
+            myFile.read(arrayOut.data(), count * sizeof(T));
+            return;
+        }
+        const int64_t CHUNK_SIZE = 1 << 20;
+        arrayOut.clear();
+        for (int64_t start = 0; start < count; start += CHUNK_SIZE)
+        {
+            int64_t thisChunk = min(CHUNK_SIZE, count - start);
+            arrayOut.resize(start + thisChunk);
+            myFile.read(arrayOut.data() + start, thisChunk * sizeof(T));
+        }
+    }
+    
+    struct PointBatch
+    {//all subdivision sample points of one voxel, as separate coordinate arrays so the per-point loops vectorize
+        std::vector<float> m_x, m_y, m_z;
+        std::vector<int> m_hit[3], m_toggle, m_half;//scratch space for PolyInfo::countInside
+        float m_minX, m_maxX;
+        int m_count;
+        PointBatch(const int& maxCount);
+    };
+    
+    PointBatch::PointBatch(const int& maxCount)
+    {
+        m_x.resize(maxCount);
+        m_y.resize(maxCount);
+        m_z.resize(maxCount);
+        for (int i = 0; i < 3; ++i) m_hit[i].resize(maxCount);
+        m_toggle.resize(maxCount);
+        m_half.resize(maxCount);
+        m_minX = 0.0f;
+        m_maxX = 0.0f;
+        m_count = 0;
+    }
+    
     struct TriInfo
     {
         Vector3D m_xyz[3];
         float m_planeEq[3];//x coef, y coef, const : z = [0] * x + [1] * y + [2]
-        bool vertRayHit(const float* xyz);//true if a +z ray from point hits this triangle
+        float m_edgeLow[3], m_edgeHigh[3], m_edgeSlope[3], m_edgeY[3];//per edge, x range and the line y = slope * (x - high) + y, oriented by increasing x
+        float m_minX, m_maxX;
+        bool m_vertical;
+        void vertRayHitBatch(const PointBatch& points, int* hitOut) const;//1 for each point whose +z ray hits this triangle, 0 otherwise
         TriInfo(const float* xyz1, const float* xyz2, const float* xyz3);
         TriInfo() {};
     };
     
     struct QuadInfo
     {
-        TriInfo m_tris[2][2];
-        int vertRayHit(const float* xyz);//+z ray intersect: 0 if never, 1 if only 1 of the 2 triangulations, 2 if both
+        TriInfo m_tris[2][2];//the two triangulations
         QuadInfo(const float* xyz1, const float* xyz2, const float* xyz3, const float* xyz4);
         QuadInfo() {};
     };
@@ -86,13 +138,13 @@ namespace
         std::vector<QuadInfo> m_quads;
         PolyInfo(const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const int32_t node, const bool& thinColumn = false);//surfaces MUST be in node correspondence, otherwise SEVERE strangeness, possible crashes
         PolyInfo() {};
-        int isInside(const float* xyz);//0 for no, 2 for yes, 1 for if only half the triangulations (between the two triangulations of one of the quad faces)
+        int countInside(PointBatch& points) const;//sum over points of: 0 for outside, 2 for inside, 1 for between the two triangulations of a quad face
     private:
         void addTri(const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const int32_t* myTri, const int rootIndex, const bool& thinColumn);//adds the tri for each surface, plus the quad
     };
     
     void PolyInfo::addTri(const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const int32_t* myTri, const int rootIndex, const bool& thinColumn)
-    {//tries to orient normals consistently with respect to inside/outside, but it doesn't currently matter
+    {//orients normals consistently with respect to inside/outside, the exact overlap mode relies on this
         int root = myTri[rootIndex], node2 = myTri[(rootIndex + 1) % 3], node3 = myTri[(rootIndex + 2) % 3];
         if (thinColumn)
         {
@@ -123,23 +175,49 @@ namespace
         }
     }
 
-    int PolyInfo::isInside(const float* xyz)
-    {
-        int i, temp, numQuads = (int)m_quads.size();
-        bool toggle = false;
-        for (i = 0; i < numQuads; ++i)
+    int PolyInfo::countInside(PointBatch& points) const
+    {//same result as testing each point separately with the even/odd rule, but a triangle at a time across all points
+        const int count = points.m_count;
+        int* toggle = points.m_toggle.data(), *half = points.m_half.data();
+        int* hit0 = points.m_hit[0].data(), *hit1 = points.m_hit[1].data(), *hit2 = points.m_hit[2].data();
+        for (int p = 0; p < count; ++p)
+        {
+            toggle[p] = 0;
+            half[p] = 0;
+        }
+        int numQuads = (int)m_quads.size();
+        for (int i = 0; i < numQuads; ++i)
         {
-            temp = m_quads[i].vertRayHit(xyz);
-            if (temp == 1) return 1;//means only one of the two triangulations has a hit, therefore, we can return early
-            if (temp) toggle = !toggle;//even/odd winding rule
+            const QuadInfo& thisQuad = m_quads[i];
+            thisQuad.m_tris[0][0].vertRayHitBatch(points, hit0);
+            thisQuad.m_tris[0][1].vertRayHitBatch(points, hit1);
+            for (int p = 0; p < count; ++p)
+            {
+                hit0[p] ^= hit1[p];//crossings of the first triangulation
+            }
+            thisQuad.m_tris[1][0].vertRayHitBatch(points, hit1);
+            thisQuad.m_tris[1][1].vertRayHitBatch(points, hit2);
+            for (int p = 0; p < count; ++p)
+            {
+                half[p] |= hit0[p] ^ hit1[p] ^ hit2[p];//triangulations disagree, so the point is between them
+                toggle[p] ^= hit0[p];//even/odd winding rule, only used when they agree
+            }
         }
         int numTris = (int)m_tris.size();
-        for (i = 0; i < numTris; ++i)
+        for (int i = 0; i < numTris; ++i)
+        {
+            m_tris[i].vertRayHitBatch(points, hit0);
+            for (int p = 0; p < count; ++p)
+            {
+                toggle[p] ^= hit0[p];
+            }
+        }
+        int ret = 0;
+        for (int p = 0; p < count; ++p)
         {
-            if (m_tris[i].vertRayHit(xyz)) toggle = !toggle;
+            ret += half[p] + (1 - half[p]) * 2 * toggle[p];
         }
-        if (toggle) return 2;
-        return 0;
+        return ret;
     }
 
     PolyInfo::PolyInfo(const caret::SurfaceFile* innerSurf, const caret::SurfaceFile* outerSurf, const int32_t node, const bool& thinColumn)
@@ -172,14 +250,6 @@ namespace
         m_tris[1][1] = TriInfo(xyz2, xyz3, xyz4);
     }
 
-    int QuadInfo::vertRayHit(const float* xyz)
-    {
-        int ret = 0;
-        if (m_tris[0][0].vertRayHit(xyz) != m_tris[0][1].vertRayHit(xyz)) ++ret;
-        if (m_tris[1][0].vertRayHit(xyz) != m_tris[1][1].vertRayHit(xyz)) ++ret;
-        return ret;
-    }
-
     TriInfo::TriInfo(const float* xyz1, const float* xyz2, const float* xyz3)
     {
         m_xyz[0] = xyz1; m_xyz[1] = xyz2; m_xyz[2] = xyz3;
@@ -197,56 +267,60 @@ namespace
         m_planeEq[1] = myResult[1][3];//b
         m_planeEq[2] = myResult[2][3];//c
         float sanity = m_planeEq[0] + m_planeEq[1] + m_planeEq[2];
-        if (!MathFunctions::isNumeric(sanity))
+        m_vertical = !MathFunctions::isNumeric(sanity);//plane is vertical, nothing can hit it
+        m_minX = m_xyz[0][0];
+        m_maxX = m_xyz[0][0];
+        for (int j = 2, i = 0; i < 3; ++i)//same edge order as PNPOLY: 2,0 then 0,1 then 1,2
         {
-            m_planeEq[0] = sanity;//make sure the first element easily identifies vertical triangles
+            int ti, tj;
+            if (m_xyz[i][0] < m_xyz[j][0])//reorient the segment consistently to get a consistent answer
+            {
+                ti = i; tj = j;
+            } else {
+                ti = j; tj = i;
+            }
+            m_edgeLow[i] = m_xyz[ti][0];
+            m_edgeHigh[i] = m_xyz[tj][0];
+            m_edgeSlope[i] = (m_xyz[ti][1] - m_xyz[tj][1]) / (m_xyz[ti][0] - m_xyz[tj][0]);//infinite or NaN for edges parallel to y, but those never cross
+            m_edgeY[i] = m_xyz[tj][1];
+            if (m_xyz[i][0] < m_minX) m_minX = m_xyz[i][0];
+            if (m_xyz[i][0] > m_maxX) m_maxX = m_xyz[i][0];
+            j = i;
         }
     }
 
-    bool TriInfo::vertRayHit(const float* xyz)
+    void TriInfo::vertRayHitBatch(const PointBatch& points, int* hitOut) const
     {
-        if (!MathFunctions::isNumeric(m_planeEq[0]))
-        {//plane is vertical, nothing can hit it
-            return false;
+        const int count = points.m_count;
+        if (m_vertical || points.m_maxX <= m_minX || points.m_minX > m_maxX)
+        {//no point can be strictly inside the x range of an edge, so no ray can hit
+            for (int p = 0; p < count; ++p) hitOut[p] = 0;
+            return;
         }
-        float planeZ = xyz[0] * m_planeEq[0] + xyz[1] * m_planeEq[1] + m_planeEq[2];//ax + by + c = z
-        if (xyz[2] >= planeZ)
-        {//point is above the plane
-            return false;
-        }//test if the x, y projection has the point inside the triangle
-        //below logic copied from PNPOLY by Wm. Randolph Franklin, swapped x for y, and slightly rewritten, for the special case of 3 vertices
-        bool inside = false;
-        for (int j = 2, i = 0; i < 3; ++i)//start with the wraparound case
+        const float* xs = points.m_x.data(), *ys = points.m_y.data(), *zs = points.m_z.data();
+        //below logic derived from PNPOLY by Wm. Randolph Franklin, swapped x for y, and rewritten without branches, for the special case of 3 vertices
+        for (int p = 0; p < count; ++p)
         {
-            if ((m_xyz[i][0] < xyz[0]) != (m_xyz[j][0] < xyz[0]))
-            {//if one vertex is on one side of the point in the x direction, and the other is on the other side (equal case is treated as greater)
-                int ti, tj;
-                if (m_xyz[i][0] < m_xyz[j][0])//reorient the segment consistently to get a consistent answer
-                {
-                    ti = i; tj = j;
-                } else {
-                    ti = j; tj = i;
-                }
-                if ((m_xyz[ti][1] - m_xyz[tj][1]) / (m_xyz[ti][0] - m_xyz[tj][0]) * (xyz[0] - m_xyz[tj][0]) + m_xyz[tj][1] > xyz[1])
-                {//if the point on the line described by the two vertices with the same x coordinate is above (greater y) than the test point
-                    inside = !inside;//even/odd winding rule again
-                }
+            float planeZ = xs[p] * m_planeEq[0] + ys[p] * m_planeEq[1] + m_planeEq[2];//ax + by + c = z
+            int inside = 0;
+            for (int e = 0; e < 3; ++e)
+            {//if the vertices are on opposite sides of the point in the x direction (equal is treated as greater), and the line at the point's x is above (greater y) the point
+                inside ^= (int)((m_edgeLow[e] < xs[p]) != (m_edgeHigh[e] < xs[p])) & (int)(m_edgeSlope[e] * (xs[p] - m_edgeHigh[e]) + m_edgeY[e] > ys[p]);
             }
-            j = i;//consecutive vertices, does 2,0 then 0,1 then 1,2
+            hitOut[p] = (int)(zs[p] < planeZ) & inside;//and the point is below the plane
         }
-        return inside;
     }
     
-    float computeVoxelFraction(const VolumeSpace& myVolSpace, const int64_t* ijk, PolyInfo& myPoly, const int divisions,
-                               const Vector3D& ivec, const Vector3D& jvec, const Vector3D& kvec)
+    float computeVoxelFraction(const VolumeSpace& myVolSpace, const int64_t* ijk, const PolyInfo& myPoly, const int divisions,
+                               const Vector3D& ivec, const Vector3D& jvec, const Vector3D& kvec, PointBatch& points)
     {
         Vector3D myLowCorner;
         myVolSpace.indexToSpace(ijk[0] - 0.5f, ijk[1] - 0.5f, ijk[2] - 0.5f, myLowCorner);
-        int inside = 0;
         Vector3D istep = ivec / divisions;
         Vector3D jstep = jvec / divisions;
         Vector3D kstep = kvec / divisions;
         myLowCorner += istep * 0.5f + jstep * 0.5f + kstep * 0.5f;
+        int count = 0;
         for (int i = 0; i < divisions; ++i)
         {
             Vector3D tempVeci = myLowCorner + istep * i;
@@ -256,17 +330,181 @@ namespace
                 for (int k = 0; k < divisions; ++k)
                 {
                     Vector3D thisPoint = tempVecj + kstep * k;
-                    inside += myPoly.isInside(thisPoint);
+                    points.m_x[count] = thisPoint[0];
+                    points.m_y[count] = thisPoint[1];
+                    points.m_z[count] = thisPoint[2];
+                    if (count == 0 || thisPoint[0] < points.m_minX) points.m_minX = thisPoint[0];
+                    if (count == 0 || thisPoint[0] > points.m_maxX) points.m_maxX = thisPoint[0];
+                    ++count;
+                }
+            }
+        }
+        points.m_count = count;
+        return ((float)myPoly.countInside(points)) / (divisions * divisions * divisions * 2);
+    }
+    
+    struct ExactPolyInfo
+    {//the polyhedron in voxel index space, where every voxel is a unit cube, so overlap volume is the voxel fraction
+        struct IndexTri
+        {
+            double m_xyz[3][3];
+            double m_weight;//1 for cap triangles, 0.5 for each quad triangulation, negated if the surface is oriented inward
+        };
+        std::vector<IndexTri> m_tris;
+        ExactPolyInfo(const PolyInfo& myPoly, const VolumeSpace& myVolSpace);
+        float computeVoxelFraction(const int64_t* ijk) const;
+    private:
+        void addTri(const TriInfo& myTri, const double& weight, const VolumeSpace& myVolSpace);
+    };
+    
+    void ExactPolyInfo::addTri(const TriInfo& myTri, const double& weight, const VolumeSpace& myVolSpace)
+    {
+        IndexTri toAdd;
+        for (int v = 0; v < 3; ++v)
+        {
+            float indexSpace[3];
+            myVolSpace.spaceToIndex(myTri.m_xyz[v][0], myTri.m_xyz[v][1], myTri.m_xyz[v][2], indexSpace);
+            for (int i = 0; i < 3; ++i) toAdd.m_xyz[v][i] = indexSpace[i];
+        }
+        toAdd.m_weight = weight;
+        m_tris.push_back(toAdd);
+    }
+    
+    ExactPolyInfo::ExactPolyInfo(const PolyInfo& myPoly, const VolumeSpace& myVolSpace)
+    {
+        int numTris = (int)myPoly.m_tris.size();
+        for (int i = 0; i < numTris; ++i)
+        {
+            addTri(myPoly.m_tris[i], 1.0, myVolSpace);
+        }
+        int numQuads = (int)myPoly.m_quads.size();
+        for (int i = 0; i < numQuads; ++i)
+        {//average the two triangulations, the continuous version of counting points between them as half inside
+            for (int j = 0; j < 2; ++j)
+            {
+                for (int k = 0; k < 2; ++k)
+                {
+                    addTri(myPoly.m_quads[i].m_tris[j][k], 0.5, myVolSpace);
                 }
             }
         }
-        return ((float)inside) / (divisions * divisions * divisions * 2);
+        if (m_tris.empty()) return;
+        double volume = 0.0;//divergence theorem, relative to one vertex to reduce rounding, sign tells us the orientation (index space can also flip it)
+        const double* ref = m_tris[0].m_xyz[0];
+        int numIndexTris = (int)m_tris.size();
+        for (int i = 0; i < numIndexTris; ++i)
+        {
+            double a[3], b[3], c[3];
+            for (int j = 0; j < 3; ++j)
+            {
+                a[j] = m_tris[i].m_xyz[0][j] - ref[j];
+                b[j] = m_tris[i].m_xyz[1][j] - ref[j];
+                c[j] = m_tris[i].m_xyz[2][j] - ref[j];
+            }
+            volume += m_tris[i].m_weight * (a[0] * (b[1] * c[2] - b[2] * c[1]) + a[1] * (b[2] * c[0] - b[0] * c[2]) + a[2] * (b[0] * c[1] - b[1] * c[0]));
+        }
+        if (volume < 0.0)
+        {
+            for (int i = 0; i < numIndexTris; ++i) m_tris[i].m_weight = -m_tris[i].m_weight;
+        }
+    }
+    
+    const int MAX_CLIP_VERTS = 12;//a triangle clipped by 6 planes can't have more than 9 vertices
+    
+    int clipPolygon(const double (*polyIn)[3], const int numIn, double (*polyOut)[3], const int axis, const double value, const bool keepBelow)
+    {//Sutherland-Hodgman against one axis-aligned plane, the polygon is convex so each clip adds at most one vertex
+        int numOut = 0;
+        for (int i = 0; i < numIn; ++i)
+        {
+            const double* cur = polyIn[i], *next = polyIn[(i + 1) % numIn];
+            double curDist = (keepBelow ? value - cur[axis] : cur[axis] - value);
+            double nextDist = (keepBelow ? value - next[axis] : next[axis] - value);
+            if (curDist >= 0.0)
+            {
+                for (int j = 0; j < 3; ++j) polyOut[numOut][j] = cur[j];
+                ++numOut;
+            }
+            if ((curDist > 0.0 && nextDist < 0.0) || (curDist < 0.0 && nextDist > 0.0))
+            {
+                double t = curDist / (curDist - nextDist);
+                for (int j = 0; j < 3; ++j) polyOut[numOut][j] = cur[j] + t * (next[j] - cur[j]);
+                polyOut[numOut][axis] = value;
+                ++numOut;
+            }
+        }
+        CaretAssert(numOut <= MAX_CLIP_VERTS);
+        return numOut;
+    }
+    
+    void integratePolygon(const double (*poly)[3], const int numVerts, const double& zBase, double& areaOut, double& integralOut)
+    {//xy area of a planar convex polygon, and the integral of (z - zBase) over that area
+        areaOut = 0.0;
+        integralOut = 0.0;
+        for (int i = 1; i + 1 < numVerts; ++i)
+        {
+            double area = fabs((poly[i][0] - poly[0][0]) * (poly[i + 1][1] - poly[0][1]) - (poly[i + 1][0] - poly[0][0]) * (poly[i][1] - poly[0][1])) * 0.5;
+            areaOut += area;
+            integralOut += area * ((poly[0][2] + poly[i][2] + poly[i + 1][2]) / 3.0 - zBase);
+        }
+    }
+    
+    float ExactPolyInfo::computeVoxelFraction(const int64_t* ijk) const
+    {//for a closed, outward oriented surface, the inside indicator along a vertical line is the sum over faces above the point of sign(normal z),
+        //so integrating it over the voxel gives, per face, sign * integral over the face's projection of (clamp(z, zlow, zhigh) - zlow)
+        double low[3], high[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            low[i] = ijk[i] - 0.5;
+            high[i] = ijk[i] + 0.5;
+        }
+        double total = 0.0;
+        double bufA[MAX_CLIP_VERTS][3], bufB[MAX_CLIP_VERTS][3];
+        int numTris = (int)m_tris.size();
+        for (int t = 0; t < numTris; ++t)
+        {
+            const IndexTri& thisTri = m_tris[t];
+            const double (*xyz)[3] = thisTri.m_xyz;
+            double orient = (xyz[1][0] - xyz[0][0]) * (xyz[2][1] - xyz[0][1]) - (xyz[2][0] - xyz[0][0]) * (xyz[1][1] - xyz[0][1]);
+            if (orient == 0.0) continue;//vertical in index space, contributes nothing
+            bool outside = false;
+            for (int i = 0; i < 3; ++i)
+            {
+                double triMin = min(min(xyz[0][i], xyz[1][i]), xyz[2][i]), triMax = max(max(xyz[0][i], xyz[1][i]), xyz[2][i]);
+                if (triMax <= low[i]) outside = true;//below the voxel in z also contributes nothing
+                if (i < 2 && triMin >= high[i]) outside = true;//but above it in z contributes the full height
+            }
+            if (outside) continue;
+            int numVerts = 3;
+            numVerts = clipPolygon(xyz, numVerts, bufA, 0, low[0], false);
+            numVerts = clipPolygon(bufA, numVerts, bufB, 0, high[0], true);
+            numVerts = clipPolygon(bufB, numVerts, bufA, 1, low[1], false);
+            numVerts = clipPolygon(bufA, numVerts, bufB, 1, high[1], true);
+            numVerts = clipPolygon(bufB, numVerts, bufA, 2, low[2], false);//now bufA is the part of the face over the voxel, above its bottom
+            if (numVerts < 3) continue;
+            double area, integral, contribution = 0.0;
+            int numSplit = clipPolygon(bufA, numVerts, bufB, 2, high[2], true);//part within the voxel's z range
+            if (numSplit >= 3)
+            {
+                integratePolygon(bufB, numSplit, low[2], area, integral);
+                contribution += integral;
+            }
+            numSplit = clipPolygon(bufA, numVerts, bufB, 2, high[2], false);//part above the voxel covers the full height
+            if (numSplit >= 3)
+            {
+                integratePolygon(bufB, numSplit, low[2], area, integral);
+                contribution += area * (high[2] - low[2]);
+            }
+            total += (orient > 0.0 ? thisTri.m_weight : -thisTri.m_weight) * contribution;
+        }
+        if (total < 1e-6) return 0.0f;//faces that cancel leave rounding noise, which shouldn't become a weight
+        if (total > 1.0) return 1.0f;
+        return (float)total;
     }
     
 }
 
 void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myWeightsOut, const VolumeSpace& myVolSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
-                                               const float* roiFrame, const int& numDivisions, const bool& thinColumn)
+                                               const float* roiFrame, const int& numDivisions, const bool& thinColumn, const bool& exactOverlap)
 {
     if (!innerSurf->hasNodeCorrespondence(*outerSurf))
     {
@@ -287,6 +525,7 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
     {
         int maxVoxelCount = 10;//guess for preallocating vectors
         CaretPointer<TopologyHelper> myTopoHelp = innerSurf->getTopologyHelper();
+        PointBatch myPoints(exactOverlap ? 0 : numDivisions * numDivisions * numDivisions);
 #pragma omp CARET_FOR schedule(dynamic)
         for (int64_t node = 0; node < numNodes; ++node)
         {
@@ -295,6 +534,8 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
             float tempf;
             int64_t node3 = node * 3;
             PolyInfo myPoly(innerSurf, outerSurf, node, thinColumn);//build the polygon
+            CaretPointer<ExactPolyInfo> myExactPoly;
+            if (exactOverlap) myExactPoly.grabNew(new ExactPolyInfo(myPoly, myVolSpace));
             Vector3D minIndex, maxIndex, tempvec;
             myVolSpace.spaceToIndex(innerCoords + node3, minIndex);//find the bounding box in VOLUME INDEX SPACE, starting with the center nodes
             maxIndex = minIndex;
@@ -339,7 +580,12 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
                     {
                         if (roiFrame == NULL || roiFrame[myVolSpace.getIndex(ijk)] > 0.0f)
                         {
-                            tempf = computeVoxelFraction(myVolSpace, ijk, myPoly, numDivisions, ivec, jvec, kvec);
+                            if (exactOverlap)
+                            {
+                                tempf = myExactPoly->computeVoxelFraction(ijk);
+                            } else {
+                                tempf = computeVoxelFraction(myVolSpace, ijk, myPoly, numDivisions, ivec, jvec, kvec, myPoints);
+                            }
                             if (tempf != 0.0f)
                             {
                                 myWeightsOut[node].push_back(VoxelWeight(tempf, ijk));
@@ -355,3 +601,136 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
         }
     }
 }
+
+void RibbonMappingHelper::writeOperator(const AString& filename, const vector<vector<VoxelWeight> >& myWeights, const VolumeSpace& myVolSpace)
+{//format: magic, then int32 version, number of vertices, then int64 volume dimensions, float32 first 3 rows of sform, int64 number of weights,
+    //then CSR arrays: int64 row starts, int64 voxel indices within a frame, float32 weights, all little endian
+    int32_t numNodes = (int32_t)myWeights.size();
+    if (numNodes < 1) throw CaretException("cannot write a ribbon mapping operator that has no vertices");
+    int32_t header[2] = { OPERATOR_VERSION, numNodes };
+    int64_t dims[3] = { myVolSpace.getDims()[0], myVolSpace.getDims()[1], myVolSpace.getDims()[2] };
+    float sform[12];
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            sform[i * 4 + j] = myVolSpace.getSform()[i][j];
+        }
+    }
+    vector<int64_t> rowStart(numNodes + 1);
+    rowStart[0] = 0;
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        rowStart[node + 1] = rowStart[node] + (int64_t)myWeights[node].size();
+    }
+    int64_t numElems = rowStart[numNodes];
+    vector<int64_t> voxels(numElems);
+    vector<float> weights(numElems);
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        int64_t base = rowStart[node];
+        int numVoxels = (int)myWeights[node].size();
+        for (int voxel = 0; voxel < numVoxels; ++voxel)
+        {
+            voxels[base + voxel] = myVolSpace.getIndex(myWeights[node][voxel].ijk);
+            weights[base + voxel] = myWeights[node][voxel].weight;
+        }
+    }
+    if (ByteOrderEnum::isSystemBigEndian())
+    {
+        ByteSwapping::swapBytes(header, 2);
+        ByteSwapping::swapBytes(dims, 3);
+        ByteSwapping::swapBytes(sform, 12);
+        ByteSwapping::swapBytes(&numElems, 1);
+        ByteSwapping::swapBytes(rowStart.data(), rowStart.size());
+        ByteSwapping::swapBytes(voxels.data(), voxels.size());
+        ByteSwapping::swapBytes(weights.data(), weights.size());
+    }
+    CaretBinaryFile myFile(filename, CaretBinaryFile::WRITE_TRUNCATE);
+    myFile.write(OPERATOR_MAGIC, 8);
+    myFile.write(header, 2 * sizeof(int32_t));
+    myFile.write(dims, 3 * sizeof(int64_t));
+    myFile.write(sform, 12 * sizeof(float));
+    myFile.write(&numElems, sizeof(int64_t));
+    myFile.write(rowStart.data(), rowStart.size() * sizeof(int64_t));
+    myFile.write(voxels.data(), voxels.size() * sizeof(int64_t));
+    myFile.write(weights.data(), weights.size() * sizeof(float));
+    myFile.close();
+}
+
+void RibbonMappingHelper::readOperator(const AString& filename, vector<vector<VoxelWeight> >& myWeightsOut, VolumeSpace& myVolSpaceOut)
+{
+    CaretBinaryFile myFile(filename, CaretBinaryFile::READ);
+    char magic[8];
+    myFile.read(magic, 8);
+    for (int i = 0; i < 8; ++i)
+    {
+        if (magic[i] != OPERATOR_MAGIC[i]) throw CaretException("file '" + filename + "' is not a ribbon mapping operator");
+    }
+    int32_t header[2];
+    int64_t dims[3], numElems;
+    float sform[12];
+    myFile.read(header, 2 * sizeof(int32_t));
+    myFile.read(dims, 3 * sizeof(int64_t));
+    myFile.read(sform, 12 * sizeof(float));
+    myFile.read(&numElems, sizeof(int64_t));
+    bool swap = ByteOrderEnum::isSystemBigEndian();
+    if (swap)
+    {
+        ByteSwapping::swapBytes(header, 2);
+        ByteSwapping::swapBytes(dims, 3);
+        ByteSwapping::swapBytes(sform, 12);
+        ByteSwapping::swapBytes(&numElems, 1);
+    }
+    if (header[0] != OPERATOR_VERSION) throw CaretException("ribbon mapping operator '" + filename + "' has unsupported version " + AString::number(header[0]));
+    int32_t numNodes = header[1];
+    if (numNodes < 1 || dims[0] < 1 || dims[1] < 1 || dims[2] < 1 || numElems < 0) throw CaretException("ribbon mapping operator '" + filename + "' has an invalid header");
+    const int64_t dimLimit = (int64_t)1 << 20;//also keeps the products below from overflowing
+    if (dims[0] > dimLimit || dims[1] > dimLimit || dims[2] > dimLimit) throw CaretException("ribbon mapping operator '" + filename + "' has an invalid header");
+    int64_t frameSize = dims[0] * dims[1] * dims[2];
+    if (numElems / numNodes > frameSize)
+    {//each vertex gets at most one weight per voxel
+        throw CaretException("ribbon mapping operator '" + filename + "' has an invalid header");
+    }
+    int64_t fileSize = myFile.size();//can be -1 for compressed files, then the arrays are read in chunks
+    const int64_t headerSize = 8 + 2 * sizeof(int32_t) + 3 * sizeof(int64_t) + 12 * sizeof(float) + sizeof(int64_t);
+    if (fileSize >= 0 && fileSize != headerSize + (numNodes + 1) * (int64_t)sizeof(int64_t) + numElems * (int64_t)(sizeof(int64_t) + sizeof(float)))
+    {
+        throw CaretException("ribbon mapping operator '" + filename + "' has the wrong file size");
+    }
+    vector<int64_t> rowStart, voxels;
+    vector<float> weights;
+    readOperatorArray(myFile, rowStart, numNodes + 1, fileSize >= 0);
+    readOperatorArray(myFile, voxels, numElems, fileSize >= 0);
+    readOperatorArray(myFile, weights, numElems, fileSize >= 0);
+    myFile.close();
+    if (swap)
+    {
+        ByteSwapping::swapBytes(rowStart.data(), rowStart.size());
+        ByteSwapping::swapBytes(voxels.data(), voxels.size());
+        ByteSwapping::swapBytes(weights.data(), weights.size());
+    }
+    if (rowStart[0] != 0 || rowStart[numNodes] != numElems) throw CaretException("ribbon mapping operator '" + filename + "' has inconsistent row starts");
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        if (rowStart[node + 1] < rowStart[node]) throw CaretException("ribbon mapping operator '" + filename + "' has inconsistent row starts");
+    }
+    for (int64_t i = 0; i < numElems; ++i)
+    {
+        if (voxels[i] < 0 || voxels[i] >= frameSize) throw CaretException("ribbon mapping operator '" + filename + "' has an invalid voxel index");
+    }
+    myVolSpaceOut = VolumeSpace(dims, sform);
+    myWeightsOut.resize(numNodes);
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        vector<VoxelWeight>& nodeWeights = myWeightsOut[node];
+        nodeWeights.resize(rowStart[node + 1] - rowStart[node]);
+        int numVoxels = (int)nodeWeights.size();
+        for (int voxel = 0; voxel < numVoxels; ++voxel)
+        {
+            int64_t index = voxels[rowStart[node] + voxel];
+            int64_t ijk[3] = { index % dims[0], (index / dims[0]) % dims[1], index / (dims[0] * dims[1]) };
+            nodeWeights[voxel] = VoxelWeight(weights[rowStart[node] + voxel], ijk);
+        }
+    }
+}
@@ -21,6 +21,8 @@
  */
 /*LICENSE_END*/
 
+#include "AString.h"
+
 #include "stdint.h"
 #include <cstddef>
 #include <vector>
@@ -49,9 +51,15 @@ namespace caret
     {
     public:
         ///compute per-vertex ribbon mapping weights - surfaces must have vertex correspondence, or an exception is thrown
+        ///exactOverlap computes the polyhedron/voxel intersection volume analytically, and ignores numDivisions
         static void computeWeightsRibbon(std::vector<std::vector<VoxelWeight> >& myWeightsOut, const VolumeSpace& myVolSpace,
                                          const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
-                                         const float* roiFrame = NULL, const int& numDivisions = 3, const bool& thinColumn = false);
+                                         const float* roiFrame = NULL, const int& numDivisions = 3, const bool& thinColumn = false,
+                                         const bool& exactOverlap = false);
+        ///save per-vertex weights as a sparse matrix of vertices by voxel indices, so that mapping other data in the same volume space doesn't need to recompute them
+        static void writeOperator(const AString& filename, const std::vector<std::vector<VoxelWeight> >& myWeights, const VolumeSpace& myVolSpace);
+        ///read weights saved by writeOperator, and the volume space they were computed for
+        static void readOperator(const AString& filename, std::vector<std::vector<VoxelWeight> >& myWeightsOut, VolumeSpace& myVolSpaceOut);
     };
 
 }
@@ -45,129 +45,209 @@ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FO
 DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
-#include "BoundingBox.h"
-#include "CaretHeap.h"
+#include "MathFunctions.h"
 #include "SignedDistanceHelper.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace std;
 using namespace caret;
 
-float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+float SignedDistanceHelper::closestTriangle(const float coord[3], ClosestPointInfo& bestInfo, const int32_t& hintTriangle) const
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
-    bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+    struct ClosestLeaf
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
+        const SignedDistanceHelper* m_this;
+        const float* m_coord;
+        ClosestPointInfo* m_bestInfo;
+        float m_bestDist;
+        void operator()(const BoundingVolumeHierarchy::Node& leaf, float& bestDist2)
         {
-            if (curOct->m_leaf)
+            const vector<int32_t>& order = m_this->m_base->m_tree.getItemOrder();
+            ClosestPointInfo tempInfo;
+            const int32_t end = leaf.m_start + leaf.m_count;
+            for (int32_t i = leaf.m_start; i < end; ++i)
             {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
-                {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
+                float tempf = m_this->unsignedDistToTri(m_coord, order[i], tempInfo);
+                if (m_bestDist < 0.0f || tempf < m_bestDist)
                 {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
+                    *m_bestInfo = tempInfo;
+                    m_bestDist = tempf;
+                    bestDist2 = tempf * tempf;
                 }
             }
         }
+    } myLeafFunc;
+    myLeafFunc.m_this = this;
+    myLeafFunc.m_coord = coord;
+    myLeafFunc.m_bestInfo = &bestInfo;
+    myLeafFunc.m_bestDist = -1.0f;
+    float startDist2 = numeric_limits<float>::infinity();
+    float hintDist = -1.0f;
+    if (hintTriangle >= 0)
+    {//only bound the search with the hint, so ties still go to the first triangle in tree order, same as without a hint
+        CaretAssert(hintTriangle < m_base->m_numTris);
+        ClosestPointInfo hintInfo;
+        hintDist = unsignedDistToTri(coord, hintTriangle, hintInfo);
+        startDist2 = hintDist * hintDist * 1.0001f + numeric_limits<float>::min();//slack for rounding in the box distances
     }
-    while (numChanged)
-    {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//need to do this before computeSign
+    m_base->m_tree.nearestSearch(coord, myLeafFunc, startDist2);
+    if (myLeafFunc.m_bestDist < 0.0f && hintTriangle >= 0)
+    {//only possible if rounding pruned the hint's own leaf
+        return unsignedDistToTri(coord, hintTriangle, bestInfo);
     }
+    return myLeafFunc.m_bestDist;
+}
+
+float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+{
+    ClosestPointInfo bestInfo;
+    float bestTriDist = closestTriangle(coord, bestInfo);
     return bestTriDist * computeSign(coord, bestInfo, myWinding);
 }
 
-void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut)
+float SignedDistanceHelper::unsignedDist(const float coord[3])
+{
+    ClosestPointInfo bestInfo;
+    return closestTriangle(coord, bestInfo);
+}
+
+int SignedDistanceHelper::windingSign(const int& crossCount, const WindingLogic& myWinding)
+{
+    switch (myWinding)
+    {
+        case EVEN_ODD:
+            if ((abs(crossCount) & 1) == 1) return -1;//& 1 instead of % 2
+            return 1;
+        case NEGATIVE:
+            if (crossCount < 0) return -1;
+            return 1;
+        case NONZERO:
+            if (crossCount != 0) return -1;
+            return 1;
+        default:
+            CaretAssertMessage(false, "windingSign called with a winding logic that doesn't count crossings");
+            return 1;
+    }
+}
+
+void SignedDistanceHelper::rayCrossings(const float start[3], const float direction[3], vector<pair<float, int> >& crossingsOut)
 {
-    CaretMutexLocker locked(&m_mutex);
-    CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
-    myHeap.push(m_base->m_indexRoot, m_base->m_indexRoot->distToPoint(coord));
-    ClosestPointInfo tempInfo, bestInfo;
-    float tempf = -1.0f, bestTriDist = -1.0f;
-    bool first = true;
-    int numChanged = 0;
-    while (!myHeap.isEmpty())
+    crossingsOut.clear();
+    Vector3D point = start, dirVec = direction;
+    int majAxis = 0, midAxis = 1;//project the triangles along the axis most aligned with the ray
+    if (abs(dirVec[1]) < abs(dirVec[0]))
     {
-        Oct<SignedDistanceHelperBase::TriVector>* curOct = myHeap.pop(&tempf);
-        if (first || tempf < bestTriDist)
+        majAxis = 1;
+        midAxis = 0;
+    }
+    if (abs(dirVec[2]) < abs(dirVec[midAxis]))
+    {
+        midAxis = 2;
+    }
+    const vector<int32_t>& triOrder = m_base->m_tree.getItemOrder();
+    vector<int32_t> myStack;
+    if (!m_base->m_tree.isEmpty()) myStack.push_back(0);
+    while (!myStack.empty())
+    {
+        int32_t curIndex = myStack.back();
+        myStack.pop_back();
+        const BoundingVolumeHierarchy::Node& curNode = m_base->m_tree.getNode(curIndex);
+        if (!curNode.rayIntersects(start, direction)) continue;
+        if (curNode.isLeaf())
         {
-            if (curOct->m_leaf)
+            const int32_t end = curNode.m_start + curNode.m_count;
+            for (int32_t i = curNode.m_start; i < end; ++i)
             {
-                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                int numTris = (int)myVecRef.size();
-                for (int i = 0; i < numTris; ++i)
+                const int32_t* myTileNodes = m_base->getTriangle(triOrder[i]);
+                Vector3D verts[3];
+                verts[0] = m_base->getCoordinate(myTileNodes[0]);
+                verts[1] = m_base->getCoordinate(myTileNodes[1]);
+                verts[2] = m_base->getCoordinate(myTileNodes[2]);
+                Vector3D triNormal;
+                MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
+                float factor = triNormal.dot(dirVec);
+                if (factor == 0.0f) continue;//skip triangles parallel to the ray
+                float t = triNormal.dot(verts[0] - point) / factor;
+                if (t < 0.0f) continue;
+                if (pointInTri(verts, point + t * dirVec, majAxis, midAxis))
                 {
-                    if (m_triMarked[myVecRef[i]] != 1)
-                    {
-                        m_triMarked[myVecRef[i]] = 1;
-                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                        tempf = unsignedDistToTri(coord, myVecRef[i], tempInfo);
-                        if (first || tempf < bestTriDist)
-                        {
-                            bestInfo = tempInfo;
-                            bestTriDist = tempf;
-                            first = false;
-                        }
-                    }
-                }
-            } else {
-                for (int ci = 0; ci < 2; ++ci)
-                {
-                    for (int cj = 0; cj < 2; ++cj)
-                    {
-                        for (int ck = 0; ck < 2; ++ck)
-                        {
-                            tempf = curOct->m_children[ci][cj][ck]->distToPoint(coord);
-                            if (first || tempf < bestTriDist)
-                            {
-                                myHeap.push(curOct->m_children[ci][cj][ck], tempf);
-                            }
-                        }
-                    }
+                    crossingsOut.push_back(make_pair(t, (factor < 0.0f ? 1 : -1)));//same convention as the vertical ray in computeSign
                 }
             }
+        } else {
+            myStack.push_back(curIndex + 1);
+            myStack.push_back(curNode.m_start);
         }
     }
-    while (numChanged)
+    sort(crossingsOut.begin(), crossingsOut.end());
+}
+
+void SignedDistanceHelper::segmentHits(const float start[3], const float direction[3], vector<SegmentHit>& hitsOut)
+{
+    struct SegmentTest
     {
-        m_triMarked[m_triMarkChanged[--numChanged]] = 0;//clean up
-    }
+        const float* m_start;
+        const float* m_direction;
+        bool operator()(const BoundingVolumeHierarchy::Node& node) const
+        {
+            return node.lineSegmentIntersects(m_start, m_direction);
+        }
+    } myNodeTest;
+    myNodeTest.m_start = start;
+    myNodeTest.m_direction = direction;
+    struct SegmentLeaf
+    {
+        const SignedDistanceHelperBase* m_base;
+        Vector3D m_point, m_dirVec;
+        vector<SegmentHit>* m_hits;
+        void operator()(const BoundingVolumeHierarchy::Node& leaf)
+        {
+            const vector<int32_t>& triOrder = m_base->m_tree.getItemOrder();
+            const int32_t end = leaf.m_start + leaf.m_count;
+            for (int32_t i = leaf.m_start; i < end; ++i)
+            {//Moller-Trumbore, which gets the barycentric weights along with the intersection
+                const int32_t* myTileNodes = m_base->getTriangle(triOrder[i]);
+                Vector3D vert0 = m_base->getCoordinate(myTileNodes[0]);
+                Vector3D edge1 = Vector3D(m_base->getCoordinate(myTileNodes[1])) - vert0;
+                Vector3D edge2 = Vector3D(m_base->getCoordinate(myTileNodes[2])) - vert0;
+                Vector3D pvec = m_dirVec.cross(edge2);
+                float det = edge1.dot(pvec);
+                if (det == 0.0f) continue;//parallel to the segment, or degenerate
+                Vector3D tvec = m_point - vert0;
+                float u = tvec.dot(pvec) / det;
+                if (u < 0.0f || u > 1.0f) continue;
+                Vector3D qvec = tvec.cross(edge1);
+                float v = m_dirVec.dot(qvec) / det;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                float t = edge2.dot(qvec) / det;
+                if (t < 0.0f || t > 1.0f) continue;
+                SegmentHit myHit;
+                myHit.distance = t;
+                myHit.triangle = triOrder[i];
+                myHit.baryWeights[0] = 1.0f - u - v;
+                myHit.baryWeights[1] = u;
+                myHit.baryWeights[2] = v;
+                m_hits->push_back(myHit);
+            }
+        }
+    } myLeafFunc;
+    myLeafFunc.m_base = m_base;
+    myLeafFunc.m_point = start;
+    myLeafFunc.m_dirVec = direction;
+    myLeafFunc.m_hits = &hitsOut;
+    hitsOut.clear();
+    m_base->m_tree.traverse(myNodeTest, myLeafFunc);
+    sort(hitsOut.begin(), hitsOut.end());
+}
+
+void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricInfo& baryInfoOut, const int32_t& hintTriangle)
+{
+    ClosestPointInfo bestInfo;
+    float bestTriDist = closestTriangle(coord, bestInfo, hintTriangle);
     baryInfoOut.triangle = bestInfo.triangle;
     baryInfoOut.point = bestInfo.tempPoint;
     baryInfoOut.absDistance = bestTriDist;
@@ -241,7 +321,7 @@ void SignedDistanceHelper::barycentricWeights(const float coord[3], BarycentricI
     }
 }
 
-int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper::ClosestPointInfo myInfo, WindingLogic myWinding)
+int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper::ClosestPointInfo myInfo, WindingLogic myWinding) const
 {
     Vector3D point = coord;
     Vector3D result = point - myInfo.tempPoint;
@@ -252,85 +332,49 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
         case NEGATIVE:
         case NONZERO:
             {
-                int numChanged = 0;
                 float positiveZ[3] = {0, 0, 1};
-                Vector3D point2 = point + positiveZ;
                 int crossCount = 0;
-                vector<Oct<SignedDistanceHelperBase::TriVector>*> myStack;
-                myStack.push_back(m_base->m_indexRoot);
+                const vector<int32_t>& triOrder = m_base->m_tree.getItemOrder();
+                vector<int32_t> myStack;
+                if (!m_base->m_tree.isEmpty()) myStack.push_back(0);
                 while (!myStack.empty())
                 {
-                    Oct<SignedDistanceHelperBase::TriVector>* curOct = myStack[myStack.size() - 1];
+                    int32_t curIndex = myStack.back();
                     myStack.pop_back();
-                    if (curOct->m_leaf)
+                    const BoundingVolumeHierarchy::Node& curNode = m_base->m_tree.getNode(curIndex);
+                    if (!curNode.rayIntersects(coord, positiveZ)) continue;
+                    if (curNode.isLeaf())
                     {
-                        vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                        int numTris = (int)myVecRef.size();
-                        for (int i = 0; i < numTris; ++i)
+                        const int32_t end = curNode.m_start + curNode.m_count;
+                        for (int32_t i = curNode.m_start; i < end; ++i)
                         {
-                            if (m_triMarked[myVecRef[i]] != 1)
+                            const int32_t* myTileNodes = m_base->getTriangle(triOrder[i]);
+                            Vector3D verts[3];
+                            verts[0] = m_base->getCoordinate(myTileNodes[0]);
+                            verts[1] = m_base->getCoordinate(myTileNodes[1]);
+                            verts[2] = m_base->getCoordinate(myTileNodes[2]);
+                            Vector3D triNormal;
+                            MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
+                            float factor = triNormal[2];//equivalent to dot product with positiveZ
+                            if (factor != 0.0f)
                             {
-                                m_triMarked[myVecRef[i]] = 1;
-                                m_triMarkChanged[numChanged++] = myVecRef[i];
-                                const int32_t* myTileNodes = m_base->getTriangle(myVecRef[i]);
-                                Vector3D verts[3];
-                                verts[0] = m_base->getCoordinate(myTileNodes[0]);
-                                verts[1] = m_base->getCoordinate(myTileNodes[1]);
-                                verts[2] = m_base->getCoordinate(myTileNodes[2]);
-                                Vector3D triNormal;
-                                MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
-                                float factor = triNormal[2];//equivalent to dot product with positiveZ
-                                if (factor != 0.0f)
+                                if (triNormal.dot(verts[0] - point) / factor > 0.0f && pointInTri(verts, point, 0, 1))
                                 {
-                                    if (triNormal.dot(verts[0] - point) / factor > 0.0f && pointInTri(verts, point, 0, 1))
+                                    if (triNormal[2] < 0.0f)
                                     {
-                                        if (triNormal[2] < 0.0f)
-                                        {
-                                            ++crossCount;
-                                        } else {
-                                            --crossCount;
-                                        }
+                                        ++crossCount;
+                                    } else {
+                                        --crossCount;
                                     }
                                 }
                             }
                         }
                     } else {
-                        for (int ci = 0; ci < 2; ++ci)
-                        {
-                            for (int cj = 0; cj < 2; ++cj)
-                            {
-                                for (int ck = 0; ck < 2; ++ck)
-                                {
-                                    if (curOct->m_children[ci][cj][ck]->rayIntersects(coord, point2))
-                                    {
-                                        myStack.push_back(curOct->m_children[ci][cj][ck]);
-                                    }
-                                }
-                            }
-                        }
+                        myStack.push_back(curIndex + 1);//left child
+                        myStack.push_back(curNode.m_start);//right child
                     }
                 }
-                while (numChanged)
-                {
-                    m_triMarked[m_triMarkChanged[--numChanged]] = 0;
-                }
-                switch (myWinding)
-                {
-                    case EVEN_ODD:
-                        if ((abs(crossCount) & 1) == 1) return -1;//& 1 instead of % 2
-                        return 1;
-                        break;
-                    case NEGATIVE:
-                        if (crossCount < 0) return -1;
-                        return 1;
-                        break;
-                    case NONZERO:
-                        if (crossCount != 0) return -1;
-                        return 1;
-                        break;
-                    default:
-                        return 1;//because compiler can't handle when a switch doesn't accound for an enum value...
-                }
+                return windingSign(crossCount, myWinding);
             }
             break;
         case NORMALS:
@@ -339,7 +383,6 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                 case 0://node
                     {
                         int curSign = 0;
-                        int numChanged = 0;
                         const vector<int>& myTiles = m_base->m_topoHelp->getNodeTiles(myInfo.node1);
                         bool first = true;
                         float bestNorm = 0;
@@ -382,71 +425,54 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                         {
                             midAxis = 2;
                         }
-                        vector<Oct<SignedDistanceHelperBase::TriVector>*> myStack;
-                        myStack.push_back(m_base->m_indexRoot);
+                        Vector3D segDirection = bestCent - point;
+                        const vector<int32_t>& triOrder = m_base->m_tree.getItemOrder();
+                        vector<int32_t> myStack;
+                        if (!m_base->m_tree.isEmpty()) myStack.push_back(0);
                         while (!myStack.empty())
                         {
-                            Oct<SignedDistanceHelperBase::TriVector>* curOct = myStack[myStack.size() - 1];
+                            int32_t curIndex = myStack.back();
                             myStack.pop_back();
-                            if (curOct->m_leaf)
+                            const BoundingVolumeHierarchy::Node& curNode = m_base->m_tree.getNode(curIndex);
+                            if (!curNode.lineSegmentIntersects(coord, segDirection)) continue;
+                            if (curNode.isLeaf())
                             {
-                                vector<int32_t>& myVecRef = *(curOct->m_data.m_triList);
-                                int numTris = (int)myVecRef.size();
-                                for (int i = 0; i < numTris; ++i)
+                                const int32_t end = curNode.m_start + curNode.m_count;
+                                for (int32_t i = curNode.m_start; i < end; ++i)
                                 {
-                                    if (m_triMarked[myVecRef[i]] != 1)
+                                    const int32_t* myTileNodes = m_base->getTriangle(triOrder[i]);
+                                    Vector3D verts[3];
+                                    verts[0] = m_base->getCoordinate(myTileNodes[0]);
+                                    verts[1] = m_base->getCoordinate(myTileNodes[1]);
+                                    verts[2] = m_base->getCoordinate(myTileNodes[2]);
+                                    Vector3D triNormal;
+                                    MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
+                                    float factor = triNormal.dot(segNormal);
+                                    if (factor == 0.0f)
                                     {
-                                        m_triMarked[myVecRef[i]] = 1;
-                                        m_triMarkChanged[numChanged++] = myVecRef[i];
-                                        const int32_t* myTileNodes = m_base->getTriangle(myVecRef[i]);
-                                        Vector3D verts[3];
-                                        verts[0] = m_base->getCoordinate(myTileNodes[0]);
-                                        verts[1] = m_base->getCoordinate(myTileNodes[1]);
-                                        verts[2] = m_base->getCoordinate(myTileNodes[2]);
-                                        Vector3D triNormal;
-                                        MathFunctions::normalVector(verts[0], verts[1], verts[2], triNormal);
-                                        float factor = triNormal.dot(segNormal);
-                                        if (factor == 0.0f)
-                                        {
-                                            continue;//skip triangles parallel to the line segment
-                                        }
-                                        float intersectDist = triNormal.dot(point - verts[0]) / factor;
-                                        if (intersectDist > 0.0f && intersectDist < bestDist)
-                                        {
-                                            Vector3D inPlane = point - intersectDist * segNormal;
-                                            if (pointInTri(verts, inPlane, majAxis, midAxis))
-                                            {
-                                                bestDist = intersectDist;
-                                                if (triNormal.dot(mySeg) > 0.0f)
-                                                {
-                                                    curSign = 1;
-                                                } else {
-                                                    curSign = -1;
-                                                }
-                                            }
-                                        }
+                                        continue;//skip triangles parallel to the line segment
                                     }
-                                }
-                            } else {
-                                for (int ci = 0; ci < 2; ++ci)
-                                {
-                                    for (int cj = 0; cj < 2; ++cj)
+                                    float intersectDist = triNormal.dot(point - verts[0]) / factor;
+                                    if (intersectDist > 0.0f && intersectDist < bestDist)
                                     {
-                                        for (int ck = 0; ck < 2; ++ck)
+                                        Vector3D inPlane = point - intersectDist * segNormal;
+                                        if (pointInTri(verts, inPlane, majAxis, midAxis))
                                         {
-                                            if (curOct->m_children[ci][cj][ck]->lineSegmentIntersects(coord, bestCent))
+                                            bestDist = intersectDist;
+                                            if (triNormal.dot(mySeg) > 0.0f)
                                             {
-                                                myStack.push_back(curOct->m_children[ci][cj][ck]);
+                                                curSign = 1;
+                                            } else {
+                                                curSign = -1;
                                             }
                                         }
                                     }
                                 }
+                            } else {
+                                myStack.push_back(curIndex + 1);
+                                myStack.push_back(curNode.m_start);
                             }
                         }
-                        while (numChanged)
-                        {
-                            m_triMarked[m_triMarkChanged[--numChanged]] = 0;
-                        }
                         return curSign;
                     }
                     break;
@@ -533,7 +559,7 @@ bool SignedDistanceHelper::pointInTri(Vector3D verts[3], Vector3D inPlane, int m
 
 ///"dumb" implementation, projects to plane, test if inside while finding closest point on each edge
 ///there are faster implementations out there, but this is easier to follow
-float SignedDistanceHelper::unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo)
+float SignedDistanceHelper::unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo) const
 {
     const int32_t* triNodes = m_base->getTriangle(triangle);
     Vector3D point = coord;
@@ -713,24 +739,11 @@ float SignedDistanceHelper::unsignedDistToTri(const float coord[3], int32_t tria
 SignedDistanceHelper::SignedDistanceHelper(CaretPointer<SignedDistanceHelperBase> myBase)
 {
     m_base = myBase;
-    int32_t numTris = m_base->m_numTris;
-    m_triMarked = CaretArray<int>(numTris);
-    m_triMarkChanged = CaretArray<int>(numTris);
-    for (int32_t i = 0; i < numTris; ++i)
-    {
-        m_triMarked[i] = 0;
-    }
 }
 
 SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
 {
     m_topoHelp = mySurf->getTopologyHelper();
-    const float* myBB = mySurf->getBoundingBox()->getBounds();
-    Vector3D minCoord, maxCoord;
-    minCoord[0] = myBB[0]; maxCoord[0] = myBB[1];
-    minCoord[1] = myBB[2]; maxCoord[1] = myBB[3];
-    minCoord[2] = myBB[4]; maxCoord[2] = myBB[5];
-    m_indexRoot.grabNew(new Oct<TriVector>(minCoord, maxCoord));
     const float* myCoordData = mySurf->getCoordinateData();
     m_numNodes = mySurf->getNumberOfNodes();
     int32_t numNodes3 = m_numNodes * 3;
@@ -741,6 +754,7 @@ SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
     }
     m_numTris = mySurf->getNumberOfTriangles();
     m_triangleList.resize(m_numTris * 3);
+    vector<float> triMins(m_numTris * 3), triMaxs(m_numTris * 3);
     for (int32_t i = 0; i < m_numTris; ++i)
     {
         int32_t i3 = i * 3;
@@ -748,106 +762,18 @@ SignedDistanceHelperBase::SignedDistanceHelperBase(const SurfaceFile* mySurf)
         m_triangleList[i3] = thisTri[0];
         m_triangleList[i3 + 1] = thisTri[1];
         m_triangleList[i3 + 2] = thisTri[2];
-        maxCoord = minCoord = myCoordData + thisTri[0] * 3;//set both to the coordinates of the first node in the triangle
-        for (int j = 1; j < 3; ++j)
+        for (int k = 0; k < 3; ++k)
         {
-            int32_t thisNode3 = thisTri[j] * 3;
-            if (myCoordData[thisNode3] < minCoord[0]) minCoord[0] = myCoordData[thisNode3];
-            if (myCoordData[thisNode3 + 1] < minCoord[1]) minCoord[1] = myCoordData[thisNode3 + 1];
-            if (myCoordData[thisNode3 + 2] < minCoord[2]) minCoord[2] = myCoordData[thisNode3 + 2];
-            if (myCoordData[thisNode3] > maxCoord[0]) maxCoord[0] = myCoordData[thisNode3];
-            if (myCoordData[thisNode3 + 1] > maxCoord[1]) maxCoord[1] = myCoordData[thisNode3 + 1];
-            if (myCoordData[thisNode3 + 2] > maxCoord[2]) maxCoord[2] = myCoordData[thisNode3 + 2];
-        }
-        addTriangle(m_indexRoot, i, minCoord, maxCoord);//use bounding box for now as an easy test to capture any chance of the triangle intersecting the Oct
-    }
-}
-
-void SignedDistanceHelperBase::addTriangle(Oct<TriVector>* thisOct, int32_t triangle, float minCoord[3], float maxCoord[3])
-{
-    if (thisOct->m_leaf)
-    {
-        thisOct->m_data.m_triList->push_back(triangle);
-        int numTris = (int)thisOct->m_data.m_triList->size();
-        if (numTris >= NUM_TRIS_TO_TEST && numTris % NUM_TRIS_TEST_INCR == NUM_TRIS_TO_TEST % NUM_TRIS_TEST_INCR)//the second modulus should const out
-        {
-            Vector3D tempMinCoord, tempMaxCoord;
-            const float* myCoordData = m_coordList.data();
-            int totalSize = 0;
-            int numSplit = 0;
-            for (int i = 0; i < numTris; ++i)//gather data on how it would end up splitting
-            {
-                const int32_t* tempTri = getTriangle((*(thisOct->m_data.m_triList))[i]);
-                tempMaxCoord = tempMinCoord = myCoordData + tempTri[0] * 3;//set both to the coordinates of the first node in the triangle
-                for (int j = 1; j < 3; ++j)
-                {
-                    int32_t thisNode3 = tempTri[j] * 3;
-                    if (myCoordData[thisNode3] < tempMinCoord[0]) tempMinCoord[0] = myCoordData[thisNode3];
-                    if (myCoordData[thisNode3 + 1] < tempMinCoord[1]) tempMinCoord[1] = myCoordData[thisNode3 + 1];
-                    if (myCoordData[thisNode3 + 2] < tempMinCoord[2]) tempMinCoord[2] = myCoordData[thisNode3 + 2];
-                    if (myCoordData[thisNode3] > tempMaxCoord[0]) tempMaxCoord[0] = myCoordData[thisNode3];
-                    if (myCoordData[thisNode3 + 1] > tempMaxCoord[1]) tempMaxCoord[1] = myCoordData[thisNode3 + 1];
-                    if (myCoordData[thisNode3 + 2] > tempMaxCoord[2]) tempMaxCoord[2] = myCoordData[thisNode3 + 2];
-                }
-                int minOct[3], maxOct[3];
-                thisOct->containingChild(tempMinCoord, minOct);
-                thisOct->containingChild(tempMaxCoord, maxOct);
-                int splitSize = 8;
-                if (minOct[0] == maxOct[0]) splitSize >>= 1;
-                if (minOct[1] == maxOct[1]) splitSize >>= 1;
-                if (minOct[2] == maxOct[2]) splitSize >>= 1;
-                totalSize += splitSize;
-                if (splitSize != 8) ++numSplit;
-            }
-            if (numSplit > 0 && totalSize < 3.0f * numTris)//don't split if all triangles end up in all child octs, and try to balance speedup with memory usage
-            {
-                thisOct->makeChildren();//do the split
-                for (int i = 0; i < numTris; ++i)//gather data on how it would end up splitting
-                {
-                    const int32_t* tempTri = getTriangle((*(thisOct->m_data.m_triList))[i]);
-                    tempMaxCoord = tempMinCoord = myCoordData + tempTri[0] * 3;//set both to the coordinates of the first node in the triangle
-                    for (int j = 1; j < 3; ++j)
-                    {
-                        int32_t thisNode3 = tempTri[j] * 3;
-                        if (myCoordData[thisNode3] < tempMinCoord[0]) tempMinCoord[0] = myCoordData[thisNode3];
-                        if (myCoordData[thisNode3 + 1] < tempMinCoord[1]) tempMinCoord[1] = myCoordData[thisNode3 + 1];
-                        if (myCoordData[thisNode3 + 2] < tempMinCoord[2]) tempMinCoord[2] = myCoordData[thisNode3 + 2];
-                        if (myCoordData[thisNode3] > tempMaxCoord[0]) tempMaxCoord[0] = myCoordData[thisNode3];
-                        if (myCoordData[thisNode3 + 1] > tempMaxCoord[1]) tempMaxCoord[1] = myCoordData[thisNode3 + 1];
-                        if (myCoordData[thisNode3 + 2] > tempMaxCoord[2]) tempMaxCoord[2] = myCoordData[thisNode3 + 2];
-                    }
-                    for (int ci = 0; ci < 2; ++ci)
-                    {
-                        for (int cj = 0; cj < 2; ++cj)
-                        {
-                            for (int ck = 0; ck < 2; ++ck)
-                            {
-                                if (thisOct->m_children[ci][cj][ck]->boundsOverlaps(tempMinCoord, tempMaxCoord))
-                                {
-                                    addTriangle(thisOct->m_children[ci][cj][ck], (*(thisOct->m_data.m_triList))[i], tempMinCoord, tempMaxCoord);
-                                }
-                            }
-                        }
-                    }
-                }
-                thisOct->m_data.freeData();//and free up some memory
-            }
-        }
-    } else {
-        for (int ci = 0; ci < 2; ++ci)
-        {
-            for (int cj = 0; cj < 2; ++cj)
+            triMins[i3 + k] = triMaxs[i3 + k] = myCoordData[thisTri[0] * 3 + k];//set both to the coordinates of the first node in the triangle
+            for (int j = 1; j < 3; ++j)
             {
-                for (int ck = 0; ck < 2; ++ck)
-                {
-                    if (thisOct->m_children[ci][cj][ck]->boundsOverlaps(minCoord, maxCoord))
-                    {
-                        addTriangle(thisOct->m_children[ci][cj][ck], triangle, minCoord, maxCoord);
-                    }
-                }
+                float thisCoord = myCoordData[thisTri[j] * 3 + k];
+                if (thisCoord < triMins[i3 + k]) triMins[i3 + k] = thisCoord;
+                if (thisCoord > triMaxs[i3 + k]) triMaxs[i3 + k] = thisCoord;
             }
         }
     }
+    m_tree.build(triMins.data(), triMaxs.data(), m_numTris, NUM_TRIS_LEAF);
 }
 
 const float* SignedDistanceHelperBase::getCoordinate(const int32_t nodeIndex) const
@@ -22,9 +22,9 @@
 /*LICENSE_END*/
 
 #include "Vector3D.h"
-#include "CaretMutex.h"
+#include "BoundingVolumeHierarchy.h"
 #include "CaretPointer.h"
-#include "OctTree.h"
+#include <utility>
 #include <vector>
 
 namespace caret {
@@ -34,29 +34,13 @@ namespace caret {
     
     class SignedDistanceHelperBase
     {
-        struct TriVector
-        {//specifically so we can cleanly deallocate the vector from non-leaf nodes when they split
-            std::vector<int32_t>* m_triList;
-            TriVector() { m_triList = new std::vector<int32_t>(); }
-            ~TriVector() { freeData(); }
-            void freeData()
-            {
-                if (m_triList != NULL)
-                {
-                    delete m_triList;
-                    m_triList = NULL;
-                }
-            }
-        };
-        static const int NUM_TRIS_TO_TEST = 50;//test for whether to split leaf at this number
-        static const int NUM_TRIS_TEST_INCR = 50;//and again at further multiples of this
-        CaretPointer<Oct<TriVector> > m_indexRoot;
+        static const int NUM_TRIS_LEAF = 4;
+        BoundingVolumeHierarchy m_tree;//each triangle is in exactly one leaf, so searches don't need to track which triangles were already tested
         int32_t m_numTris, m_numNodes;
         std::vector<float> m_coordList;//make a copy of what we need from SurfaceFile so that if the SurfaceFile gets destroyed, we don't crash
         std::vector<int32_t> m_triangleList;
         CaretPointer<TopologyHelper> m_topoHelp;
         SignedDistanceHelperBase();
-        void addTriangle(Oct<TriVector>* thisOct, int32_t triangle, float minCoord[3], float maxCoord[3]);
         const float* getCoordinate(const int32_t nodeIndex) const;//make these public? probably don't want them to be widely used, that is what SurfaceFile is for (but we don't want to store a SurfaceFile pointer)
         const int32_t* getTriangle(const int32_t tileIndex) const;
     public:
@@ -92,10 +76,7 @@ namespace caret {
             NORMALS
         };
     private:
-        CaretMutex m_mutex;
         CaretPointer<SignedDistanceHelperBase> m_base;
-        CaretArray<int> m_triMarked;
-        CaretArray<int> m_triMarkChanged;
         SignedDistanceHelper();
         struct ClosestPointInfo
         {
@@ -103,18 +84,43 @@ namespace caret {
             int32_t node1, node2, triangle;
             Vector3D tempPoint;
         };
-        float unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo);
-        int computeSign(const float coord[3], ClosestPointInfo myInfo, WindingLogic myWinding);
-        bool pointInTri(Vector3D verts[3], Vector3D inPlane, int majAxis, int midAxis);
+        float unsignedDistToTri(const float coord[3], int32_t triangle, ClosestPointInfo& myInfo) const;
+        float closestTriangle(const float coord[3], ClosestPointInfo& bestInfo, const int32_t& hintTriangle = -1) const;
+        int computeSign(const float coord[3], ClosestPointInfo myInfo, WindingLogic myWinding) const;
+        static bool pointInTri(Vector3D verts[3], Vector3D inPlane, int majAxis, int midAxis);
     public:
         SignedDistanceHelper(CaretPointer<SignedDistanceHelperBase> myBase);
         
         ///return the signed distance value at the point
         float dist(const float coord[3], WindingLogic myWinding);
         
+        ///return the unsigned distance to the surface, without the cost of determining the sign
+        float unsignedDist(const float coord[3]);
+        
+        ///find every triangle crossed by the ray, as (distance along ray in units of direction, +1 or -1 depending on which way the triangle faces), sorted by distance
+        ///summing the second members of all crossings beyond a point gives the crossing count used by the EVEN_ODD, NEGATIVE and NONZERO methods
+        ///so that all points along a line can get their sign from one traversal
+        void rayCrossings(const float start[3], const float direction[3], std::vector<std::pair<float, int> >& crossingsOut);
+        
+        struct SegmentHit
+        {
+            float distance;//along the segment, in units of direction, so 0 is start and 1 is the end
+            int32_t triangle;
+            float baryWeights[3];//for the triangle's nodes, in the order the triangle lists them
+            bool operator<(const SegmentHit& rhs) const { return distance < rhs.distance; }
+        };
+        
+        ///find every triangle that the line segment from start to start + direction passes through, sorted by distance
+        ///unlike rayCrossings, it reports which triangle was hit and where, for picking the surface under a point on screen
+        void segmentHits(const float start[3], const float direction[3], std::vector<SegmentHit>& hitsOut);
+        
+        ///convert a crossing count to a sign, for any winding method except NORMALS
+        static int windingSign(const int& crossCount, const WindingLogic& myWinding);
+        
         ///find the closest point ON the surface, and return information about it
         ///will never have negative barycentric weights, or a point outside the triangle
-        void barycentricWeights(const float coordIn[3], BarycentricInfo& baryInfoOut);
+        ///hintTriangle is optional, a triangle expected to be close to the point, which lets the search skip most of the surface, the result is the same as without it
+        void barycentricWeights(const float coordIn[3], BarycentricInfo& baryInfoOut, const int32_t& hintTriangle = -1);
     };
 
 }
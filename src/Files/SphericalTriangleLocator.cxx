@@ -0,0 +1,170 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SphericalTriangleLocator.h"
+
+#include "CaretAssert.h"
+#include "SurfaceFile.h"
+#include "Vector3D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace caret;
+using namespace std;
+
+SphericalTriangleLocator::SphericalTriangleLocator(const SurfaceFile* mySphere)
+{
+    m_numTris = mySphere->getNumberOfTriangles();
+    const float* coordData = mySphere->getCoordinateData();
+    m_edgeNormals.resize(m_numTris * 9);
+    double totalVolume = 0.0;//to find which way the triangles are wound
+    for (int32_t i = 0; i < m_numTris; ++i)
+    {
+        const int32_t* thisTri = mySphere->getTriangle(i);
+        for (int j = 0; j < 3; ++j)
+        {//the plane through the origin and an edge separates the directions inside the triangle from those outside
+            Vector3D edgeNormal = Vector3D(coordData + thisTri[j] * 3).cross(coordData + thisTri[(j + 1) % 3] * 3);
+            if (j == 0) totalVolume += edgeNormal.dot(coordData + thisTri[2] * 3);
+            edgeNormal = edgeNormal.normal();//unit length, so walk() can use one tolerance for every edge
+            for (int k = 0; k < 3; ++k)
+            {
+                m_edgeNormals[i * 9 + j * 3 + k] = edgeNormal[k];
+            }
+        }
+    }
+    if (totalVolume < 0.0)
+    {
+        for (int64_t i = 0; i < (int64_t)m_edgeNormals.size(); ++i)
+        {
+            m_edgeNormals[i] = -m_edgeNormals[i];
+        }
+    }
+    vector<pair<int64_t, int32_t> > edgeList(m_numTris * 3);//(edge key, triangle * 3 + edge), sorting puts both sides of an edge together
+    int64_t numNodes = mySphere->getNumberOfNodes();
+    for (int32_t i = 0; i < m_numTris; ++i)
+    {
+        const int32_t* thisTri = mySphere->getTriangle(i);
+        for (int j = 0; j < 3; ++j)
+        {
+            int64_t node1 = thisTri[j], node2 = thisTri[(j + 1) % 3];
+            edgeList[i * 3 + j] = make_pair(min(node1, node2) * numNodes + max(node1, node2), i * 3 + j);
+        }
+    }
+    sort(edgeList.begin(), edgeList.end());
+    m_edgeNeighbor.resize(m_numTris * 3, -1);
+    int64_t numEdges = (int64_t)edgeList.size();
+    for (int64_t i = 0; i < numEdges; )
+    {
+        int64_t end = i + 1;
+        while (end < numEdges && edgeList[end].first == edgeList[i].first) ++end;
+        if (end - i == 2)//boundary and nonmanifold edges stop the walk
+        {
+            m_edgeNeighbor[edgeList[i].second] = edgeList[i + 1].second / 3;
+            m_edgeNeighbor[edgeList[i + 1].second] = edgeList[i].second / 3;
+        }
+        i = end;
+    }
+    m_gridSize = max(1, (int)sqrt(m_numTris / 48.0));//about 8 triangles per cell on average, so few cells are empty despite the cube map distortion
+    m_bucketSeed.resize(6 * m_gridSize * m_gridSize, -1);
+    m_triangleCell.resize(m_numTris);
+    for (int32_t i = 0; i < m_numTris; ++i)
+    {
+        const int32_t* thisTri = mySphere->getTriangle(i);
+        Vector3D center = (Vector3D(coordData + thisTri[0] * 3) + Vector3D(coordData + thisTri[1] * 3) + Vector3D(coordData + thisTri[2] * 3)) / 3.0f;
+        int64_t cell = cellIndex(center);
+        m_triangleCell[i] = cell;
+        if (m_bucketSeed[cell] == -1) m_bucketSeed[cell] = i;
+    }
+    int32_t lastSeed = -1;//empty cells borrow a seed from the previous cell, the walk makes up the difference
+    int64_t numCells = (int64_t)m_bucketSeed.size();
+    for (int64_t i = 0; i < numCells; ++i)
+    {
+        if (m_bucketSeed[i] == -1)
+        {
+            m_bucketSeed[i] = lastSeed;
+        } else {
+            lastSeed = m_bucketSeed[i];
+        }
+    }
+    for (int64_t i = 0; i < numCells && m_bucketSeed[i] == -1; ++i)
+    {
+        m_bucketSeed[i] = lastSeed;//leading empty cells, lastSeed is now the last seed in the grid
+    }
+}
+
+int64_t SphericalTriangleLocator::cellIndex(const float dir[3]) const
+{
+    int major = 0;
+    for (int i = 1; i < 3; ++i)
+    {
+        if (fabs(dir[i]) > fabs(dir[major])) major = i;
+    }
+    int face = major * 2 + (dir[major] < 0.0f ? 1 : 0);
+    float majorAbs = fabs(dir[major]);
+    if (majorAbs == 0.0f) return 0;
+    int cellCoords[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        float proj = dir[(major + 1 + i) % 3] / majorAbs;//in [-1, 1]
+        cellCoords[i] = (int)((proj + 1.0f) * 0.5f * m_gridSize);
+        if (cellCoords[i] < 0) cellCoords[i] = 0;
+        if (cellCoords[i] >= m_gridSize) cellCoords[i] = m_gridSize - 1;
+    }
+    return (int64_t(face) * m_gridSize + cellCoords[1]) * m_gridSize + cellCoords[0];
+}
+
+int32_t SphericalTriangleLocator::walk(const float dir[3], int32_t start) const
+{
+    const int32_t maxSteps = 100 + 4 * (int32_t)sqrt((float)m_numTris);//a walk across the whole sphere takes on the order of sqrt(triangles) steps
+    //directions on an edge or vertex (like the vertices of an identical mesh) can round to slightly outside of every triangle that touches them
+    const float tolerance = -1e-6f * sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    int32_t current = start;
+    for (int32_t step = 0; step < maxSteps; ++step)
+    {
+        const float* normals = m_edgeNormals.data() + current * 9;
+        int worstEdge = -1;
+        float worstDot = tolerance;
+        for (int j = 0; j < 3; ++j)
+        {
+            float tempf = normals[j * 3] * dir[0] + normals[j * 3 + 1] * dir[1] + normals[j * 3 + 2] * dir[2];
+            if (tempf < worstDot)
+            {
+                worstDot = tempf;
+                worstEdge = j;
+            }
+        }
+        if (worstEdge == -1) return current;//inside or on the boundary of every edge
+        current = m_edgeNeighbor[current * 3 + worstEdge];//cross the edge we are farthest outside of
+        if (current == -1) return -1;
+    }
+    return -1;
+}
+
+int32_t SphericalTriangleLocator::locate(const float coordIn[3], const int32_t& startTriangle) const
+{
+    if (m_numTris == 0) return -1;
+    CaretAssert(startTriangle < m_numTris);
+    int64_t cell = cellIndex(coordIn);
+    int32_t start = startTriangle;
+    if (start < 0 || m_triangleCell[start] != cell) start = m_bucketSeed[cell];//a previous result in another cell could be anywhere, don't risk a long walk
+    return walk(coordIn, start);
+}
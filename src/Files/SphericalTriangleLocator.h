@@ -0,0 +1,52 @@
+#ifndef __SPHERICAL_TRIANGLE_LOCATOR_H__
+#define __SPHERICAL_TRIANGLE_LOCATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+#include "stdint.h"
+
+namespace caret
+{
+    class SurfaceFile;
+    
+    ///finds which triangle of a sphere centered on the origin a direction from the origin passes through, by walking across edges from a nearby triangle
+    ///starting triangles come from a cube map bucket grid over the sphere, or from a previous result, since successive queries are usually near each other
+    class SphericalTriangleLocator
+    {
+        int32_t m_numTris;
+        int m_gridSize;//cells per cube face edge
+        std::vector<int32_t> m_bucketSeed;//a triangle in or near each cell
+        std::vector<int64_t> m_triangleCell;//cell of each triangle's center, to tell whether a start triangle is worth walking from
+        std::vector<float> m_edgeNormals;//3 per triangle, cross products of the edge's endpoints, pointing into the triangle
+        std::vector<int32_t> m_edgeNeighbor;//triangle across each edge, -1 for boundary or nonmanifold edges
+        int64_t cellIndex(const float dir[3]) const;
+        int32_t walk(const float dir[3], int32_t start) const;
+    public:
+        SphericalTriangleLocator(const SurfaceFile* mySphere);
+        
+        ///returns the triangle containing the direction to coordIn from the origin, or -1 if the walk couldn't find one (holes, folded or very irregular meshes)
+        ///startTriangle should be the result of a nearby query if there is one, it is only used if it is in the same grid cell as coordIn, otherwise the walk starts from the bucket grid
+        int32_t locate(const float coordIn[3], const int32_t& startTriangle = -1) const;
+    };
+}
+
+#endif //__SPHERICAL_TRIANGLE_LOCATOR_H__
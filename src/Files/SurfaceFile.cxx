@@ -18,9 +18,12 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <set>
 
+#include <QCoreApplication>
 #include <QThread>
 
 #include "BoundingBox.h"
@@ -33,10 +36,12 @@
 #include "DataFileContentInformation.h"
 #include "DescriptiveStatistics.h"
 #include "FastStatistics.h"
+#include "EventGraphicsUpdateAllWindows.h"
 #include "EventSurfaceColoringInvalidate.h"
 
 #include "GiftiFile.h"
 #include "GiftiMetaDataXmlElements.h"
+#include "GraphicsOpenGLSurfaceBuffers.h"
 #include "MathFunctions.h"
 #include "Matrix4x4.h"
 #include "Vector3D.h"
@@ -45,10 +50,62 @@
 #include "GeodesicHelper.h"
 #include "PlainTextStringBuilder.h"
 #include "SignedDistanceHelper.h"
+#include "SurfaceLevelsOfDetail.h"
 #include "TopologyHelper.h"
 
 using namespace caret;
 
+/**
+ * Creates levels of detail from copies of a surface's coordinates
+ * and triangles so that the surface may change while it runs.
+ * Graphics are updated when it finishes so that the levels are used.
+ */
+class SurfaceFile::LevelsOfDetailThread : public QThread
+{
+public:
+    LevelsOfDetailThread(const SurfaceFile* surfaceFile)
+    : m_xyz(surfaceFile->getCoordinateData(),
+            surfaceFile->getCoordinateData() + (surfaceFile->getNumberOfNodes() * 3)),
+    m_triangles(surfaceFile->getTriangle(0),
+                surfaceFile->getTriangle(0) + (surfaceFile->getNumberOfTriangles() * 3)),
+    m_geometryModificationCount(surfaceFile->getGeometryModificationCount()),
+    m_cancelFlag(false)
+    {
+        /*
+         * Signal is emitted in this thread so the update is
+         * queued for the application's (main) thread
+         */
+        QCoreApplication* application = QCoreApplication::instance();
+        if (application != NULL) {
+            QObject::connect(this, &QThread::finished,
+                             application, []() {
+                                 EventManager::get()->sendEvent(EventGraphicsUpdateAllWindows().getPointer());
+                             },
+                             Qt::QueuedConnection);
+        }
+    }
+    
+    void run() {
+        m_levelsOfDetail.reset(new SurfaceLevelsOfDetail(m_xyz.data(),
+                                                         static_cast<int32_t>(m_xyz.size() / 3),
+                                                         m_triangles.data(),
+                                                         static_cast<int32_t>(m_triangles.size() / 3),
+                                                         m_geometryModificationCount,
+                                                         &m_cancelFlag));
+    }
+    
+    const std::vector<float> m_xyz;
+    
+    const std::vector<int32_t> m_triangles;
+    
+    const int64_t m_geometryModificationCount;
+    
+    /** Set to stop creating the levels */
+    std::atomic<bool> m_cancelFlag;
+    
+    std::unique_ptr<SurfaceLevelsOfDetail> m_levelsOfDetail;
+};
+
 /**
  * Constructor.
  */
@@ -103,6 +160,11 @@ SurfaceFile::~SurfaceFile()
 {
     EventManager::get()->removeAllEventsFromListener(this);
     
+    if (m_levelsOfDetailThread != NULL) {
+        m_levelsOfDetailThread->m_cancelFlag = true;
+        m_levelsOfDetailThread->wait();
+    }
+    
     if (this->boundingBox != NULL) {
         delete this->boundingBox;
         this->boundingBox = NULL;
@@ -136,6 +198,8 @@ SurfaceFile::clear()
     trianglePointer = NULL;
     GiftiTypeFile::clear();
     invalidateHelpers();
+    invalidateNodeTriangles();
+    invalidateNormals();
     this->invalidateNodeColoringForBrowserTabs();
 }
 
@@ -321,6 +385,8 @@ void SurfaceFile::setNumberOfNodesAndTriangles(const int32_t& nodes, const int32
     trianglePointer = NULL;
     giftiFile->clearAndKeepMetadata();
     invalidateHelpers();
+    invalidateNodeTriangles();
+    invalidateNormals();
     this->invalidateNodeColoringForBrowserTabs();
     std::vector<int64_t> dims(2);
     dims[1] = 3;
@@ -393,7 +459,8 @@ void SurfaceFile::setCoordinate(const int32_t nodeIndex, const float xIn, const
     this->coordinatePointer[offset] = xIn;
     this->coordinatePointer[offset+1] = yIn;
     this->coordinatePointer[offset+2] = zIn;
-    invalidateNormals();
+    markNodeNormalDirty(nodeIndex);
+    ++m_geometryModificationCount;
     invalidateHelpers();
     setModified();
 }
@@ -459,6 +526,7 @@ void SurfaceFile::setTriangle(const int32_t& index, const int32_t& node1, const
     trianglePointer[offset + 1] = node2;
     trianglePointer[offset + 2] = node3;
     invalidateHelpers();
+    invalidateNodeTriangles();
     invalidateNormals();
     setModified();
 }
@@ -525,6 +593,8 @@ SurfaceFile::initializeMembersSurfaceFile()
     m_geoHelperIndex = 0;
     m_topoHelperIndex = 0;
     m_normalsComputed = false;
+    m_dirtyNormalNodes.clear();
+    invalidateNodeTriangles();
 }
 
 /**
@@ -584,7 +654,220 @@ void
 SurfaceFile::invalidateNormals()
 {
     m_normalsComputed = false;
+    m_dirtyNormalNodes.clear();
+    ++m_geometryModificationCount;
 }
+
+/**
+ * @return The OpenGL buffers used to draw this surface, created when first requested.
+ * The buffers compare the geometry and node coloring modification counts with those
+ * they were loaded at, so they only need loading again after the surface changes.
+ */
+GraphicsOpenGLSurfaceBuffers*
+SurfaceFile::getGraphicsOpenGLSurfaceBuffers() const
+{
+    if (m_graphicsOpenGLSurfaceBuffers == NULL) {
+        m_graphicsOpenGLSurfaceBuffers.reset(new GraphicsOpenGLSurfaceBuffers());
+    }
+    return m_graphicsOpenGLSurfaceBuffers.get();
+}
+
+/**
+ * @return The levels of detail for drawing this surface at small sizes, or NULL
+ * if the surface is too small to simplify or the levels are not yet available.
+ * Since simplification takes a while for large surfaces, the levels are created
+ * in a background thread when first requested or requested after the geometry
+ * changes, and the surface is drawn at full resolution until they are ready.
+ */
+const SurfaceLevelsOfDetail*
+SurfaceFile::getLevelsOfDetail() const
+{
+    if (m_levelsOfDetailThread != NULL) {
+        if ( ! m_levelsOfDetailThread->isFinished()) {
+            return NULL;
+        }
+        m_levelsOfDetailThread->wait();
+        m_levelsOfDetail = std::move(m_levelsOfDetailThread->m_levelsOfDetail);
+        m_levelsOfDetailThread.reset();
+    }
+    
+    if (m_levelsOfDetail != NULL) {
+        if (m_levelsOfDetail->getGeometryModificationCount() == m_geometryModificationCount) {
+            return m_levelsOfDetail.get();
+        }
+        m_levelsOfDetail.reset();
+    }
+    
+    if (getNumberOfTriangles() >= SurfaceLevelsOfDetail::MINIMUM_TRIANGLES_FOR_SIMPLIFICATION) {
+        m_levelsOfDetailThread.reset(new LevelsOfDetailThread(this));
+        m_levelsOfDetailThread->start(QThread::LowPriority);
+    }
+    
+    return NULL;
+}
+
+namespace
+{
+    ///same math as MathFunctions::normalVector, but inline over a range of triangles so the compiler can vectorize it
+    void computeTriangleNormals(const float* coords, const int32_t* triangles, const int32_t start, const int32_t end, float* normalsOut)
+    {
+        for (int32_t i = start; i < end; ++i)
+        {
+            if (triangles[i * 3] < 0 || triangles[i * 3 + 1] < 0 || triangles[i * 3 + 2] < 0)
+            {//not used by any node, but don't read outside the coordinates
+                normalsOut[i * 3] = 0.0f;
+                normalsOut[i * 3 + 1] = 0.0f;
+                normalsOut[i * 3 + 2] = 0.0f;
+                continue;
+            }
+            const float* v1 = coords + triangles[i * 3] * 3;
+            const float* v2 = coords + triangles[i * 3 + 1] * 3;
+            const float* v3 = coords + triangles[i * 3 + 2] * 3;
+            double a0 = v3[0] - v2[0];//double precision is needed for small or sliver triangles
+            double a1 = v3[1] - v2[1];
+            double a2 = v3[2] - v2[2];
+            double b0 = v1[0] - v2[0];
+            double b1 = v1[1] - v2[1];
+            double b2 = v1[2] - v2[2];
+            double nv0 = (a1 * b2 - a2 * b1);
+            double nv1 = (a2 * b0 - a0 * b2);
+            double nv2 = (a0 * b1 - a1 * b0);
+            double length = std::sqrt(nv0 * nv0 + nv1 * nv1 + nv2 * nv2);
+            if (length != 0.0)
+            {
+                nv0 /= length;
+                nv1 /= length;
+                nv2 /= length;
+            }
+            normalsOut[i * 3] = (float)nv0;
+            normalsOut[i * 3 + 1] = (float)nv1;
+            normalsOut[i * 3 + 2] = (float)nv2;
+        }
+    }
+}
+
+/**
+ * Build the node to triangle incidence lists, if they don't exist.
+ * Triangles with an invalid (negative) node are not included.
+ */
+void
+SurfaceFile::validateNodeTriangles() const
+{
+    CaretMutexLocker locked(&m_nodeTrianglesMutex);
+    const int32_t numNodes = getNumberOfNodes();
+    if ((int32_t)m_nodeTriangleStart.size() == numNodes + 1) return;
+    const int32_t numTriangles = getNumberOfTriangles();
+    std::vector<int32_t> start(numNodes + 1, 0);
+    for (int32_t i = 0; i < numTriangles * 3; i += 3) {
+        if ((trianglePointer[i] < 0) || (trianglePointer[i + 1] < 0) || (trianglePointer[i + 2] < 0)) continue;
+        for (int j = 0; j < 3; ++j) {
+            ++start[trianglePointer[i + j] + 1];
+        }
+    }
+    for (int32_t i = 0; i < numNodes; ++i) {
+        start[i + 1] += start[i];
+    }
+    std::vector<int32_t> triangles(start[numNodes]);
+    std::vector<int32_t> position(start.begin(), start.end() - 1);
+    for (int32_t i = 0; i < numTriangles; ++i) {//ascending triangle order within each node
+        const int32_t* thisTri = trianglePointer + i * 3;
+        if ((thisTri[0] < 0) || (thisTri[1] < 0) || (thisTri[2] < 0)) continue;
+        for (int j = 0; j < 3; ++j) {
+            triangles[position[thisTri[j]]++] = i;
+        }
+    }
+    m_nodeTriangles.swap(triangles);
+    m_nodeTriangleStart.swap(start);//do this last, its size is what marks the lists as valid
+}
+
+/**
+ * Discard the node to triangle incidence lists, when topology changes.
+ */
+void
+SurfaceFile::invalidateNodeTriangles()
+{
+    CaretMutexLocker locked(&m_nodeTrianglesMutex);
+    m_nodeTriangleStart.clear();
+    m_nodeTriangles.clear();
+    ++m_geometryModificationCount;//triangles changed
+}
+
+/**
+ * Record that a node moved, so that only the normals around it need
+ * updating.  Falls back to recomputing everything when many nodes move.
+ */
+void
+SurfaceFile::markNodeNormalDirty(const int32_t nodeIndex)
+{
+    if (m_normalsComputed == false) return;
+    if ((int32_t)m_dirtyNormalNodes.size() >= getNumberOfNodes() / 8) {
+        invalidateNormals();
+        return;
+    }
+    m_dirtyNormalNodes.push_back(nodeIndex);
+}
+
+/**
+ * Sum the triangle normals around each of the given nodes and normalize.
+ */
+void
+SurfaceFile::gatherNodeNormals(const int32_t* nodes,
+                               const int32_t numNodes)
+{
+    float* normalPointer = this->normalVectors.data();
+    const float* triangleNormals = m_triangleNormals.data();
+#pragma omp CARET_PARFOR schedule(dynamic, 1024) if(numNodes > 4096)
+    for (int32_t n = 0; n < numNodes; n++) {
+        const int32_t node = ((nodes == NULL) ? n : nodes[n]);
+        const int32_t i3 = node * 3;
+        float accum[3] = { 0.0f, 0.0f, 0.0f };
+        const int32_t end = m_nodeTriangleStart[node + 1];
+        for (int32_t t = m_nodeTriangleStart[node]; t < end; t++) {
+            const float* triNormal = triangleNormals + m_nodeTriangles[t] * 3;
+            accum[0] += triNormal[0];
+            accum[1] += triNormal[1];
+            accum[2] += triNormal[2];
+        }
+        if (end > m_nodeTriangleStart[node]) {
+            normalPointer[i3 + 0] = accum[0];
+            normalPointer[i3 + 1] = accum[1];
+            normalPointer[i3 + 2] = accum[2];
+            MathFunctions::normalizeVector(normalPointer + i3);
+        } else {
+            normalPointer[i3 + 0] = 0.0f;//zero the normals for unconnected nodes
+            normalPointer[i3 + 1] = 0.0f;
+            normalPointer[i3 + 2] = 0.0f;
+        }
+    }
+}
+
+/**
+ * Recompute the normals of only the triangles touching moved nodes, and of the nodes of those triangles.
+ */
+void
+SurfaceFile::updateDirtyNormals()
+{
+    validateNodeTriangles();
+    std::vector<int32_t> triangles;
+    const int32_t numDirty = (int32_t)m_dirtyNormalNodes.size();
+    for (int32_t i = 0; i < numDirty; i++) {
+        const int32_t node = m_dirtyNormalNodes[i];
+        triangles.insert(triangles.end(), m_nodeTriangles.begin() + m_nodeTriangleStart[node], m_nodeTriangles.begin() + m_nodeTriangleStart[node + 1]);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+    std::vector<int32_t> nodes;
+    const int32_t numTriangles = (int32_t)triangles.size();
+    for (int32_t i = 0; i < numTriangles; i++) {
+        computeTriangleNormals(this->coordinatePointer, this->trianglePointer, triangles[i], triangles[i] + 1, m_triangleNormals.data());
+        nodes.insert(nodes.end(), this->trianglePointer + triangles[i] * 3, this->trianglePointer + triangles[i] * 3 + 3);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    gatherNodeNormals(nodes.data(), (int32_t)nodes.size());
+    m_dirtyNormalNodes.clear();
+}
+
 /**
  * Compute surface normals.
  */
@@ -593,9 +876,12 @@ SurfaceFile::computeNormals()
 {
     if (m_normalsComputed)//don't recompute when not needed
     {
+        if (m_dirtyNormalNodes.empty() == false) {
+            updateDirtyNormals();
+            ++m_geometryModificationCount;
+        }
         return;
     }
-    m_normalsComputed = true;
     int32_t numCoords = this->getNumberOfNodes();
     if (numCoords > 0) {
         this->normalVectors.resize(numCoords * 3);
@@ -606,53 +892,21 @@ SurfaceFile::computeNormals()
     
     const int32_t numTriangles = this->getNumberOfTriangles();
     if ((numCoords > 0) && (numTriangles > 0)) {
-        float* normalPointer = &this->normalVectors[0];
-        std::vector<int> numContribute(numCoords, 0);
-
-        float triangleNormal[3];
-        for (int32_t i = 0; i < numTriangles; i++) {
-            const int32_t it3 = i * 3;
-            const int n1 = this->trianglePointer[it3];
-            const int n2 = this->trianglePointer[it3 + 1];
-            const int n3 = this->trianglePointer[it3 + 2];
-            const int32_t c1 = n1 * 3;
-            const int32_t c2 = n2 * 3;
-            const int32_t c3 = n3 * 3;
-            if ((n1 >= 0)
-                && (n2 >= 0)
-                && (n3 >= 0)) {
-                
-                MathFunctions::normalVector(&this->coordinatePointer[c1],
-                                            &this->coordinatePointer[c2],
-                                            &this->coordinatePointer[c3],
-                                            triangleNormal);
-                
-                normalPointer[c1 + 0] += triangleNormal[0];//+= is not guaranteed to be atomic, do not parallelize
-                normalPointer[c1 + 1] += triangleNormal[1];
-                normalPointer[c1 + 2] += triangleNormal[2];
-                numContribute[n1] += 1;
-                normalPointer[c2 + 0] += triangleNormal[0];
-                normalPointer[c2 + 1] += triangleNormal[1];
-                normalPointer[c2 + 2] += triangleNormal[2];
-                numContribute[n2] += 1;
-                normalPointer[c3 + 0] += triangleNormal[0];
-                normalPointer[c3 + 1] += triangleNormal[1];
-                normalPointer[c3 + 2] += triangleNormal[2];
-                numContribute[n3] += 1;
-            }
-        }
-        
-        for (int i = 0; i < numCoords; i++) {
-            const int i3 = i * 3;
-            if (numContribute[i] > 0) {
-                MathFunctions::normalizeVector(normalPointer + i3);
-            } else {
-                normalPointer[i3 + 0] = 0.0f;//zero the normals for unconnected nodes
-                normalPointer[i3 + 1] = 0.0f;
-                normalPointer[i3 + 2] = 0.0f;
-            }
+        validateNodeTriangles();
+        m_triangleNormals.resize(numTriangles * 3);
+        const int32_t BLOCK_SIZE = 4096;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int32_t start = 0; start < numTriangles; start += BLOCK_SIZE) {
+            computeTriangleNormals(this->coordinatePointer, this->trianglePointer, start, std::min(start + BLOCK_SIZE, numTriangles), m_triangleNormals.data());
         }
+        gatherNodeNormals(NULL, numCoords);//each node sums its own triangles, so there are no conflicting writes
+    }
+    else if (numCoords > 0) {
+        std::fill(this->normalVectors.begin(), this->normalVectors.end(), 0.0f);
     }
+    m_normalsComputed = true;
+    m_dirtyNormalNodes.clear();
+    ++m_geometryModificationCount;
 }
 
 std::vector<float> SurfaceFile::computeAverageNormals()
@@ -662,6 +916,7 @@ std::vector<float> SurfaceFile::computeAverageNormals()
     int numCoords = getNumberOfNodes();
     std::vector<float> ret(numCoords * 3);
     CaretPointer<TopologyHelper> myTopoHelp = getTopologyHelper();//TODO: make this not circular - separate base that doesn't handle helpers (and is used by helpers) from file that handles helpers and normals?
+#pragma omp CARET_PARFOR schedule(dynamic, 1024)
     for (int i = 0; i < numCoords; ++i)
     {
         int i3 = i * 3;
@@ -1008,6 +1263,8 @@ SurfaceFile::applyMatrix(const Matrix4x4& matrix)
         }
     }
     
+    invalidateHelpers();//distance and locator helpers keep copies of the coordinates
+    invalidateNormals();
     computeNormals();
     
     setModified();
@@ -1152,20 +1409,25 @@ void SurfaceFile::computeNodeAreas(std::vector<float>& areasOut) const
     int32_t triEnd = getNumberOfTriangles();
     int32_t numNodes = getNumberOfNodes();
     areasOut.resize(numNodes);
-    for (int32_t i = 0; i < numNodes; ++i)
-    {
-        areasOut[i] = 0.0f;
-    }
+    validateNodeTriangles();
+    std::vector<float> triAreas(triEnd);
+#pragma omp CARET_PARFOR schedule(dynamic, 4096)
     for (int32_t i = 0; i < triEnd; ++i)
     {
         const int32_t* thisTri = getTriangle(i);
-        const float* node1 = getCoordinate(thisTri[0]);
-        const float* node2 = getCoordinate(thisTri[1]);
-        const float* node3 = getCoordinate(thisTri[2]);
-        float area3 = MathFunctions::triangleArea(node1, node2, node3) / 3.0f;
-        areasOut[thisTri[0]] += area3;
-        areasOut[thisTri[1]] += area3;
-        areasOut[thisTri[2]] += area3;
+        if (thisTri[0] < 0 || thisTri[1] < 0 || thisTri[2] < 0) continue;
+        triAreas[i] = MathFunctions::triangleArea(getCoordinate(thisTri[0]), getCoordinate(thisTri[1]), getCoordinate(thisTri[2])) / 3.0f;
+    }
+#pragma omp CARET_PARFOR schedule(dynamic, 4096)
+    for (int32_t i = 0; i < numNodes; ++i)
+    {//gather in ascending triangle order, to get the same sums as scattering from a serial loop over triangles
+        float accum = 0.0f;
+        const int32_t end = m_nodeTriangleStart[i + 1];
+        for (int32_t t = m_nodeTriangleStart[i]; t < end; ++t)
+        {
+            accum += triAreas[m_nodeTriangles[t]];
+        }
+        areasOut[i] = accum;
     }
 }
 
@@ -1370,6 +1632,7 @@ SurfaceFile::invalidateNodeColoringForBrowserTabs()
         this->surfaceMontageNodeColoringForBrowserTabs[i].clear();
         this->wholeBrainNodeColoringForBrowserTabs[i].clear();
     }    
+    ++m_nodeColoringModificationCount;
 }
 
 /**
@@ -1498,6 +1761,7 @@ SurfaceFile::setSurfaceNodeColoringRgbaForBrowserTab(const int32_t browserTabInd
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
 }
 
 /**
@@ -1545,6 +1809,7 @@ SurfaceFile::setSurfaceMontageNodeColoringRgbaForBrowserTab(const int32_t browse
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
 }
 
 
@@ -1592,6 +1857,7 @@ SurfaceFile::setWholeBrainNodeColoringRgbaForBrowserTab(const int32_t browserTab
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
 }
 
 /**
@@ -22,6 +22,7 @@
  */
 /*LICENSE_END*/
 
+#include <memory>
 #include <vector>
 #include <stdint.h>
 
@@ -42,10 +43,12 @@ namespace caret {
     class GeodesicHelper;
     class GeodesicHelperBase;
     class GiftiDataArray;
+    class GraphicsOpenGLSurfaceBuffers;
     class Matrix4x4;
     class PlainTextStringBuilder;
     class SignedDistanceHelper;
     class SignedDistanceHelperBase;
+    class SurfaceLevelsOfDetail;
     class TopologyHelper;
     class TopologyHelperBase;
     
@@ -179,6 +182,16 @@ namespace caret {
 
         void invalidateNormals();
         
+        /** @return Count that changes whenever the coordinates, normals, or triangles change. */
+        int64_t getGeometryModificationCount() const { return m_geometryModificationCount; }
+        
+        /** @return Count that changes whenever any node coloring for a browser tab changes. */
+        int64_t getNodeColoringModificationCount() const { return m_nodeColoringModificationCount; }
+        
+        GraphicsOpenGLSurfaceBuffers* getGraphicsOpenGLSurfaceBuffers() const;
+        
+        const SurfaceLevelsOfDetail* getLevelsOfDetail() const;
+        
         void translateToCenterOfMass();
         
         void flipNormals();
@@ -263,7 +276,40 @@ namespace caret {
         
         bool m_normalsComputed;
         
+        /** unit normal of each triangle, kept so that moving a few nodes only recomputes their triangles */
+        std::vector<float> m_triangleNormals;
+        
+        /** nodes moved since the normals were computed, when there are few enough to update incrementally */
+        std::vector<int32_t> m_dirtyNormalNodes;
+        
+        ///node to triangle incidence, each node's triangles are in ascending order so that gathering sums in the same order as a serial loop over triangles
+        mutable std::vector<int32_t> m_nodeTriangleStart, m_nodeTriangles;
+        
+        void validateNodeTriangles() const;
+        
+        void invalidateNodeTriangles();
+        
+        void markNodeNormalDirty(const int32_t nodeIndex);
+        
+        void updateDirtyNormals();
+        
+        void gatherNodeNormals(const int32_t* nodes, const int32_t numNodes);
+        
         bool m_skipSanityCheck;
+        
+        int64_t m_geometryModificationCount = 0;
+        
+        int64_t m_nodeColoringModificationCount = 0;
+        
+        ///OpenGL buffers for drawing, only created by the graphics code, never copied
+        mutable std::unique_ptr<GraphicsOpenGLSurfaceBuffers> m_graphicsOpenGLSurfaceBuffers;
+        
+        class LevelsOfDetailThread;
+        
+        ///simplified triangles for drawing at small sizes, created in a thread when first requested, never copied
+        mutable std::unique_ptr<SurfaceLevelsOfDetail> m_levelsOfDetail;
+        
+        mutable std::unique_ptr<LevelsOfDetailThread> m_levelsOfDetailThread;
 
         ///topology base for surface
         mutable CaretPointer<TopologyHelperBase> m_topoBase;
@@ -300,7 +346,7 @@ namespace caret {
         
         mutable BoundingBox* boundingBox;
         
-        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex;
+        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex, m_nodeTrianglesMutex;
     };
 
 } // namespace
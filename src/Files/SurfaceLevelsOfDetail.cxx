@@ -0,0 +1,612 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __SURFACE_LEVELS_OF_DETAIL_DECLARE__
+#include "SurfaceLevelsOfDetail.h"
+#undef __SURFACE_LEVELS_OF_DETAIL_DECLARE__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "ElapsedTimer.h"
+
+using namespace caret;
+
+
+namespace
+{
+    ///sum of squared distances to planes, upper triangle of a symmetric 4x4 matrix
+    typedef std::array<double, 10> Quadric;
+
+    double quadricError(const Quadric& q, const float* xyz)
+    {
+        const double x = xyz[0];
+        const double y = xyz[1];
+        const double z = xyz[2];
+        return ((q[0] * x * x) + (2.0 * q[1] * x * y) + (2.0 * q[2] * x * z) + (2.0 * q[3] * x)
+                + (q[4] * y * y) + (2.0 * q[5] * y * z) + (2.0 * q[6] * y)
+                + (q[7] * z * z) + (2.0 * q[8] * z)
+                + q[9]);
+    }
+
+    ///normal vector with length of twice the triangle's area
+    void triangleNormal(const float* a, const float* b, const float* c, double normalOut[3])
+    {
+        const double ab[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+        const double ac[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+        normalOut[0] = (ab[1] * ac[2]) - (ab[2] * ac[1]);
+        normalOut[1] = (ab[2] * ac[0]) - (ab[0] * ac[2]);
+        normalOut[2] = (ab[0] * ac[1]) - (ab[1] * ac[0]);
+    }
+
+    ///candidate removal of an edge's 'from' vertex by moving it to the edge's 'to' vertex
+    struct Collapse
+    {
+        double m_cost;
+        int32_t m_fromVertex;
+        int32_t m_toVertex;
+        int32_t m_fromVersion;
+        int32_t m_toVersion;
+
+        ///priority queue is largest first so lowest cost must be largest
+        bool operator<(const Collapse& rhs) const { return (m_cost > rhs.m_cost); }
+    };
+}
+
+/**
+ * \class caret::SurfaceLevelsOfDetail
+ * \brief Simplified versions of a surface's triangles for drawing at small sizes
+ * \ingroup Files
+ *
+ * A surface that covers a small part of the screen, such as in one of many
+ * tiled tabs, has many triangles per pixel.  Each level of detail has about a
+ * quarter of the triangles of the previous level, created by repeatedly
+ * collapsing the edge whose removal least changes the shape of the surface,
+ * as measured by the sum of squared distances to the planes of the original
+ * triangles (Garland and Heckbert, "Surface Simplification Using Quadric
+ * Error Metrics", 1997).
+ *
+ * An edge is collapsed by moving one of its vertices to the other, so the
+ * triangles of every level use a subset of the surface's vertices.  The
+ * surface's coordinates, normal vectors, and node colorings are used
+ * unchanged when drawing any level.  Vertices on a boundary of the surface
+ * are never removed so the outline of a cut or flat surface is preserved.
+ */
+
+/**
+ * Constructor that creates the levels of detail.  Surfaces with fewer than
+ * MINIMUM_TRIANGLES_FOR_SIMPLIFICATION triangles have no levels.
+ *
+ * @param xyz
+ *     The coordinates, three per vertex.
+ * @param numberOfVertices
+ *     Number of vertices.
+ * @param triangleVertices
+ *     Vertex indices, three per triangle.
+ * @param numberOfTriangles
+ *     Number of triangles.
+ * @param geometryModificationCount
+ *     The surface's geometry modification count.
+ * @param cancelFlag
+ *     If not NULL, simplification stops, leaving no levels, when
+ *     this flag becomes true.
+ */
+SurfaceLevelsOfDetail::SurfaceLevelsOfDetail(const float* xyz,
+                                             const int32_t numberOfVertices,
+                                             const int32_t* triangleVertices,
+                                             const int32_t numberOfTriangles,
+                                             const int64_t geometryModificationCount,
+                                             const std::atomic<bool>* cancelFlag)
+: CaretObject(),
+m_geometryModificationCount(geometryModificationCount)
+{
+    if (numberOfTriangles >= MINIMUM_TRIANGLES_FOR_SIMPLIFICATION) {
+        ElapsedTimer timer;
+        timer.start();
+
+        simplify(xyz,
+                 numberOfVertices,
+                 triangleVertices,
+                 numberOfTriangles,
+                 cancelFlag);
+
+        CaretLogFine("Created "
+                     + AString::number(m_levelTriangles.size())
+                     + " levels of detail for surface with "
+                     + AString::number(numberOfTriangles)
+                     + " triangles in "
+                     + AString::number(timer.getElapsedTimeSeconds(), 'f', 3)
+                     + " seconds");
+    }
+}
+
+/**
+ * Destructor.
+ */
+SurfaceLevelsOfDetail::~SurfaceLevelsOfDetail()
+{
+}
+
+/**
+ * @return Number of levels of detail.  The full resolution surface is not a level.
+ */
+int32_t
+SurfaceLevelsOfDetail::getNumberOfLevels() const
+{
+    return static_cast<int32_t>(m_levelTriangles.size());
+}
+
+/**
+ * @return Vertex indices, three per triangle, of a level.
+ *
+ * @param levelIndex
+ *     Index of the level.
+ */
+const int32_t*
+SurfaceLevelsOfDetail::getLevelTriangles(const int32_t levelIndex) const
+{
+    CaretAssertVectorIndex(m_levelTriangles, levelIndex);
+    return m_levelTriangles[levelIndex].data();
+}
+
+/**
+ * @return Number of triangles in a level.
+ *
+ * @param levelIndex
+ *     Index of the level.
+ */
+int32_t
+SurfaceLevelsOfDetail::getLevelNumberOfTriangles(const int32_t levelIndex) const
+{
+    CaretAssertVectorIndex(m_levelTriangles, levelIndex);
+    return static_cast<int32_t>(m_levelTriangles[levelIndex].size() / 3);
+}
+
+/**
+ * Find the level with the fewest triangles that has at least the given
+ * number of triangles.
+ *
+ * @param numberOfTriangles
+ *     Number of triangles needed.
+ * @return
+ *     Index of the level or negative if the full resolution surface is needed.
+ */
+int32_t
+SurfaceLevelsOfDetail::getLevelForNumberOfTriangles(const int32_t numberOfTriangles) const
+{
+    int32_t levelIndex = -1;
+    const int32_t numberOfLevels = getNumberOfLevels();
+    for (int32_t i = 0; i < numberOfLevels; i++) {
+        if (getLevelNumberOfTriangles(i) < numberOfTriangles) {
+            break;
+        }
+        levelIndex = i;
+    }
+    return levelIndex;
+}
+
+/**
+ * Create the levels by collapsing edges in order of increasing error,
+ * saving the triangles each time the number of triangles reaches the
+ * size of the next level.
+ *
+ * @param xyz
+ *     The coordinates, three per vertex.
+ * @param numberOfVertices
+ *     Number of vertices.
+ * @param triangleVertices
+ *     Vertex indices, three per triangle.
+ * @param numberOfTriangles
+ *     Number of triangles.
+ * @param cancelFlag
+ *     If not NULL, all levels are discarded and simplification stops
+ *     when this flag becomes true.
+ */
+void
+SurfaceLevelsOfDetail::simplify(const float* xyz,
+                                const int32_t numberOfVertices,
+                                const int32_t* triangleVertices,
+                                const int32_t numberOfTriangles,
+                                const std::atomic<bool>* cancelFlag)
+{
+    std::vector<int32_t> triangles(triangleVertices,
+                                   triangleVertices + (numberOfTriangles * 3));
+    std::vector<char> triangleValid(numberOfTriangles, 0);
+    std::vector<std::vector<int32_t>> vertexTriangles(numberOfVertices);
+    std::vector<Quadric> quadrics(numberOfVertices);
+    std::vector<double> vertexNormals(numberOfVertices * 3, 0.0);
+    int32_t numberOfValidTriangles = 0;
+
+    /*
+     * Each vertex's quadric sums the area weighted planes of its triangles
+     */
+    for (int32_t iTriangle = 0; iTriangle < numberOfTriangles; iTriangle++) {
+        const int32_t* tv = &triangles[iTriangle * 3];
+        bool validFlag = true;
+        for (int32_t k = 0; k < 3; k++) {
+            if ((tv[k] < 0)
+                || (tv[k] >= numberOfVertices)) {
+                validFlag = false;
+            }
+        }
+        if (( ! validFlag)
+            || (tv[0] == tv[1])
+            || (tv[1] == tv[2])
+            || (tv[0] == tv[2])) {
+            continue;
+        }
+
+        triangleValid[iTriangle] = 1;
+        ++numberOfValidTriangles;
+        for (int32_t k = 0; k < 3; k++) {
+            vertexTriangles[tv[k]].push_back(iTriangle);
+        }
+
+        double normal[3];
+        const float* p0 = &xyz[tv[0] * 3];
+        triangleNormal(p0, &xyz[tv[1] * 3], &xyz[tv[2] * 3], normal);
+        const double length = std::sqrt((normal[0] * normal[0])
+                                        + (normal[1] * normal[1])
+                                        + (normal[2] * normal[2]));
+        if (length <= 0.0) {
+            continue;
+        }
+        for (int32_t k = 0; k < 3; k++) {
+            for (int32_t m = 0; m < 3; m++) {
+                vertexNormals[(tv[k] * 3) + m] += normal[m];
+            }
+        }
+        const double a = normal[0] / length;
+        const double b = normal[1] / length;
+        const double c = normal[2] / length;
+        const double d = -((a * p0[0]) + (b * p0[1]) + (c * p0[2]));
+        const double area = length * 0.5;
+        const Quadric plane = { {
+            area * a * a, area * a * b, area * a * c, area * a * d,
+            area * b * b, area * b * c, area * b * d,
+            area * c * c, area * c * d,
+            area * d * d
+        } };
+        for (int32_t k = 0; k < 3; k++) {
+            Quadric& q = quadrics[tv[k]];
+            for (int32_t i = 0; i < 10; i++) {
+                q[i] += plane[i];
+            }
+        }
+    }
+
+    /*
+     * Neighbors of a vertex through its valid triangles, sorted,
+     * with a neighbor listed once for each triangle containing it
+     */
+    auto getNeighborsWithRepeats = [&](const int32_t vertex,
+                                       std::vector<int32_t>& neighborsOut) {
+        neighborsOut.clear();
+        for (const int32_t iTriangle : vertexTriangles[vertex]) {
+            if (triangleValid[iTriangle]) {
+                const int32_t* tv = &triangles[iTriangle * 3];
+                for (int32_t k = 0; k < 3; k++) {
+                    if (tv[k] != vertex) {
+                        neighborsOut.push_back(tv[k]);
+                    }
+                }
+            }
+        }
+        std::sort(neighborsOut.begin(), neighborsOut.end());
+    };
+
+    /*
+     * Neighbors of a vertex through its valid triangles, each listed
+     * once.  The neighbors are left marked with the current mark value.
+     */
+    std::vector<int32_t> vertexMark(numberOfVertices, 0);
+    int32_t markValue = 0;
+    auto getNeighbors = [&](const int32_t vertex,
+                            std::vector<int32_t>& neighborsOut) {
+        ++markValue;
+        neighborsOut.clear();
+        for (const int32_t iTriangle : vertexTriangles[vertex]) {
+            if (triangleValid[iTriangle]) {
+                const int32_t* tv = &triangles[iTriangle * 3];
+                for (int32_t k = 0; k < 3; k++) {
+                    const int32_t neighbor = tv[k];
+                    if ((neighbor != vertex)
+                        && (vertexMark[neighbor] != markValue)) {
+                        vertexMark[neighbor] = markValue;
+                        neighborsOut.push_back(neighbor);
+                    }
+                }
+            }
+        }
+    };
+
+    /*
+     * A vertex is on a boundary, or non-manifold, if any of its neighbors
+     * is not in exactly two of its triangles.  These are never removed.
+     */
+    std::vector<char> vertexLocked(numberOfVertices, 0);
+    std::vector<int32_t> neighbors;
+    for (int32_t iVertex = 0; iVertex < numberOfVertices; iVertex++) {
+        getNeighborsWithRepeats(iVertex, neighbors);
+        const int32_t numNeighbors = static_cast<int32_t>(neighbors.size());
+        int32_t runStart = 0;
+        for (int32_t i = 1; i <= numNeighbors; i++) {
+            if ((i == numNeighbors)
+                || (neighbors[i] != neighbors[runStart])) {
+                if ((i - runStart) != 2) {
+                    vertexLocked[iVertex] = 1;
+                    break;
+                }
+                runStart = i;
+            }
+        }
+    }
+
+    std::vector<int32_t> vertexVersion(numberOfVertices, 0);
+    std::vector<char> vertexRemoved(numberOfVertices, 0);
+    std::priority_queue<Collapse> collapseQueue;
+
+    /*
+     * Add the collapse, in the direction with least error, of an edge
+     */
+    auto addEdgeCollapse = [&](const int32_t v1,
+                               const int32_t v2) {
+        Quadric q;
+        for (int32_t i = 0; i < 10; i++) {
+            q[i] = quadrics[v1][i] + quadrics[v2][i];
+        }
+        Collapse collapse;
+        bool validFlag = false;
+        if ( ! vertexLocked[v1]) {
+            collapse.m_cost       = quadricError(q, &xyz[v2 * 3]);
+            collapse.m_fromVertex = v1;
+            collapse.m_toVertex   = v2;
+            validFlag = true;
+        }
+        if ( ! vertexLocked[v2]) {
+            const double cost = quadricError(q, &xyz[v1 * 3]);
+            if (( ! validFlag)
+                || (cost < collapse.m_cost)) {
+                collapse.m_cost       = cost;
+                collapse.m_fromVertex = v2;
+                collapse.m_toVertex   = v1;
+                validFlag = true;
+            }
+        }
+        if (validFlag) {
+            collapse.m_fromVersion = vertexVersion[collapse.m_fromVertex];
+            collapse.m_toVersion   = vertexVersion[collapse.m_toVertex];
+            collapseQueue.push(collapse);
+        }
+    };
+
+    /*
+     * In a consistently oriented surface, each edge is in increasing
+     * order in only one of its two triangles
+     */
+    for (int32_t iTriangle = 0; iTriangle < numberOfTriangles; iTriangle++) {
+        if (triangleValid[iTriangle]) {
+            const int32_t* tv = &triangles[iTriangle * 3];
+            for (int32_t k = 0; k < 3; k++) {
+                const int32_t v1 = tv[k];
+                const int32_t v2 = tv[(k + 1) % 3];
+                if (v1 < v2) {
+                    addEdgeCollapse(v1, v2);
+                }
+            }
+        }
+    }
+
+    std::vector<int32_t> fromNeighbors;
+    std::vector<int32_t> toNeighbors;
+    int32_t previousNumberOfTriangles = numberOfValidTriangles;
+    int32_t targetNumberOfTriangles = static_cast<int32_t>(previousNumberOfTriangles * s_levelReductionFactor);
+
+    while (targetNumberOfTriangles >= s_minimumTrianglesInLevel) {
+        while ((numberOfValidTriangles > targetNumberOfTriangles)
+               && ( ! collapseQueue.empty())) {
+            if ((cancelFlag != NULL)
+                && (*cancelFlag)) {
+                m_levelTriangles.clear();
+                return;
+            }
+
+            const Collapse collapse = collapseQueue.top();
+            collapseQueue.pop();
+
+            const int32_t fromVertex = collapse.m_fromVertex;
+            const int32_t toVertex   = collapse.m_toVertex;
+            if (vertexRemoved[fromVertex]
+                || vertexRemoved[toVertex]
+                || (collapse.m_fromVersion != vertexVersion[fromVertex])
+                || (collapse.m_toVersion != vertexVersion[toVertex])) {
+                continue;
+            }
+
+            /*
+             * The edge's vertices must share exactly the two neighbors of
+             * the edge's triangles or the surface would become non-manifold
+             */
+            getNeighbors(toVertex, toNeighbors);
+            getNeighbors(fromVertex, fromNeighbors);
+            int32_t numberOfCommonNeighbors = 0;
+            for (const int32_t neighbor : toNeighbors) {
+                if (vertexMark[neighbor] == markValue) {
+                    ++numberOfCommonNeighbors;
+                }
+            }
+            if (numberOfCommonNeighbors != 2) {
+                continue;
+            }
+
+            /*
+             * Do not let any remaining triangle fold over
+             */
+            const float* toXYZ = &xyz[toVertex * 3];
+            bool foldFlag = false;
+            for (const int32_t iTriangle : vertexTriangles[fromVertex]) {
+                if ( ! triangleValid[iTriangle]) {
+                    continue;
+                }
+                const int32_t* tv = &triangles[iTriangle * 3];
+                if ((tv[0] == toVertex)
+                    || (tv[1] == toVertex)
+                    || (tv[2] == toVertex)) {
+                    continue;
+                }
+                const float* before[3];
+                const float* after[3];
+                int32_t afterVertices[3];
+                for (int32_t k = 0; k < 3; k++) {
+                    before[k] = &xyz[tv[k] * 3];
+                    after[k]  = ((tv[k] == fromVertex) ? toXYZ : before[k]);
+                    afterVertices[k] = ((tv[k] == fromVertex) ? toVertex : tv[k]);
+                }
+                double beforeNormal[3];
+                double afterNormal[3];
+                triangleNormal(before[0], before[1], before[2], beforeNormal);
+                triangleNormal(after[0], after[1], after[2], afterNormal);
+                
+                /*
+                 * Small changes by many collapses could turn a triangle
+                 * over so it must also face the way the original surface
+                 * faces at its vertices
+                 */
+                for (int32_t k = 0; k < 3; k++) {
+                    const double* vertexNormal = &vertexNormals[afterVertices[k] * 3];
+                    if (((afterNormal[0] * vertexNormal[0])
+                         + (afterNormal[1] * vertexNormal[1])
+                         + (afterNormal[2] * vertexNormal[2])) <= 0.0) {
+                        foldFlag = true;
+                    }
+                }
+                if (foldFlag) {
+                    break;
+                }
+                
+                const double dot = ((beforeNormal[0] * afterNormal[0])
+                                    + (beforeNormal[1] * afterNormal[1])
+                                    + (beforeNormal[2] * afterNormal[2]));
+                const double beforeLength2 = ((beforeNormal[0] * beforeNormal[0])
+                                              + (beforeNormal[1] * beforeNormal[1])
+                                              + (beforeNormal[2] * beforeNormal[2]));
+                const double afterLength2 = ((afterNormal[0] * afterNormal[0])
+                                             + (afterNormal[1] * afterNormal[1])
+                                             + (afterNormal[2] * afterNormal[2]));
+                /*
+                 * Cosine of angle between normals must exceed 0.2
+                 */
+                if ((dot <= 0.0)
+                    || ((dot * dot) <= (0.04 * beforeLength2 * afterLength2))) {
+                    foldFlag = true;
+                    break;
+                }
+            }
+            if (foldFlag) {
+                continue;
+            }
+
+            /*
+             * Remove the edge's triangles and move the 'from' vertex's
+             * other triangles to the 'to' vertex
+             */
+            for (const int32_t iTriangle : vertexTriangles[fromVertex]) {
+                if ( ! triangleValid[iTriangle]) {
+                    continue;
+                }
+                int32_t* tv = &triangles[iTriangle * 3];
+                if ((tv[0] == toVertex)
+                    || (tv[1] == toVertex)
+                    || (tv[2] == toVertex)) {
+                    triangleValid[iTriangle] = 0;
+                    --numberOfValidTriangles;
+                }
+                else {
+                    for (int32_t k = 0; k < 3; k++) {
+                        if (tv[k] == fromVertex) {
+                            tv[k] = toVertex;
+                        }
+                    }
+                    vertexTriangles[toVertex].push_back(iTriangle);
+                }
+            }
+            vertexTriangles[fromVertex].clear();
+            vertexRemoved[fromVertex] = 1;
+
+            std::vector<int32_t>& toTriangles = vertexTriangles[toVertex];
+            toTriangles.erase(std::remove_if(toTriangles.begin(),
+                                             toTriangles.end(),
+                                             [&](const int32_t iTriangle) { return ( ! triangleValid[iTriangle]); }),
+                              toTriangles.end());
+
+            for (int32_t i = 0; i < 10; i++) {
+                quadrics[toVertex][i] += quadrics[fromVertex][i];
+            }
+            ++vertexVersion[toVertex];
+
+            getNeighbors(toVertex, toNeighbors);
+            for (const int32_t neighbor : toNeighbors) {
+                addEdgeCollapse(toVertex, neighbor);
+            }
+        }
+
+        /*
+         * Stop if too few edges could be collapsed for a useful level
+         */
+        if (numberOfValidTriangles > (previousNumberOfTriangles * 0.75)) {
+            break;
+        }
+
+        m_levelTriangles.push_back(std::vector<int32_t>());
+        std::vector<int32_t>& levelTriangles = m_levelTriangles.back();
+        levelTriangles.reserve(numberOfValidTriangles * 3);
+        for (int32_t iTriangle = 0; iTriangle < numberOfTriangles; iTriangle++) {
+            if (triangleValid[iTriangle]) {
+                levelTriangles.insert(levelTriangles.end(),
+                                      &triangles[iTriangle * 3],
+                                      &triangles[iTriangle * 3] + 3);
+            }
+        }
+
+        previousNumberOfTriangles = numberOfValidTriangles;
+        targetNumberOfTriangles = static_cast<int32_t>(previousNumberOfTriangles * s_levelReductionFactor);
+    }
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+SurfaceLevelsOfDetail::toString() const
+{
+    AString text("SurfaceLevelsOfDetail");
+    for (int32_t i = 0; i < getNumberOfLevels(); i++) {
+        text += (" "
+                 + AString::number(getLevelNumberOfTriangles(i)));
+    }
+    return text;
+}
+
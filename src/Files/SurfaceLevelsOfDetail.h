@@ -0,0 +1,96 @@
+#ifndef __SURFACE_LEVELS_OF_DETAIL_H__
+#define __SURFACE_LEVELS_OF_DETAIL_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <atomic>
+#include <vector>
+
+#include "CaretObject.h"
+
+namespace caret {
+
+    class SurfaceLevelsOfDetail : public CaretObject {
+
+    public:
+        SurfaceLevelsOfDetail(const float* xyz,
+                              const int32_t numberOfVertices,
+                              const int32_t* triangleVertices,
+                              const int32_t numberOfTriangles,
+                              const int64_t geometryModificationCount,
+                              const std::atomic<bool>* cancelFlag = NULL);
+
+        virtual ~SurfaceLevelsOfDetail();
+
+        /** @return The surface's geometry modification count when the levels were created */
+        int64_t getGeometryModificationCount() const { return m_geometryModificationCount; }
+
+        int32_t getNumberOfLevels() const;
+
+        const int32_t* getLevelTriangles(const int32_t levelIndex) const;
+
+        int32_t getLevelNumberOfTriangles(const int32_t levelIndex) const;
+
+        int32_t getLevelForNumberOfTriangles(const int32_t numberOfTriangles) const;
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+        /** Surfaces with fewer triangles are not simplified */
+        static const int32_t MINIMUM_TRIANGLES_FOR_SIMPLIFICATION;
+
+    private:
+        SurfaceLevelsOfDetail(const SurfaceLevelsOfDetail&);
+
+        SurfaceLevelsOfDetail& operator=(const SurfaceLevelsOfDetail&);
+
+        void simplify(const float* xyz,
+                      const int32_t numberOfVertices,
+                      const int32_t* triangleVertices,
+                      const int32_t numberOfTriangles,
+                      const std::atomic<bool>* cancelFlag);
+
+        const int64_t m_geometryModificationCount;
+
+        /** Triangles of each level, from most to fewest triangles */
+        std::vector<std::vector<int32_t>> m_levelTriangles;
+
+        /** Each level has about this fraction of the triangles in the previous level */
+        static const float s_levelReductionFactor;
+
+        /** Levels with fewer triangles are not created */
+        static const int32_t s_minimumTrianglesInLevel;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __SURFACE_LEVELS_OF_DETAIL_DECLARE__
+    const int32_t SurfaceLevelsOfDetail::MINIMUM_TRIANGLES_FOR_SIMPLIFICATION = 20000;
+
+    const float SurfaceLevelsOfDetail::s_levelReductionFactor = 0.25f;
+
+    const int32_t SurfaceLevelsOfDetail::s_minimumTrianglesInLevel = 2000;
+#endif // __SURFACE_LEVELS_OF_DETAIL_DECLARE__
+
+} // namespace
+#endif  //__SURFACE_LEVELS_OF_DETAIL_H__
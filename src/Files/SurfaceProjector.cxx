@@ -27,6 +27,7 @@
 #undef __SURFACE_PROJECTOR_DEFINE__
 
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "FociFile.h"
 #include "Focus.h"
 #include "MathFunctions.h"
@@ -109,6 +110,30 @@ m_surfaceFileRight(rightSurfaceFile),
 m_surfaceFileCerebellum(cerebellumSurfaceFile),
 m_mode(MODE_LEFT_RIGHT_CEREBELLUM)
 {
+    initializeMembersSurfaceProjector();
+}
+
+/**
+ * Copy constructor, copies only the configuration (surfaces and offset),
+ * used to give each thread its own projector since projecting an item
+ * modifies members.  The surfaces' spatial search structures are shared
+ * through the SurfaceFile helpers, so copies are cheap.
+ *
+ * @param o
+ *     Projector whose configuration is copied.
+ */
+SurfaceProjector::SurfaceProjector(const SurfaceProjector& o)
+: CaretObject(o),
+m_surfaceFiles(o.m_surfaceFiles),
+m_surfaceFileLeft(o.m_surfaceFileLeft),
+m_surfaceFileRight(o.m_surfaceFileRight),
+m_surfaceFileCerebellum(o.m_surfaceFileCerebellum),
+m_mode(o.m_mode),
+m_sphericalRadii(o.m_sphericalRadii)
+{
+    initializeMembersSurfaceProjector();
+    m_surfaceOffset = o.m_surfaceOffset;
+    m_surfaceOffsetValid = o.m_surfaceOffsetValid;
 }
 
 
@@ -138,6 +163,52 @@ SurfaceProjector::initializeMembersSurfaceProjector()
 }
 
 
+/**
+ * Compute the radius of each spherical surface.  A surface's radius
+ * comes from its bounding box, which the surface creates, without
+ * locking, when first requested, so the radii are computed before
+ * projecting in parallel.
+ */
+void
+SurfaceProjector::computeSphericalRadii()
+{
+    m_sphericalRadii.clear();
+    
+    std::vector<const SurfaceFile*> surfaceFiles(m_surfaceFiles);
+    surfaceFiles.push_back(m_surfaceFileLeft);
+    surfaceFiles.push_back(m_surfaceFileRight);
+    surfaceFiles.push_back(m_surfaceFileCerebellum);
+    for (std::vector<const SurfaceFile*>::const_iterator iter = surfaceFiles.begin();
+         iter != surfaceFiles.end();
+         iter++) {
+        const SurfaceFile* sf = *iter;
+        if (sf != NULL) {
+            if (sf->getSurfaceType() == SurfaceTypeEnum::SPHERICAL) {
+                m_sphericalRadii[sf] = sf->getSphericalRadius();
+            }
+        }
+    }
+}
+
+/**
+ * Get the radius of a spherical surface.
+ *
+ * @param surfaceFile
+ *     The spherical surface.
+ * @return
+ *     The radius computed by computeSphericalRadii(), or if
+ *     not computed, the radius from the surface.
+ */
+float
+SurfaceProjector::getSphericalRadius(const SurfaceFile* surfaceFile) const
+{
+    std::map<const SurfaceFile*, float>::const_iterator iter = m_sphericalRadii.find(surfaceFile);
+    if (iter != m_sphericalRadii.end()) {
+        return iter->second;
+    }
+    return surfaceFile->getSphericalRadius();
+}
+
 /**
  * Set the desired offset of projected items from the surface->
  *
@@ -164,28 +235,77 @@ SurfaceProjector::projectFociFile(FociFile* fociFile)
     CaretAssert(fociFile);
     const int32_t numberOfFoci = fociFile->getNumberOfFoci();
     
-    AString errorMessage = "";
+    std::vector<Focus*> foci(numberOfFoci);
+    std::vector<int32_t> focusIndices(numberOfFoci);
     for (int32_t i = 0; i < numberOfFoci; i++) {
-        Focus* focus = fociFile->getFocus(i);
-        try {
-            if (m_validateFlag) {
-                m_validateItemName = ("Focus "
-                                      + AString::number(i)
-                                      + ", "
-                                      + focus->getName());
+        foci[i] = fociFile->getFocus(i);
+        focusIndices[i] = i;
+    }
+    projectFoci(foci,
+                focusIndices);
+}
+
+/**
+ * Project a group of foci, in parallel.
+ * @param foci
+ *     The foci, each is projected independently.
+ * @param focusIndices
+ *     Index of each focus, for messages (negative indicates no index).
+ * @throws SurfaceProjectorException
+ *      If projecting any of the items failed, after attempting all of them.
+ */
+void
+SurfaceProjector::projectFoci(const std::vector<Focus*>& foci,
+                              const std::vector<int32_t>& focusIndices)
+{
+    CaretAssert(foci.size() == focusIndices.size());
+    const int32_t numberOfFoci = static_cast<int32_t>(foci.size());
+    
+    /*
+     * Messages are kept per focus and reported after the loop, so that
+     * their order doesn't depend on the threads.
+     */
+    std::vector<AString> errorMessages(numberOfFoci);
+    std::vector<AString> warningMessages(numberOfFoci);
+    computeSphericalRadii();
+#pragma omp CARET_PAR
+    {
+        SurfaceProjector threadProjector(*this);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int32_t i = 0; i < numberOfFoci; i++) {
+            Focus* focus = foci[i];
+            try {
+                if (threadProjector.m_validateFlag) {
+                    threadProjector.m_validateItemName = ("Focus "
+                                                          + AString::number(focusIndices[i])
+                                                          + ", "
+                                                          + focus->getName());
+                }
+                threadProjector.projectFocusAux(focusIndices[i],
+                                                focus,
+                                                warningMessages[i]);
+            }
+            catch (const CaretException& e) {
+                errorMessages[i] = (focus->getName()
+                                    + ", index="
+                                    + AString::number(focusIndices[i])
+                                    + ": "
+                                    + e.whatString());
             }
-            projectFocus(i,
-                         focus);
         }
-        catch (const SurfaceProjectorException& spe) {
+    }
+    m_sphericalRadii.clear();
+    
+    AString errorMessage = "";
+    for (int32_t i = 0; i < numberOfFoci; i++) {
+        if (warningMessages[i].isEmpty() == false) {
+            CaretLogWarning(warningMessages[i]);
+        }
+        if (errorMessages[i].isEmpty() == false) {
             if (errorMessage.isEmpty() == false) {
                 errorMessage += "\n";
             }
-            errorMessage += (focus->getName()
-                             + ", index="
-                             + AString::number(i)
-                             + ": "
-                             + spe.whatString());
+            errorMessage += errorMessages[i];
         }
     }
     
@@ -207,6 +327,32 @@ void
 SurfaceProjector::projectFocus(const int32_t focusIndex,
                                Focus* focus)
 {
+    AString warningMessage;
+    projectFocusAux(focusIndex,
+                    focus,
+                    warningMessage);
+    if (warningMessage.isEmpty() == false) {
+        CaretLogWarning(warningMessage);
+    }
+}
+
+/**
+ * Project a focus, without logging.
+ * @param focusIndex
+ *    Index of the focus (negative indicates no index)
+ * @param focus
+ *    The focus.
+ * @param warningMessageOut
+ *    Set to the projection warning for the focus, empty if there is none.
+ * @throws SurfaceProjectorException
+ *      If projecting an item failed.
+ */
+void
+SurfaceProjector::projectFocusAux(const int32_t focusIndex,
+                                  Focus* focus,
+                                  AString& warningMessageOut)
+{
+    warningMessageOut = "";
     const int32_t numberOfProjections = focus->getNumberOfProjections();
     CaretAssert(numberOfProjections > 0);
     if (numberOfProjections < 0) {
@@ -243,7 +389,7 @@ SurfaceProjector::projectFocus(const int32_t focusIndex,
         }
         msg += (": "
                 + m_projectionWarning);
-        CaretLogWarning(msg);;
+        warningMessageOut = msg;
     }
 }
 
@@ -678,7 +824,7 @@ SurfaceProjector::projectToSurface(const SurfaceFile* surfaceFile,
             break;
         case SurfaceTypeEnum::SPHERICAL:
             m_surfaceTypeHint = SURFACE_HINT_SPHERE;
-            m_sphericalSurfaceRadius = surfaceFile->getSphericalRadius();
+            m_sphericalSurfaceRadius = getSphericalRadius(surfaceFile);
             break;
         default:
             m_surfaceTypeHint = SURFACE_HINT_THREE_DIMENSIONAL;
@@ -27,6 +27,7 @@
 
 #include <stdint.h>
 
+#include <map>
 #include <set>
 
 namespace caret {
@@ -65,6 +66,9 @@ namespace caret {
         void projectFocus(const int32_t focusIndex,
                           Focus* focus);
         
+        void projectFoci(const std::vector<Focus*>& foci,
+                         const std::vector<int32_t>& focusIndices);
+        
         void setSurfaceOffset(const float surfaceOffset);
         
     private:
@@ -122,6 +126,14 @@ namespace caret {
 
         void initializeMembersSurfaceProjector();
         
+        void computeSphericalRadii();
+        
+        float getSphericalRadius(const SurfaceFile* surfaceFile) const;
+        
+        void projectFocusAux(const int32_t focusIndex,
+                             Focus* focus,
+                             AString& warningMessageOut);
+        
         void getProjectionLocation(const SurfaceFile* surfaceFile,
                                    const float xyz[3],
                                    ProjectionLocation& projectionLocation) const;
@@ -185,6 +197,9 @@ namespace caret {
 
         float m_sphericalSurfaceRadius;
         
+        /** Radius of each spherical surface, computed before projecting in parallel */
+        std::map<const SurfaceFile*, float> m_sphericalRadii;
+        
         float m_surfaceOffset;
         
         bool m_surfaceOffsetValid;
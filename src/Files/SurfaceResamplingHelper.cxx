@@ -25,25 +25,57 @@
 
 #include "SurfaceResamplingHelper.h"
 
+#include "ByteOrderEnum.h"
+#include "ByteSwapping.h"
 #include "CaretAssert.h"
+#include "CaretBinaryFile.h"
 #include "CaretException.h"
 #include "CaretOMP.h"
 #include "GeodesicHelper.h"
 #include "SignedDistanceHelper.h"
+#include "SphericalTriangleLocator.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 #include "Vector3D.h"
 
+#include <algorithm>
 #include <set>
 #include <map>
 
 using namespace std;
 using namespace caret;
 
+namespace
+{
+    const char OPERATOR_MAGIC[8] = { 'w', 'b', 'r', 's', 'm', 'p', 'o', 'p' };
+    const int32_t OPERATOR_VERSION = 1;
+    
+    //when the file size isn't known (compressed), grow the array as data arrives, so a corrupt count runs out of data before it can cause a huge allocation
+    template <typename T>
+    void readOperatorArray(CaretBinaryFile& myFile, vector<T>& arrayOut, const int64_t& count, const bool& sizeChecked)
+    {
+        if (sizeChecked)
+        {
+            arrayOut.resize(count);
+            myFile.read(arrayOut.data(), count * sizeof(T));
+            return;
+        }
+        const int64_t CHUNK_SIZE = 1 << 20;
+        arrayOut.clear();
+        for (int64_t start = 0; start < count; start += CHUNK_SIZE)
+        {
+            int64_t thisChunk = min(CHUNK_SIZE, count - start);
+            arrayOut.resize(start + thisChunk);
+            myFile.read(arrayOut.data() + start, thisChunk * sizeof(T));
+        }
+    }
+}
+
 SurfaceResamplingHelper::SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
                                                  const float* currentAreas, const float* newAreas, const float* currentRoi)
 {
     if (!checkSphere(currentSphere) || !checkSphere(newSphere)) throw CaretException("input surfaces to SurfaceResamplingHelper must be spheres");
+    m_numInputNodes = currentSphere->getNumberOfNodes();
     SurfaceFile currentSphereMod, newSphereMod;
     changeRadius(100.0f, currentSphere, &currentSphereMod);
     changeRadius(100.0f, newSphere, &newSphereMod);
@@ -190,6 +222,80 @@ void SurfaceResamplingHelper::resampleLargest(const int32_t* input, int32_t* out
     }
 }
 
+void SurfaceResamplingHelper::resampleNormalBlock(const float* input, float* output, const int& numCols, const float& invalidVal) const
+{
+    int numNodes = (int)m_weights.size() - 1;
+#pragma omp CARET_PAR
+    {
+        vector<double> accum(numCols);
+#pragma omp CARET_FOR schedule(dynamic, 64)
+        for (int i = 0; i < numNodes; ++i)
+        {
+            float* outRow = output + (int64_t)i * numCols;
+            WeightElem* end = m_weights[i + 1], *elem = m_weights[i];
+            if (elem != end)
+            {
+                for (int c = 0; c < numCols; ++c)
+                {
+                    accum[c] = 0.0;
+                }
+                for (; elem != end; ++elem)
+                {
+                    const float* inRow = input + (int64_t)elem->node * numCols;//each weight is loaded once for all columns, and the column loop is contiguous
+                    const double weight = elem->weight;
+                    for (int c = 0; c < numCols; ++c)
+                    {
+                        accum[c] += inRow[c] * weight;
+                    }
+                }
+                for (int c = 0; c < numCols; ++c)
+                {
+                    outRow[c] = accum[c];
+                }
+            } else {
+                for (int c = 0; c < numCols; ++c)
+                {
+                    outRow[c] = invalidVal;
+                }
+            }
+        }
+    }
+}
+
+void SurfaceResamplingHelper::resampleLargestBlock(const float* input, float* output, const int& numCols, const float& invalidVal) const
+{
+    int numNodes = (int)m_weights.size() - 1;
+#pragma omp CARET_PARFOR schedule(dynamic, 64)
+    for (int i = 0; i < numNodes; ++i)
+    {
+        WeightElem* end = m_weights[i + 1];
+        float largest = -1.0f;
+        int largestNode = -1;
+        for (WeightElem* elem = m_weights[i]; elem != end; ++elem)
+        {
+            if (elem->weight > largest)
+            {
+                largest = elem->weight;
+                largestNode = elem->node;
+            }
+        }
+        float* outRow = output + (int64_t)i * numCols;
+        if (largestNode != -1)
+        {
+            const float* inRow = input + (int64_t)largestNode * numCols;
+            for (int c = 0; c < numCols; ++c)
+            {
+                outRow[c] = inRow[c];
+            }
+        } else {
+            for (int c = 0; c < numCols; ++c)
+            {
+                outRow[c] = invalidVal;
+            }
+        }
+    }
+}
+
 void SurfaceResamplingHelper::getResampleValidROI(float* output) const
 {
     int numNodes = (int)m_weights.size() - 1;
@@ -204,6 +310,108 @@ void SurfaceResamplingHelper::getResampleValidROI(float* output) const
     }
 }
 
+void SurfaceResamplingHelper::writeOperator(const AString& filename) const
+{//format: magic, then int32 version, input nodes, output nodes, then int64 number of weights, then CSR arrays: int64 row starts, int32 nodes, float32 weights, all little endian
+    if (m_weights.size() == 0) throw CaretException("cannot write a resampling operator that has no weights");
+    int32_t numOutNodes = getNumberOfOutputNodes();
+    int64_t numElems = m_weights[numOutNodes] - m_weights[0];
+    int32_t header[3] = { OPERATOR_VERSION, m_numInputNodes, numOutNodes };
+    vector<int64_t> rowStart(numOutNodes + 1);
+    for (int32_t i = 0; i <= numOutNodes; ++i)
+    {
+        rowStart[i] = m_weights[i] - m_weights[0];
+    }
+    vector<int32_t> nodes(numElems);
+    vector<float> weights(numElems);
+    for (int64_t i = 0; i < numElems; ++i)
+    {
+        nodes[i] = m_storagechunk[i].node;
+        weights[i] = m_storagechunk[i].weight;
+    }
+    if (ByteOrderEnum::isSystemBigEndian())
+    {
+        ByteSwapping::swapBytes(header, 3);
+        ByteSwapping::swapBytes(&numElems, 1);
+        ByteSwapping::swapBytes(rowStart.data(), rowStart.size());
+        ByteSwapping::swapBytes(nodes.data(), nodes.size());
+        ByteSwapping::swapBytes(weights.data(), weights.size());
+    }
+    CaretBinaryFile myFile(filename, CaretBinaryFile::WRITE_TRUNCATE);
+    myFile.write(OPERATOR_MAGIC, 8);
+    myFile.write(header, 3 * sizeof(int32_t));
+    myFile.write(&numElems, sizeof(int64_t));
+    myFile.write(rowStart.data(), rowStart.size() * sizeof(int64_t));
+    myFile.write(nodes.data(), nodes.size() * sizeof(int32_t));
+    myFile.write(weights.data(), weights.size() * sizeof(float));
+    myFile.close();
+}
+
+void SurfaceResamplingHelper::readOperator(const AString& filename)
+{
+    CaretBinaryFile myFile(filename, CaretBinaryFile::READ);
+    char magic[8];
+    myFile.read(magic, 8);
+    for (int i = 0; i < 8; ++i)
+    {
+        if (magic[i] != OPERATOR_MAGIC[i]) throw CaretException("file '" + filename + "' is not a resampling operator");
+    }
+    int32_t header[3];
+    int64_t numElems;
+    myFile.read(header, 3 * sizeof(int32_t));
+    myFile.read(&numElems, sizeof(int64_t));
+    bool swap = ByteOrderEnum::isSystemBigEndian();
+    if (swap)
+    {
+        ByteSwapping::swapBytes(header, 3);
+        ByteSwapping::swapBytes(&numElems, 1);
+    }
+    if (header[0] != OPERATOR_VERSION) throw CaretException("resampling operator '" + filename + "' has unsupported version " + AString::number(header[0]));
+    int32_t numInNodes = header[1], numOutNodes = header[2];
+    if (numInNodes < 1 || numOutNodes < 1 || numElems < 0 || numElems > (int64_t)numInNodes * numOutNodes)
+    {//each output vertex gets at most one weight per input vertex
+        throw CaretException("resampling operator '" + filename + "' has an invalid header");
+    }
+    int64_t fileSize = myFile.size();//can be -1 for compressed files, then the arrays are read in chunks
+    const int64_t headerSize = 8 + 3 * sizeof(int32_t) + sizeof(int64_t);
+    if (fileSize >= 0 && fileSize != headerSize + (numOutNodes + 1) * (int64_t)sizeof(int64_t) + numElems * (int64_t)(sizeof(int32_t) + sizeof(float)))
+    {
+        throw CaretException("resampling operator '" + filename + "' has the wrong file size");
+    }
+    vector<int64_t> rowStart;
+    vector<int32_t> nodes;
+    vector<float> weights;
+    readOperatorArray(myFile, rowStart, numOutNodes + 1, fileSize >= 0);
+    readOperatorArray(myFile, nodes, numElems, fileSize >= 0);
+    readOperatorArray(myFile, weights, numElems, fileSize >= 0);
+    myFile.close();
+    if (swap)
+    {
+        ByteSwapping::swapBytes(rowStart.data(), rowStart.size());
+        ByteSwapping::swapBytes(nodes.data(), nodes.size());
+        ByteSwapping::swapBytes(weights.data(), weights.size());
+    }
+    if (rowStart[0] != 0 || rowStart[numOutNodes] != numElems) throw CaretException("resampling operator '" + filename + "' has inconsistent row starts");
+    for (int32_t i = 0; i < numOutNodes; ++i)
+    {
+        if (rowStart[i + 1] < rowStart[i]) throw CaretException("resampling operator '" + filename + "' has inconsistent row starts");
+    }
+    for (int64_t i = 0; i < numElems; ++i)
+    {
+        if (nodes[i] < 0 || nodes[i] >= numInNodes) throw CaretException("resampling operator '" + filename + "' has an invalid vertex index");
+    }
+    m_numInputNodes = numInNodes;
+    m_storagechunk = CaretArray<WeightElem>(numElems);
+    m_weights = CaretArray<WeightElem*>(numOutNodes + 1);
+    for (int64_t i = 0; i < numElems; ++i)
+    {
+        m_storagechunk[i] = WeightElem(nodes[i], weights[i]);
+    }
+    for (int32_t i = 0; i <= numOutNodes; ++i)
+    {
+        m_weights[i] = m_storagechunk + rowStart[i];
+    }
+}
+
 void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* currentSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut)
 {
     if (cutSurfaceIn->getNumberOfNodes() != currentSphere->getNumberOfNodes()) throw CaretException("input surface has different number of nodes than input sphere");
@@ -562,16 +770,21 @@ void SurfaceResamplingHelper::makeBarycentricWeights(const SurfaceFile* from, co
     int numToNodes = to->getNumberOfNodes();
     weights.resize(numToNodes);
     const float* toCoordData = to->getCoordinateData();
+    SphericalTriangleLocator myLocator(from);//finds a triangle near the answer cheaply, so the closest point search has a tight bound from the start
     if (currentRoi == NULL)
     {
 #pragma omp CARET_PAR
         {
             CaretPointer<SignedDistanceHelper> mySignedHelp = from->getSignedDistanceHelper();
-#pragma omp CARET_FOR schedule(dynamic)
+            int32_t lastTriangle = -1;//vertex order usually has neighbors close together, so start the walk where the last one ended
+#pragma omp CARET_FOR schedule(dynamic, 64)
             for (int i = 0; i < numToNodes; ++i)
             {
                 BarycentricInfo myInfo;
-                mySignedHelp->barycentricWeights(toCoordData + i * 3, myInfo);
+                int32_t hint = myLocator.locate(toCoordData + i * 3, lastTriangle);
+                if (hint == -1 && lastTriangle != -1) hint = myLocator.locate(toCoordData + i * 3);//the walk from far away can fail where the bucket grid won't
+                if (hint != -1) lastTriangle = hint;
+                mySignedHelp->barycentricWeights(toCoordData + i * 3, myInfo, hint);
                 if (myInfo.baryWeights[0] != 0.0f) weights[i][myInfo.nodes[0]] = myInfo.baryWeights[0];
                 if (myInfo.baryWeights[1] != 0.0f) weights[i][myInfo.nodes[1]] = myInfo.baryWeights[1];
                 if (myInfo.baryWeights[2] != 0.0f) weights[i][myInfo.nodes[2]] = myInfo.baryWeights[2];
@@ -581,12 +794,16 @@ void SurfaceResamplingHelper::makeBarycentricWeights(const SurfaceFile* from, co
 #pragma omp CARET_PAR
         {
             CaretPointer<SignedDistanceHelper> mySignedHelp = from->getSignedDistanceHelper();
-#pragma omp CARET_FOR schedule(dynamic)
+            int32_t lastTriangle = -1;
+#pragma omp CARET_FOR schedule(dynamic, 64)
             for (int i = 0; i < numToNodes; ++i)
             {
                 BarycentricInfo myInfo;
                 float weightsum = 0.0f;//there are only 3 weights, so don't bother with double precision
-                mySignedHelp->barycentricWeights(toCoordData + i * 3, myInfo);
+                int32_t hint = myLocator.locate(toCoordData + i * 3, lastTriangle);
+                if (hint == -1 && lastTriangle != -1) hint = myLocator.locate(toCoordData + i * 3);
+                if (hint != -1) lastTriangle = hint;
+                mySignedHelp->barycentricWeights(toCoordData + i * 3, myInfo, hint);
                 if (myInfo.baryWeights[0] != 0.0f && currentRoi[myInfo.nodes[0]] > 0.0f)
                 {
                     weights[i][myInfo.nodes[0]] = myInfo.baryWeights[0];
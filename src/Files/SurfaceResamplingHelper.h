@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include "AString.h"
 #include "CaretPointer.h"
 #include "SurfaceResamplingMethodEnum.h"
 
@@ -42,6 +43,7 @@ namespace caret {
         };
         CaretArray<WeightElem> m_storagechunk;
         CaretArray<WeightElem*> m_weights;
+        int m_numInputNodes;
         static bool checkSphere(const SurfaceFile* surface);
         static void changeRadius(const float& radius, const SurfaceFile* input, SurfaceFile* output);
         void computeWeightsAdapBaryArea(const SurfaceFile* currentSphere, const SurfaceFile* newSphere, const float* currentAreas, const float* newAreas, const float* currentRoi);
@@ -49,7 +51,7 @@ namespace caret {
         static void makeBarycentricWeights(const SurfaceFile* from, const SurfaceFile* to, std::vector<std::map<int, float> >& weights, const float* currentRoi);
         void compactWeights(const std::vector<std::map<int, float> >& weights);
     public:
-        SurfaceResamplingHelper() { }
+        SurfaceResamplingHelper() { m_numInputNodes = 0; }
         SurfaceResamplingHelper(const SurfaceResamplingMethodEnum::Enum& myMethod, const SurfaceFile* currentSphere, const SurfaceFile* newSphere,
                                 const float* currentAreas = NULL, const float* newAreas = NULL, const float* currentRoi = NULL);
         ///resample real-valued data by means of weights
@@ -62,9 +64,20 @@ namespace caret {
         void resampleLargest(const float* input, float* output, const float& invalidVal = 0.0f) const;
         ///resample int data according to what weight is largest
         void resampleLargest(const int32_t* input, int32_t* output, const int32_t& invalidVal = 0) const;
+        ///resample several columns in one pass over the weights, input and output have the columns interleaved, numCols values per vertex
+        void resampleNormalBlock(const float* input, float* output, const int& numCols, const float& invalidVal = 0.0f) const;
+        ///interleaved multi-column version of resampleLargest
+        void resampleLargestBlock(const float* input, float* output, const int& numCols, const float& invalidVal = 0.0f) const;
         ///get the ROI of nodes that have data within the input ROI
         void getResampleValidROI(float* output) const;
         
+        int getNumberOfInputNodes() const { return m_numInputNodes; }
+        int getNumberOfOutputNodes() const { return (m_weights.size() == 0 ? 0 : (int)m_weights.size() - 1); }
+        ///save the weights as a sparse matrix, so that applying the same resampling again doesn't need to recompute them
+        void writeOperator(const AString& filename) const;
+        ///replace the weights with ones saved by writeOperator
+        void readOperator(const AString& filename);
+        
         ///resample a cut surface - not something you will apply multiple times, so static method
         static void resampleCutSurface(const SurfaceFile* cutSurfaceIn, const SurfaceFile* curSphere, const SurfaceFile* newSphere, SurfaceFile* surfaceOut);
     };
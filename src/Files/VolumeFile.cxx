@@ -17,6 +17,7 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 /*LICENSE_END*/
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <sstream>
@@ -191,6 +192,7 @@ VolumeFile::clear()
     m_brickStatisticsValid = false;
     m_splinesValid = false;
     m_frameSplineValid.clear();
+    m_frameSplinePrefiltered.clear();
     m_frameSplines.clear();
     
     m_dataRangeValid = false;
@@ -414,10 +416,9 @@ float VolumeFile::interpolateValue(const float coordIn1, const float coordIn2, c
                     return INVALID_INTERP_VALUE;
                 }
             }
-            int64_t whichFrame = component * dimensions[3] + brickIndex;
-            validateSpline(brickIndex, component);
+            VolumeSpline& frameSpline = getFrameSpline(brickIndex, component);
             if (validOut != NULL) *validOut = true;
-            return m_frameSplines[whichFrame].sample(indexSpace);
+            return frameSpline.sample(indexSpace);
         }
         case TRILINEAR:
         {
@@ -487,7 +488,49 @@ float VolumeFile::interpolateValue(const float coordIn1, const float coordIn2, c
     }
 }
 
-void VolumeFile::validateSpline(const int64_t brickIndex, const int64_t component) const
+void VolumeFile::interpolateValuesCubic(const float* coordsIn, float* valuesOut, const int64_t& numPoints, const int64_t brickIndex, const int64_t component) const
+{
+    if (m_singleSliceFlag)
+    {//interpolateValue switches to enclosing voxel for this
+        for (int64_t i = 0; i < numPoints; ++i)
+        {
+            valuesOut[i] = interpolateValue(coordsIn + i * 3, CUBIC, NULL, brickIndex, component);
+        }
+        return;
+    }
+    const int64_t* dimensions = getDimensionsPtr();
+    float invalidVal = INVALID_INTERP_VALUE;
+    if (getType() == SubvolumeAttributes::LABEL)
+    {
+        invalidVal = getMapLabelTable(brickIndex)->getUnassignedLabelKey();
+    }
+    VolumeSpline& frameSpline = getFrameSpline(brickIndex, component);
+    const int64_t BLOCK_SIZE = 256;
+    float indexSpace[BLOCK_SIZE * 3];
+    bool valid[BLOCK_SIZE];
+    for (int64_t blockStart = 0; blockStart < numPoints; blockStart += BLOCK_SIZE)
+    {
+        int64_t blockCount = min(BLOCK_SIZE, numPoints - blockStart);
+        for (int64_t i = 0; i < blockCount; ++i)
+        {
+            float* thisIndex = indexSpace + i * 3;
+            spaceToIndex(coordsIn + (blockStart + i) * 3, thisIndex);
+            valid[i] = true;
+            for (int axis = 0; axis < 3; ++axis)
+            {//same test as interpolateValue: both the floor and the next index must be inside the volume
+                int64_t indLow = floor(thisIndex[axis]);
+                if (indLow < 0 || indLow + 1 >= dimensions[axis]) valid[i] = false;
+            }
+        }
+        frameSpline.sampleMultiple(indexSpace, valuesOut + blockStart, blockCount);
+        for (int64_t i = 0; i < blockCount; ++i)
+        {
+            if (!valid[i]) valuesOut[blockStart + i] = invalidVal;
+        }
+    }
+}
+
+void VolumeFile::validateSpline(const int64_t brickIndex, const int64_t component, const bool& framePrefiltered) const
 {
     const int64_t* dimensions = getDimensionsPtr();
     CaretAssert(brickIndex >= 0 && brickIndex < dimensions[3]);//function is public, so check inputs
@@ -499,27 +542,42 @@ void VolumeFile::validateSpline(const int64_t brickIndex, const int64_t componen
         if (!m_splinesValid)//double check
         {
             m_frameSplineValid = vector<bool>(numFrames, false);
+            m_frameSplinePrefiltered = vector<bool>(numFrames, false);
             m_frameSplines = vector<VolumeSpline>(numFrames);//release the old spline memory
             m_splinesValid = true;//the only purpose of this flag is for setModified to be fast, don't worry about it becoming false again before the below happens
         }
     }
     CaretAssert((int64_t)m_frameSplineValid.size() == numFrames);
+    CaretAssert((int64_t)m_frameSplinePrefiltered.size() == numFrames);
     CaretAssert((int64_t)m_frameSplines.size() == numFrames);
-    if (!m_frameSplineValid[whichFrame])
+    //a spline made in the other mode is wrong for this request, don't switch modes while other threads sample the frame
+    if (!m_frameSplineValid[whichFrame] || m_frameSplinePrefiltered[whichFrame] != framePrefiltered)
     {
         CaretMutexLocker locked(&m_splineMutex);//prevent concurrent modify access to spline state
-        if (!m_frameSplineValid[whichFrame])//double check
+        if (!m_frameSplineValid[whichFrame] || m_frameSplinePrefiltered[whichFrame] != framePrefiltered)//double check
         {
-            m_frameSplines[whichFrame] = VolumeSpline(getFrame(brickIndex, component), dimensions);
+            m_frameSplines[whichFrame] = VolumeSpline(getFrame(brickIndex, component), dimensions, framePrefiltered);
             if (m_frameSplines[whichFrame].ignoredNonNumeric())
             {
                 CaretLogWarning("ignored non-numeric input value when calculating cubic splines in volume '" + getFileName() + "', frame #" + AString::number(brickIndex + 1));
             }
+            m_frameSplinePrefiltered[whichFrame] = framePrefiltered;
             m_frameSplineValid[whichFrame] = true;
         }
     }
 }
 
+VolumeSpline& VolumeFile::getFrameSpline(const int64_t brickIndex, const int64_t component) const
+{
+    const int64_t* dimensions = getDimensionsPtr();
+    int64_t whichFrame = component * dimensions[3] + brickIndex;
+    if (!m_splinesValid || !m_frameSplineValid[whichFrame])
+    {
+        validateSpline(brickIndex, component);
+    }
+    return m_frameSplines[whichFrame];
+}
+
 void VolumeFile::freeSpline(const int64_t brickIndex, const int64_t component) const
 {
     const int64_t* dimensions = getDimensionsPtr();
@@ -532,6 +590,7 @@ void VolumeFile::freeSpline(const int64_t brickIndex, const int64_t component) c
         if (!m_splinesValid)//double check
         {
             m_frameSplineValid = vector<bool>(numFrames, false);
+            m_frameSplinePrefiltered = vector<bool>(numFrames, false);
             m_frameSplines = vector<VolumeSpline>(numFrames);//release the old spline memory
             m_splinesValid = true;//the only purpose of this flag is for setModified to be fast
         }
@@ -653,6 +712,7 @@ void VolumeFile::validateMembers()
     m_dataRangeValid = false;
     const int64_t* dimensions = getDimensionsPtr();
     m_frameSplineValid = vector<bool>(dimensions[3] * dimensions[4], false);
+    m_frameSplinePrefiltered = vector<bool>(dimensions[3] * dimensions[4], false);
     m_frameSplines = vector<VolumeSpline>(dimensions[3] * dimensions[4]);//release any previous spline memory
     m_splinesValid = true;//this now indicates only if they need to all be recalculated - the frame vectors will always have the correct length
     int numMaps = getNumberOfMaps();
@@ -57,6 +57,9 @@ namespace caret {
         
         void checkStatisticsValid();
         
+        ///spline of a frame for sampling, computes it from the frame values if there isn't one, but keeps a prefiltered one from validateSpline
+        VolumeSpline& getFrameSpline(const int64_t brickIndex, const int64_t component) const;
+        
         struct BrickAttributes//for storing ONLY stuff that doesn't get saved to the caret extension
         {//TODO: prune this once statistics gets straightened out
             CaretPointer<FastStatistics> m_fastStatistics;
@@ -105,6 +108,8 @@ namespace caret {
         
         mutable std::vector<bool> m_frameSplineValid;
         
+        mutable std::vector<bool> m_frameSplinePrefiltered;//which mode each valid spline was made with, so validateSpline can tell when it must redo one
+        
         mutable std::vector<VolumeSpline> m_frameSplines;
         
         bool m_chartingEnabledForTab[BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS];
@@ -172,7 +177,8 @@ namespace caret {
         
         SubvolumeAttributes::VolumeType getType() const;
         
-        void validateSpline(const int64_t brickIndex = 0, const int64_t component = 0) const;
+        ///framePrefiltered means the frame already contains spline coefficients, as written by -volume-spline-prefilter
+        void validateSpline(const int64_t brickIndex = 0, const int64_t component = 0, const bool& framePrefiltered = false) const;
 
         void freeSpline(const int64_t brickIndex = 0, const int64_t component = 0) const;
 
@@ -180,6 +186,9 @@ namespace caret {
 
         float interpolateValue(const float coordIn1, const float coordIn2, const float coordIn3, InterpType interp = TRILINEAR, bool* validOut = NULL, const int64_t brickIndex = 0, const int64_t component = 0) const;
 
+        ///CUBIC interpolation of many points at once, coordsIn is 3 floats per point, same results as interpolateValue on each point
+        void interpolateValuesCubic(const float* coordsIn, float* valuesOut, const int64_t& numPoints, const int64_t brickIndex = 0, const int64_t component = 0) const;
+
         ///returns true if volume space matches in spatial dimensions and sform
         bool matchesVolumeSpace(const VolumeFile* right) const;
         
@@ -23,23 +23,132 @@
 #include "VolumeFileVoxelColorizer.h"
 #undef __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
 
+#include <atomic>
+#include <cmath>
+
+#include <QMutexLocker>
+#include <QThread>
+
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "ElapsedTimer.h"
+#include "FastStatistics.h"
+#include "FrameProfiler.h"
 #include "GiftiLabel.h"
 #include "GroupAndNameHierarchyItem.h"
 #include "NodeAndVoxelColoring.h"
+#include "Palette.h"
+#include "PaletteColorMapping.h"
 #include "VolumeFile.h"
 
-#include <cmath>
-
 using namespace caret;
 
 
+namespace caret {
+    /**
+     * Colors all voxels in a palette mapped map in a thread so that
+     * the volume may be displayed before all of it is colored.  The
+     * settings used for coloring are copied when the thread is created
+     * since they may be changed in the main thread.
+     */
+    class VolumeFileVoxelColorizer::BackgroundColoringThread : public QThread {
+    public:
+        BackgroundColoringThread(const int32_t mapIndex,
+                                 const FastStatistics& statistics,
+                                 const PaletteColorMapping& paletteColorMapping,
+                                 const Palette& palette,
+                                 const float* mapData,
+                                 const PaletteColorMapping& thresholdPaletteColorMapping,
+                                 const float* thresholdData,
+                                 const bool ignoreThresholding,
+                                 const int64_t voxelCount)
+        : QThread(),
+        m_mapIndex(mapIndex),
+        m_statistics(statistics),
+        m_paletteColorMapping(paletteColorMapping),
+        m_palette(palette),
+        m_mapData(mapData),
+        m_thresholdPaletteColorMapping(thresholdPaletteColorMapping),
+        m_thresholdData(thresholdData),
+        m_ignoreThresholding(ignoreThresholding),
+        m_voxelCount(voxelCount)
+        {
+            m_cancelFlag = false;
+            m_completeFlag = false;
+        }
+        
+        /**
+         * Color the voxels in chunks, stopping if canceled.
+         */
+        void run() override {
+            m_rgba.resize(m_voxelCount * 4);
+            
+            const int64_t chunkSize = 1024 * 1024;
+            for (int64_t chunkStart = 0; chunkStart < m_voxelCount; chunkStart += chunkSize) {
+                if (m_cancelFlag) {
+                    return;
+                }
+                const int64_t chunkCount = std::min(chunkSize,
+                                                    m_voxelCount - chunkStart);
+                NodeAndVoxelColoring::colorScalarsWithPalette(&m_statistics,
+                                                              &m_paletteColorMapping,
+                                                              &m_palette,
+                                                              m_mapData + chunkStart,
+                                                              &m_thresholdPaletteColorMapping,
+                                                              m_thresholdData + chunkStart,
+                                                              chunkCount,
+                                                              &m_rgba[chunkStart * 4],
+                                                              m_ignoreThresholding);
+            }
+            
+            m_completeFlag = true;
+        }
+        
+        const int32_t m_mapIndex;
+        
+        const FastStatistics m_statistics;
+        
+        const PaletteColorMapping m_paletteColorMapping;
+        
+        const Palette m_palette;
+        
+        const float* m_mapData;
+        
+        const PaletteColorMapping m_thresholdPaletteColorMapping;
+        
+        const float* m_thresholdData;
+        
+        const bool m_ignoreThresholding;
+        
+        const int64_t m_voxelCount;
+        
+        std::atomic<bool> m_cancelFlag;
+        
+        /** Only set when all voxels were colored */
+        std::atomic<bool> m_completeFlag;
+        
+        std::vector<uint8_t> m_rgba;
+    };
+}
     
 /**
  * \class caret::VolumeFileVoxelColorizer 
  * \brief Delegate for coloring a volumes voxels.
+ *
+ * Maps are colored when their voxels are first requested rather than
+ * when a coloring is assigned, so that a file with many maps is not
+ * colored in its entirety when it is loaded or its palette changes.
+ *
+ * For large palette mapped volumes, only the requested voxels (usually
+ * a slice) are colored immediately and the rest of the map is colored
+ * by a background thread.  When the thread finishes, its coloring is
+ * used for subsequent requests.  Changes to the coloring cancel the
+ * thread.  Label and RGB volumes, and small volumes, are colored
+ * entirely when first requested.
+ *
+ * The memory used for colorings, by all volume files, is limited by
+ * discarding the colorings of the least recently used maps, which are
+ * recolored if needed again.
  */
 
 /**
@@ -65,10 +174,12 @@ VolumeFileVoxelColorizer::VolumeFileVoxelColorizer(VolumeFile* volumeFile)
     m_voxelCountPerMap = m_dimI * m_dimJ * m_dimK;
     m_mapRGBACount = m_voxelCountPerMap * 4;
     
-    for (int64_t i = 0; i < m_mapCount; i++) {
-        m_mapRGBA.push_back(new uint8_t[m_mapRGBACount]);
-        m_mapColoringValid.push_back(false);
-    }
+    m_mapRGBA.resize(m_mapCount);
+    m_mapColoringValid.resize(m_mapCount, false);
+    m_mapLastUsed.resize(m_mapCount, 0);
+    
+    QMutexLocker locker(&s_allColorizersMutex);
+    s_allColorizers.insert(this);
 }
 
 /**
@@ -76,14 +187,16 @@ VolumeFileVoxelColorizer::VolumeFileVoxelColorizer(VolumeFile* volumeFile)
  */
 VolumeFileVoxelColorizer::~VolumeFileVoxelColorizer()
 {
-    for (int64_t i = 0; i < m_mapCount; i++) {
-        delete[] m_mapRGBA[i];
-    }
+    finishBackgroundColoring(true);
+    
+    QMutexLocker locker(&s_allColorizersMutex);
+    s_allColorizers.erase(this);
     m_mapRGBA.clear();
 }
 
 /**
- * Assign voxel coloring for a map.
+ * Assign voxel coloring for a map.  The map is colored when its
+ * voxel colors are next requested.
  *
  * @param mapIndex
  *     Index of map.
@@ -93,8 +206,25 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
 {
     CaretAssertVectorIndex(m_mapRGBA, mapIndex);
     
-    ElapsedTimer timer;
-    timer.start();
+    if (isMapColoredInBackground(mapIndex)) {
+        finishBackgroundColoring(true);
+    }
+    m_mapColoringValid[mapIndex] = false;
+}
+
+/**
+ * Get the data and palette settings for coloring a palette mapped map.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param inputsOut
+ *     Contains the data and settings on exit.
+ */
+void
+VolumeFileVoxelColorizer::getPaletteColoringInputs(const int32_t mapIndex,
+                                                   PaletteColoringInputs& inputsOut) const
+{
+    CaretAssert(m_volumeFile->isMappedWithPalette());
     
     /*
      * Pointer to map's data 
@@ -104,33 +234,31 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
     VolumeFile* thresholdVolume = NULL;
     int32_t thresholdVolumeMapIndex   = -1;
 
-    if (m_volumeFile->isMappedWithPalette()) {
-        switch (m_volumeFile->getMapPaletteColorMapping(mapIndex)->getThresholdType()) {
-            case PaletteThresholdTypeEnum::THRESHOLD_TYPE_FILE:
-            {
-                CaretMappableDataFileAndMapSelectionModel* threshSel = m_volumeFile->getMapThresholdFileSelectionModel(mapIndex);
-                CaretMappableDataFile* mapFile = threshSel->getSelectedFile();
-                if (mapFile != NULL) {
-                    thresholdVolume = dynamic_cast<VolumeFile*>(mapFile);
-                    CaretAssert(thresholdVolume);
-                    thresholdVolumeMapIndex = threshSel->getSelectedMapIndex();
-                }
+    switch (m_volumeFile->getMapPaletteColorMapping(mapIndex)->getThresholdType()) {
+        case PaletteThresholdTypeEnum::THRESHOLD_TYPE_FILE:
+        {
+            CaretMappableDataFileAndMapSelectionModel* threshSel = m_volumeFile->getMapThresholdFileSelectionModel(mapIndex);
+            CaretMappableDataFile* mapFile = threshSel->getSelectedFile();
+            if (mapFile != NULL) {
+                thresholdVolume = dynamic_cast<VolumeFile*>(mapFile);
+                CaretAssert(thresholdVolume);
+                thresholdVolumeMapIndex = threshSel->getSelectedMapIndex();
             }
-                break;
-            case PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED:
-                break;
-            case PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED_AVERAGE_AREA:
-                break;
-            case PaletteThresholdTypeEnum::THRESHOLD_TYPE_NORMAL:
-                /*
-                 * Thresholding with 'self'
-                 */
-                thresholdVolume = m_volumeFile;
-                thresholdVolumeMapIndex = mapIndex;
-                break;
-            case PaletteThresholdTypeEnum::THRESHOLD_TYPE_OFF:
-                break;
         }
+            break;
+        case PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED:
+            break;
+        case PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED_AVERAGE_AREA:
+            break;
+        case PaletteThresholdTypeEnum::THRESHOLD_TYPE_NORMAL:
+            /*
+             * Thresholding with 'self'
+             */
+            thresholdVolume = m_volumeFile;
+            thresholdVolumeMapIndex = mapIndex;
+            break;
+        case PaletteThresholdTypeEnum::THRESHOLD_TYPE_OFF:
+            break;
     }
     
     /*
@@ -165,38 +293,93 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
         }
     }
     
+    const FastStatistics* statistics = NULL;
+    switch (m_volumeFile->getPaletteNormalizationMode()) {
+        case PaletteNormalizationModeEnum::NORMALIZATION_ALL_MAP_DATA:
+            statistics = m_volumeFile->getFileFastStatistics();
+            break;
+        case PaletteNormalizationModeEnum::NORMALIZATION_SELECTED_MAP_DATA:
+            statistics = m_volumeFile->getMapFastStatistics(mapIndex);
+            break;
+    }
+    CaretAssert(statistics);
+    
+    inputsOut.m_statistics = statistics;
+    inputsOut.m_paletteColorMapping = m_volumeFile->getMapPaletteColorMapping(mapIndex);
+    inputsOut.m_mapData = mapDataPointer;
+    inputsOut.m_thresholdData = (ignoreThresholding
+                                 ? mapDataPointer
+                                 : thresholdVolume->getFrame(thresholdVolumeMapIndex));
+    inputsOut.m_thresholdPaletteColorMapping = (ignoreThresholding
+                                                ? m_volumeFile->getMapPaletteColorMapping(mapIndex)
+                                                : thresholdVolume->getMapPaletteColorMapping(thresholdVolumeMapIndex));
+    inputsOut.m_ignoreThresholding = ignoreThresholding;
+}
+
+/**
+ * @return True if the given map is colored by a background thread
+ * and the thread's coloring has not yet been used.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+bool
+VolumeFileVoxelColorizer::isMapColoredInBackground(const int32_t mapIndex) const
+{
+    return ((m_backgroundColoringThread != NULL)
+            && (m_backgroundColoringThread->m_mapIndex == mapIndex));
+}
+
+/**
+ * Color all voxels in a map, immediately, in this thread.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+void
+VolumeFileVoxelColorizer::colorMap(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    
+    if (isMapColoredInBackground(mapIndex)) {
+        finishBackgroundColoring(false);
+        if (m_mapColoringValid[mapIndex]) {
+            return;
+        }
+    }
+    
+    ElapsedTimer timer;
+    timer.start();
+    
+    std::vector<uint8_t>& mapRGBA = m_mapRGBA[mapIndex];
+    if (static_cast<int64_t>(mapRGBA.size()) != m_mapRGBACount) {
+        mapRGBA.resize(m_mapRGBACount);
+    }
+    std::fill(mapRGBA.begin(),
+              mapRGBA.end(),
+              0);
+    
+    /*
+     * Pointer to map's data 
+     */
+    const float* mapDataPointer = m_volumeFile->getFrame(mapIndex);
+    
     switch (m_volumeFile->getType()) {
         case SubvolumeAttributes::UNKNOWN:
         case SubvolumeAttributes::ANATOMY:
         case SubvolumeAttributes::FUNCTIONAL:
         {
-            FastStatistics* statistics = NULL;
-            switch (m_volumeFile->getPaletteNormalizationMode()) {
-                case PaletteNormalizationModeEnum::NORMALIZATION_ALL_MAP_DATA:
-                    statistics = const_cast<FastStatistics*>(m_volumeFile->getFileFastStatistics());
-                    break;
-                case PaletteNormalizationModeEnum::NORMALIZATION_SELECTED_MAP_DATA:
-                    statistics = const_cast<FastStatistics*>(m_volumeFile->getMapFastStatistics(mapIndex));
-                    break;
-            }
-            CaretAssert(statistics);
-            
-            const float* thresholdDataPointer = (ignoreThresholding
-                                                 ? mapDataPointer
-                                                 : thresholdVolume->getFrame(thresholdVolumeMapIndex));
-            const PaletteColorMapping* thresholdPaletteColorMapping = (ignoreThresholding
-                                                                       ? m_volumeFile->getMapPaletteColorMapping(mapIndex)
-                                                                       : thresholdVolume->getMapPaletteColorMapping(thresholdVolumeMapIndex));
-
-            NodeAndVoxelColoring::colorScalarsWithPalette(statistics,
-                                                          m_volumeFile->getMapPaletteColorMapping(mapIndex),
-                                                          mapDataPointer,
-                                                          thresholdPaletteColorMapping,
-                                                          thresholdDataPointer,
+            PaletteColoringInputs inputs;
+            getPaletteColoringInputs(mapIndex,
+                                     inputs);
+            NodeAndVoxelColoring::colorScalarsWithPalette(inputs.m_statistics,
+                                                          inputs.m_paletteColorMapping,
+                                                          inputs.m_mapData,
+                                                          inputs.m_thresholdPaletteColorMapping,
+                                                          inputs.m_thresholdData,
                                                           m_voxelCountPerMap,
-                                                          m_mapRGBA[mapIndex],
-                                                          ignoreThresholding);
-            m_mapColoringValid[mapIndex] = true;
+                                                          &mapRGBA[0],
+                                                          inputs.m_ignoreThresholding);
         }
             break;
         case SubvolumeAttributes::LABEL:
@@ -204,8 +387,7 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
                 NodeAndVoxelColoring::colorIndicesWithLabelTable(m_volumeFile->getMapLabelTable(mapIndex),
                                                                  &mapDataPointer[0],
                                                                  m_voxelCountPerMap,
-                                                                 m_mapRGBA[mapIndex]);
-                m_mapColoringValid[mapIndex] = true;
+                                                                 &mapRGBA[0]);
             }
             break;
         case SubvolumeAttributes::RGB:
@@ -224,8 +406,7 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
                                                            alphaComponents,
                                                            m_voxelCountPerMap,
                                                            thresholdRGB,
-                                                           m_mapRGBA[mapIndex]);
-                m_mapColoringValid[mapIndex] = true;
+                                                           &mapRGBA[0]);
             }
             else {
                 CaretLogSevere("An RGB/RGBA volume must contain 3 or 4 components per voxel: "
@@ -239,6 +420,13 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
             break;
     }
     
+    /*
+     * Unsupported types remain transparent rather than
+     * being colored again for every request
+     */
+    m_mapColoringValid[mapIndex] = true;
+    useMapColoring(mapIndex);
+    
     CaretLogFine("Time to color map named \""
                    + m_volumeFile->getMapName(mapIndex)
                    + " in volume file "
@@ -248,21 +436,426 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
                    + " milliseconds");
 }
 
+/**
+ * Get the coloring of all voxels in a map, coloring the map if needed.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @return
+ *     RGBA for all voxels in the map.
+ */
+const uint8_t*
+VolumeFileVoxelColorizer::getMapColoring(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    
+    if ( ! m_mapColoringValid[mapIndex]) {
+        colorMap(mapIndex);
+    }
+    CaretAssert(static_cast<int64_t>(m_mapRGBA[mapIndex].size()) == m_mapRGBACount);
+    
+    useMapColoring(mapIndex);
+    
+    return &m_mapRGBA[mapIndex][0];
+}
+
+/**
+ * Color some of the voxels in a palette mapped map without
+ * storing the coloring.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param voxelIndices
+ *     Indices of the voxels in the map's data.
+ * @param rgbaOut
+ *     Coloring of the voxels, four per voxel, on exit.
+ */
+void
+VolumeFileVoxelColorizer::colorVoxelsInMap(const int32_t mapIndex,
+                                           const std::vector<int64_t>& voxelIndices,
+                                           uint8_t* rgbaOut) const
+{
+    PaletteColoringInputs inputs;
+    getPaletteColoringInputs(mapIndex,
+                             inputs);
+    
+    const int64_t numberOfVoxels = static_cast<int64_t>(voxelIndices.size());
+    std::vector<float> scalars(numberOfVoxels);
+    std::vector<float> thresholds(numberOfVoxels);
+    for (int64_t i = 0; i < numberOfVoxels; i++) {
+        const int64_t voxelIndex = voxelIndices[i];
+        CaretAssert((voxelIndex >= 0) && (voxelIndex < m_voxelCountPerMap));
+        scalars[i]    = inputs.m_mapData[voxelIndex];
+        thresholds[i] = inputs.m_thresholdData[voxelIndex];
+    }
+    
+    if (numberOfVoxels > 0) {
+        NodeAndVoxelColoring::colorScalarsWithPalette(inputs.m_statistics,
+                                                      inputs.m_paletteColorMapping,
+                                                      &scalars[0],
+                                                      inputs.m_thresholdPaletteColorMapping,
+                                                      &thresholds[0],
+                                                      numberOfVoxels,
+                                                      rgbaOut,
+                                                      inputs.m_ignoreThresholding);
+    }
+}
+
+/**
+ * Start coloring all voxels in a palette mapped map in a background
+ * thread.  The coloring of a previous thread that has finished is used,
+ * and a previous thread that is still running is stopped.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+void
+VolumeFileVoxelColorizer::startBackgroundColoring(const int32_t mapIndex) const
+{
+    if (m_backgroundColoringThread != NULL) {
+        finishBackgroundColoring( ! m_backgroundColoringThread->isFinished());
+    }
+    
+    PaletteColoringInputs inputs;
+    getPaletteColoringInputs(mapIndex,
+                             inputs);
+    
+    /*
+     * The palette is found with an event, which may
+     * only be sent from the main thread
+     */
+    const Palette* palette = inputs.m_paletteColorMapping->getPalette();
+    CaretAssert(palette);
+    
+    m_backgroundColoringThread.reset(new BackgroundColoringThread(mapIndex,
+                                                                  *inputs.m_statistics,
+                                                                  *inputs.m_paletteColorMapping,
+                                                                  *palette,
+                                                                  inputs.m_mapData,
+                                                                  *inputs.m_thresholdPaletteColorMapping,
+                                                                  inputs.m_thresholdData,
+                                                                  inputs.m_ignoreThresholding,
+                                                                  m_voxelCountPerMap));
+    m_backgroundColoringThread->start(QThread::LowPriority);
+}
+
+/**
+ * Wait for the background coloring thread, if there is one, and use
+ * its coloring if it colored all voxels.
+ *
+ * @param cancelFlag
+ *     If true, the thread is stopped and its coloring is discarded.
+ */
+void
+VolumeFileVoxelColorizer::finishBackgroundColoring(const bool cancelFlag) const
+{
+    if (m_backgroundColoringThread == NULL) {
+        return;
+    }
+    
+    if (cancelFlag) {
+        m_backgroundColoringThread->m_cancelFlag = true;
+    }
+    m_backgroundColoringThread->wait();
+    
+    if ( ! cancelFlag) {
+        if (m_backgroundColoringThread->m_completeFlag) {
+            const int32_t mapIndex = m_backgroundColoringThread->m_mapIndex;
+            CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+            m_mapRGBA[mapIndex].swap(m_backgroundColoringThread->m_rgba);
+            m_mapColoringValid[mapIndex] = true;
+            useMapColoring(mapIndex);
+        }
+    }
+    
+    m_backgroundColoringThread.reset();
+}
+
+/**
+ * Record use of a map's coloring and discard least recently used
+ * colorings if they use too much memory.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+void
+VolumeFileVoxelColorizer::useMapColoring(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapLastUsed, mapIndex);
+    
+    QMutexLocker locker(&s_allColorizersMutex);
+    ++s_mapUseCounter;
+    m_mapLastUsed[mapIndex] = s_mapUseCounter;
+    
+    limitColoringMemory(this,
+                        mapIndex);
+}
+
+/**
+ * Discard the colorings of least recently used maps, in any volume
+ * file, until the memory used by all colorings is within the limit.
+ * The caller must lock s_allColorizersMutex.
+ *
+ * @param colorizerToKeep
+ *     Colorizer containing the map whose coloring is never discarded.
+ * @param mapIndexToKeep
+ *     Index of map whose coloring is never discarded.
+ */
+void
+VolumeFileVoxelColorizer::limitColoringMemory(const VolumeFileVoxelColorizer* colorizerToKeep,
+                                              const int32_t mapIndexToKeep)
+{
+    int64_t totalBytes = 0;
+    for (const VolumeFileVoxelColorizer* colorizer : s_allColorizers) {
+        for (const auto& rgba : colorizer->m_mapRGBA) {
+            totalBytes += static_cast<int64_t>(rgba.capacity());
+        }
+    }
+    
+    while (totalBytes > s_maximumColoringMemoryBytes) {
+        VolumeFileVoxelColorizer* oldestColorizer = NULL;
+        int32_t oldestMapIndex = -1;
+        for (VolumeFileVoxelColorizer* colorizer : s_allColorizers) {
+            for (int32_t i = 0; i < colorizer->m_mapCount; i++) {
+                if ((colorizer == colorizerToKeep)
+                    && (i == mapIndexToKeep)) {
+                    continue;
+                }
+                if ( ! colorizer->m_mapRGBA[i].empty()) {
+                    if ((oldestColorizer == NULL)
+                        || (colorizer->m_mapLastUsed[i] < oldestColorizer->m_mapLastUsed[oldestMapIndex])) {
+                        oldestColorizer = colorizer;
+                        oldestMapIndex  = i;
+                    }
+                }
+            }
+        }
+        if (oldestColorizer == NULL) {
+            break;
+        }
+        
+        totalBytes -= static_cast<int64_t>(oldestColorizer->m_mapRGBA[oldestMapIndex].capacity());
+        std::vector<uint8_t>().swap(oldestColorizer->m_mapRGBA[oldestMapIndex]);
+        oldestColorizer->m_mapColoringValid[oldestMapIndex] = false;
+    }
+}
+
+/**
+ * @return True if all voxels in the given map are colored.  False if
+ * the map has not been colored, its coloring was invalidated or
+ * discarded, or it is still being colored in the background.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+bool
+VolumeFileVoxelColorizer::isMapColored(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapColoringValid, mapIndex);
+    return m_mapColoringValid[mapIndex];
+}
+
+/**
+ * Wait for the background coloring thread, if there is one, to finish.
+ * Its coloring is used when voxel colors are next requested.
+ */
+void
+VolumeFileVoxelColorizer::waitForBackgroundColoring() const
+{
+    if (m_backgroundColoringThread != NULL) {
+        m_backgroundColoringThread->wait();
+    }
+}
+
+/**
+ * @return Memory, in bytes, used by the colorings of all volume files.
+ */
+int64_t
+VolumeFileVoxelColorizer::getColoringMemoryBytes()
+{
+    QMutexLocker locker(&s_allColorizersMutex);
+    
+    int64_t totalBytes = 0;
+    for (const VolumeFileVoxelColorizer* colorizer : s_allColorizers) {
+        for (const auto& rgba : colorizer->m_mapRGBA) {
+            totalBytes += static_cast<int64_t>(rgba.capacity());
+        }
+    }
+    return totalBytes;
+}
+
+/**
+ * @return Maximum memory, in bytes, for the colorings of all volume files.
+ */
+int64_t
+VolumeFileVoxelColorizer::getMaximumColoringMemoryBytes()
+{
+    QMutexLocker locker(&s_allColorizersMutex);
+    return s_maximumColoringMemoryBytes;
+}
+
+/**
+ * Set the maximum memory for the colorings of all volume files.
+ * The limit is applied when a map's coloring is next used.
+ *
+ * @param maximumBytes
+ *     New maximum, in bytes.
+ */
+void
+VolumeFileVoxelColorizer::setMaximumColoringMemoryBytes(const int64_t maximumBytes)
+{
+    QMutexLocker locker(&s_allColorizersMutex);
+    s_maximumColoringMemoryBytes = maximumBytes;
+}
+
 /**
  * Invalidate the RGBA coloring for all maps.
  */
 void
 VolumeFileVoxelColorizer::invalidateColoring()
 {
+    finishBackgroundColoring(true);
     std::fill(m_mapColoringValid.begin(),
               m_mapColoringValid.end(),
               false);
 }
 
 /**
- * Get voxel coloring for a slice in a map.  If voxel coloring is not ready
- * (it may be running in a different thread) this method will wait until the 
- * coloring is valid prior to returning the slice's coloring.
+ * Get the coloring of voxels in a map.  If the map has been colored,
+ * its coloring is copied.  Otherwise, a large palette mapped map's
+ * voxels are colored as needed while the rest of the map is colored
+ * in the background, and any other map is colored entirely.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param voxelIndices
+ *     Indices of the voxels in the map's data.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param rgbaOut
+ *    RGBA color components out, four per voxel index.
+ * @return
+ *    Number of voxels with alpha greater than zero
+ */
+int64_t
+VolumeFileVoxelColorizer::getVoxelColorsForVoxelIndices(const int32_t mapIndex,
+                                                        const std::vector<int64_t>& voxelIndices,
+                                                        const DisplayGroupEnum::Enum displayGroup,
+                                                        const int32_t tabIndex,
+                                                        uint8_t* rgbaOut) const
+{
+    FrameProfiler::Scope profileScope("colorVoxels");
+    
+    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    CaretAssert(rgbaOut);
+    
+    const int64_t numberOfVoxels = static_cast<int64_t>(voxelIndices.size());
+    
+    if (isMapColoredInBackground(mapIndex)) {
+        if (m_backgroundColoringThread->isFinished()) {
+            finishBackgroundColoring(false);
+        }
+    }
+    
+    if ( ! m_mapColoringValid[mapIndex]) {
+        bool colorInBackgroundFlag = false;
+        if (m_voxelCountPerMap >= s_backgroundColoringMinimumVoxelCount) {
+            switch (m_volumeFile->getType()) {
+                case SubvolumeAttributes::UNKNOWN:
+                case SubvolumeAttributes::ANATOMY:
+                case SubvolumeAttributes::FUNCTIONAL:
+                    colorInBackgroundFlag = true;
+                    break;
+                case SubvolumeAttributes::LABEL:
+                case SubvolumeAttributes::RGB:
+                case SubvolumeAttributes::SEGMENTATION:
+                case SubvolumeAttributes::VECTOR:
+                    break;
+            }
+        }
+        
+        /*
+         * A threshold volume in another file might be closed
+         * while a thread is using its data
+         */
+        if (colorInBackgroundFlag
+            && (m_volumeFile->getMapPaletteColorMapping(mapIndex)->getThresholdType()
+                == PaletteThresholdTypeEnum::THRESHOLD_TYPE_FILE)) {
+            colorInBackgroundFlag = false;
+        }
+        
+        if (colorInBackgroundFlag) {
+            colorVoxelsInMap(mapIndex,
+                             voxelIndices,
+                             rgbaOut);
+            if ( ! isMapColoredInBackground(mapIndex)) {
+                startBackgroundColoring(mapIndex);
+            }
+        }
+        else {
+            colorMap(mapIndex);
+        }
+    }
+    
+    if (m_mapColoringValid[mapIndex]) {
+        const uint8_t* mapRGBA = getMapColoring(mapIndex);
+        for (int64_t i = 0; i < numberOfVoxels; i++) {
+            const int64_t rgbaOffset = voxelIndices[i] * 4;
+            CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
+            const int64_t rgbaOutIndex = i * 4;
+            rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
+            rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
+            rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
+            rgbaOut[rgbaOutIndex+3] = mapRGBA[rgbaOffset+3];
+        }
+    }
+    
+    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
+                                         ? m_volumeFile->getMapLabelTable(mapIndex)
+                                         : NULL);
+    if (m_volumeFile->isMappedWithLabelTable()) {
+        CaretAssert(labelTable);
+    }
+    const float* mapData = m_volumeFile->getFrame(mapIndex);
+    
+    int64_t validVoxelCount = 0;
+    
+    for (int64_t i = 0; i < numberOfVoxels; i++) {
+        uint8_t& alpha = rgbaOut[i * 4 + 3];
+        if (alpha > 0) {
+            if (labelTable != NULL) {
+                /*
+                 * For label data, verify that the label is displayed.
+                 * If NOT displayed, zero out the alpha value to
+                 * prevent display of the data.
+                 */
+                const int32_t dataValue = static_cast<int32_t>(mapData[voxelIndices[i]]);
+                const GiftiLabel* label = labelTable->getLabel(dataValue);
+                if (label != NULL) {
+                    const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
+                    if (item != NULL) {
+                        if (item->isSelected(displayGroup, tabIndex) == false) {
+                            alpha = 0;
+                        }
+                    }
+                }
+            }
+        }
+        
+        if (alpha > 0) {
+            ++validVoxelCount;
+        }
+    }
+    
+    return validVoxelCount;
+}
+
+/**
+ * Get voxel coloring for a slice in a map.  If the map's coloring is not
+ * ready (it may be running in a different thread) the slice's voxels
+ * are colored without waiting for the coloring.
  *
  * @param mapIndex
  *     Index of map.
@@ -315,67 +908,21 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
             break;
     }
 
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
-    
-    int64_t validVoxelCount = 0;
-    
-    /*
-     * Output RGBA values for slice
-     */
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelIndices;
+    voxelIndices.reserve((iEnd - iStart + 1) * (jEnd - jStart + 1) * (kEnd - kStart + 1));
     for (int64_t k = kStart; k <= kEnd; k++) {
         for (int64_t j = jStart; j <= jEnd; j++) {
             for (int64_t i = iStart; i <= iEnd; i++) {
-                const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(i, j, k);
-                CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
-                rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-                rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-                rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-                uint8_t alpha = mapRGBA[rgbaOffset+3];
-                
-                if (alpha > 0) {
-                    if (labelTable != NULL) {
-                        /*
-                         * For label data, verify that the label is displayed.
-                         * If NOT displayed, zero out the alpha value to
-                         * prevent display of the data.
-                         */
-                        const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(i,
-                                                                                              j,
-                                                                                              k,
-                                                                                              mapIndex));
-                        const GiftiLabel* label = labelTable->getLabel(dataValue);
-                        if (label != NULL) {
-                            const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                            if (item != NULL) {
-                                if (item->isSelected(displayGroup, tabIndex) == false) {
-                                    alpha = 0;
-                                }
-                            }
-                        }
-                    }
-                }
-                
-                if (alpha > 0.0) {
-                    ++validVoxelCount;
-                }
-                rgbaOut[rgbaOutIndex+3] = alpha;
-                rgbaOutIndex += 4;
+                voxelIndices.push_back(getVoxelIndex(i, j, k));
             }
         }
     }
     
-    return validVoxelCount;
+    return getVoxelColorsForVoxelIndices(mapIndex,
+                                         voxelIndices,
+                                         displayGroup,
+                                         tabIndex,
+                                         rgbaOut);
 }
 
 /**
@@ -413,60 +960,18 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                                     const int32_t tabIndex,
                                     uint8_t* rgbaOut) const
 {
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
+    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    CaretAssert(rgbaOut);
     
-    int64_t validVoxelCount = 0;
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelIndices;
+    voxelIndices.reserve(numberOfRows * numberOfColumns);
     
     int64_t rowIJK[3] = { firstVoxelIJK[0], firstVoxelIJK[1], firstVoxelIJK[2] };
     for (int64_t iRow = 0; iRow < numberOfRows; iRow++) {
         
         int64_t ijk[3] = { rowIJK[0], rowIJK[1], rowIJK[2] };
         for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-            const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(ijk);
-            
-            CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
-            rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-            rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-            rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-            uint8_t alpha = mapRGBA[rgbaOffset+3];
-            
-            if (alpha > 0) {
-                if (labelTable != NULL) {
-                    /*
-                     * For label data, verify that the label is displayed.
-                     * If NOT displayed, zero out the alpha value to
-                     * prevent display of the data.
-                     */
-                    const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(ijk,
-                                                                                          mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL) {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL) {
-                            if (item->isSelected(displayGroup, tabIndex) == false) {
-                                alpha = 0;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            if (alpha > 0.0) {
-                ++validVoxelCount;
-            }
-            rgbaOut[rgbaOutIndex+3] = alpha;
-            rgbaOutIndex += 4;
+            voxelIndices.push_back(getVoxelIndex(ijk[0], ijk[1], ijk[2]));
             
             ijk[0] += columnStepIJK[0];
             ijk[1] += columnStepIJK[1];
@@ -478,13 +983,17 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
         rowIJK[2] += rowStepIJK[2];
     }
     
-    return validVoxelCount;
+    return getVoxelColorsForVoxelIndices(mapIndex,
+                                         voxelIndices,
+                                         displayGroup,
+                                         tabIndex,
+                                         rgbaOut);
 }
 
 /**
- * Get voxel coloring for a sub-slice in a map.  If voxel coloring is not ready
- * (it may be running in a different thread) this method will wait until the
- * coloring is valid prior to returning the slice's coloring.
+ * Get voxel coloring for a sub-slice in a map.  If the map's coloring is not
+ * ready (it may be running in a different thread) the sub-slice's voxels
+ * are colored without waiting for the coloring.
  *
  * @param mapIndex
  *     Index of map.
@@ -574,23 +1083,9 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
     CaretUsedInDebugCompileOnly(const int64_t voxelCount = (voxelCountIJK[0] * voxelCountIJK[1] * voxelCountIJK[2]));
     CaretUsedInDebugCompileOnly(const int64_t rgbaCount = voxelCount * 4);
     
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
-    
-    int64_t validVoxelCount = 0;
-    
     CaretUsedInDebugCompileOnly(int64_t innerCount = std::abs(lastCornerVoxelIndex[innerLoop] - firstCornerVoxelIndex[innerLoop]) + 1);//to check validity of index
     
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelIndices;
     for (iterijk[outerLoop] = firstCornerVoxelIndex[outerLoop];
          iterijk[outerLoop] != lastCornerVoxelIndex[outerLoop] + incrementijk[outerLoop];
          iterijk[outerLoop] += incrementijk[outerLoop])
@@ -599,52 +1094,19 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
             iterijk[innerLoop] != lastCornerVoxelIndex[innerLoop] + incrementijk[innerLoop];
             iterijk[innerLoop] += incrementijk[innerLoop])
         {
-            CaretAssert(rgbaOutIndex == 4 * (innerCount * std::abs(iterijk[outerLoop] - firstCornerVoxelIndex[outerLoop]) +
+            CaretAssert(static_cast<int64_t>(voxelIndices.size()) == (innerCount * std::abs(iterijk[outerLoop] - firstCornerVoxelIndex[outerLoop]) +
                         std::abs(iterijk[innerLoop] - firstCornerVoxelIndex[innerLoop])));
-            CaretAssertArrayIndex(rgbaOut, rgbaCount, rgbaOutIndex + 3);
-            
-            const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(iterijk[0], iterijk[1], iterijk[2]);
-            CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
+            CaretAssertArrayIndex(rgbaOut, rgbaCount, static_cast<int64_t>(voxelIndices.size()) * 4 + 3);
             
-            rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-            rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-            rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-            uint8_t alpha = mapRGBA[rgbaOffset+3];
-            
-            if (alpha > 0)
-            {
-                if (labelTable != NULL)
-                {
-                    //For label data, verify that the label is displayed.
-                    //If NOT displayed, zero out the alpha value to
-                    //prevent display of the data.
-                    
-                    const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(iterijk, mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL)
-                    {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL)
-                        {
-                            if (item->isSelected(displayGroup, tabIndex) == false)
-                            {
-                                alpha = 0;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            if (alpha > 0.0) {
-                ++validVoxelCount;
-            }
-            rgbaOut[rgbaOutIndex+3] = alpha;
-
-            rgbaOutIndex += 4;
+            voxelIndices.push_back(getVoxelIndex(iterijk[0], iterijk[1], iterijk[2]));
         }
     }
 
-    return validVoxelCount;
+    return getVoxelColorsForVoxelIndices(mapIndex,
+                                         voxelIndices,
+                                         displayGroup,
+                                         tabIndex,
+                                         rgbaOut);
 }
 
 /**
@@ -678,8 +1140,8 @@ VolumeFileVoxelColorizer::getVoxelColorInMap(const int64_t i,
      * Pointer to maps RGBA values
      */
     CaretAssertVectorIndex(m_mapRGBA, mapIndex);
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(i, j, k);
+    const uint8_t* mapRGBA = getMapColoring(mapIndex);
+    const int64_t rgbaOffset = getVoxelIndex(i, j, k) * 4;
     CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
     rgbaOut[0] = mapRGBA[rgbaOffset];
     rgbaOut[1] = mapRGBA[rgbaOffset+1];
@@ -723,12 +1185,15 @@ void
 VolumeFileVoxelColorizer::clearVoxelColoringForMap(const int64_t mapIndex)
 {
     CaretAssertVectorIndex(m_mapRGBA, mapIndex);
-    uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    for (int64_t i = 0; i < m_mapRGBACount; i++) {
-        mapRGBA[i] = 0.0;
+    if (isMapColoredInBackground(mapIndex)) {
+        finishBackgroundColoring(true);
     }
     
+    std::vector<uint8_t>& mapRGBA = m_mapRGBA[mapIndex];
+    std::fill(mapRGBA.begin(),
+              mapRGBA.end(),
+              0);
+    
     CaretAssertVectorIndex(m_mapColoringValid, mapIndex);
     m_mapColoringValid[mapIndex] = false;
 }
@@ -21,6 +21,11 @@
  */
 /*LICENSE_END*/
 
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <QMutex>
 
 #include "CaretObject.h"
 #include "DisplayGroupEnum.h"
@@ -28,6 +33,8 @@
 
 namespace caret {
 
+    class FastStatistics;
+    class PaletteColorMapping;
     class VolumeFile;
     
     class VolumeFileVoxelColorizer : public CaretObject {
@@ -78,29 +85,78 @@ namespace caret {
         
         void invalidateColoring();
         
+        bool isMapColored(const int32_t mapIndex) const;
+        
+        void waitForBackgroundColoring() const;
+        
+        static int64_t getColoringMemoryBytes();
+        
+        static int64_t getMaximumColoringMemoryBytes();
+        
+        static void setMaximumColoringMemoryBytes(const int64_t maximumBytes);
+        
     private:
         VolumeFileVoxelColorizer(const VolumeFileVoxelColorizer&);
 
         VolumeFileVoxelColorizer& operator=(const VolumeFileVoxelColorizer&);
         
+        class BackgroundColoringThread;
+        
         /**
-         * Get theRGBA offset for a voxel index
+         * Data and settings for coloring a map with a palette
          */
-        inline int64_t getRgbaOffsetForVoxelIndex(const int64_t i,
-                                           const int64_t j,
-                                           const int64_t k) const {
-            return (4 * (i
-                         + (j * m_dimI)
-                         + ((k * m_dimI * m_dimJ))));
-        }
-
+        class PaletteColoringInputs {
+        public:
+            const FastStatistics* m_statistics = NULL;
+            
+            const PaletteColorMapping* m_paletteColorMapping = NULL;
+            
+            const float* m_mapData = NULL;
+            
+            const PaletteColorMapping* m_thresholdPaletteColorMapping = NULL;
+            
+            const float* m_thresholdData = NULL;
+            
+            bool m_ignoreThresholding = true;
+        };
+        
+        void getPaletteColoringInputs(const int32_t mapIndex,
+                                      PaletteColoringInputs& inputsOut) const;
+        
+        bool isMapColoredInBackground(const int32_t mapIndex) const;
+        
+        const uint8_t* getMapColoring(const int32_t mapIndex) const;
+        
+        void colorMap(const int32_t mapIndex) const;
+        
+        void colorVoxelsInMap(const int32_t mapIndex,
+                              const std::vector<int64_t>& voxelIndices,
+                              uint8_t* rgbaOut) const;
+        
+        int64_t getVoxelColorsForVoxelIndices(const int32_t mapIndex,
+                                              const std::vector<int64_t>& voxelIndices,
+                                              const DisplayGroupEnum::Enum displayGroup,
+                                              const int32_t tabIndex,
+                                              uint8_t* rgbaOut) const;
+        
+        void startBackgroundColoring(const int32_t mapIndex) const;
+        
+        void finishBackgroundColoring(const bool cancelFlag) const;
+        
+        void useMapColoring(const int32_t mapIndex) const;
+        
+        static void limitColoringMemory(const VolumeFileVoxelColorizer* colorizerToKeep,
+                                        const int32_t mapIndexToKeep);
+        
         /**
-         * Get theRGBA offset for a voxel index
+         * Get the index of a voxel in a map's data
          */
-        inline int64_t getRgbaOffsetForVoxelIndex(const int64_t ijk[3]) const {
-            return (4 * (ijk[0]
-                         + (ijk[1] * m_dimI)
-                         + ((ijk[2] * m_dimI * m_dimJ))));
+        inline int64_t getVoxelIndex(const int64_t i,
+                                     const int64_t j,
+                                     const int64_t k) const {
+            return (i
+                    + (j * m_dimI)
+                    + ((k * m_dimI * m_dimJ)));
         }
         
         // ADD_NEW_MEMBERS_HERE
@@ -114,12 +170,47 @@ namespace caret {
         int64_t m_mapCount;
         int64_t m_mapRGBACount;
         
-        std::vector<bool> m_mapColoringValid;
-        std::vector<uint8_t*> m_mapRGBA;
+        /*
+         * Maps are colored when first needed, so these are modified
+         * by the const methods that get colors.
+         */
+        
+        mutable std::vector<bool> m_mapColoringValid;
+        
+        /** Coloring of each map, empty until the map is colored or after it is discarded */
+        mutable std::vector<std::vector<uint8_t>> m_mapRGBA;
+        
+        /** Value of s_mapUseCounter when each map's coloring was last used */
+        mutable std::vector<int64_t> m_mapLastUsed;
+        
+        /** Colors all voxels in a map while the displayed voxels are colored as needed */
+        mutable std::unique_ptr<BackgroundColoringThread> m_backgroundColoringThread;
+        
+        static const int64_t s_backgroundColoringMinimumVoxelCount;
+        
+        /** All colorizers, so that the memory limit applies to the colorings of all volume files */
+        static std::set<VolumeFileVoxelColorizer*> s_allColorizers;
+        
+        /** Protects s_allColorizers, s_mapUseCounter, and s_maximumColoringMemoryBytes */
+        static QMutex s_allColorizersMutex;
+        
+        static int64_t s_mapUseCounter;
+        
+        static int64_t s_maximumColoringMemoryBytes;
     };
     
 #ifdef __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
-    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    /** Smaller maps are colored immediately */
+    const int64_t VolumeFileVoxelColorizer::s_backgroundColoringMinimumVoxelCount = 256 * 256 * 64;
+    
+    std::set<VolumeFileVoxelColorizer*> VolumeFileVoxelColorizer::s_allColorizers;
+    
+    QMutex VolumeFileVoxelColorizer::s_allColorizersMutex;
+    
+    int64_t VolumeFileVoxelColorizer::s_mapUseCounter = 0;
+    
+    /** Colorings of least recently used maps are discarded to stay within this size */
+    int64_t VolumeFileVoxelColorizer::s_maximumColoringMemoryBytes = 1024LL * 1024LL * 1024LL;
 #endif // __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
 
 } // namespace
@@ -38,13 +38,28 @@ VolumeSpline::VolumeSpline()
     m_dims[2] = 0;
 }
 
-VolumeSpline::VolumeSpline(const float* frame, const int64_t framedims[3])
+VolumeSpline::VolumeSpline(const float* frame, const int64_t framedims[3], const bool& framePrefiltered)
 {
     m_ignoredNonNumeric = false;
     m_dims[0] = framedims[0];
     m_dims[1] = framedims[1];
     m_dims[2] = framedims[2];
     m_deconv = CaretArray<float>(m_dims[0] * m_dims[1] * m_dims[2]);
+    if (framePrefiltered)
+    {
+        int64_t frameSize = m_dims[0] * m_dims[1] * m_dims[2];
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            if (MathFunctions::isNumeric(frame[i]))
+            {
+                m_deconv[i] = frame[i];
+            } else {
+                m_deconv[i] = 0.0f;
+                m_ignoredNonNumeric = true;
+            }
+        }
+        return;
+    }
     CaretArray<float> scratchArray(m_dims[0] * max(m_dims[1], m_dims[2])), deconvScratch(max(m_dims[0], max(m_dims[1], m_dims[2])));//allocate as much as we will need, even if we don't use it all yet
     predeconvolve(deconvScratch, m_dims[0]);
     for (int k = 0; k < m_dims[2]; ++k)
@@ -230,6 +245,72 @@ float VolumeSpline::sample(const float& ifloat, const float& jfloat, const float
     }
 }
 
+void VolumeSpline::sampleMultiple(const float* ijk, float* valuesOut, const int64_t& count)
+{
+    const int GROUP_SIZE = 8;
+    const int64_t zstep = m_dims[0] * m_dims[1];
+    const float* deconvData = m_deconv.getArray();
+    for (int64_t groupStart = 0; groupStart < count; groupStart += GROUP_SIZE)
+    {
+        int groupCount = (int)min((int64_t)GROUP_SIZE, count - groupStart);
+        const float* groupIJK = ijk + groupStart * 3;
+        float frac[3][GROUP_SIZE] = { { 0.0f } }, weights[3][4][GROUP_SIZE];//weights are computed for the full group size, so that loop has a fixed length
+        int64_t low[3][GROUP_SIZE];
+        bool interior[GROUP_SIZE];
+        for (int p = 0; p < groupCount; ++p)
+        {
+            interior[p] = true;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float coord = groupIJK[p * 3 + axis];
+                if (!(coord >= 0.0f) || coord > m_dims[axis] - 1)//also catches NaN
+                {
+                    interior[p] = false;
+                    low[axis][p] = 0;
+                    frac[axis][p] = 0.0f;
+                    continue;
+                }
+                float intPart = floor(coord);//coord is nonnegative, so this matches modf
+                frac[axis][p] = coord - intPart;
+                low[axis][p] = (int64_t)intPart;
+                if (low[axis][p] < 1 || low[axis][p] >= m_dims[axis] - 2) interior[p] = false;//edge weights are different, leave them to sample()
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {//no edge cases here, so this is the same arithmetic as CubicSpline::bspline, done for the whole group at once
+            for (int p = 0; p < GROUP_SIZE; ++p)
+            {
+                float f = frac[axis][p], f2 = f * f, f3 = f2 * f;
+                weights[axis][0][p] = (-f3 + 3.0f * f2 - 3.0f * f + 1.0f) / 6.0f;
+                weights[axis][1][p] = (3.0f * f3 - 6.0f * f2 + 4.0f) / 6.0f;
+                weights[axis][2][p] = (-3.0f * f3 + 3.0f * f2 + 3.0f * f + 1.0f) / 6.0f;
+                weights[axis][3][p] = f3 / 6.0f;
+            }
+        }
+        for (int p = 0; p < groupCount; ++p)
+        {
+            if (!interior[p])
+            {
+                valuesOut[groupStart + p] = sample(groupIJK + p * 3);
+                continue;
+            }
+            const float* basePtr = deconvData + (low[0][p] - 1 + m_dims[0] * (low[1][p] - 1 + m_dims[1] * (low[2][p] - 1)));
+            float ktemp[4];
+            for (int k = 0; k < 4; ++k)
+            {
+                float jtemp[4];
+                for (int j = 0; j < 4; ++j)
+                {
+                    const float* row = basePtr + k * zstep + j * m_dims[0];
+                    jtemp[j] = row[0] * weights[0][0][p] + row[1] * weights[0][1][p] + row[2] * weights[0][2][p] + row[3] * weights[0][3][p];
+                }
+                ktemp[k] = jtemp[0] * weights[1][0][p] + jtemp[1] * weights[1][1][p] + jtemp[2] * weights[1][2][p] + jtemp[3] * weights[1][3][p];
+            }
+            valuesOut[groupStart + p] = ktemp[0] * weights[2][0][p] + ktemp[1] * weights[2][1][p] + ktemp[2] * weights[2][2][p] + ktemp[3] * weights[2][3][p];
+        }
+    }
+}
+
 void VolumeSpline::deconvolve(float* data, const float* backsubs, const int64_t& length)
 {
     if (length < 1) return;
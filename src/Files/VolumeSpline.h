@@ -35,9 +35,13 @@ namespace caret {
         void predeconvolve(float* backsubs, const int64_t& length);//since the back substitution on the same size array uses the same coefficients, precompute them
     public:
         VolumeSpline();
-        VolumeSpline(const float* frame, const int64_t framedims[3]);
+        ///framePrefiltered means frame already contains the spline coefficients (from getCoefficients()), so the deconvolution is skipped
+        VolumeSpline(const float* frame, const int64_t framedims[3], const bool& framePrefiltered = false);
         float sample(const float& i, const float& j, const float& k);
         float sample(const float ijk[3]) { return sample(ijk[0], ijk[1], ijk[2]); }
+        ///same results as sample() on each point, ijk is 3 floats per point - spline weights are computed a group of points at a time
+        void sampleMultiple(const float* ijk, float* valuesOut, const int64_t& count);
+        const float* getCoefficients() const { return m_deconv.getArray(); }
         bool ignoredNonNumeric() const { return m_ignoredNonNumeric; }
     };
     
@@ -97,6 +97,30 @@ GraphicsEngineDataOpenGL::invalidateColors()
     m_reloadColorsFlag = true;
 }
 
+/**
+ * Invalidate the texture coordinates after they have
+ * changed in the graphics primitive.
+ */
+void
+GraphicsEngineDataOpenGL::invalidateTextureCoordinates()
+{
+    m_reloadTextureCoordinatesFlag = true;
+}
+
+/**
+ * Invalidate the texture image after it has
+ * changed in the graphics primitive.  The texture
+ * is recreated when the primitive is next drawn.
+ */
+void
+GraphicsEngineDataOpenGL::invalidateTextureImage()
+{
+    if (m_textureImageDataName != NULL) {
+        delete m_textureImageDataName;
+        m_textureImageDataName = NULL;
+    }
+}
+
 /**
  * Get the OpenGL Buffer Usage Hint from the primitive.
  *
@@ -300,9 +324,14 @@ GraphicsEngineDataOpenGL::loadTextureCoordinateBuffer(GraphicsPrimitive* primiti
     switch (primitive->m_textureDataType) {
         case GraphicsPrimitive::TextureDataType::FLOAT_STR:
         {
-            EventGraphicsOpenGLCreateBufferObject createEvent;
-            EventManager::get()->sendEvent(createEvent.getPointer());
-            m_textureCoordinatesBufferObject.reset(createEvent.getOpenGLBufferObject());
+            /*
+             * Texture coordinate buffer may have been created.
+             */
+            if (m_textureCoordinatesBufferObject == NULL) {
+                EventGraphicsOpenGLCreateBufferObject createEvent;
+                EventManager::get()->sendEvent(createEvent.getPointer());
+                m_textureCoordinatesBufferObject.reset(createEvent.getOpenGLBufferObject());
+            }
             CaretAssert(m_textureCoordinatesBufferObject->getBufferObjectName());
             
             m_textureCoordinatesDataType = GL_FLOAT;
@@ -321,7 +350,9 @@ GraphicsEngineDataOpenGL::loadTextureCoordinateBuffer(GraphicsPrimitive* primiti
             break;
         case GraphicsPrimitive::TextureDataType::NONE:
             break;
-    }    
+    }
+    
+    m_reloadTextureCoordinatesFlag = false;
 }
 
 
@@ -998,6 +1029,13 @@ GraphicsEngineDataOpenGL::drawPrivate(const PrivateDrawMode drawMode,
         if (openglData->m_reloadColorsFlag) {
             openglData->loadColorBuffer(primitive);
         }
+        
+        /*
+         * Texture coordinates may get updated
+         */
+        if (openglData->m_reloadTextureCoordinatesFlag) {
+            openglData->loadTextureCoordinateBuffer(primitive);
+        }
     }
     
     openglData->loadTextureImageDataBuffer(primitive);
@@ -1112,7 +1150,14 @@ GraphicsEngineDataOpenGL::drawPrivate(const PrivateDrawMode drawMode,
         && (drawMode == PrivateDrawMode::DRAW_NORMAL)
         && (openglData->m_textureImageDataName->getTextureName() > 0)) {
             glEnable(GL_TEXTURE_2D);
-            glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+            switch (primitive->getTextureEnvironmentMode()) {
+                case GraphicsPrimitive::TextureEnvironmentMode::MODULATE:
+                    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+                    break;
+                case GraphicsPrimitive::TextureEnvironmentMode::REPLACE:
+                    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+                    break;
+            }
             glBindTexture(GL_TEXTURE_2D, openglData->m_textureImageDataName->getTextureName());
             
             glEnableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -56,6 +56,10 @@ namespace caret {
         
         void invalidateColors();
         
+        void invalidateTextureCoordinates();
+        
+        void invalidateTextureImage();
+        
         // ADD_NEW_METHODS_HERE
 
     private:
@@ -126,6 +130,8 @@ namespace caret {
         
         bool m_reloadColorsFlag = false;
         
+        bool m_reloadTextureCoordinatesFlag = false;
+        
         std::unique_ptr<GraphicsOpenGLBufferObject> m_normalVectorBufferObject;
         
         GLenum m_normalVectorDataType = GL_FLOAT;
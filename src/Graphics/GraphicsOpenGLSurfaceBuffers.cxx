@@ -0,0 +1,401 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_DECLARE__
+#include "GraphicsOpenGLSurfaceBuffers.h"
+#undef __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_DECLARE__
+
+#include "CaretAssert.h"
+#include "EventGraphicsOpenGLCreateBufferObject.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLBufferObject.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::GraphicsOpenGLSurfaceBuffers
+ * \brief Surface coordinates, normals, triangles, and colors kept in OpenGL buffers
+ * \ingroup Graphics
+ *
+ * The vertex and triangle data of a surface only changes when the surface
+ * is edited, but drawing with client-side vertex arrays sends all of it
+ * to the graphics card for every frame.  This keeps the data in buffer
+ * objects and reloads the geometry only when the owner's geometry
+ * modification count changes, and a coloring only when its coloring
+ * modification count changes.
+ *
+ * Simplified triangles for levels of detail may be loaded in additional
+ * buffers and drawn with the same coordinates, normals, and colors.
+ *
+ * Buffers are created in the context sharing group that is current when
+ * they are first loaded.  If drawing moves to a different context, the
+ * buffers are released and created again in the new context.
+ */
+
+/**
+ * Constructor.
+ */
+GraphicsOpenGLSurfaceBuffers::GraphicsOpenGLSurfaceBuffers()
+: CaretObject()
+{
+
+}
+
+/**
+ * Destructor.
+ */
+GraphicsOpenGLSurfaceBuffers::~GraphicsOpenGLSurfaceBuffers()
+{
+    deleteBuffers();
+}
+
+/**
+ * @return A new buffer object in the current OpenGL context or NULL
+ * if a buffer could not be created.
+ */
+GraphicsOpenGLBufferObject*
+GraphicsOpenGLSurfaceBuffers::createBufferObject()
+{
+    EventGraphicsOpenGLCreateBufferObject createEvent;
+    EventManager::get()->sendEvent(createEvent.getPointer());
+    GraphicsOpenGLBufferObject* bufferObject = createEvent.getOpenGLBufferObject();
+    if (bufferObject != NULL) {
+        if (bufferObject->getBufferObjectName() == 0) {
+            delete bufferObject;
+            bufferObject = NULL;
+        }
+    }
+    return bufferObject;
+}
+
+/**
+ * Release all buffers.  Deletion of the OpenGL buffers is deferred
+ * until their context is current.
+ */
+void
+GraphicsOpenGLSurfaceBuffers::deleteBuffers()
+{
+    m_coordinateBufferObject.reset();
+    m_normalVectorBufferObject.reset();
+    m_triangleBufferObject.reset();
+    m_colorBuffers.clear();
+    m_levelOfDetailTriangleBuffers.clear();
+    m_geometryModificationCount = -1;
+    m_numberOfVertices = 0;
+    m_numberOfTriangleIndices = 0;
+}
+
+/**
+ * Load the coordinates, normal vectors, and triangles, unless the buffers already
+ * contain this geometry.  Must be called with an OpenGL context current.
+ *
+ * @param openglContextPointer
+ *     Pointer to the current OpenGL context sharing group.
+ * @param geometryModificationCount
+ *     Count that the owner changes whenever the coordinates, normals, or triangles change.
+ * @param xyz
+ *     The coordinates, three per vertex.
+ * @param normalXYZ
+ *     The normal vectors, three per vertex.
+ * @param numberOfVertices
+ *     Number of vertices.
+ * @param triangleVertices
+ *     Vertex indices, three per triangle.
+ * @param numberOfTriangles
+ *     Number of triangles.
+ * @return
+ *     True if the buffers are ready for drawing, false if they could not be
+ *     created and the caller should draw from client memory.
+ */
+bool
+GraphicsOpenGLSurfaceBuffers::loadGeometry(void* openglContextPointer,
+                                           const int64_t geometryModificationCount,
+                                           const float* xyz,
+                                           const float* normalXYZ,
+                                           const int32_t numberOfVertices,
+                                           const int32_t* triangleVertices,
+                                           const int32_t numberOfTriangles)
+{
+    if (openglContextPointer == NULL) {
+        return false;
+    }
+    if (openglContextPointer != m_openglContextPointer) {
+        deleteBuffers();
+        m_openglContextPointer = openglContextPointer;
+    }
+
+    if ((numberOfVertices <= 0)
+        || (numberOfTriangles <= 0)) {
+        return false;
+    }
+
+    if ((m_triangleBufferObject != NULL)
+        && (geometryModificationCount == m_geometryModificationCount)
+        && (numberOfVertices == m_numberOfVertices)
+        && ((numberOfTriangles * 3) == m_numberOfTriangleIndices)) {
+        return true;
+    }
+
+    if (m_coordinateBufferObject == NULL) {
+        m_coordinateBufferObject.reset(createBufferObject());
+    }
+    if (m_normalVectorBufferObject == NULL) {
+        m_normalVectorBufferObject.reset(createBufferObject());
+    }
+    if (m_triangleBufferObject == NULL) {
+        m_triangleBufferObject.reset(createBufferObject());
+    }
+    if ((m_coordinateBufferObject == NULL)
+        || (m_normalVectorBufferObject == NULL)
+        || (m_triangleBufferObject == NULL)) {
+        deleteBuffers();
+        return false;
+    }
+
+    /*
+     * Colors are per vertex so any with a different vertex count are useless
+     */
+    if (numberOfVertices != m_numberOfVertices) {
+        m_colorBuffers.clear();
+    }
+    
+    /*
+     * Levels of detail are created from the geometry
+     */
+    m_levelOfDetailTriangleBuffers.clear();
+
+    const GLsizeiptr vertexSizeBytes = numberOfVertices * 3 * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_coordinateBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 vertexSizeBytes,
+                 reinterpret_cast<const GLvoid*>(xyz),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_normalVectorBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 vertexSizeBytes,
+                 reinterpret_cast<const GLvoid*>(normalXYZ),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 m_triangleBufferObject->getBufferObjectName());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 numberOfTriangles * 3 * sizeof(int32_t),
+                 reinterpret_cast<const GLvoid*>(triangleVertices),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    m_geometryModificationCount = geometryModificationCount;
+    m_numberOfVertices          = numberOfVertices;
+    m_numberOfTriangleIndices   = numberOfTriangles * 3;
+
+    return true;
+}
+
+/**
+ * Load a per-vertex coloring, unless a buffer already contains it.
+ * Must be called after a successful loadGeometry().
+ *
+ * @param rgba
+ *     The coloring, four per vertex.  The address identifies the coloring
+ *     so it should be memory owned by the surface, such as a tab's coloring.
+ * @param coloringModificationCount
+ *     Count that the owner changes whenever any of its colorings change.
+ * @return
+ *     True if the coloring buffer is ready for drawing, else false.
+ */
+bool
+GraphicsOpenGLSurfaceBuffers::loadColors(const float* rgba,
+                                         const int64_t coloringModificationCount)
+{
+    if ((rgba == NULL)
+        || (m_numberOfVertices <= 0)) {
+        return false;
+    }
+
+    std::map<const float*, ColorBuffer>::iterator iter = m_colorBuffers.find(rgba);
+    if (iter == m_colorBuffers.end()) {
+        /*
+         * Addresses of invalidated colorings are never seen again, so
+         * start over rather than let them accumulate
+         */
+        const int32_t maximumNumberOfColorBuffers = 64;
+        if (static_cast<int32_t>(m_colorBuffers.size()) >= maximumNumberOfColorBuffers) {
+            m_colorBuffers.clear();
+        }
+        iter = m_colorBuffers.insert(std::make_pair(rgba, ColorBuffer())).first;
+    }
+
+    ColorBuffer& colorBuffer = iter->second;
+    if ((colorBuffer.m_bufferObject != NULL)
+        && (colorBuffer.m_modificationCount == coloringModificationCount)) {
+        return true;
+    }
+
+    if (colorBuffer.m_bufferObject == NULL) {
+        colorBuffer.m_bufferObject.reset(createBufferObject());
+        if (colorBuffer.m_bufferObject == NULL) {
+            m_colorBuffers.erase(iter);
+            return false;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 colorBuffer.m_bufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 m_numberOfVertices * 4 * sizeof(float),
+                 reinterpret_cast<const GLvoid*>(rgba),
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    colorBuffer.m_modificationCount = coloringModificationCount;
+
+    return true;
+}
+
+/**
+ * Load the triangles of a level of detail, unless a buffer already contains
+ * them.  Must be called after a successful loadGeometry() and the triangles
+ * must be for the loaded geometry.
+ *
+ * @param levelIndex
+ *     Index of the level.
+ * @param triangleVertices
+ *     Vertex indices, three per triangle.
+ * @param numberOfTriangles
+ *     Number of triangles.
+ * @return
+ *     True if the level is ready for drawing, else false.
+ */
+bool
+GraphicsOpenGLSurfaceBuffers::loadLevelOfDetailTriangles(const int32_t levelIndex,
+                                                         const int32_t* triangleVertices,
+                                                         const int32_t numberOfTriangles)
+{
+    CaretAssert(levelIndex >= 0);
+    if ((m_triangleBufferObject == NULL)
+        || (numberOfTriangles <= 0)) {
+        return false;
+    }
+    
+    if (levelIndex >= static_cast<int32_t>(m_levelOfDetailTriangleBuffers.size())) {
+        m_levelOfDetailTriangleBuffers.resize(levelIndex + 1);
+    }
+    
+    TriangleBuffer& triangleBuffer = m_levelOfDetailTriangleBuffers[levelIndex];
+    if (triangleBuffer.m_bufferObject != NULL) {
+        return true;
+    }
+    
+    triangleBuffer.m_bufferObject.reset(createBufferObject());
+    if (triangleBuffer.m_bufferObject == NULL) {
+        return false;
+    }
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 triangleBuffer.m_bufferObject->getBufferObjectName());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 numberOfTriangles * 3 * sizeof(int32_t),
+                 reinterpret_cast<const GLvoid*>(triangleVertices),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    triangleBuffer.m_numberOfTriangleIndices = numberOfTriangles * 3;
+    
+    return true;
+}
+
+/**
+ * Draw the triangles from the buffers.  The geometry and, when not NULL,
+ * the coloring must have been loaded.
+ *
+ * @param rgba
+ *     Coloring previously passed to loadColors().  If NULL, the vertices are
+ *     drawn with the current OpenGL color.
+ * @param levelIndex
+ *     Level of detail previously passed to loadLevelOfDetailTriangles() or
+ *     negative to draw the full resolution triangles.
+ */
+void
+GraphicsOpenGLSurfaceBuffers::drawTriangles(const float* rgba,
+                                            const int32_t levelIndex)
+{
+    CaretAssert(m_triangleBufferObject);
+    
+    GLuint triangleBufferName = m_triangleBufferObject->getBufferObjectName();
+    GLsizei numberOfTriangleIndices = m_numberOfTriangleIndices;
+    if (levelIndex >= 0) {
+        CaretAssertVectorIndex(m_levelOfDetailTriangleBuffers, levelIndex);
+        const TriangleBuffer& triangleBuffer = m_levelOfDetailTriangleBuffers[levelIndex];
+        CaretAssert(triangleBuffer.m_bufferObject);
+        triangleBufferName      = triangleBuffer.m_bufferObject->getBufferObjectName();
+        numberOfTriangleIndices = triangleBuffer.m_numberOfTriangleIndices;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_coordinateBufferObject->getBufferObjectName());
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_normalVectorBufferObject->getBufferObjectName());
+    glNormalPointer(GL_FLOAT, 0, 0);
+
+    if (rgba != NULL) {
+        std::map<const float*, ColorBuffer>::const_iterator iter = m_colorBuffers.find(rgba);
+        CaretAssert(iter != m_colorBuffers.end());
+        if (iter != m_colorBuffers.end()) {
+            glEnableClientState(GL_COLOR_ARRAY);
+            glBindBuffer(GL_ARRAY_BUFFER,
+                         iter->second.m_bufferObject->getBufferObjectName());
+            glColorPointer(4, GL_FLOAT, 0, 0);
+        }
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 triangleBufferName);
+    glDrawElements(GL_TRIANGLES,
+                   numberOfTriangleIndices,
+                   GL_UNSIGNED_INT,
+                   0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+GraphicsOpenGLSurfaceBuffers::toString() const
+{
+    return "GraphicsOpenGLSurfaceBuffers";
+}
+
@@ -0,0 +1,122 @@
+#ifndef __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_H__
+#define __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "CaretObject.h"
+#include "CaretOpenGLInclude.h"
+
+namespace caret {
+
+    class GraphicsOpenGLBufferObject;
+
+    class GraphicsOpenGLSurfaceBuffers : public CaretObject {
+
+    public:
+        GraphicsOpenGLSurfaceBuffers();
+
+        virtual ~GraphicsOpenGLSurfaceBuffers();
+
+        bool loadGeometry(void* openglContextPointer,
+                          const int64_t geometryModificationCount,
+                          const float* xyz,
+                          const float* normalXYZ,
+                          const int32_t numberOfVertices,
+                          const int32_t* triangleVertices,
+                          const int32_t numberOfTriangles);
+
+        bool loadColors(const float* rgba,
+                        const int64_t coloringModificationCount);
+
+        bool loadLevelOfDetailTriangles(const int32_t levelIndex,
+                                        const int32_t* triangleVertices,
+                                        const int32_t numberOfTriangles);
+
+        void drawTriangles(const float* rgba,
+                           const int32_t levelIndex);
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+    private:
+        GraphicsOpenGLSurfaceBuffers(const GraphicsOpenGLSurfaceBuffers&);
+
+        GraphicsOpenGLSurfaceBuffers& operator=(const GraphicsOpenGLSurfaceBuffers&);
+
+        /**
+         * A color buffer and the coloring modification count at which it was loaded.
+         */
+        class ColorBuffer {
+        public:
+            std::unique_ptr<GraphicsOpenGLBufferObject> m_bufferObject;
+
+            int64_t m_modificationCount = -1;
+        };
+
+        /**
+         * Triangles of a level of detail.
+         */
+        class TriangleBuffer {
+        public:
+            std::unique_ptr<GraphicsOpenGLBufferObject> m_bufferObject;
+
+            GLsizei m_numberOfTriangleIndices = 0;
+        };
+
+        static GraphicsOpenGLBufferObject* createBufferObject();
+
+        void deleteBuffers();
+
+        void* m_openglContextPointer = NULL;
+
+        int64_t m_geometryModificationCount = -1;
+
+        int32_t m_numberOfVertices = 0;
+
+        GLsizei m_numberOfTriangleIndices = 0;
+
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_coordinateBufferObject;
+
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_normalVectorBufferObject;
+
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_triangleBufferObject;
+
+        /** keyed by the coloring array, each tab and model type has its own */
+        std::map<const float*, ColorBuffer> m_colorBuffers;
+
+        /** indexed by level, each is only valid for the geometry that is loaded */
+        std::vector<TriangleBuffer> m_levelOfDetailTriangleBuffers;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_DECLARE__
+
+} // namespace
+#endif  //__GRAPHICS_OPEN_G_L_SURFACE_BUFFERS_H__
@@ -131,6 +131,7 @@ GraphicsPrimitive::copyHelperGraphicsPrimitive(const GraphicsPrimitive& obj)
     m_textureImageBytesRGBA       = obj.m_textureImageBytesRGBA;
     m_textureImageWidth           = obj.m_textureImageWidth;
     m_textureImageHeight          = obj.m_textureImageHeight;
+    m_textureEnvironmentMode      = obj.m_textureEnvironmentMode;
 
     m_graphicsEngineDataForOpenGL.reset();
 }
@@ -283,6 +284,31 @@ GraphicsPrimitive::setUsageTypeTextureCoordinates(const UsageType usageType)
     m_usageTypeTextureCoordinates = usageType;
 }
 
+/**
+ * @return How the texture is combined with the color.
+ */
+GraphicsPrimitive::TextureEnvironmentMode
+GraphicsPrimitive::getTextureEnvironmentMode() const
+{
+    return m_textureEnvironmentMode;
+}
+
+/**
+ * Set how the texture is combined with the color.  The default,
+ * REPLACE, ignores the color.  With MODULATE, the texture is
+ * multiplied by the current color (primitive has no colors),
+ * so one texture, such as a white image with alpha, may be
+ * drawn in any color.
+ *
+ * @param textureEnvironmentMode
+ *     New value for texture environment mode.
+ */
+void
+GraphicsPrimitive::setTextureEnvironmentMode(const TextureEnvironmentMode textureEnvironmentMode)
+{
+    m_textureEnvironmentMode = textureEnvironmentMode;
+}
+
 /**
  * @return Is this graphics primitive valid.
  * Primitive is valid if all of these conditions are met
@@ -910,6 +936,36 @@ GraphicsPrimitive::replaceFloatXYZ(const std::vector<float>& xyz)
     m_boundingBoxValid = false;
 }
 
+/**
+ * Replace all vertices with the given XYZ coordinates and
+ * texture coordinates.  The number of vertices may change.
+ * Only valid for primitives without normal vectors and colors.
+ *
+ * @param xyz
+ *     The new XYZ coordinates.
+ * @param textureSTR
+ *     The new STR texture coordinates.
+ */
+void
+GraphicsPrimitive::replaceVerticesProtected(const std::vector<float>& xyz,
+                                            const std::vector<float>& textureSTR)
+{
+    CaretAssert(m_normalVectorDataType == NormalVectorDataType::NONE);
+    CaretAssert(m_colorDataType == ColorDataType::NONE);
+    CaretAssert(m_textureDataType == TextureDataType::FLOAT_STR);
+    CaretAssert(xyz.size() == textureSTR.size());
+    
+    m_xyz = xyz;
+    m_floatTextureSTR = textureSTR;
+    
+    if (m_graphicsEngineDataForOpenGL != NULL) {
+        m_graphicsEngineDataForOpenGL->invalidateCoordinates();
+        m_graphicsEngineDataForOpenGL->invalidateTextureCoordinates();
+    }
+    
+    m_boundingBoxValid = false;
+}
+
 /**
  * Replace the XYZ coordinate at the given index
  *
@@ -1517,6 +1573,10 @@ GraphicsPrimitive::setTextureImage(const uint8_t* imageBytesRGBA,
         m_textureImageBytesRGBA.insert(m_textureImageBytesRGBA.end(),
                                        imageBytesRGBA, imageBytesRGBA + numBytes);
     }
+    
+    if (m_graphicsEngineDataForOpenGL != NULL) {
+        m_graphicsEngineDataForOpenGL->invalidateTextureImage();
+    }
 }
 
 /**
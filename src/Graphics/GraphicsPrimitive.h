@@ -276,6 +276,16 @@ namespace caret {
             MODIFIED_MANY_DRAWN_MANY_TIMES
         };
         
+        /**
+         * How the texture is combined with the color
+         */
+        enum class TextureEnvironmentMode {
+            /** Texture replaces the color (like OpenGL GL_REPLACE) */
+            REPLACE,
+            /** Texture is multiplied by the current color (like OpenGL GL_MODULATE) */
+            MODULATE
+        };
+        
     protected:
         GraphicsPrimitive(const VertexDataType       vertexDataType,
                           const NormalVectorDataType normalVectorDataType,
@@ -330,6 +340,10 @@ namespace caret {
         
         void setUsageTypeTextureCoordinates(const UsageType usage);
         
+        TextureEnvironmentMode getTextureEnvironmentMode() const;
+        
+        void setTextureEnvironmentMode(const TextureEnvironmentMode textureEnvironmentMode);
+        
         virtual void receiveEvent(Event* event);
         
         bool isValid() const;
@@ -446,6 +460,9 @@ namespace caret {
                                 const uint8_t rgbaByte[4],
                                 const float textureSTR[3]);
         
+        void replaceVerticesProtected(const std::vector<float>& xyz,
+                                      const std::vector<float>& textureSTR);
+        
         AString getPrimitiveTypeAsText() const;
         
         AString getLineWidthTypeAsText(const LineWidthType lineWidthType) const;
@@ -478,6 +495,8 @@ namespace caret {
         
         UsageType m_usageTypeTextureCoordinates = UsageType::MODIFIED_ONCE_DRAWN_FEW_TIMES;
         
+        TextureEnvironmentMode m_textureEnvironmentMode = TextureEnvironmentMode::REPLACE;
+        
         std::unique_ptr<GraphicsEngineDataOpenGL> m_graphicsEngineDataForOpenGL;
         
         int32_t m_textureImageWidth = -1;
@@ -159,6 +159,43 @@ GraphicsPrimitiveV3fT3f::addVertex(const float x,
     addVertex(x, y, 0.0f, s, t);
 }
 
+/**
+ * Replace all vertices.  Useful when a primitive's texture is
+ * reused for drawing different vertices.
+ *
+ * @param xyz
+ *     XYZ-coordinates of the vertices.
+ * @param textureSTR
+ *     STR texture coordinates of the vertices.
+ */
+void
+GraphicsPrimitiveV3fT3f::replaceVertices(const std::vector<float>& xyz,
+                                         const std::vector<float>& textureSTR)
+{
+    replaceVerticesProtected(xyz,
+                             textureSTR);
+}
+
+/**
+ * Replace the texture image.
+ *
+ * @param imageBytesRGBA
+ *     Bytes containing the image data.
+ * @param imageWidth
+ *     Width of the actual image.
+ * @param imageHeight
+ *     Height of the image.
+ */
+void
+GraphicsPrimitiveV3fT3f::replaceTextureImage(const uint8_t* imageBytesRGBA,
+                                             const int32_t imageWidth,
+                                             const int32_t imageHeight)
+{
+    setTextureImage(imageBytesRGBA,
+                    imageWidth,
+                    imageHeight);
+}
+
 /**
  * Clone this primitive.
  */
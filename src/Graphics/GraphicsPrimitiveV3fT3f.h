@@ -57,6 +57,13 @@ namespace caret {
                        const float s,
                        const float t);
 
+        void replaceVertices(const std::vector<float>& xyz,
+                             const std::vector<float>& textureSTR);
+        
+        void replaceTextureImage(const uint8_t* imageBytesRGBA,
+                                 const int32_t imageWidth,
+                                 const int32_t imageHeight);
+
         virtual GraphicsPrimitive* clone() const;
         
         // ADD_NEW_METHODS_HERE
@@ -81,6 +81,7 @@
 #include "EventUserInterfaceUpdate.h"
 #include "FileInformation.h"
 #include "FociProjectionDialog.h"
+#include "FrameProfiler.h"
 #include "GapsAndMargins.h"
 #include "GuiManager.h"
 #include "LockAspectWarningDialog.h"
@@ -1493,6 +1494,13 @@ BrainBrowserWindow::createActions()
                                 this,
                                 SLOT(processDevelopGraphicsTiming()));
     
+    m_developerFrameProfileTraceAction =
+    WuQtUtilities::createAction("Save Frame Profile Trace...",
+                                "Save the frame profiler's timings as a Chrome trace file (chrome://tracing)",
+                                this,
+                                this,
+                                SLOT(processDevelopSaveFrameProfileTrace()));
+    
     m_developerExportVtkFileAction = 
     WuQtUtilities::createAction("Export to VTK File",
                                 "Export model(s) to VTK File",
@@ -1565,6 +1573,7 @@ BrainBrowserWindow::createMenuDevelop()
     m_developerExportVtkFileAction->setVisible(false);
     
     menu->addAction(m_developerGraphicsTimingAction);
+    menu->addAction(m_developerFrameProfileTraceAction);
     
     std::vector<DeveloperFlagsEnum::Enum> developerFlags;
     DeveloperFlagsEnum::getAllEnums(developerFlags);
@@ -1621,6 +1630,8 @@ BrainBrowserWindow::developerMenuAboutToShow()
                            + action->text());
         }
     }
+    
+    m_developerFrameProfileTraceAction->setEnabled(FrameProfiler::isEnabled());
 }
 
 /**
@@ -1640,6 +1651,10 @@ BrainBrowserWindow::developerMenuFlagTriggered(QAction* action)
     if (valid) {
         DeveloperFlagsEnum::setFlag(enumValue,
                                     action->isChecked());
+        
+        if (enumValue == DeveloperFlagsEnum::DEVELOPER_FLAG_FRAME_PROFILER) {
+            FrameProfiler::setEnabled(action->isChecked());
+        }
 
         /*
          * Update graphics and GUI
@@ -2887,6 +2902,46 @@ BrainBrowserWindow::processDevelopGraphicsTiming()
     WuQMessageBox::informationOk(this, msg);
 }
 
+/**
+ * Save the frame profiler's timings as a Chrome trace file.
+ */
+void
+BrainBrowserWindow::processDevelopSaveFrameProfileTrace()
+{
+    static QString previousTraceFileName = "";
+    
+    const QString traceFileFilter = "Chrome Trace File (*.json)";
+    
+    CaretFileDialog cfd(this,
+                        "Save Frame Profile Trace",
+                        GuiManager::get()->getBrain()->getCurrentDirectory(),
+                        traceFileFilter);
+    cfd.selectNameFilter(traceFileFilter);
+    cfd.setAcceptMode(QFileDialog::AcceptSave);
+    cfd.setFileMode(CaretFileDialog::AnyFile);
+    if ( ! previousTraceFileName.isEmpty()) {
+        cfd.selectFile(previousTraceFileName);
+    }
+    
+    if (cfd.exec() == CaretFileDialog::Accepted) {
+        QStringList selectedFiles = cfd.selectedFiles();
+        if (selectedFiles.size() > 0) {
+            const QString traceFileName = selectedFiles[0];
+            if ( ! traceFileName.isEmpty()) {
+                try {
+                    previousTraceFileName = traceFileName;
+                    
+                    FrameProfiler::get()->writeChromeTrace(traceFileName);
+                }
+                catch (const DataFileException& dfe) {
+                    WuQMessageBox::errorOk(this,
+                                           dfe.whatString());
+                }
+            }
+        }
+    }
+}
+
 
 /**
  * Export to VTK file.
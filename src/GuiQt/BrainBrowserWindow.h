@@ -228,6 +228,8 @@ namespace caret {
         
         void processDevelopGraphicsTiming();
         
+        void processDevelopSaveFrameProfileTrace();
+        
         void processDevelopExportVtkFile();
         void developerMenuAboutToShow();
         void developerMenuFlagTriggered(QAction*);
@@ -412,6 +414,7 @@ namespace caret {
         QAction* m_developMenuAction;
         QActionGroup* m_developerFlagsActionGroup;
         QAction* m_developerGraphicsTimingAction;
+        QAction* m_developerFrameProfileTraceAction;
         QAction* m_developerExportVtkFileAction;
         
         QAction* m_macroMenuAction;
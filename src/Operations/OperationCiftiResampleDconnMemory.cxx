@@ -28,6 +28,8 @@
 #include "SurfaceFile.h"
 #include "WarpfieldFile.h"
 
+#include <QDir>
+
 using namespace caret;
 using namespace std;
 
@@ -114,11 +116,20 @@ OperationParameters* OperationCiftiResampleDconnMemory::getParameters()
     cerebAreaMetricsOpt->addMetricParameter(1, "current-area", "a metric file with vertex areas for the current mesh");
     cerebAreaMetricsOpt->addMetricParameter(2, "new-area", "a metric file with vertex areas for the new mesh");
     
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(16, "-mem-limit", "stream the data through temporary files instead of keeping the intermediate in memory");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "approximate memory to use for matrix data, in gigabytes");
+    OptionalParameter* tempDirOpt = memLimitOpt->createOptionalParameter(2, "-temp-dir", "specify where to put the temporary files");
+    tempDirOpt->addStringParameter(1, "directory", "the directory to use, default is the system temporary directory");
+    
     AString myHelpText =
         AString("This command does the same thing as running -cifti-resample twice, but uses memory up to approximately 2x the size that the intermediate file would be.  ") +
         "This is because the intermediate dconn is kept in memory, rather than written to disk, " +
         "and the components before and after resampling/dilation have to be in memory at the same time during the relevant computation.  " +
         "The <template-direction> argument should usually be COLUMN, as dtseries, dscalar, and dlabel all have brainordinates on that direction.  " +
+        "When -mem-limit is specified, the input rows are instead resampled into a temporary file stored in blocks of columns, each block is then read with one " +
+        "large sequential read and its columns resampled, and the output rows are assembled from a second temporary file, so that memory use stays near the given limit " +
+        "and the input and output are never entirely in memory.  " +
+        "This needs free disk space of about the size of the intermediate plus the size of the output, in float32.  " +
         "If spheres are not specified for a surface structure which exists in the cifti files, its data is copied without resampling or dilation.  " +
         "Dilation is done with the 'nearest' method, and is done on <new-sphere> for surface data.  " +
         "Volume components are padded before dilation so that dilation doesn't run into the edge of the component bounding box.\n\n" +
@@ -396,6 +407,27 @@ void OperationCiftiResampleDconnMemory::useParameters(OperationParameters* myPar
     {
         throw OperationException(message);
     }
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(16);
+    if (memLimitOpt->m_present)
+    {
+        double limitGB = memLimitOpt->getDouble(1);
+        if (limitGB <= 0.0) throw OperationException("memory limit must be positive");
+        AString tempDir = QDir::tempPath();
+        OptionalParameter* tempDirOpt = memLimitOpt->getOptionalParameter(2);
+        if (tempDirOpt->m_present)
+        {
+            tempDir = tempDirOpt->getString(1);
+        }
+        int64_t memLimitBytes = (int64_t)(limitGB * 1024.0 * 1024.0 * 1024.0);
+        AlgorithmCiftiResample::resampleBothStreaming(myCiftiIn, myTemplate, templateDir, mySurfMethod, myVolMethod, myCiftiOut, surfLargest, voldilatemm, surfdilatemm,
+                                                      (warpfieldOpt->m_present ? NULL : &(myAffine.getMatrix())), (warpfieldOpt->m_present ? myWarpfield.getWarpfield() : NULL),
+                                                      curLeftSphere, newLeftSphere, curLeftAreas, newLeftAreas,
+                                                      curRightSphere, newRightSphere, curRightAreas, newRightAreas,
+                                                      curCerebSphere, newCerebSphere, curCerebAreas, newCerebAreas,
+                                                      volDilateMethod, volDilateExponent, surfDilateMethod, surfDilateExponent,
+                                                      memLimitBytes, tempDir);
+        return;
+    }
     CiftiFile tempCifti;
     //TSC: resampling along column first causes it to hit peak memory usage earlier
     if (warpfieldOpt->m_present)
@@ -21,6 +21,9 @@
 
 #include <cstdio>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <new>
 
 #ifdef HAVE_GLEW
 #include <GL/glew.h>
@@ -30,8 +33,14 @@
 #include <GL/osmesa.h>
 #endif // HAVE_OSMESA
 
-#include <QImage>
 #include <QColor>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QProcess>
+#include <QTemporaryFile>
+#include <QTextStream>
 
 
 #include "Brain.h"
@@ -48,6 +57,7 @@
 #include "EventMapYokingSelectMap.h"
 #include "EventManager.h"
 #include "FileInformation.h"
+#include "FrameProfiler.h"
 #include "DummyFontTextRenderer.h"
 #include "FtglFontTextRenderer.h"
 #include "ImageFile.h"
@@ -124,6 +134,27 @@ OperationShowScene::getParameters()
     connDbOpt->addStringParameter(1, "Username", "Connectome DB Username");
     connDbOpt->addStringParameter(2, "Password", "Connectome DB Password");
     
+    const QString sceneListSwitch("-scene-list");
+    OptionalParameter* sceneListOpt = ret->createOptionalParameter(10, sceneListSwitch, "Render additional scenes listed in a text file");
+    sceneListOpt->addStringParameter(1, "list-file", "text file listing the scenes and their image files");
+    
+    const QString mapSweepSwitch("-map-sweep");
+    OptionalParameter* mapSweepOpt = ret->createOptionalParameter(11, mapSweepSwitch, "Render each scene once for each map in a range of a map yoking group");
+    mapSweepOpt->addStringParameter(1, "Map Yoking Roman Numeral", "Roman numeral identifying the map yoking group (I, II, III, IV, V, VI, VII, VIII, IX, X)");
+    mapSweepOpt->addIntegerParameter(2, "First Map Index", "First map index for yoking group.  Indices start at 1 (one)");
+    mapSweepOpt->addIntegerParameter(3, "Last Map Index", "Last map index for yoking group.  Indices start at 1 (one)");
+    
+    const QString processesSwitch("-processes");
+    OptionalParameter* processesOpt = ret->createOptionalParameter(12, processesSwitch, "Divide the scenes among processes that render in parallel");
+    processesOpt->addIntegerParameter(1, "Number of Processes", "number of processes");
+    
+    const QString profileSwitch("-profile");
+    ret->createOptionalParameter(13, profileSwitch, "Print the time spent in each stage of drawing");
+    
+    const QString profileTraceSwitch("-profile-trace");
+    OptionalParameter* profileTraceOpt = ret->createOptionalParameter(14, profileTraceSwitch, "Write the time of each stage of drawing to a trace file");
+    profileTraceOpt->addStringParameter(1, "trace-file", "output Chrome trace file (.json)");
+    
     AString helpText("Render content of browser windows displayed in a scene "
                      "into image file(s).  The image file name should be "
                      "similar to \"capture.png\".  If there is only one image "
@@ -170,6 +201,37 @@ OperationShowScene::getParameters()
                  "      output image.\n"
                  );
     
+    helpText += ("\n"
+                 "Many scenes may be rendered by one command using the\n"
+                 "\"" + sceneListSwitch + "\" option, which is much faster than a\n"
+                 "command for each scene since files that are used by more\n"
+                 "than one scene are read only once.  Each line in the list\n"
+                 "file contains a scene file name, a scene name or number,\n"
+                 "and an image file name, separated by tabs.  Empty lines and\n"
+                 "lines starting with '#' are ignored.  The listed scenes are\n"
+                 "rendered after the scene specified by the parameters.  With\n"
+                 "the \"" + processesSwitch + "\" option, the scenes are divided into\n"
+                 "groups of consecutive scenes and each group is rendered by\n"
+                 "a separate process.\n"
+                 "\n"
+                 "The \"" + mapSweepSwitch + "\" option renders each scene once for\n"
+                 "each map in the range with the map selected in the map\n"
+                 "yoking group.  The map number is inserted into the image\n"
+                 "name: \"capture_map1.png\", \"capture_map2.png\" etc.\n"
+                 );
+    
+    helpText += ("\n"
+                 "The \"" + profileSwitch + "\" option prints, after all scenes are\n"
+                 "rendered, the number of times, total, mean, and maximum\n"
+                 "time of each stage of drawing, such as coloring surfaces\n"
+                 "and drawing volume slices.  The \"" + profileTraceSwitch + "\" option\n"
+                 "writes the time of every stage to a file that may be viewed\n"
+                 "in the Chrome web browser at \"chrome://tracing\".  When\n"
+                 "scenes are rendered by more than one process, each process\n"
+                 "prints its own times and the process number is inserted\n"
+                 "into the trace file name: \"trace_1.json\", \"trace_2.json\" etc.\n"
+                 );
+    
     
     ret->setHelpText(helpText);
     
@@ -188,51 +250,183 @@ OperationShowScene::useParameters(OperationParameters* /*myParams*/,
                              "not being built with the Mesa OffScreen Library");
 }
 #else // HAVE_OSMESA
+
+namespace caret {
+    /**
+     * An OSMesa context and the image buffer into which it renders,
+     * reused for all images so that the context and the OpenGL
+     * resources created for drawing are only created once.
+     */
+    class OperationShowScene::OffscreenContext {
+    public:
+        OffscreenContext() { }
+        
+        ~OffscreenContext() {
+            /*
+             * OpenGL must be destroyed before the context since
+             * buffers and textures are deleted by OpenGL
+             */
+            m_brainOpenGL.reset();
+            if (m_mesaContext != 0) {
+                OSMesaDestroyContext(m_mesaContext);
+            }
+        }
+        
+        /**
+         * Make the context current for rendering an image of the given size.
+         *
+         * @return The image buffer, valid until the next call.
+         */
+        unsigned char* makeCurrent(const int32_t imageWidth,
+                                   const int32_t imageHeight) {
+            if (m_mesaContext == 0) {
+                const int depthBits = 16;
+                const int stencilBits = 0;
+                const int accumBits = 0;
+                m_mesaContext = OSMesaCreateContextExt(OSMESA_RGBA,
+                                                       depthBits,
+                                                       stencilBits,
+                                                       accumBits,
+                                                       NULL);
+                if (m_mesaContext == 0) {
+                    throw OperationException("Creating Mesa Context failed.");
+                }
+            }
+            
+            const int64_t imageBufferSize = static_cast<int64_t>(imageWidth) * imageHeight * 4;
+            if ((imageWidth != m_imageWidth)
+                || (imageHeight != m_imageHeight)) {
+                try {
+                    m_imageBuffer.resize(imageBufferSize);
+                }
+                catch (const std::bad_alloc&) {
+                    throw OperationException("Allocating image buffer size="
+                                             + QString::number(imageBufferSize)
+                                             + " failed.");
+                }
+                
+                if (OSMesaMakeCurrent(m_mesaContext,
+                                      &m_imageBuffer[0],
+                                      GL_UNSIGNED_BYTE,
+                                      imageWidth,
+                                      imageHeight) == 0) {
+                    throw OperationException("Assigning buffer to context and make current failed.");
+                }
+                m_imageWidth  = imageWidth;
+                m_imageHeight = imageHeight;
+            }
+            
+            if (m_brainOpenGL == NULL) {
+                m_brainOpenGL.reset(createBrainOpenGL());
+            }
+            
+            return &m_imageBuffer[0];
+        }
+        
+        OSMesaContext m_mesaContext = 0;
+        
+        std::vector<unsigned char> m_imageBuffer;
+        
+        int32_t m_imageWidth = -1;
+        
+        int32_t m_imageHeight = -1;
+        
+        std::unique_ptr<BrainOpenGL> m_brainOpenGL;
+    };
+}
+
 void
 OperationShowScene::useParameters(OperationParameters* myParams,
                                   ProgressObject* myProgObj)
 {
     LevelProgress myProgress(myProgObj);
-    AString sceneFileName = FileInformation(myParams->getString(1)).getAbsoluteFilePath();
-    AString sceneNameOrNumber = myParams->getString(2);
-    AString imageFileName = FileInformation(myParams->getString(3)).getAbsoluteFilePath();
-    const int32_t userImageWidth  = myParams->getInteger(4);
-    const int32_t userImageHeight = myParams->getInteger(5);
+    SceneImage firstSceneImage;
+    firstSceneImage.m_sceneFileName = FileInformation(myParams->getString(1)).getAbsoluteFilePath();
+    firstSceneImage.m_sceneNameOrNumber = myParams->getString(2);
+    firstSceneImage.m_imageFileName = FileInformation(myParams->getString(3)).getAbsoluteFilePath();
+    
+    RenderOptions renderOptions;
+    renderOptions.m_imageWidth  = myParams->getInteger(4);
+    renderOptions.m_imageHeight = myParams->getInteger(5);
     
     OptionalParameter* useWindowSizeParam = myParams->getOptionalParameter(6);
-    const bool useWindowSizeForImageSizeFlag = useWindowSizeParam->m_present;
+    renderOptions.m_useWindowSizeSwitch = useWindowSizeParam->m_optionSwitch;
+    renderOptions.m_useWindowSizeForImageSizeFlag = useWindowSizeParam->m_present;
     
-    const bool doNotUseSceneColorsFlag = myParams->getOptionalParameter(7)->m_present;
+    renderOptions.m_doNotUseSceneColorsFlag = myParams->getOptionalParameter(7)->m_present;
+    
+    /*
+     * Options passed to child processes
+     */
+    QStringList commonArguments;
+    commonArguments << QString::number(renderOptions.m_imageWidth)
+                    << QString::number(renderOptions.m_imageHeight);
+    if (renderOptions.m_useWindowSizeForImageSizeFlag) {
+        commonArguments << useWindowSizeParam->m_optionSwitch;
+    }
+    if (renderOptions.m_doNotUseSceneColorsFlag) {
+        commonArguments << myParams->getOptionalParameter(7)->m_optionSwitch;
+    }
     
-    MapYokingGroupEnum::Enum mapYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
-    int32_t mapYokingMapIndex = -1;
     OptionalParameter* mapYokeOpt = myParams->getOptionalParameter(8);
     if (mapYokeOpt->m_present) {
         const AString romanNumeral = mapYokeOpt->getString(1);
         bool validFlag = false;
-        mapYokingGroup = MapYokingGroupEnum::fromGuiName(romanNumeral, &validFlag);
+        renderOptions.m_mapYokingGroup = MapYokingGroupEnum::fromGuiName(romanNumeral, &validFlag);
         if ( ! validFlag) {
             throw OperationException(romanNumeral
                                      + " does not identify a valid Map Yoking Group.  ");
         }
-        mapYokingMapIndex = mapYokeOpt->getInteger(2);
-        if (mapYokingMapIndex < 1) {
+        renderOptions.m_mapYokingMapIndex = mapYokeOpt->getInteger(2);
+        if (renderOptions.m_mapYokingMapIndex < 1) {
             throw OperationException("Map yoking map index must be one or greater.");
         }
+        commonArguments << mapYokeOpt->m_optionSwitch
+                        << romanNumeral
+                        << QString::number(renderOptions.m_mapYokingMapIndex);
+        
+        /*
+         * Map indice in code start at zero
+         */
+        renderOptions.m_mapYokingMapIndex--;
+    }
+    
+    OptionalParameter* mapSweepOpt = myParams->getOptionalParameter(11);
+    if (mapSweepOpt->m_present) {
+        const AString romanNumeral = mapSweepOpt->getString(1);
+        bool validFlag = false;
+        renderOptions.m_mapSweepYokingGroup = MapYokingGroupEnum::fromGuiName(romanNumeral, &validFlag);
+        if (( ! validFlag)
+            || (renderOptions.m_mapSweepYokingGroup == MapYokingGroupEnum::MAP_YOKING_GROUP_OFF)) {
+            throw OperationException(romanNumeral
+                                     + " does not identify a valid Map Yoking Group.  ");
+        }
+        renderOptions.m_mapSweepFirstMapIndex = mapSweepOpt->getInteger(2);
+        renderOptions.m_mapSweepLastMapIndex  = mapSweepOpt->getInteger(3);
+        if ((renderOptions.m_mapSweepFirstMapIndex < 1)
+            || (renderOptions.m_mapSweepLastMapIndex < renderOptions.m_mapSweepFirstMapIndex)) {
+            throw OperationException("Map sweep indices must be one or greater and the last "
+                                     "index must not be less than the first index.");
+        }
+        commonArguments << mapSweepOpt->m_optionSwitch
+                        << romanNumeral
+                        << QString::number(renderOptions.m_mapSweepFirstMapIndex)
+                        << QString::number(renderOptions.m_mapSweepLastMapIndex);
         
         /*
          * Map indice in code start at zero
          */
-        mapYokingMapIndex--;
+        renderOptions.m_mapSweepFirstMapIndex--;
+        renderOptions.m_mapSweepLastMapIndex--;
     }
     
-    if ( ! useWindowSizeForImageSizeFlag) {
-        if ((userImageWidth <= 0)
-            || (userImageHeight <= 0)) {
+    if ( ! renderOptions.m_useWindowSizeForImageSizeFlag) {
+        if ((renderOptions.m_imageWidth <= 0)
+            || (renderOptions.m_imageHeight <= 0)) {
             throw OperationException("Invalid image size width="
-                                     + QString::number(userImageWidth)
+                                     + QString::number(renderOptions.m_imageWidth)
                                      + " height="
-                                     + QString::number(userImageHeight));
+                                     + QString::number(renderOptions.m_imageHeight));
         }
     }
 
@@ -245,6 +439,9 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     if (connDbOpt->m_present) {
         username = connDbOpt->getString(1);
         password = connDbOpt->getString(2);
+        commonArguments << connDbOpt->m_optionSwitch
+                        << username
+                        << password;
     }
     else {
         CaretPreferences* prefs = SessionManager::get()->getCaretPreferences();
@@ -253,21 +450,183 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     }
     CaretDataFile::setFileReadingUsernameAndPassword(username,
                                                      password);
+    
+    const bool profileFlag = myParams->getOptionalParameter(13)->m_present;
+    if (profileFlag) {
+        commonArguments << myParams->getOptionalParameter(13)->m_optionSwitch;
+    }
+    AString profileTraceFileName;
+    OptionalParameter* profileTraceOpt = myParams->getOptionalParameter(14);
+    if (profileTraceOpt->m_present) {
+        profileTraceFileName = FileInformation(profileTraceOpt->getString(1)).getAbsoluteFilePath();
+    }
+    
+    std::vector<SceneImage> sceneImages;
+    sceneImages.push_back(firstSceneImage);
+    OptionalParameter* sceneListOpt = myParams->getOptionalParameter(10);
+    if (sceneListOpt->m_present) {
+        readSceneImageList(sceneListOpt->getString(1),
+                           sceneImages);
+    }
+    
+    OptionalParameter* processesOpt = myParams->getOptionalParameter(12);
+    if (processesOpt->m_present) {
+        const int32_t numberOfProcesses = processesOpt->getInteger(1);
+        if (numberOfProcesses < 1) {
+            throw OperationException("Number of processes must be one or greater.");
+        }
+        if ((numberOfProcesses > 1)
+            && (sceneImages.size() > 1)) {
+            renderInChildProcesses(sceneImages,
+                                   numberOfProcesses,
+                                   commonArguments,
+                                   profileTraceFileName);
+            return;
+        }
+    }
 
     /*
-     * Read the scene file and load the scene
+     * Enable voxel coloring since it is defaulted off for commands
+     */
+    VolumeFile::setVoxelColoringEnabled(true);
+    
+    if (profileFlag
+        || ( ! profileTraceFileName.isEmpty())) {
+        FrameProfiler::setEnabled(true);
+    }
+    
+    /*
+     * Scene files are read once since many scenes may be in the same file.
+     * The context is declared after the scene files so that it is destroyed
+     * first, while the data drawn by OpenGL still exists.
+     */
+    std::map<AString, std::unique_ptr<SceneFile>> sceneFiles;
+    OffscreenContext offscreenContext;
+    
+    AString sceneErrorMessages;
+    for (const auto& sceneImage : sceneImages) {
+        std::unique_ptr<SceneFile>& sceneFile = sceneFiles[sceneImage.m_sceneFileName];
+        if (sceneFile == NULL) {
+            sceneFile.reset(new SceneFile());
+            sceneFile->readFile(sceneImage.m_sceneFileName);
+        }
+        
+        Scene* scene = getSceneFromSceneFile(sceneFile.get(),
+                                             sceneImage.m_sceneNameOrNumber);
+        
+        const AString sceneErrorMessage = renderScene(scene,
+                                                      sceneImage.m_sceneFileName,
+                                                      sceneImage.m_imageFileName,
+                                                      renderOptions,
+                                                      offscreenContext);
+        if ( ! sceneErrorMessage.isEmpty()) {
+            if (sceneImages.size() > 1) {
+                sceneErrorMessages += ("Scene \""
+                                       + sceneImage.m_sceneNameOrNumber
+                                       + "\" in "
+                                       + sceneImage.m_sceneFileName
+                                       + ":\n");
+            }
+            sceneErrorMessages += (sceneErrorMessage
+                                   + "\n");
+        }
+    }
+    
+    /*
+     * Print error messages
      */
-    SceneFile sceneFile;
-    sceneFile.readFile(sceneFileName);
-    Scene* scene = sceneFile.getSceneWithName(sceneNameOrNumber);
+    if ( ! sceneErrorMessages.isEmpty()) {
+        std::cerr << "ERRORS loading scene, output image may be incorrect." << std::endl;
+        std::cerr << sceneErrorMessages << std::endl;
+    }
+    
+    if (profileFlag) {
+        std::cout << FrameProfiler::get()->getStageTimingsText() << std::endl;
+    }
+    if ( ! profileTraceFileName.isEmpty()) {
+        try {
+            FrameProfiler::get()->writeChromeTrace(profileTraceFileName);
+        }
+        catch (const DataFileException& dfe) {
+            throw OperationException(dfe);
+        }
+    }
+}
+
+/**
+ * Read a list of scenes and the image files into which they are rendered.
+ *
+ * @param listFileName
+ *     Name of the list file.
+ * @param sceneImagesOut
+ *     Scenes from the list are appended to this.
+ */
+void
+OperationShowScene::readSceneImageList(const AString& listFileName,
+                                       std::vector<SceneImage>& sceneImagesOut)
+{
+    QFile file(listFileName);
+    if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
+        throw OperationException("Unable to open scene list file "
+                                 + listFileName
+                                 + ": "
+                                 + file.errorString());
+    }
+    
+    QTextStream stream(&file);
+    int32_t lineNumber = 0;
+    while ( ! stream.atEnd()) {
+        const QString line = stream.readLine();
+        lineNumber++;
+        
+        if (line.trimmed().isEmpty()
+            || line.trimmed().startsWith('#')) {
+            continue;
+        }
+        
+        const QStringList items = line.split('\t');
+        if (items.size() != 3) {
+            throw OperationException("Line "
+                                     + AString::number(lineNumber)
+                                     + " in scene list file "
+                                     + listFileName
+                                     + " does not contain a scene file name, scene name or number,"
+                                     " and image file name separated by tabs.");
+        }
+        
+        SceneImage sceneImage;
+        sceneImage.m_sceneFileName = FileInformation(items[0].trimmed()).getAbsoluteFilePath();
+        sceneImage.m_sceneNameOrNumber = items[1].trimmed();
+        sceneImage.m_imageFileName = FileInformation(items[2].trimmed()).getAbsoluteFilePath();
+        sceneImagesOut.push_back(sceneImage);
+    }
+}
+
+/**
+ * Get a scene from a scene file.
+ *
+ * @param sceneFile
+ *     The scene file.
+ * @param sceneNameOrNumber
+ *     Name or number (starting at one) of the scene.
+ * @return
+ *     The scene.
+ */
+Scene*
+OperationShowScene::getSceneFromSceneFile(SceneFile* sceneFile,
+                                          const AString& sceneNameOrNumber)
+{
+    CaretAssert(sceneFile);
+    
+    Scene* scene = sceneFile->getSceneWithName(sceneNameOrNumber);
     if (scene == NULL) {
         bool valid = false;
         const int32_t sceneIndexStartAtOne = sceneNameOrNumber.toInt(&valid);
         if (valid) {
             const int32_t sceneIndex = sceneIndexStartAtOne - 1;
             if ((sceneIndex >= 0)
-                && (sceneIndex < sceneFile.getNumberOfScenes())) {
-                scene = sceneFile.getSceneAtIndex(sceneIndex);
+                && (sceneIndex < sceneFile->getNumberOfScenes())) {
+                scene = sceneFile->getSceneAtIndex(sceneIndex);
             }
             else {
                 throw OperationException("Scene index is invalid");
@@ -278,15 +637,43 @@ OperationShowScene::useParameters(OperationParameters* myParams,
         }
     }
     
-    /*
-     * Enable voxel coloring since it is defaulted off for commands
-     */
-    VolumeFile::setVoxelColoringEnabled(true);
+    return scene;
+}
+
+/**
+ * Restore a scene and render its windows into image files.  Data files
+ * that are not modified and that were loaded by a previous scene are
+ * reused by the scene.
+ *
+ * @param scene
+ *     The scene.
+ * @param sceneFileName
+ *     Name of the file containing the scene.
+ * @param imageFileName
+ *     Name of the image file.
+ * @param renderOptions
+ *     Options for rendering.
+ * @param offscreenContext
+ *     Context in which the windows are rendered.
+ * @return
+ *     Errors that occurred while restoring the scene.  Processing continues
+ *     after these errors since they may not affect the images.
+ */
+AString
+OperationShowScene::renderScene(Scene* scene,
+                                const AString& sceneFileName,
+                                const AString& imageFileName,
+                                const RenderOptions& renderOptions,
+                                OffscreenContext& offscreenContext)
+{
+    CaretAssert(scene);
     
     SceneAttributes sceneAttributes(SceneTypeEnum::SCENE_TYPE_FULL,
                                     scene);
+    sceneAttributes.setSceneFileName(sceneFileName);
+    sceneAttributes.setSceneName(scene->getName());
     
-    if (doNotUseSceneColorsFlag) {
+    if (renderOptions.m_doNotUseSceneColorsFlag) {
         sceneAttributes.setUseSceneForegroundAndBackgroundColors(false);
     }
     
@@ -303,35 +690,79 @@ OperationShowScene::useParameters(OperationParameters* myParams,
     sessionManager->restoreFromScene(&sceneAttributes,
                                      guiManagerClass->getClass("m_sessionManager"));
     
-    /*
-     * Get the error message but continue processing since the error
-     * may not affect the scene.  Print error message later.
-     */
-    const AString sceneErrorMessage = sceneAttributes.getErrorMessage();
-    
     if (sessionManager->getNumberOfBrains() <= 0) {
         throw OperationException("Scene loading failure, SessionManager contains no Brains");
     }
-    Brain* brain = SessionManager::get()->getBrain(0);
-    
-    const GapsAndMargins* gapsAndMargins = brain->getGapsAndMargins();
-    
-    bool missingWindowMessageHasBeenDisplayed = false;
     
     /*
      * Apply map yoking
      */
-    if (mapYokingGroup != MapYokingGroupEnum::MAP_YOKING_GROUP_OFF) {
-        MapYokingGroupEnum::setSelectedMapIndex(mapYokingGroup, mapYokingMapIndex);
+    if (renderOptions.m_mapYokingGroup != MapYokingGroupEnum::MAP_YOKING_GROUP_OFF) {
+        MapYokingGroupEnum::setSelectedMapIndex(renderOptions.m_mapYokingGroup,
+                                                renderOptions.m_mapYokingMapIndex);
         
-        EventMapYokingSelectMap yokeEvent(mapYokingGroup,
+        EventMapYokingSelectMap yokeEvent(renderOptions.m_mapYokingGroup,
                                           NULL,
                                           NULL,
-                                          mapYokingMapIndex,
+                                          renderOptions.m_mapYokingMapIndex,
                                           true);
         EventManager::get()->sendEvent(yokeEvent.getPointer());
     }
     
+    if (renderOptions.m_mapSweepYokingGroup != MapYokingGroupEnum::MAP_YOKING_GROUP_OFF) {
+        /*
+         * The scene is not restored again for each map
+         */
+        for (int32_t mapIndex = renderOptions.m_mapSweepFirstMapIndex;
+             mapIndex <= renderOptions.m_mapSweepLastMapIndex;
+             mapIndex++) {
+            MapYokingGroupEnum::setSelectedMapIndex(renderOptions.m_mapSweepYokingGroup,
+                                                    mapIndex);
+            
+            EventMapYokingSelectMap yokeEvent(renderOptions.m_mapSweepYokingGroup,
+                                              NULL,
+                                              NULL,
+                                              mapIndex,
+                                              true);
+            EventManager::get()->sendEvent(yokeEvent.getPointer());
+            
+            renderWindows(insertIntoImageFileName(imageFileName,
+                                                  "_map" + AString::number(mapIndex + 1)),
+                          renderOptions,
+                          offscreenContext);
+        }
+    }
+    else {
+        renderWindows(imageFileName,
+                      renderOptions,
+                      offscreenContext);
+    }
+    
+    return sceneAttributes.getErrorMessage();
+}
+
+/**
+ * Render the windows of the restored scene into image files.
+ *
+ * @param imageFileName
+ *     Name of the image file.  If there is more than one window,
+ *     an index is inserted into the name for each window's image.
+ * @param renderOptions
+ *     Options for rendering.
+ * @param offscreenContext
+ *     Context in which the windows are rendered.
+ */
+void
+OperationShowScene::renderWindows(const AString& imageFileName,
+                                  const RenderOptions& renderOptions,
+                                  OffscreenContext& offscreenContext)
+{
+    Brain* brain = SessionManager::get()->getBrain(0);
+    
+    const GapsAndMargins* gapsAndMargins = brain->getGapsAndMargins();
+    
+    bool missingWindowMessageHasBeenDisplayed = false;
+    
     std::vector<BrowserWindowContent*> allBrowserWindowContent;
     for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_WINDOWS; i++) {
         std::unique_ptr<EventBrowserWindowContent> browserContentEvent = EventBrowserWindowContent::getWindowContent(i);
@@ -357,10 +788,10 @@ OperationShowScene::useParameters(OperationParameters* myParams,
         const bool restoreToTabTiles = bwc->isTileTabsEnabled();
         const int32_t windowIndex = bwc->getWindowIndex();
         
-        int32_t imageWidth  = userImageWidth;
-        int32_t imageHeight = userImageHeight;
+        int32_t imageWidth  = renderOptions.m_imageWidth;
+        int32_t imageHeight = renderOptions.m_imageHeight;
         
-        if (useWindowSizeForImageSizeFlag) {
+        if (renderOptions.m_useWindowSizeForImageSizeFlag) {
             /*
              * Requires version AFTER 1.2.0-pre1
              */
@@ -375,7 +806,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                 if ((imageWidth <= 0)
                     || (imageHeight <= 0)) {
                     const QString msg("Option "
-                                      + useWindowSizeParam->m_optionSwitch
+                                      + renderOptions.m_useWindowSizeSwitch
                                       + " is used but window size not found in scene and width="
                                       + QString::number(imageWidth)
                                       + " height="
@@ -387,7 +818,7 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                 
                 if ( ! missingWindowMessageHasBeenDisplayed) {
                     const QString msg("Option \""
-                                      + useWindowSizeParam->m_optionSwitch
+                                      + renderOptions.m_useWindowSizeSwitch
                                       + "\" is used but window size not found in scene.\n"
                                       "   Scene was created prior to implementation of this option.\n"
                                       "   Image size will be width="
@@ -420,49 +851,19 @@ OperationShowScene::useParameters(OperationParameters* myParams,
         const int windowWidth  = windowViewport[2];
         const int windowHeight = windowViewport[3];
         
-        //
-        // Create the Mesa Context
-        //
-        const int depthBits = 16;
-        const int stencilBits = 0;
-        const int accumBits = 0;
-        OSMesaContext mesaContext = OSMesaCreateContextExt(OSMESA_RGBA,
-                                                           depthBits,
-                                                           stencilBits,
-                                                           accumBits,
-                                                           NULL);
-        if (mesaContext == 0) {
-            throw ("Creating Mesa Context failed.");
-        }
-        
-        //
-        // Allocate image buffer
-        //
-        const int32_t imageBufferSize =imageWidth * imageHeight * 4 * sizeof(unsigned char);
-        unsigned char* imageBuffer = new unsigned char[imageBufferSize];
-        if (imageBuffer == 0) {
-            throw OperationException("Allocating image buffer size="
-                                     + QString::number(imageBufferSize)
-                                     + " failed.");
-        }
+        const unsigned char* imageBuffer = offscreenContext.makeCurrent(imageWidth,
+                                                                        imageHeight);
+        BrainOpenGL* brainOpenGL = offscreenContext.m_brainOpenGL.get();
+        CaretAssert(brainOpenGL);
         
-        //
-        // Assign buffer to Mesa Context and make current
-        //
-        if (OSMesaMakeCurrent(mesaContext,
-                              imageBuffer,
-                              GL_UNSIGNED_BYTE,
-                              imageWidth,
-                              imageHeight) == 0) {
-            throw OperationException("Assigning buffer to context and make current failed.");
-        }
+        const int32_t outputImageIndex = ((numberOfWindows > 1)
+                                          ? iWindow
+                                          : -1);
         
         /*
          * If tile tabs was saved to the scene, restore it as the scenes tile tabs configuration
          */
         if (restoreToTabTiles) {
-            CaretPointer<BrainOpenGL> brainOpenGL(createBrainOpenGL());
-            
             TileTabsConfiguration* tileTabsConfiguration = bwc->getSelectedTileTabsConfiguration();
             CaretAssert(tileTabsConfiguration);
             
@@ -513,13 +914,9 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                                                                                   viewports.end());
                     brainOpenGL->drawModels(windowIndex,
                                             brain,
-                                            mesaContext,
+                                            offscreenContext.m_mesaContext,
                                             constViewports);
                     
-                    const int32_t outputImageIndex = ((numberOfWindows > 1)
-                                                      ? iWindow
-                                                      : -1);
-                    
                     writeImage(imageFileName,
                                outputImageIndex,
                                imageBuffer,
@@ -535,8 +932,6 @@ OperationShowScene::useParameters(OperationParameters* myParams,
                 }
         }
         else {
-            CaretPointer<BrainOpenGL> brainOpenGL(createBrainOpenGL());
-            
             const int32_t selectedTabIndex = bwc->getSceneSelectedTabIndex();
             
             EventBrowserTabGet getTabContent(selectedTabIndex);
@@ -562,33 +957,114 @@ OperationShowScene::useParameters(OperationParameters* myParams,
             
             brainOpenGL->drawModels(windowIndex,
                                     brain,
-                                    mesaContext,
+                                    offscreenContext.m_mesaContext,
                                     viewportContents);
             
-            const int32_t outputImageIndex = ((numberOfWindows > 1)
-                                              ? iWindow
-                                              : -1);
-            
             writeImage(imageFileName,
                        outputImageIndex,
                        imageBuffer,
                        imageWidth,
                        imageHeight);
         }
+    }
+}
+
+/**
+ * Render scenes by dividing them among child processes that each
+ * run this command with a group of consecutive scenes, since
+ * consecutive scenes are most likely to use the same data files.
+ *
+ * @param sceneImages
+ *     The scenes and their image files.
+ * @param numberOfProcesses
+ *     Number of processes.
+ * @param commonArguments
+ *     Arguments, other than the scenes, passed to every process.
+ * @param profileTraceFileName
+ *     If not empty, each process writes a profile trace to this file
+ *     name with the process number inserted.
+ */
+void
+OperationShowScene::renderInChildProcesses(const std::vector<SceneImage>& sceneImages,
+                                           const int32_t numberOfProcesses,
+                                           const QStringList& commonArguments,
+                                           const AString& profileTraceFileName)
+{
+    const int32_t numberOfScenes = static_cast<int32_t>(sceneImages.size());
+    const int32_t processCount = std::min(numberOfProcesses,
+                                          numberOfScenes);
+    CaretAssert(processCount > 0);
+    
+    std::vector<std::unique_ptr<QTemporaryFile>> listFiles;
+    std::vector<std::unique_ptr<QProcess>> processes;
+    
+    for (int32_t iProcess = 0; iProcess < processCount; iProcess++) {
+        const int32_t firstScene = (iProcess * numberOfScenes) / processCount;
+        const int32_t lastScene  = (((iProcess + 1) * numberOfScenes) / processCount) - 1;
+        CaretAssert(firstScene <= lastScene);
+        
+        const SceneImage& firstSceneImage = sceneImages[firstScene];
+        QStringList arguments;
+        arguments << getCommandSwitch()
+                  << firstSceneImage.m_sceneFileName
+                  << firstSceneImage.m_sceneNameOrNumber
+                  << firstSceneImage.m_imageFileName
+                  << commonArguments;
+        if ( ! profileTraceFileName.isEmpty()) {
+            arguments << "-profile-trace"
+                      << insertIntoFileName(profileTraceFileName,
+                                            ("_" + AString::number(iProcess + 1)));
+        }
         
-        /*
-         * Free image memory and Mesa context
-         */
-        delete[] imageBuffer;
-        OSMesaDestroyContext(mesaContext);
+        if (lastScene > firstScene) {
+            std::unique_ptr<QTemporaryFile> listFile(new QTemporaryFile(QDir::tempPath()
+                                                                        + "/wb_show_scene_XXXXXX.txt"));
+            if ( ! listFile->open()) {
+                throw OperationException("Unable to create scene list file for process: "
+                                         + listFile->errorString());
+            }
+            QTextStream stream(listFile.get());
+            for (int32_t iScene = firstScene + 1; iScene <= lastScene; iScene++) {
+                const SceneImage& sceneImage = sceneImages[iScene];
+                stream << sceneImage.m_sceneFileName << "\t"
+                       << sceneImage.m_sceneNameOrNumber << "\t"
+                       << sceneImage.m_imageFileName << "\n";
+            }
+            stream.flush();
+            listFile->close();
+            
+            arguments << "-scene-list"
+                      << listFile->fileName();
+            listFiles.push_back(std::move(listFile));
+        }
+        
+        std::unique_ptr<QProcess> process(new QProcess());
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->start(QCoreApplication::applicationFilePath(),
+                       arguments);
+        if ( ! process->waitForStarted(-1)) {
+            throw OperationException("Unable to start process for rendering scenes: "
+                                     + process->errorString());
+        }
+        processes.push_back(std::move(process));
     }
     
-    /*
-     * Print error messages
-     */
-    if ( ! sceneErrorMessage.isEmpty()) {
-        std::cerr << "ERRORS loading scene, output image may be incorrect." << std::endl;
-        std::cerr << sceneErrorMessage << std::endl;
+    AString failureMessage;
+    for (int32_t iProcess = 0; iProcess < processCount; iProcess++) {
+        QProcess* process = processes[iProcess].get();
+        process->waitForFinished(-1);
+        if ((process->exitStatus() != QProcess::NormalExit)
+            || (process->exitCode() != 0)) {
+            failureMessage += ("Process "
+                               + AString::number(iProcess + 1)
+                               + " rendering scenes starting with \""
+                               + sceneImages[(iProcess * numberOfScenes) / processCount].m_sceneNameOrNumber
+                               + "\" failed.\n");
+        }
+    }
+    
+    if ( ! failureMessage.isEmpty()) {
+        throw OperationException(failureMessage);
     }
 }
 
@@ -776,6 +1252,64 @@ OperationShowScene::createBrainOpenGL()
 
 #endif // HAVE_OSMESA
 
+/**
+ * Insert text into an image file name before its extension.  If there
+ * is no extension, the text and the PNG extension are appended.
+ *
+ * @param imageFileName
+ *     Name of image file.
+ * @param text
+ *     Text inserted into the name.
+ * @return
+ *     Name with text inserted.
+ */
+AString
+OperationShowScene::insertIntoImageFileName(const AString& imageFileName,
+                                            const AString& text)
+{
+    QString outputName(imageFileName);
+    const int dotOffset = outputName.lastIndexOf(".");
+    if (dotOffset >= 0) {
+        outputName.insert(dotOffset,
+                          text);
+    }
+    else {
+        outputName += (text
+                       + ".png");
+    }
+    
+    return outputName;
+}
+
+/**
+ * Insert text into a file name before its extension.  If there
+ * is no extension, the text is appended.
+ *
+ * @param fileName
+ *     Name of file.
+ * @param text
+ *     Text inserted into the name.
+ * @return
+ *     Name with text inserted.
+ */
+AString
+OperationShowScene::insertIntoFileName(const AString& fileName,
+                                       const AString& text)
+{
+    QString outputName(fileName);
+    const int slashOffset = outputName.lastIndexOf("/");
+    const int dotOffset = outputName.lastIndexOf(".");
+    if (dotOffset > slashOffset) {
+        outputName.insert(dotOffset,
+                          text);
+    }
+    else {
+        outputName += text;
+    }
+    
+    return outputName;
+}
+
 /**
  * Write the image data to a Image File.
  *
@@ -806,15 +1340,8 @@ OperationShowScene::writeImage(const AString& imageFileName,
                                                        2, // width
                                                        10, // base
                                                        QChar('0')); // fill character
-        const int dotOffset = outputName.lastIndexOf(".");
-        if (dotOffset >= 0) {
-            outputName.insert(dotOffset,
-                              imageNumber);
-        }
-        else {
-            outputName += (imageNumber
-                           + ".png");
-        }
+        outputName = insertIntoImageFileName(imageFileName,
+                                             imageNumber);
     }
     
     try {
@@ -22,11 +22,16 @@
 /*LICENSE_END*/
 
 
+#include <QStringList>
+
 #include "AbstractOperation.h"
+#include "MapYokingGroupEnum.h"
 
 namespace caret {
 
     class BrainOpenGLFixedPipeline;
+    class Scene;
+    class SceneFile;
     
     class OperationShowScene : public AbstractOperation {
 
@@ -43,8 +48,75 @@ namespace caret {
         static bool isShowSceneCommandAvailable();
         
     private:
+        class OffscreenContext;
+        
+        /**
+         * A scene and the image file into which it is rendered
+         */
+        class SceneImage {
+        public:
+            AString m_sceneFileName;
+            
+            AString m_sceneNameOrNumber;
+            
+            AString m_imageFileName;
+        };
+        
+        /**
+         * Options that apply to rendering of all scenes
+         */
+        class RenderOptions {
+        public:
+            int32_t m_imageWidth = 0;
+            
+            int32_t m_imageHeight = 0;
+            
+            AString m_useWindowSizeSwitch;
+            
+            bool m_useWindowSizeForImageSizeFlag = false;
+            
+            bool m_doNotUseSceneColorsFlag = false;
+            
+            MapYokingGroupEnum::Enum m_mapYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
+            
+            int32_t m_mapYokingMapIndex = -1;
+            
+            MapYokingGroupEnum::Enum m_mapSweepYokingGroup = MapYokingGroupEnum::MAP_YOKING_GROUP_OFF;
+            
+            int32_t m_mapSweepFirstMapIndex = -1;
+            
+            int32_t m_mapSweepLastMapIndex = -1;
+        };
+        
+        static void readSceneImageList(const AString& listFileName,
+                                       std::vector<SceneImage>& sceneImagesOut);
+        
+        static Scene* getSceneFromSceneFile(SceneFile* sceneFile,
+                                            const AString& sceneNameOrNumber);
+        
+        static AString renderScene(Scene* scene,
+                                   const AString& sceneFileName,
+                                   const AString& imageFileName,
+                                   const RenderOptions& renderOptions,
+                                   OffscreenContext& offscreenContext);
+        
+        static void renderWindows(const AString& imageFileName,
+                                  const RenderOptions& renderOptions,
+                                  OffscreenContext& offscreenContext);
+        
+        static void renderInChildProcesses(const std::vector<SceneImage>& sceneImages,
+                                           const int32_t numberOfProcesses,
+                                           const QStringList& commonArguments,
+                                           const AString& profileTraceFileName);
+        
         static BrainOpenGLFixedPipeline* createBrainOpenGL();
         
+        static AString insertIntoImageFileName(const AString& imageFileName,
+                                               const AString& text);
+        
+        static AString insertIntoFileName(const AString& fileName,
+                                          const AString& text);
+        
         static void writeImage(const AString& imageFileName,
                                   const int32_t imageIndex,
                                   const unsigned char* imageContent,
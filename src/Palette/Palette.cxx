@@ -322,6 +322,34 @@ Palette::getPaletteColor(
                          const float scalarIn,
                          const bool interpolateColorFlagIn,
                          float rgbaOut[4]) const
+{
+    bool interpolateColorFlag = interpolateColorFlagIn;
+    const int32_t paletteIndex = getPaletteColorIndex(scalarIn,
+                                                      interpolateColorFlagIn,
+                                                      interpolateColorFlag);
+    getPaletteColorForIndex(scalarIn,
+                            paletteIndex,
+                            interpolateColorFlag,
+                            rgbaOut);
+}
+
+/**
+ * Find the scalar and color used to color a scalar.  The index depends
+ * only on which interval between the palette's scalars contains the
+ * scalar, so the result may be reused for other scalars in the same
+ * interval as is done by PaletteLookupTable.
+ *
+ * @param scalarIn - scalar for which color is sought.
+ * @param interpolateColorFlagIn - interpolate the color between scalars.
+ * @param interpolateColorFlagOut - output indicating if the color
+ *    of the scalar is interpolated.
+ * @return Index of the scalar and color, or negative if the palette has
+ *    no scalars and colors.
+ */
+int32_t
+Palette::getPaletteColorIndex(const float scalarIn,
+                              const bool interpolateColorFlagIn,
+                              bool& interpolateColorFlagOut) const
 {
     /*
      * When the number of colors in a palette is small, the
@@ -362,22 +390,18 @@ Palette::getPaletteColor(
     int numScalarColors = this->getNumberOfScalarsAndColors();
     const bool doBinarySearchFlag = numScalarColors > 50;
     
-    rgbaOut[0] = 0.0f;
-    rgbaOut[1] = 0.0f;
-    rgbaOut[2] = 0.0f;
-    rgbaOut[3] = 1.0f;
-    
     bool interpolateColorFlag = interpolateColorFlagIn;
     
     float scalar = scalarIn;
     if (scalar < -1.0) scalar = -1.0;
     if (scalar >  1.0) scalar = 1.0;
     
+    int32_t paletteIndex = -1;
+    
     if (numScalarColors > 0) {
         
         int32_t highDataIndex = 0;
         int32_t lowDataIndex  = numScalarColors - 1;
-        int32_t paletteIndex = -1;
         
         if (numScalarColors == 1) {
             paletteIndex = 0;
@@ -450,32 +474,65 @@ Palette::getPaletteColor(
                 }
             }
         }
-        if (paletteIndex >= 0) {
-            const PaletteScalarAndColor* psac = this->getScalarAndColor(paletteIndex);
-            if (psac->isNoneColor()) {
-                rgbaOut[3] = 0.0;
-            }
-            else {
-                psac->getColor(rgbaOut); // color assigned here
-                if (interpolateColorFlag &&
-                    (paletteIndex < (numScalarColors - 1))) {
-                    const PaletteScalarAndColor* psacBelow = this->getScalarAndColor(paletteIndex + 1);
-                    float totalDiff = psac->getScalar() - psacBelow->getScalar();
-                    if (totalDiff != 0.0) {
-                        float offset = scalar - psacBelow->getScalar();
-                        float percentAbove = offset / totalDiff;
-                        float percentBelow = 1.0f - percentAbove;
-                        if ( ! psacBelow->isNoneColor()) {
-                            const float* rgbaAbove = psac->getColor();
-                            const float* rgbaBelow = psacBelow->getColor();
-                            
-                            rgbaOut[0] = (percentAbove * rgbaAbove[0]
-                                          + percentBelow * rgbaBelow[0]);
-                            rgbaOut[1] = (percentAbove * rgbaAbove[1]
-                                          + percentBelow * rgbaBelow[1]);
-                            rgbaOut[2] = (percentAbove * rgbaAbove[2]
-                                          + percentBelow * rgbaBelow[2]);
-                        }
+    }
+    
+    interpolateColorFlagOut = interpolateColorFlag;
+    
+    return paletteIndex;
+}
+
+/**
+ * Get the RGBA (4) colors in the range of zero to one using the
+ * scalar and color found by getPaletteColorIndex().
+ *
+ * @param scalarIn - scalar for which color is sought.
+ * @param paletteIndex - index from getPaletteColorIndex().
+ * @param interpolateColorFlag - interpolation output by getPaletteColorIndex().
+ * @param rgbaOut - Array of 4 containing color components ranging zero to one.
+ */
+void
+Palette::getPaletteColorForIndex(const float scalarIn,
+                                 const int32_t paletteIndex,
+                                 const bool interpolateColorFlag,
+                                 float rgbaOut[4]) const
+{
+    const int32_t numScalarColors = this->getNumberOfScalarsAndColors();
+    
+    rgbaOut[0] = 0.0f;
+    rgbaOut[1] = 0.0f;
+    rgbaOut[2] = 0.0f;
+    rgbaOut[3] = 1.0f;
+    
+    float scalar = scalarIn;
+    if (scalar < -1.0) scalar = -1.0;
+    if (scalar >  1.0) scalar = 1.0;
+    
+    if ((paletteIndex >= 0)
+        && (paletteIndex < numScalarColors)) {
+        const PaletteScalarAndColor* psac = this->getScalarAndColor(paletteIndex);
+        if (psac->isNoneColor()) {
+            rgbaOut[3] = 0.0;
+        }
+        else {
+            psac->getColor(rgbaOut); // color assigned here
+            if (interpolateColorFlag &&
+                (paletteIndex < (numScalarColors - 1))) {
+                const PaletteScalarAndColor* psacBelow = this->getScalarAndColor(paletteIndex + 1);
+                float totalDiff = psac->getScalar() - psacBelow->getScalar();
+                if (totalDiff != 0.0) {
+                    float offset = scalar - psacBelow->getScalar();
+                    float percentAbove = offset / totalDiff;
+                    float percentBelow = 1.0f - percentAbove;
+                    if ( ! psacBelow->isNoneColor()) {
+                        const float* rgbaAbove = psac->getColor();
+                        const float* rgbaBelow = psacBelow->getColor();
+                        
+                        rgbaOut[0] = (percentAbove * rgbaAbove[0]
+                                      + percentBelow * rgbaBelow[0]);
+                        rgbaOut[1] = (percentAbove * rgbaAbove[1]
+                                      + percentBelow * rgbaBelow[1]);
+                        rgbaOut[2] = (percentAbove * rgbaAbove[2]
+                                      + percentBelow * rgbaBelow[2]);
                     }
                 }
             }
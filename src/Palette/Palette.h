@@ -97,6 +97,15 @@ namespace caret {
                              const bool interpolateColorFlag,
                              float rgbaOut[4]) const;
         
+        int32_t getPaletteColorIndex(const float scalar,
+                                     const bool interpolateColorFlagIn,
+                                     bool& interpolateColorFlagOut) const;
+        
+        void getPaletteColorForIndex(const float scalar,
+                                     const int32_t paletteIndex,
+                                     const bool interpolateColorFlag,
+                                     float rgbaOut[4]) const;
+        
         void setModified();
         
         void clearModified();
@@ -0,0 +1,159 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __PALETTE_LOOKUP_TABLE_DECLARE__
+#include "PaletteLookupTable.h"
+#undef __PALETTE_LOOKUP_TABLE_DECLARE__
+
+#include "CaretAssert.h"
+#include "Palette.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::PaletteLookupTable
+ * \brief Speeds up coloring many scalars with a palette
+ * \ingroup Palette
+ *
+ * Most of the time spent coloring a scalar with a palette is the search
+ * for the palette interval containing the scalar.  This divides the
+ * normalized range into equal width bins and records the interval for
+ * each bin that lies entirely within one interval, so that coloring
+ * most scalars only requires indexing the table.  Scalars in the few
+ * bins that contain a palette scalar are searched for as before.
+ *
+ * Colors are computed by the palette from the interval, so they are
+ * identical to those from Palette::getPaletteColor().  The palette must
+ * not be modified while the table is in use.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param palette
+ *     The palette.
+ * @param interpolateColorFlag
+ *     Interpolate the color between scalars.
+ */
+PaletteLookupTable::PaletteLookupTable(const Palette* palette,
+                                       const bool interpolateColorFlag)
+: CaretObject(),
+m_palette(palette),
+m_interpolateColorFlag(interpolateColorFlag)
+{
+    CaretAssert(palette);
+
+    /*
+     * The interval index does not increase as the scalar increases so
+     * if both ends of a bin are in the same interval, all of the bin is.
+     * The ends are moved slightly outward to cover rounding when a
+     * scalar's bin is computed.
+     */
+    const float binWidth = 2.0f / NUMBER_OF_BINS;
+    const float binMargin = binWidth * 0.01f;
+    m_binPaletteIndices.resize(NUMBER_OF_BINS);
+    for (int32_t iBin = 0; iBin < NUMBER_OF_BINS; iBin++) {
+        const float binMinimum = -1.0f + (iBin * binWidth) - binMargin;
+        const float binMaximum = -1.0f + ((iBin + 1) * binWidth) + binMargin;
+        bool minimumInterpolateFlag = false;
+        const int32_t minimumIndex = m_palette->getPaletteColorIndex(binMinimum,
+                                                                     m_interpolateColorFlag,
+                                                                     minimumInterpolateFlag);
+        bool maximumInterpolateFlag = false;
+        const int32_t maximumIndex = m_palette->getPaletteColorIndex(binMaximum,
+                                                                     m_interpolateColorFlag,
+                                                                     maximumInterpolateFlag);
+
+        int32_t binValue = -1;
+        if ((minimumIndex >= 0)
+            && (minimumIndex == maximumIndex)
+            && (minimumInterpolateFlag == maximumInterpolateFlag)) {
+            binValue = (minimumIndex * 2) + (minimumInterpolateFlag ? 1 : 0);
+        }
+        m_binPaletteIndices[iBin] = binValue;
+    }
+}
+
+/**
+ * Destructor.
+ */
+PaletteLookupTable::~PaletteLookupTable()
+{
+}
+
+/**
+ * Get the RGBA (4) colors in the range of zero to one.
+ *
+ * @param scalar
+ *     Normalized scalar for which color is sought.
+ * @param rgbaOut
+ *     Array of 4 containing color components ranging zero to one.
+ */
+void
+PaletteLookupTable::getPaletteColor(const float scalar,
+                                    float rgbaOut[4]) const
+{
+    int32_t binValue = -1;
+
+    /*
+     * False for NaN which is left to the palette
+     */
+    if ((scalar >= -1.0f)
+        && (scalar <= 1.0f)) {
+        int32_t binIndex = static_cast<int32_t>((scalar + 1.0f) * (NUMBER_OF_BINS / 2));
+        if (binIndex >= NUMBER_OF_BINS) {
+            binIndex = NUMBER_OF_BINS - 1;
+        }
+        CaretAssertVectorIndex(m_binPaletteIndices, binIndex);
+        binValue = m_binPaletteIndices[binIndex];
+    }
+    else if (scalar > 1.0f) {
+        binValue = m_binPaletteIndices[NUMBER_OF_BINS - 1];
+    }
+    else if (scalar < -1.0f) {
+        binValue = m_binPaletteIndices[0];
+    }
+
+    if (binValue >= 0) {
+        m_palette->getPaletteColorForIndex(scalar,
+                                           binValue / 2,
+                                           ((binValue % 2) != 0),
+                                           rgbaOut);
+    }
+    else {
+        m_palette->getPaletteColor(scalar,
+                                   m_interpolateColorFlag,
+                                   rgbaOut);
+    }
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+PaletteLookupTable::toString() const
+{
+    return "PaletteLookupTable";
+}
+
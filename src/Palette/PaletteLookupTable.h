@@ -0,0 +1,74 @@
+#ifndef __PALETTE_LOOKUP_TABLE_H__
+#define __PALETTE_LOOKUP_TABLE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include "CaretObject.h"
+
+namespace caret {
+
+    class Palette;
+
+    class PaletteLookupTable : public CaretObject {
+
+    public:
+        PaletteLookupTable(const Palette* palette,
+                           const bool interpolateColorFlag);
+
+        virtual ~PaletteLookupTable();
+
+        void getPaletteColor(const float scalar,
+                             float rgbaOut[4]) const;
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+        /** Number of equal width bins spanning normalized values -1 to 1 */
+        static const int32_t NUMBER_OF_BINS;
+
+    private:
+        PaletteLookupTable(const PaletteLookupTable&);
+
+        PaletteLookupTable& operator=(const PaletteLookupTable&);
+
+        const Palette* m_palette;
+
+        const bool m_interpolateColorFlag;
+
+        /**
+         * For each bin, twice the palette index plus one if interpolated,
+         * or negative if the bin spans more than one palette interval.
+         */
+        std::vector<int32_t> m_binPaletteIndices;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __PALETTE_LOOKUP_TABLE_DECLARE__
+    const int32_t PaletteLookupTable::NUMBER_OF_BINS = 4096;
+#endif // __PALETTE_LOOKUP_TABLE_DECLARE__
+
+} // namespace
+#endif  //__PALETTE_LOOKUP_TABLE_H__
@@ -0,0 +1,154 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "BlockResampleTest.h"
+
+#include "AlgorithmMetricResample.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+#include "TestSurfaces.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+BlockResampleTest::BlockResampleTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//the blocked functions must give exactly what resampling one column at a time gives, including for the panel sizes -metric-resample uses
+void BlockResampleTest::execute()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    SurfaceFile curSphere, newSphere;
+    TestSurfaces::makeSphere(3, 100.0f, coords, tiles);
+    TestSurfaces::makeSurfaceFile(coords, tiles, curSphere);
+    TestSurfaces::makeSphere(4, 100.0f, coords, tiles);
+    for (int i = 0; i < (int)coords.size(); i += 3)
+    {//rotate a little, so that new vertices don't land exactly on old ones
+        const float y = coords[i + 1], z = coords[i + 2];
+        coords[i + 1] = y * cos(0.13f) - z * sin(0.13f);
+        coords[i + 2] = y * sin(0.13f) + z * cos(0.13f);
+    }
+    TestSurfaces::makeSurfaceFile(coords, tiles, newSphere);
+    const int curNodes = curSphere.getNumberOfNodes(), newNodes = newSphere.getNumberOfNodes();
+    vector<float> curAreas, newAreas, roi(curNodes);
+    curSphere.computeNodeAreas(curAreas);
+    newSphere.computeNodeAreas(newAreas);
+    for (int node = 0; node < curNodes; ++node)
+    {//leave out a cap, so some new vertices get no weights and take the invalid value
+        roi[node] = (curSphere.getCoordinate(node)[2] < 60.0f) ? 1.0f : 0.0f;
+    }
+    SurfaceResamplingHelper myHelp(SurfaceResamplingMethodEnum::ADAP_BARY_AREA, &curSphere, &newSphere, curAreas.data(), newAreas.data(), roi.data());
+    const int MAX_COLS = 37;
+    vector<float> columns(MAX_COLS * curNodes);
+    for (int i = 0; i < (int)columns.size(); ++i)
+    {
+        columns[i] = rand() / (float)RAND_MAX - 0.5f;
+    }
+    const float INVALID = -7.0f;
+    vector<float> expectNormal(MAX_COLS * newNodes), expectLargest(MAX_COLS * newNodes);
+    for (int col = 0; col < MAX_COLS; ++col)
+    {
+        myHelp.resampleNormal(columns.data() + col * curNodes, expectNormal.data() + col * newNodes, INVALID);
+        myHelp.resampleLargest(columns.data() + col * curNodes, expectLargest.data() + col * newNodes, INVALID);
+    }
+    const int blockSizes[] = { 1, 5, 16, MAX_COLS };
+    for (int b = 0; b < 4; ++b)
+    {
+        const int numCols = blockSizes[b];
+        vector<float> inBlock(numCols * curNodes), normalBlock(numCols * newNodes), largestBlock(numCols * newNodes);
+        for (int node = 0; node < curNodes; ++node)
+        {
+            for (int col = 0; col < numCols; ++col)
+            {
+                inBlock[node * numCols + col] = columns[col * curNodes + node];
+            }
+        }
+        myHelp.resampleNormalBlock(inBlock.data(), normalBlock.data(), numCols, INVALID);
+        myHelp.resampleLargestBlock(inBlock.data(), largestBlock.data(), numCols, INVALID);
+        for (int node = 0; node < newNodes; ++node)
+        {
+            for (int col = 0; col < numCols; ++col)
+            {
+                if (normalBlock[node * numCols + col] != expectNormal[col * newNodes + node])
+                {
+                    setFailed("resampleNormalBlock with " + AString::number(numCols) + " columns differs from resampleNormal at vertex " + AString::number(node) +
+                              ", column " + AString::number(col));
+                    return;
+                }
+                if (largestBlock[node * numCols + col] != expectLargest[col * newNodes + node])
+                {
+                    setFailed("resampleLargestBlock with " + AString::number(numCols) + " columns differs from resampleLargest at vertex " + AString::number(node) +
+                              ", column " + AString::number(col));
+                    return;
+                }
+            }
+        }
+    }
+    int numInvalid = 0;
+    for (int node = 0; node < newNodes; ++node)
+    {
+        if (expectNormal[node] == INVALID) ++numInvalid;
+    }
+    if (numInvalid == 0)
+    {
+        setFailed("roi didn't leave any vertices without weights, the invalid value isn't tested");
+    }
+    //-metric-resample transposes into panels, check the whole command against the per-column result
+    MetricFile metricIn, roiMetric, curAreaMetric, newAreaMetric;
+    metricIn.setNumberOfNodesAndColumns(curNodes, MAX_COLS);
+    for (int col = 0; col < MAX_COLS; ++col)
+    {
+        metricIn.setValuesForColumn(col, columns.data() + col * curNodes);
+    }
+    roiMetric.setNumberOfNodesAndColumns(curNodes, 1);
+    roiMetric.setValuesForColumn(0, roi.data());
+    curAreaMetric.setNumberOfNodesAndColumns(curNodes, 1);
+    curAreaMetric.setValuesForColumn(0, curAreas.data());
+    newAreaMetric.setNumberOfNodesAndColumns(newNodes, 1);
+    newAreaMetric.setValuesForColumn(0, newAreas.data());
+    for (int largest = 0; largest < 2; ++largest)
+    {
+        MetricFile metricOut;
+        AlgorithmMetricResample(NULL, &metricIn, &curSphere, &newSphere, SurfaceResamplingMethodEnum::ADAP_BARY_AREA, &metricOut,
+                                &curAreaMetric, &newAreaMetric, &roiMetric, NULL, largest != 0);
+        const vector<float>& expected = (largest != 0) ? expectLargest : expectNormal;
+        for (int col = 0; col < MAX_COLS; ++col)
+        {
+            for (int node = 0; node < newNodes; ++node)
+            {
+                float expectVal = expected[col * newNodes + node];
+                if (expectVal == INVALID) expectVal = 0.0f;//-metric-resample uses the default invalid value
+                if (metricOut.getValue(node, col) != expectVal)
+                {
+                    setFailed(AString(largest != 0 ? "-metric-resample -largest" : "-metric-resample") + " differs from per-column resampling at vertex " +
+                              AString::number(node) + ", column " + AString::number(col));
+                    return;
+                }
+            }
+        }
+    }
+}
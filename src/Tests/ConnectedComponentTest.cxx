@@ -0,0 +1,177 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ConnectedComponentTest.h"
+
+#include "AlgorithmVolumeFindClusters.h"
+#include "ConnectedComponentHelper.h"
+#include "FloatMatrix.h"
+#include "VolumeFile.h"
+
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int GRID_X = 37, GRID_Y = 29, GRID_Z = 11;
+    
+    struct GridNeighbors
+    {
+        int m_maxManhattan;
+        GridNeighbors(const int& connectivity)
+        {
+            m_maxManhattan = (connectivity == 6) ? 1 : ((connectivity == 18) ? 2 : 3);
+        }
+        void operator()(const int64_t& index, vector<int64_t>& neighOut) const
+        {
+            neighOut.clear();
+            int x = index % GRID_X, y = (index / GRID_X) % GRID_Y, z = index / (GRID_X * GRID_Y);
+            for (int k = -1; k <= 1; ++k)
+            {
+                for (int j = -1; j <= 1; ++j)
+                {
+                    for (int i = -1; i <= 1; ++i)
+                    {
+                        int manhattan = abs(i) + abs(j) + abs(k);
+                        if (manhattan == 0 || manhattan > m_maxManhattan) continue;
+                        if (x + i < 0 || x + i >= GRID_X || y + j < 0 || y + j >= GRID_Y || z + k < 0 || z + k >= GRID_Z) continue;
+                        neighOut.push_back(index + i + GRID_X * (j + GRID_Y * k));
+                    }
+                }
+            }
+        }
+    };
+    
+    //serial flood fill from each unvisited element in index order
+    int64_t floodFill(const vector<char>& marked, const GridNeighbors& myNeighbors, vector<int64_t>& clusterOut)
+    {
+        const int64_t numElements = (int64_t)marked.size();
+        clusterOut.assign(numElements, -1);
+        int64_t numClusters = 0;
+        vector<int64_t> stack, neighbors;
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            if (!marked[i] || clusterOut[i] != -1) continue;
+            clusterOut[i] = numClusters;
+            stack.push_back(i);
+            while (!stack.empty())
+            {
+                int64_t elem = stack.back();
+                stack.pop_back();
+                myNeighbors(elem, neighbors);
+                for (int n = 0; n < (int)neighbors.size(); ++n)
+                {
+                    if (marked[neighbors[n]] && clusterOut[neighbors[n]] == -1)
+                    {
+                        clusterOut[neighbors[n]] = numClusters;
+                        stack.push_back(neighbors[n]);
+                    }
+                }
+            }
+            ++numClusters;
+        }
+        return numClusters;
+    }
+}
+
+ConnectedComponentTest::ConnectedComponentTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ConnectedComponentTest::execute()
+{
+    const int64_t numElements = GRID_X * GRID_Y * GRID_Z;
+    const int connectivities[3] = { 6, 18, 26 };
+    const int blockCounts[5] = { 1, 2, 3, 7, 16 };
+    const int densities[3] = { 15, 30, 50 };//percent, around the percolation threshold of each connectivity
+    for (int c = 0; c < 3; ++c)
+    {
+        GridNeighbors myNeighbors(connectivities[c]);
+        for (int d = 0; d < 3; ++d)
+        {
+            vector<char> marked(numElements);
+            for (int64_t i = 0; i < numElements; ++i)
+            {
+                marked[i] = (rand() % 100 < densities[d]) ? 1 : 0;
+            }
+            vector<int64_t> expected;
+            int64_t expectedCount = floodFill(marked, myNeighbors, expected);
+            for (int b = 0; b < 5; ++b)
+            {
+                const AString name = AString::number(connectivities[c]) + "-connectivity, " + AString::number(densities[d]) + "% marked, " + AString::number(blockCounts[b]) + " blocks";
+                vector<int64_t> actual;
+                int64_t actualCount = ConnectedComponentHelper::labelComponentsInBlocks(numElements, marked.data(), myNeighbors, actual, blockCounts[b]);
+                if (actualCount != expectedCount)
+                {
+                    setFailed(name + ": found " + AString::number(actualCount) + " clusters, flood fill found " + AString::number(expectedCount));
+                    continue;
+                }
+                for (int64_t i = 0; i < numElements; ++i)
+                {
+                    if (actual[i] != expected[i])
+                    {
+                        setFailed(name + ": element " + AString::number(i) + " labeled " + AString::number(actual[i]) + ", flood fill labeled " + AString::number(expected[i]));
+                        break;
+                    }
+                }
+                if (blockCounts[b] > 1)
+                {//make sure the merge across blocks was exercised
+                    set<int64_t> firstBlockClusters;
+                    const int64_t boundary = numElements / blockCounts[b];
+                    for (int64_t i = 0; i < boundary; ++i)
+                    {
+                        if (expected[i] != -1) firstBlockClusters.insert(expected[i]);
+                    }
+                    bool crosses = false;
+                    for (int64_t i = boundary; i < numElements && !crosses; ++i)
+                    {
+                        if (expected[i] != -1 && firstBlockClusters.count(expected[i]) > 0) crosses = true;
+                    }
+                    if (!crosses && densities[d] >= 30)
+                    {
+                        setFailed(name + ": no cluster crosses a block boundary, the test data is too sparse");
+                    }
+                }
+            }
+        }
+    }
+    //two voxels that only share a corner are one cluster with 26-connectivity, and two with 6 or 18
+    vector<int64_t> dims(3, 4);
+    VolumeFile volIn(dims, FloatMatrix::identity(4).getMatrix());
+    volIn.setValueAllVoxels(0.0f);
+    volIn.setValue(1.0f, 1, 1, 1, 0, 0);
+    volIn.setValue(1.0f, 2, 2, 2, 0, 0);
+    for (int c = 0; c < 3; ++c)
+    {
+        VolumeFile volOut;
+        int endVal = 0;
+        AlgorithmVolumeFindClusters(NULL, &volIn, 0.5f, 0.0f, &volOut, false, NULL, -1, 1, &endVal, -1.0f, -1.0f, connectivities[c]);
+        const int expectedClusters = (connectivities[c] == 26) ? 1 : 2;
+        if (endVal - 1 != expectedClusters || volOut.getValue(2, 2, 2, 0, 0) != (float)expectedClusters)
+        {
+            setFailed("-volume-find-clusters with " + AString::number(connectivities[c]) + "-connectivity found " + AString::number(endVal - 1) +
+                      " clusters of corner-adjacent voxels, expected " + AString::number(expectedClusters));
+        }
+    }
+}
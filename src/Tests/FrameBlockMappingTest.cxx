@@ -0,0 +1,161 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "FrameBlockMappingTest.h"
+
+#include "AlgorithmVolumeToSurfaceMapping.h"
+#include "MetricFile.h"
+#include "RibbonMappingHelper.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const float INNER_RADIUS = 30.0f, OUTER_RADIUS = 36.0f;
+    const int64_t NUM_FRAMES = 21;//more than one block of frames, and not a multiple of the block size
+    
+    vector<vector<float> > makeSform(const vector<int64_t>& dims)
+    {
+        vector<vector<float> > ret(3, vector<float>(4, 0.0f));
+        for (int i = 0; i < 3; ++i)
+        {
+            ret[i][i] = 2.5f;
+            ret[i][3] = -2.5f * (dims[i] - 1) / 2.0f;
+        }
+        return ret;
+    }
+    
+    //compare a column mapped with all frames at once against mapping only that frame
+    AString compareColumn(const MetricFile& allFrames, const MetricFile& oneFrame, const int64_t column)
+    {
+        for (int32_t node = 0; node < allFrames.getNumberOfNodes(); ++node)
+        {
+            if (allFrames.getValue(node, column) != oneFrame.getValue(node, 0))
+            {
+                return "vertex " + AString::number(node) + ", frame " + AString::number(column) + ": " +
+                       AString::number(allFrames.getValue(node, column)) + " vs " + AString::number(oneFrame.getValue(node, 0));
+            }
+        }
+        return "";
+    }
+}
+
+FrameBlockMappingTest::FrameBlockMappingTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void FrameBlockMappingTest::execute()
+{
+    vector<float> innerCoords, outerCoords, midCoords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(3, INNER_RADIUS, innerCoords, tiles);
+    TestSurfaces::makeSphere(3, OUTER_RADIUS, outerCoords, tiles);
+    TestSurfaces::makeSphere(3, (INNER_RADIUS + OUTER_RADIUS) / 2.0f, midCoords, tiles);
+    SurfaceFile innerSurf, outerSurf, midSurf;
+    TestSurfaces::makeSurfaceFile(innerCoords, tiles, innerSurf);
+    TestSurfaces::makeSurfaceFile(outerCoords, tiles, outerSurf);
+    TestSurfaces::makeSurfaceFile(midCoords, tiles, midSurf);
+    const int32_t numNodes = midSurf.getNumberOfNodes();
+    vector<int64_t> dims(4, 32);
+    dims[3] = NUM_FRAMES;
+    VolumeFile volIn(dims, makeSform(dims));
+    vector<int64_t> roiDims(dims.begin(), dims.begin() + 3);
+    VolumeFile roiVol(roiDims, makeSform(dims));
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                float xyz[3];
+                volIn.indexToSpace(i, j, k, xyz);
+                const float radius = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+                roiVol.setValue((radius >= INNER_RADIUS && radius <= OUTER_RADIUS ? 1.0f : 0.0f), i, j, k);
+                for (int64_t b = 0; b < NUM_FRAMES; ++b)
+                {
+                    volIn.setValue(sin(i * 0.3f + b) + cos(j * 0.2f - b * 0.1f) * k * 0.1f, i, j, k, b);
+                }
+            }
+        }
+    }
+    //ribbon: against the per-frame loop the mapping used before frames were blocked, which sums in the same order
+    MetricFile ribbonAll;
+    vector<vector<VoxelWeight> > ribbonWeights;
+    AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &ribbonAll, &innerSurf, &outerSurf, NULL, 3, false, -1, -1.0f, -1, NULL, false, &ribbonWeights);
+    if (ribbonAll.getNumberOfColumns() != NUM_FRAMES)
+    {
+        setFailed("ribbon mapping made " + AString::number(ribbonAll.getNumberOfColumns()) + " columns, expected " + AString::number(NUM_FRAMES));
+        return;
+    }
+    for (int64_t b = 0; b < NUM_FRAMES; ++b)
+    {
+        for (int32_t node = 0; node < numNodes; ++node)
+        {
+            float expected = 0.0f, totalWeight = 0.0f;
+            for (int voxel = 0; voxel < (int)ribbonWeights[node].size(); ++voxel)
+            {
+                const float thisWeight = ribbonWeights[node][voxel].weight;
+                totalWeight += thisWeight;
+                expected += thisWeight * volIn.getValue(ribbonWeights[node][voxel].ijk, b);
+            }
+            expected = (totalWeight != 0.0f ? expected / totalWeight : 0.0f);
+            if (ribbonAll.getValue(node, b) != expected)
+            {
+                setFailed("ribbon mapping of vertex " + AString::number(node) + ", frame " + AString::number(b) + " is " +
+                          AString::number(ribbonAll.getValue(node, b)) + ", per-frame weighting gives " + AString::number(expected));
+                return;
+            }
+        }
+    }
+    //myelin style: all frames at once against one subvolume at a time
+    MetricFile thickness;
+    thickness.setNumberOfNodesAndColumns(numNodes, 1);
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        thickness.setValue(node, 0, OUTER_RADIUS - INNER_RADIUS);
+    }
+    MetricFile myelinAll;
+    AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &myelinAll, &roiVol, &thickness, 2.0f);
+    for (int64_t b = 0; b < NUM_FRAMES; ++b)
+    {
+        MetricFile myelinOne, ribbonOne;
+        AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &myelinOne, &roiVol, &thickness, 2.0f, b);
+        AString difference = compareColumn(myelinAll, myelinOne, b);
+        if (difference != "")
+        {
+            setFailed("myelin style mapping of all frames differs from one subvolume at " + difference);
+            return;
+        }
+        AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &ribbonOne, &innerSurf, &outerSurf, NULL, 3, false, b);
+        difference = compareColumn(ribbonAll, ribbonOne, b);
+        if (difference != "")
+        {
+            setFailed("ribbon mapping of all frames differs from one subvolume at " + difference);
+            return;
+        }
+    }
+}
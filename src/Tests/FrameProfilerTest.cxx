@@ -0,0 +1,168 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "FrameProfilerTest.h"
+
+#include "FrameProfiler.h"
+
+#include <QDir>
+#include <QFile>
+
+using namespace caret;
+using namespace std;
+
+FrameProfilerTest::FrameProfilerTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//each expected entry is the indentation and name of a stage, optionally followed by " (count)"
+bool FrameProfilerTest::checkLines(const vector<AString>& lines, const vector<AString>& expected, const AString& description)
+{
+    if (lines.size() != expected.size())
+    {
+        setFailed(description + ": " + AString::number(lines.size()) + " stages in last frame, expected " + AString::number(expected.size()));
+        return false;
+    }
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        AString name = expected[i], countText;
+        const int countStart = name.indexOf(" (");
+        if (countStart >= 0)
+        {
+            countText = name.mid(countStart);
+            name = name.left(countStart);
+        }
+        const AString suffix = " ms" + countText;
+        bool valid = lines[i].startsWith(name + " ") && lines[i].endsWith(suffix);
+        if (valid)
+        {
+            const AString timeText = lines[i].mid(name.length() + 1, lines[i].length() - name.length() - 1 - suffix.length());
+            timeText.toDouble(&valid);
+            valid = valid && timeText.indexOf('.') == timeText.length() - 3;
+        }
+        if (!valid)
+        {
+            setFailed(description + ": stage line \"" + lines[i] + "\" does not match \"" + expected[i] + "\"");
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrameProfilerTest::execute()
+{
+    FrameProfiler* profiler = FrameProfiler::get();
+    FrameProfiler::setEnabled(false);
+    profiler->clear();
+    {
+        FrameProfiler::Frame frame;
+        FrameProfiler::Scope scope("disabled");
+    }
+    if (!profiler->getLastFrameTimings().empty())
+    {
+        setFailed("stages were timed while profiling was disabled");
+        return;
+    }
+    
+    FrameProfiler::setEnabled(true);
+    {
+        FrameProfiler::Frame frame;
+        FrameProfiler::Scope draw("draw");
+        for (int i = 0; i < 3; ++i)
+        {
+            FrameProfiler::Scope text("text");
+        }
+        {
+            FrameProfiler::Scope surface("surface");
+            FrameProfiler::Scope text("text");
+        }
+    }
+    vector<AString> expected;
+    expected.push_back("draw");
+    expected.push_back("  text (3)");//stages with the same name in the same enclosing stage are combined
+    expected.push_back("  surface");
+    expected.push_back("    text");
+    if (!checkLines(profiler->getLastFrameTimings(), expected, "nested stages")) { FrameProfiler::setEnabled(false); return; }
+    
+    {
+        FrameProfiler::Scope outer("outer");//a frame that begins within a stage starts at depth zero
+        {
+            FrameProfiler::Frame frame;
+            FrameProfiler::Scope inner("inner");
+            FrameProfiler::Scope quoted("quote\"d");
+        }
+    }
+    expected.clear();
+    expected.push_back("inner");
+    expected.push_back("  quote\"d");
+    if (!checkLines(profiler->getLastFrameTimings(), expected, "frame within a stage")) { FrameProfiler::setEnabled(false); return; }
+    
+    const QStringList timingLines = profiler->getStageTimingsText().split("\n", QString::SkipEmptyParts);
+    bool foundText = false;
+    for (int i = 1; i < timingLines.size(); ++i)
+    {
+        const QStringList fields = timingLines[i].split(" ", QString::SkipEmptyParts);
+        if (fields.size() == 5 && fields[0] == "text")
+        {
+            foundText = true;
+            if (fields[1] != "4")
+            {
+                setFailed("accumulated count of stage text is " + fields[1] + ", expected 4");
+                FrameProfiler::setEnabled(false);
+                return;
+            }
+        }
+    }
+    if (!foundText)
+    {
+        setFailed("stage text missing from accumulated timings");
+        FrameProfiler::setEnabled(false);
+        return;
+    }
+    
+    const AString traceName = QDir::tempPath() + "/frameprofilertest_trace.json";
+    profiler->writeChromeTrace(traceName);
+    FrameProfiler::setEnabled(false);
+    QFile traceFile(traceName);
+    if (!traceFile.open(QIODevice::ReadOnly))
+    {
+        setFailed("unable to read trace file " + traceName);
+        return;
+    }
+    const AString trace = QString::fromUtf8(traceFile.readAll());
+    traceFile.close();
+    QFile::remove(traceName);
+    const int numStages = trace.count(QString("\"ph\":\"X\""));
+    if (numStages != 9)
+    {
+        setFailed("trace contains " + AString::number(numStages) + " stages, expected 9");
+        return;
+    }
+    if (!trace.contains("\"name\":\"quote\\\"d\""))
+    {
+        setFailed("quote in stage name is not escaped in trace");
+        return;
+    }
+    if (!trace.startsWith("{\"traceEvents\":[") || !trace.trimmed().endsWith("]}"))
+    {
+        setFailed("trace is not a traceEvents object");
+        return;
+    }
+}
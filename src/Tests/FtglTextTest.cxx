@@ -0,0 +1,329 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "FtglTextTest.h"
+
+#include "AnnotationTextFontNameEnum.h"
+#include "FtglFontTextRenderer.h"
+#include "FtglGlyphAtlas.h"
+#include "GraphicsPrimitiveV3fT3f.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QStringList>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#ifdef HAVE_FREETYPE
+#include <FTGL/ftgl.h>
+#endif // HAVE_FREETYPE
+
+using namespace caret;
+using namespace std;
+
+FtglTextTest::FtglTextTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+#ifdef HAVE_FREETYPE
+
+namespace
+{
+    //a glyph's quad from two triangles, and the glyph's rectangle in atlas pixels
+    struct GlyphQuad
+    {
+        float left, right, bottom, top, z;
+        int atlasLeft, atlasRight, atlasTop, atlasBottom;
+    };
+    
+    bool getGlyphQuad(const vector<float>& xyz, const vector<float>& str, const int width, const int height, GlyphQuad& quadOut)
+    {
+        if (xyz.size() != 18 || str.size() != 18) return false;
+        quadOut.left = quadOut.right = xyz[0];
+        quadOut.bottom = quadOut.top = xyz[1];
+        quadOut.z = xyz[2];
+        float sMin = str[0], sMax = str[0], tMin = str[1], tMax = str[1];
+        for (int i = 0; i < 6; ++i)
+        {
+            quadOut.left = min(quadOut.left, xyz[i * 3]);
+            quadOut.right = max(quadOut.right, xyz[i * 3]);
+            quadOut.bottom = min(quadOut.bottom, xyz[i * 3 + 1]);
+            quadOut.top = max(quadOut.top, xyz[i * 3 + 1]);
+            if (xyz[i * 3 + 2] != quadOut.z) return false;
+            sMin = min(sMin, str[i * 3]);
+            sMax = max(sMax, str[i * 3]);
+            tMin = min(tMin, str[i * 3 + 1]);
+            tMax = max(tMax, str[i * 3 + 1]);
+        }
+        if (sMin < 0.0f || sMax > 1.0f || tMin < 0.0f || tMax > 1.0f) return false;
+        quadOut.atlasLeft = (int)floor(sMin * width + 0.5f);
+        quadOut.atlasRight = (int)floor(sMax * width + 0.5f);
+        quadOut.atlasTop = (int)floor(tMin * height + 0.5f);
+        quadOut.atlasBottom = (int)floor(tMax * height + 0.5f);
+        return true;
+    }
+}
+
+void FtglTextTest::checkGlyphPlacement(const QByteArray& fontFileData)
+{
+    FtglGlyphAtlas atlas(fontFileData, 48);
+    if (!atlas.isValid())
+    {
+        setFailed("glyph atlas could not be created");
+        return;
+    }
+    vector<float> xyz, str;
+    if (!atlas.addCharacterVertices(L' ', 10.0, 20.0, 0.0, xyz, str) || !xyz.empty())
+    {
+        setFailed("space should be in the atlas without vertices");
+        return;
+    }
+    
+    //the quad moves with the pen, snapped to whole pixels like FTGL, and keeps its texture coordinates
+    GlyphQuad quadA, quadMoved, quadFraction;
+    atlas.addCharacterVertices(L'A', 100.0, 50.0, 0.0, xyz, str);
+    const vector<float> strA = str;
+    if (!getGlyphQuad(xyz, str, atlas.getWidth(), atlas.getHeight(), quadA))
+    {
+        setFailed("'A' does not have two triangles with texture coordinates in the atlas");
+        return;
+    }
+    xyz.clear();
+    str.clear();
+    atlas.addCharacterVertices(L'A', 110.0, 70.0, 1.0, xyz, str);
+    getGlyphQuad(xyz, str, atlas.getWidth(), atlas.getHeight(), quadMoved);
+    xyz.clear();
+    str.clear();
+    atlas.addCharacterVertices(L'A', 100.75, 50.75, 0.0, xyz, str);
+    getGlyphQuad(xyz, str, atlas.getWidth(), atlas.getHeight(), quadFraction);
+    if (quadMoved.left != quadA.left + 10.0f || quadMoved.right != quadA.right + 10.0f ||
+        quadMoved.bottom != quadA.bottom + 20.0f || quadMoved.top != quadA.top + 20.0f || quadMoved.z != 1.0f ||
+        str != strA)
+    {
+        setFailed("'A' is not placed relative to the pen");
+    }
+    if (quadFraction.left != quadA.left || quadFraction.top != quadA.top || quadFraction.right != quadA.right)
+    {
+        setFailed("'A' is not placed at a whole pixel");
+    }
+    if (quadA.right - quadA.left != quadA.atlasRight - quadA.atlasLeft ||
+        quadA.top - quadA.bottom != quadA.atlasBottom - quadA.atlasTop ||
+        quadA.right <= quadA.left || quadA.top <= quadA.bottom)
+    {
+        setFailed("size of 'A' in the atlas differs from its size when drawn");
+    }
+    
+    //pack the printable ASCII characters, which also grows the atlas
+    const int initialHeight = atlas.getHeight();
+    vector<GlyphQuad> quads;
+    for (wchar_t c = L'!'; c <= L'~'; ++c)
+    {
+        xyz.clear();
+        str.clear();
+        if (!atlas.addCharacterVertices(c, 0.0, 0.0, 0.0, xyz, str))
+        {
+            setFailed("character " + AString::number((int)c) + " is not in the atlas");
+            return;
+        }
+        GlyphQuad quad;
+        if (!getGlyphQuad(xyz, str, atlas.getWidth(), atlas.getHeight(), quad))
+        {
+            setFailed("character " + AString::number((int)c) + " does not have two triangles with texture coordinates in the atlas");
+            return;
+        }
+        quads.push_back(quad);
+    }
+    if (atlas.getNumberOfGlyphs() != 1 + (int)quads.size())
+    {
+        setFailed("atlas has " + AString::number(atlas.getNumberOfGlyphs()) + " glyphs, expected " + AString::number(1 + quads.size()));
+    }
+    if (atlas.getHeight() == initialHeight)
+    {
+        setFailed("atlas did not grow, so keeping glyph positions while growing is not tested");
+    }
+    
+    //positions of earlier glyphs are kept when the atlas grows, glyphs do not overlap, and padding is empty
+    xyz.clear();
+    str.clear();
+    atlas.addCharacterVertices(L'A', 100.0, 50.0, 0.0, xyz, str);
+    GlyphQuad quadAfter;
+    getGlyphQuad(xyz, str, atlas.getWidth(), atlas.getHeight(), quadAfter);
+    if (quadAfter.atlasLeft != quadA.atlasLeft || quadAfter.atlasTop != quadA.atlasTop ||
+        quadAfter.left != quadA.left || quadAfter.top != quadA.top)
+    {
+        setFailed("'A' moved when the atlas grew");
+    }
+    for (size_t i = 0; i < quads.size(); ++i)
+    {
+        const GlyphQuad& q = quads[i];
+        bool covered = false;
+        for (int y = q.atlasTop; y < q.atlasBottom; ++y)
+        {
+            for (int x = q.atlasLeft; x < q.atlasRight; ++x)
+            {
+                if (atlas.getCoverage(x, y) > 0) covered = true;
+            }
+        }
+        if (!covered)
+        {
+            setFailed("character " + AString::number((int)(L'!' + i)) + " has no coverage in the atlas");
+        }
+        for (int x = q.atlasLeft - 1; x <= q.atlasRight; ++x)
+        {
+            if (atlas.getCoverage(x, q.atlasTop - 1) != 0 || atlas.getCoverage(x, q.atlasBottom) != 0)
+            {
+                setFailed("character " + AString::number((int)(L'!' + i)) + " has coverage in its padding");
+                break;
+            }
+        }
+        for (size_t j = 0; j < i; ++j)
+        {
+            const GlyphQuad& p = quads[j];
+            if (q.atlasLeft < p.atlasRight && p.atlasLeft < q.atlasRight &&
+                q.atlasTop < p.atlasBottom && p.atlasTop < q.atlasBottom)
+            {
+                setFailed("characters " + AString::number((int)(L'!' + j)) + " and " + AString::number((int)(L'!' + i)) + " overlap in the atlas");
+                return;
+            }
+        }
+    }
+    
+    //one primitive, modulated by the text color, is used for text of all colors
+    GraphicsPrimitiveV3fT3f* primitive = atlas.getPrimitive();
+    if (primitive == NULL || primitive != atlas.getPrimitive() ||
+        primitive->getTextureEnvironmentMode() != GraphicsPrimitive::TextureEnvironmentMode::MODULATE)
+    {
+        setFailed("atlas should have one primitive that modulates the text color");
+    }
+}
+
+//cached layouts of text strings must equal layouts created without the cache for every attribute, so the cache key has every attribute affecting the layout
+//a polygon font without display lists is used since it does not need an OpenGL context
+void FtglTextTest::checkTextStringCache(const QByteArray& fontFileData)
+{
+    typedef FtglFontTextRenderer::TextString TextString;
+    typedef FtglFontTextRenderer::TextCharacter TextCharacter;
+    typedef FtglFontTextRenderer::TextDrawingSpace TextDrawingSpace;
+    FtglFontTextRenderer::FontData fontData;
+    fontData.m_ftglFontType = FtglFontTextRenderer::FtglFontTypeEnum::POLYGON;
+    fontData.m_fontData = fontFileData;
+    fontData.m_font = new FTGLPolygonFont((const unsigned char*)fontData.m_fontData.data(), fontData.m_fontData.size());
+    fontData.m_font->UseDisplayList(false);
+    if (fontData.m_font->Error() || !fontData.m_font->FaceSize(24))
+    {
+        setFailed("unable to create font for testing text string cache");
+        return;
+    }
+    fontData.m_valid = true;
+    
+    //text with a space since a stacked space uses other bounds
+    const QStringList textStrings = (QStringList() << "A Vg" << "AVg");
+    const vector<TextDrawingSpace> drawingSpaces = { TextDrawingSpace::MODEL, TextDrawingSpace::VIEWPORT };
+    const vector<AnnotationTextOrientationEnum::Enum> orientations = { AnnotationTextOrientationEnum::HORIZONTAL, AnnotationTextOrientationEnum::STACKED };
+    const vector<double> thicknesses = { 0.0, 2.0 };
+    int expectedCached = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (const QString& text : textStrings)
+        {
+            for (const TextDrawingSpace drawingSpace : drawingSpaces)
+            {
+                for (const AnnotationTextOrientationEnum::Enum orientation : orientations)
+                {
+                    for (const double underline : thicknesses)
+                    {
+                        for (const double outline : thicknesses)
+                        {
+                            const AString name("\"" + text + "\" space=" + AString::number((int)drawingSpace) +
+                                               " orientation=" + AnnotationTextOrientationEnum::toName(orientation) +
+                                               " underline=" + AString::number(underline) + " outline=" + AString::number(outline) +
+                                               " pass=" + AString::number(pass));
+                            unique_ptr<TextString> cached(fontData.newTextString(text, drawingSpace, orientation, underline, outline));
+                            const TextString uncached(text, drawingSpace, orientation, underline, outline, fontData.m_font);
+                            if (pass == 0) ++expectedCached;
+                            if (cached->m_textDrawingSpace != uncached.m_textDrawingSpace ||
+                                cached->m_underlineThickness != uncached.m_underlineThickness ||
+                                cached->m_outlineThickness != uncached.m_outlineThickness ||
+                                cached->m_stringGlyphsMinX != uncached.m_stringGlyphsMinX ||
+                                cached->m_stringGlyphsMaxX != uncached.m_stringGlyphsMaxX ||
+                                cached->m_stringGlyphsMinY != uncached.m_stringGlyphsMinY ||
+                                cached->m_stringGlyphsMaxY != uncached.m_stringGlyphsMaxY ||
+                                cached->m_characters.size() != uncached.m_characters.size())
+                            {
+                                setFailed("cached text string differs for " + name);
+                                return;
+                            }
+                            for (size_t i = 0; i < cached->m_characters.size(); ++i)
+                            {
+                                const TextCharacter* a = cached->m_characters[i];
+                                const TextCharacter* b = uncached.m_characters[i];
+                                if (a->m_character != b->m_character || a->m_horizontalAdvance != b->m_horizontalAdvance ||
+                                    a->m_glyphMinX != b->m_glyphMinX || a->m_glyphMaxX != b->m_glyphMaxX ||
+                                    a->m_glyphMinY != b->m_glyphMinY || a->m_glyphMaxY != b->m_glyphMaxY ||
+                                    a->m_offsetX != b->m_offsetX || a->m_offsetY != b->m_offsetY || a->m_offsetZ != b->m_offsetZ)
+                                {
+                                    setFailed("cached character " + AString::number(i) + " differs for " + name);
+                                    return;
+                                }
+                            }
+                            if (fontData.getNumberOfCachedTextStrings() != expectedCached)
+                            {
+                                setFailed("cache has " + AString::number(fontData.getNumberOfCachedTextStrings()) +
+                                          " text strings but should have " + AString::number(expectedCached) + " after " + name);
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FtglTextTest::execute()
+{
+    QFile file(AnnotationTextFontNameEnum::getResourceFontFileName(AnnotationTextFontNameEnum::VERA));
+    if (!file.open(QFile::ReadOnly))
+    {
+        setFailed("unable to open font " + file.fileName());
+        return;
+    }
+    const QByteArray fontFileData = file.readAll();
+    checkGlyphPlacement(fontFileData);
+    checkTextStringCache(fontFileData);
+}
+
+#else // HAVE_FREETYPE
+
+void FtglTextTest::checkGlyphPlacement(const QByteArray&)
+{
+}
+
+void FtglTextTest::checkTextStringCache(const QByteArray&)
+{
+}
+
+void FtglTextTest::execute()
+{
+}
+
+#endif // HAVE_FREETYPE
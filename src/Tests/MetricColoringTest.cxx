@@ -0,0 +1,173 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "MetricColoringTest.h"
+
+#include "DataFileException.h"
+#include "MetricFile.h"
+#include "PaletteColorMapping.h"
+#include "SurfaceNodeColoring.h"
+#include "TestPaletteProvider.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    void fillMap(MetricFile& metric, const int32_t mapIndex)
+    {
+        const int32_t numNodes = metric.getNumberOfNodes();
+        vector<float> values(numNodes);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            values[i] = (rand() % 20001) / 2000.0f - 5.0f;
+        }
+        metric.setValuesForColumn(mapIndex, values.data());
+    }
+}
+
+MetricColoringTest::MetricColoringTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//coloring from an object that may reuse an earlier coloring must match coloring by a new object, which colors from scratch
+bool MetricColoringTest::compareWithNewColoring(SurfaceNodeColoring& reused, MetricFile& metric, const int32_t mapIndex, const AString& description)
+{
+    const int32_t numNodes = metric.getNumberOfNodes();
+    vector<float> reusedRGBA(numNodes * 4, -1.0f), newRGBA(numNodes * 4, -2.0f);
+    reused.colorMetricMap(&metric, mapIndex, numNodes, reusedRGBA.data());
+    SurfaceNodeColoring newColoring;
+    newColoring.colorMetricMap(&metric, mapIndex, numNodes, newRGBA.data());
+    for (int32_t i = 0; i < numNodes * 4; ++i)
+    {
+        if (reusedRGBA[i] != newRGBA[i])
+        {
+            setFailed(description + ": node " + AString::number(i / 4) + " has " + AString::number(reusedRGBA[i]) +
+                      " in component " + AString::number(i % 4) + ", new coloring gives " + AString::number(newRGBA[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+void MetricColoringTest::execute()
+{
+    srand(7);
+    TestPaletteProvider paletteProvider;
+    const int32_t numNodes = 5000, numMaps = 3;
+    MetricFile metric;
+    metric.setNumberOfNodesAndColumns(numNodes, numMaps);
+    metric.setStructure(StructureEnum::CORTEX_LEFT);
+    for (int32_t m = 0; m < numMaps; ++m)
+    {
+        fillMap(metric, m);
+    }
+    metric.clearModified();
+    SurfaceNodeColoring reused;
+    if (!compareWithNewColoring(reused, metric, 0, "first coloring")) return;
+    if (!compareWithNewColoring(reused, metric, 0, "same map again")) return;
+    if (!compareWithNewColoring(reused, metric, 1, "second map")) return;
+    if (!compareWithNewColoring(reused, metric, 0, "back to first map")) return;
+    PaletteColorMapping* mapping = metric.getPaletteColorMapping(0);
+    mapping->setSelectedPaletteName("videen_style");
+    if (!compareWithNewColoring(reused, metric, 0, "palette changed")) return;
+    mapping->setThresholdType(PaletteThresholdTypeEnum::THRESHOLD_TYPE_NORMAL);
+    mapping->setThresholdNormalMinimum(-1.0f);
+    mapping->setThresholdNormalMaximum(2.0f);
+    if (!compareWithNewColoring(reused, metric, 0, "threshold turned on")) return;
+    mapping->setThresholdNormalMaximum(3.0f);
+    if (!compareWithNewColoring(reused, metric, 0, "threshold changed")) return;
+    mapping->setDisplayNegativeDataFlag(false);
+    if (!compareWithNewColoring(reused, metric, 0, "negative data hidden")) return;
+    metric.setPaletteNormalizationMode(PaletteNormalizationModeEnum::NORMALIZATION_ALL_MAP_DATA);
+    if (!compareWithNewColoring(reused, metric, 0, "normalization changed")) return;
+    fillMap(metric, 0);//unsaved data changes must not use the coloring of the old data
+    if (!compareWithNewColoring(reused, metric, 0, "data changed")) return;
+    metric.clearModified();
+    if (!compareWithNewColoring(reused, metric, 0, "data changed and saved")) return;
+    if (!compareWithNewColoring(reused, metric, 0, "saved data again")) return;
+    for (int32_t m = 0; m < numMaps; ++m)
+    {
+        if (!compareWithNewColoring(reused, metric, m, "map " + AString::number(m) + " after changes")) return;
+    }
+    checkReuse(reused, metric);
+    if (failed()) return;
+    checkReload(metric);
+}
+
+//without any changes, the coloring must actually be reused, which shows as a stale coloring after an unnotified in-place data edit
+void MetricColoringTest::checkReuse(SurfaceNodeColoring& reused, MetricFile& metric)
+{
+    const int32_t numNodes = metric.getNumberOfNodes();
+    vector<float> firstRGBA(numNodes * 4), secondRGBA(numNodes * 4);
+    reused.colorMetricMap(&metric, 1, numNodes, firstRGBA.data());
+    float* data = const_cast<float*>(metric.getValuePointerForColumn(1));
+    vector<float> original(data, data + numNodes);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        data[i] = -data[i];
+    }
+    reused.colorMetricMap(&metric, 1, numNodes, secondRGBA.data());
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        data[i] = original[i];
+    }
+    if (firstRGBA != secondRGBA)
+    {
+        setFailed("coloring of an unchanged map was not reused");
+    }
+}
+
+//reading the file again must not use the coloring of the data that was replaced, even though the map unique identifiers are read from the file
+void MetricColoringTest::checkReload(MetricFile& metric)
+{
+    const AString fileName = QDir::tempPath() + "/MetricColoringTest.func.gii";
+    try
+    {
+        metric.writeFile(fileName);
+        MetricFile loaded;
+        loaded.readFile(fileName);
+        SurfaceNodeColoring reused;
+        if (!compareWithNewColoring(reused, loaded, 0, "file read")) return;
+        const AString mapUniqueID = loaded.getMapUniqueID(0);
+        fillMap(metric, 0);
+        metric.writeFile(fileName);
+        loaded.readFile(fileName);
+        if (loaded.getMapUniqueID(0) != mapUniqueID)
+        {
+            setFailed("map unique identifier changed when file was read again, reload case is not tested");
+        }
+        else
+        {
+            compareWithNewColoring(reused, loaded, 0, "file read again with changed data");
+        }
+    }
+    catch (const DataFileException& e)
+    {
+        setFailed("metric file write/read failed: " + e.whatString());
+    }
+    QFile::remove(fileName);
+}
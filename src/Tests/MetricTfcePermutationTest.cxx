@@ -0,0 +1,151 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "MetricTfcePermutationTest.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float randomFloat(const float minimum, const float maximum)
+    {
+        return minimum + (maximum - minimum) * (rand() / (float)RAND_MAX);
+    }
+    
+    //straightforward t-statistic of the unpermuted data, one-sample if groups is empty
+    float tStatistic(const MetricFile& subjData, const vector<int>& groups, const int node)
+    {
+        const int numSubj = subjData.getNumberOfColumns();
+        double sum[2] = { 0.0, 0.0 };
+        int count[2] = { 0, 0 };
+        for (int s = 0; s < numSubj; ++s)
+        {
+            const int group = groups.empty() ? 0 : groups[s];
+            sum[group] += subjData.getValue(node, s);
+            ++count[group];
+        }
+        double mean[2] = { sum[0] / max(count[0], 1), sum[1] / max(count[1], 1) }, sumSqDev = 0.0;
+        for (int s = 0; s < numSubj; ++s)
+        {
+            const int group = groups.empty() ? 0 : groups[s];
+            const double dev = subjData.getValue(node, s) - mean[group];
+            sumSqDev += dev * dev;
+        }
+        if (groups.empty())
+        {
+            return (float)(mean[0] / sqrt(sumSqDev / (numSubj - 1) / numSubj));
+        }
+        return (float)((mean[1] - mean[0]) / sqrt(sumSqDev / (numSubj - 2) * (1.0 / count[0] + 1.0 / count[1])));
+    }
+}
+
+MetricTfcePermutationTest::MetricTfcePermutationTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void MetricTfcePermutationTest::checkTest(const AString& name, const SurfaceFile& mySurf, const MetricFile& subjData, const vector<int>& groups)
+{
+    const int numNodes = mySurf.getNumberOfNodes(), numPermutations = 40;
+    MetricFile tfceOut, pvalOut, tfceOut2, pvalOut2;
+    vector<float> nullDist, nullDist2;
+    AlgorithmMetricTFCEPermutation(NULL, &mySurf, &subjData, &tfceOut, &pvalOut, numPermutations, groups, NULL, 1.0f, 2.0f, NULL, 7, &nullDist);
+    AlgorithmMetricTFCEPermutation(NULL, &mySurf, &subjData, &tfceOut2, &pvalOut2, numPermutations, groups, NULL, 1.0f, 2.0f, NULL, 7, &nullDist2);
+    if (nullDist != nullDist2)
+    {
+        setFailed(name + ": null distribution differs between runs with the same seed");
+    }
+    MetricFile statMetric, expectTfce;//the unpermuted output must match -metric-tfce on the t-statistic
+    statMetric.setNumberOfNodesAndColumns(numNodes, 1);
+    for (int node = 0; node < numNodes; ++node)
+    {
+        statMetric.setValue(node, 0, tStatistic(subjData, groups, node));
+    }
+    AlgorithmMetricTFCE(NULL, &mySurf, &statMetric, &expectTfce);
+    float maxPos = 0.0f, maxNeg = 0.0f;
+    for (int node = 0; node < numNodes; ++node)
+    {
+        const float expected = expectTfce.getValue(node, 0), actual = tfceOut.getValue(node, 0);
+        if (abs(expected - actual) > 1e-3f * (1.0f + abs(expected)))
+        {
+            setFailed(name + ": TFCE mismatch at vertex " + AString::number(node) + ", expected " + AString::number(expected) + ", got " + AString::number(actual));
+            return;
+        }
+        maxPos = max(maxPos, actual);
+        maxNeg = max(maxNeg, -actual);
+    }
+    if ((int)nullDist.size() != numPermutations * 2 || nullDist[0] != maxPos || nullDist[1] != maxNeg)
+    {
+        setFailed(name + ": first permutation of the null distribution is not the unpermuted data");
+        return;
+    }
+    for (int node = 0; node < numNodes; ++node)
+    {
+        const float val = tfceOut.getValue(node, 0);
+        int count = 0;
+        for (int p = 0; p < numPermutations; ++p)
+        {
+            if ((val > 0.0f && nullDist[p * 2] >= val) || (val < 0.0f && nullDist[p * 2 + 1] >= -val)) ++count;
+        }
+        const float expected = (val == 0.0f) ? 1.0f : ((float)count) / numPermutations;
+        if (pvalOut.getValue(node, 0) != expected)
+        {
+            setFailed(name + ": p-value mismatch at vertex " + AString::number(node) + ", expected " + AString::number(expected) + ", got " + AString::number(pvalOut.getValue(node, 0)));
+            return;
+        }
+    }
+}
+
+void MetricTfcePermutationTest::execute()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(3, 50.0f, coords, tiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    const int numNodes = mySurf.getNumberOfNodes(), numSubj = 10;
+    MetricFile subjData;
+    subjData.setNumberOfNodesAndColumns(numNodes, numSubj);
+    vector<int> groups(numSubj);
+    for (int s = 0; s < numSubj; ++s)
+    {
+        groups[s] = s % 2;
+        for (int node = 0; node < numNodes; ++node)
+        {//positive effect near +z, larger in group 1, negative effect near -x
+            const float* xyz = mySurf.getCoordinate(node);
+            float signal = 0.0f;
+            if (xyz[2] > 30.0f) signal = 1.0f + groups[s];
+            if (xyz[0] < -35.0f) signal = -1.5f;
+            subjData.setValue(node, s, signal + randomFloat(-1.0f, 1.0f));
+        }
+    }
+    checkTest("one-sample", mySurf, subjData, vector<int>());
+    checkTest("two-sample", mySurf, subjData, groups);
+}
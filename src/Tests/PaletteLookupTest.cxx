@@ -0,0 +1,134 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "PaletteLookupTest.h"
+
+#include "ElapsedTimer.h"
+#include "Palette.h"
+#include "PaletteLookupTable.h"
+#include "PaletteScalarAndColor.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float randomFloat(const float minimum, const float maximum)
+    {
+        return minimum + (maximum - minimum) * (rand() / (float)RAND_MAX);
+    }
+    
+    //evenly spaced scalars from 1 to -1, optionally with some "none" colors and a repeated scalar
+    void makePalette(Palette& palette, const int numColors, const bool withNone, const bool withRepeat)
+    {
+        float lastScalar = 1.0f;
+        for (int i = 0; i < numColors; ++i)
+        {
+            float scalar = (numColors == 1) ? 0.3f : 1.0f - 2.0f * i / (numColors - 1);
+            if (withRepeat && i > 0 && i == numColors / 2) scalar = lastScalar;
+            palette.addScalarAndColor(scalar, (withNone && i % 3 == 1) ? "none" : "color");
+            const float rgba[4] = { randomFloat(0.0f, 1.0f), randomFloat(0.0f, 1.0f), randomFloat(0.0f, 1.0f), 1.0f };
+            palette.getScalarAndColor(i)->setColor(rgba);
+            lastScalar = scalar;
+        }
+    }
+}
+
+PaletteLookupTest::PaletteLookupTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void PaletteLookupTest::execute()
+{
+    const int numColorsList[] = { 1, 2, 3, 5, 17, 64, 256 };//more than 50 colors uses binary search
+    const int numTests = 20000;
+    const float binWidth = 2.0f / PaletteLookupTable::NUMBER_OF_BINS;
+    for (int c = 0; c < (int)(sizeof(numColorsList) / sizeof(int)); ++c)
+    {
+        for (int variant = 0; variant < 8; ++variant)
+        {
+            const bool withNone = (variant & 1) != 0, withRepeat = (variant & 2) != 0, interpolate = (variant & 4) != 0;
+            Palette palette;
+            makePalette(palette, numColorsList[c], withNone, withRepeat);
+            PaletteLookupTable lookup(&palette, interpolate);
+            for (int i = 0; i < numTests; ++i)
+            {
+                float scalar;
+                if (i % 2 == 0)
+                {//near bin boundaries, where rounding matters
+                    scalar = -1.0f + (rand() % (PaletteLookupTable::NUMBER_OF_BINS + 1)) * binWidth + randomFloat(-1e-6f, 1e-6f);
+                } else {//includes values outside the normalized range
+                    scalar = randomFloat(-1.2f, 1.2f);
+                }
+                float expected[4], actual[4];
+                palette.getPaletteColor(scalar, interpolate, expected);
+                lookup.getPaletteColor(scalar, actual);
+                for (int j = 0; j < 4; ++j)
+                {
+                    if (expected[j] != actual[j])
+                    {
+                        setFailed("lookup color mismatch with " + AString::number(numColorsList[c]) + " colors, variant " + AString::number(variant) +
+                                  ", scalar " + AString::number(scalar, 'g', 9) + ", component " + AString::number(j) +
+                                  ": expected " + AString::number(expected[j]) + ", got " + AString::number(actual[j]));
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    //timing only, for surface (32k and 164k vertices) and volume (7M voxels) sizes, never fails
+    Palette palette;
+    makePalette(palette, 17, false, false);
+    const int64_t sizes[] = { 32492, 163842, 7000000 };
+    for (int s = 0; s < 3; ++s)
+    {
+        vector<float> scalars(sizes[s]);
+        for (int64_t i = 0; i < sizes[s]; ++i)
+        {
+            scalars[i] = randomFloat(-1.0f, 1.0f);
+        }
+        float rgba[4], searchSum = 0.0f, lookupSum = 0.0f;//also keeps the loops from being optimized away
+        ElapsedTimer timer;
+        timer.start();
+        for (int64_t i = 0; i < sizes[s]; ++i)
+        {
+            palette.getPaletteColor(scalars[i], true, rgba);
+            searchSum += rgba[0];
+        }
+        const double searchTime = timer.getElapsedTimeMilliseconds();
+        timer.start();
+        PaletteLookupTable lookup(&palette, true);
+        for (int64_t i = 0; i < sizes[s]; ++i)
+        {
+            lookup.getPaletteColor(scalars[i], rgba);
+            lookupSum += rgba[0];
+        }
+        const double lookupTime = timer.getElapsedTimeMilliseconds();
+        cout << sizes[s] << " scalars: palette search " << searchTime << " ms, lookup table " << lookupTime << " ms" << endl;
+        if (searchSum != lookupSum)
+        {
+            setFailed("lookup colors differ from palette colors in timing test");
+        }
+    }
+}
@@ -0,0 +1,233 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ParallelProjectionTest.h"
+
+#include "AlgorithmBorderResample.h"
+#include "AlgorithmException.h"
+#include "Border.h"
+#include "BorderFile.h"
+#include "CaretPointer.h"
+#include "Focus.h"
+#include "SurfaceFile.h"
+#include "SurfaceProjectedItem.h"
+#include "SurfaceProjector.h"
+#include "SurfaceProjectorException.h"
+#include "TestSurfaces.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float randFloat()
+    {
+        return (rand() % 20001) / 10000.0f - 1.0f;
+    }
+    
+    //a sphere with its vertices moved a little along the sphere, so that closest points aren't all at symmetric positions
+    void makeSphereSurface(const int subdivisions, const float radius, const float center[3], const StructureEnum::Enum structure, SurfaceFile& surfOut)
+    {
+        vector<float> coords;
+        vector<int32_t> tiles;
+        TestSurfaces::makeSphere(subdivisions, 1.0f, coords, tiles);
+        for (int i = 0; i < (int)coords.size(); i += 3)
+        {
+            float xyz[3];
+            for (int j = 0; j < 3; ++j) xyz[j] = coords[i + j] + 0.02f * randFloat();
+            const float length = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+            for (int j = 0; j < 3; ++j) coords[i + j] = xyz[j] / length * radius + center[j];
+        }
+        TestSurfaces::makeSurfaceFile(coords, tiles, surfOut);
+        surfOut.setStructure(structure);
+    }
+}
+
+ParallelProjectionTest::ParallelProjectionTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ParallelProjectionTest::execute()
+{
+    srand(41);
+    checkFoci(SurfaceTypeEnum::ANATOMICAL);
+    checkFoci(SurfaceTypeEnum::SPHERICAL);
+    checkBorders();
+}
+
+//projectFoci in parallel must give each focus the same projections as projecting them one at a time
+//parallel projection is done first, so that surface data created on first use (such as a sphere's radius) is created by the threads
+void ParallelProjectionTest::checkFoci(const SurfaceTypeEnum::Enum surfaceType)
+{
+    const AString typeName = SurfaceTypeEnum::toName(surfaceType);
+    const float leftCenter[3] = { -50.0f, 0.0f, 0.0f }, rightCenter[3] = { 50.0f, 0.0f, 0.0f }, cerebCenter[3] = { 0.0f, -50.0f, -40.0f };
+    SurfaceFile leftSurf, rightSurf, cerebSurf;
+    makeSphereSurface(4, 40.0f, leftCenter, StructureEnum::CORTEX_LEFT, leftSurf);
+    makeSphereSurface(4, 40.0f, rightCenter, StructureEnum::CORTEX_RIGHT, rightSurf);
+    makeSphereSurface(3, 25.0f, cerebCenter, StructureEnum::CEREBELLUM, cerebSurf);
+    leftSurf.setSurfaceType(surfaceType);
+    rightSurf.setSurfaceType(surfaceType);
+    cerebSurf.setSurfaceType(surfaceType);
+    const int numFoci = 500;
+    vector<CaretPointer<Focus> > serialFoci(numFoci), parallelFoci(numFoci);
+    vector<Focus*> parallelPointers(numFoci);
+    vector<int32_t> focusIndices(numFoci);
+    for (int i = 0; i < numFoci; ++i)
+    {//some near the cerebellum, so that some foci also get a second, cerebellar projection
+        const float xyz[3] = { 100.0f * randFloat(), 80.0f * randFloat() - 10.0f, 60.0f * randFloat() - 10.0f };
+        serialFoci[i].grabNew(new Focus());
+        serialFoci[i]->setName("focus " + AString::number(i));
+        serialFoci[i]->getProjection(0)->setStereotaxicXYZ(xyz);
+        parallelFoci[i].grabNew(new Focus(*serialFoci[i]));
+        parallelPointers[i] = parallelFoci[i];
+        focusIndices[i] = i;
+    }
+    bool parallelThrew = false;
+    try
+    {
+        SurfaceProjector parallelProjector(&leftSurf, &rightSurf, &cerebSurf);
+        parallelProjector.projectFoci(parallelPointers, focusIndices);
+    } catch (SurfaceProjectorException&) {
+        parallelThrew = true;
+    }
+    vector<char> serialFailed(numFoci, 0);
+    {
+        SurfaceProjector serialProjector(&leftSurf, &rightSurf, &cerebSurf);
+        for (int i = 0; i < numFoci; ++i)
+        {
+            try
+            {
+                serialProjector.projectFocus(i, serialFoci[i]);
+            } catch (SurfaceProjectorException&) {
+                serialFailed[i] = 1;
+            }
+        }
+    }
+    bool anySerialFailed = false;
+    int numSecond = 0;
+    for (int i = 0; i < numFoci; ++i)
+    {
+        if (serialFailed[i] != 0)
+        {
+            anySerialFailed = true;
+            continue;
+        }
+        if (serialFoci[i]->getNumberOfProjections() != parallelFoci[i]->getNumberOfProjections())
+        {
+            setFailed(typeName + ": focus " + AString::number(i) + " has " + AString::number(parallelFoci[i]->getNumberOfProjections()) +
+                      " projections in parallel, " + AString::number(serialFoci[i]->getNumberOfProjections()) + " serially");
+            return;
+        }
+        if (serialFoci[i]->getNumberOfProjections() > 1) ++numSecond;
+        for (int p = 0; p < serialFoci[i]->getNumberOfProjections(); ++p)
+        {
+            if (!(*(serialFoci[i]->getProjection(p)) == *(parallelFoci[i]->getProjection(p))))
+            {
+                setFailed(typeName + ": projection " + AString::number(p) + " of focus " + AString::number(i) + " differs between parallel and serial projection");
+                return;
+            }
+        }
+    }
+    if (anySerialFailed != parallelThrew)
+    {
+        setFailed(typeName + ": parallel projection " + (parallelThrew ? "threw" : "didn't throw") + ", but serial projection " +
+                  (anySerialFailed ? "failed on some foci" : "succeeded on every focus"));
+    }
+    if (numSecond == 0)
+    {
+        setFailed(typeName + ": no focus got a cerebellar second projection, the test doesn't cover them");
+    }
+}
+
+//resampling all borders at once, which projects the points of different borders in parallel, must match resampling each border alone
+void ParallelProjectionTest::checkBorders()
+{
+    const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    SurfaceFile curSphere, newSphere;
+    makeSphereSurface(4, 100.0f, origin, StructureEnum::CORTEX_LEFT, curSphere);
+    makeSphereSurface(3, 100.0f, origin, StructureEnum::CORTEX_LEFT, newSphere);
+    SurfaceProjector curProjector(&curSphere);
+    const int numBorders = 12;
+    BorderFile allBorders;
+    allBorders.setStructure(StructureEnum::CORTEX_LEFT);
+    allBorders.setNumberOfNodes(curSphere.getNumberOfNodes());
+    vector<CaretPointer<BorderFile> > singleBorders(numBorders);
+    for (int b = 0; b < numBorders; ++b)
+    {
+        CaretPointer<Border> myBorder(new Border());
+        myBorder->setName("border " + AString::number(b));
+        myBorder->setClassName("test");
+        myBorder->setStructure(StructureEnum::CORTEX_LEFT);
+        float start[3] = { randFloat(), randFloat(), randFloat() }, step[3] = { 0.03f * randFloat(), 0.03f * randFloat(), 0.03f * randFloat() };
+        const int numPoints = 20 + rand() % 40;
+        for (int p = 0; p < numPoints; ++p)
+        {//a path of points along the sphere, projected to the current sphere
+            float xyz[3];
+            for (int j = 0; j < 3; ++j) xyz[j] = start[j] + p * step[j];
+            const float length = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+            for (int j = 0; j < 3; ++j) xyz[j] *= 100.0f / length;
+            CaretPointer<SurfaceProjectedItem> myPoint(new SurfaceProjectedItem());
+            myPoint->setStructure(StructureEnum::CORTEX_LEFT);
+            myPoint->setStereotaxicXYZ(xyz);
+            curProjector.projectItemToTriangle(myPoint);
+            myBorder->addPoint(myPoint.releasePointer());
+        }
+        singleBorders[b].grabNew(new BorderFile());
+        singleBorders[b]->setStructure(StructureEnum::CORTEX_LEFT);
+        singleBorders[b]->setNumberOfNodes(curSphere.getNumberOfNodes());
+        singleBorders[b]->addBorder(new Border(*myBorder));
+        allBorders.addBorder(myBorder.releasePointer());
+    }
+    try
+    {
+        BorderFile allOut;
+        AlgorithmBorderResample(NULL, &allBorders, &curSphere, &newSphere, &allOut);
+        if (allOut.getNumberOfBorders() != numBorders)
+        {
+            setFailed("border resampling produced " + AString::number(allOut.getNumberOfBorders()) + " borders, expected " + AString::number(numBorders));
+            return;
+        }
+        for (int b = 0; b < numBorders; ++b)
+        {
+            BorderFile singleOut;
+            AlgorithmBorderResample(NULL, singleBorders[b], &curSphere, &newSphere, &singleOut);
+            const Border* allBorder = allOut.getBorder(b), * singleBorder = singleOut.getBorder(0);
+            if (allBorder->getNumberOfPoints() != singleBorder->getNumberOfPoints())
+            {
+                setFailed("border " + AString::number(b) + " has a different number of points when resampled with other borders");
+                return;
+            }
+            for (int p = 0; p < allBorder->getNumberOfPoints(); ++p)
+            {
+                if (!(*(allBorder->getPoint(p)) == *(singleBorder->getPoint(p))))
+                {
+                    setFailed("point " + AString::number(p) + " of border " + AString::number(b) + " differs when resampled with other borders");
+                    return;
+                }
+            }
+        }
+    } catch (CaretException& e) {
+        setFailed("border resampling threw: " + e.whatString());
+    }
+}
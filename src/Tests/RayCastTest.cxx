@@ -0,0 +1,183 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "RayCastTest.h"
+
+#include "CaretPointer.h"
+#include "SignedDistanceHelper.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "Vector3D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int NUM_SEGMENTS = 3000;
+    const float EDGE_EPSILON = 1e-4f;//hits this close to a triangle edge or a segment end are not checked, since rounding may go either way
+    
+    float randomFloat(const float minimum, const float maximum)
+    {
+        return minimum + (maximum - minimum) * (rand() / (float)RAND_MAX);
+    }
+    
+    struct BruteHit
+    {
+        int32_t triangle;
+        float distance;
+        float weights[3];
+        bool ambiguous;
+    };
+    
+    //intersect with the triangle's plane, then get barycentric weights from signed subtriangle areas, a different method than segmentHits uses
+    void bruteForceHits(const SurfaceFile& mySurf, const Vector3D& start, const Vector3D& direction, vector<BruteHit>& hitsOut)
+    {
+        hitsOut.clear();
+        const int32_t numTiles = mySurf.getNumberOfTriangles();
+        for (int32_t t = 0; t < numTiles; ++t)
+        {
+            const int32_t* tile = mySurf.getTriangle(t);
+            const Vector3D a = mySurf.getCoordinate(tile[0]), b = mySurf.getCoordinate(tile[1]), c = mySurf.getCoordinate(tile[2]);
+            const Vector3D normal = (b - a).cross(c - a);
+            const float denom = normal.dot(direction), normal2 = normal.dot(normal);
+            if (abs(denom) < 1e-6f * sqrt(normal2) * direction.length()) continue;//segment nearly in the plane of the triangle
+            BruteHit myHit;
+            myHit.triangle = t;
+            myHit.distance = normal.dot(a - start) / denom;
+            const Vector3D point = start + direction * myHit.distance;
+            myHit.weights[0] = normal.dot((b - point).cross(c - point)) / normal2;
+            myHit.weights[1] = normal.dot((c - point).cross(a - point)) / normal2;
+            myHit.weights[2] = normal.dot((a - point).cross(b - point)) / normal2;
+            const float minWeight = min(myHit.weights[0], min(myHit.weights[1], myHit.weights[2]));
+            const float distMargin = EDGE_EPSILON * 10.0f;
+            if (minWeight < -EDGE_EPSILON || myHit.distance < -distMargin || myHit.distance > 1.0f + distMargin) continue;
+            myHit.ambiguous = (minWeight < EDGE_EPSILON || myHit.distance < distMargin || myHit.distance > 1.0f - distMargin);
+            hitsOut.push_back(myHit);
+        }
+    }
+}
+
+RayCastTest::RayCastTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void RayCastTest::execute()
+{
+    srand(67);
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(4, 50.0f, coords, tiles);
+    SurfaceFile sphere;
+    TestSurfaces::makeSurfaceFile(coords, tiles, sphere);
+    const float sphereMin[3] = { -80.0f, -80.0f, -80.0f }, sphereMax[3] = { 80.0f, 80.0f, 80.0f };
+    checkSurface(sphere, sphereMin, sphereMax, "sphere");
+    TestSurfaces::makeSheet(40, coords, tiles);
+    SurfaceFile sheet;
+    TestSurfaces::makeSurfaceFile(coords, tiles, sheet);
+    const float sheetMin[3] = { -5.0f, -5.0f, -8.0f }, sheetMax[3] = { 44.0f, 44.0f, 8.0f };//nearly parallel segments cross the wavy sheet several times
+    checkSurface(sheet, sheetMin, sheetMax, "sheet");
+}
+
+void RayCastTest::checkSurface(const SurfaceFile& mySurf, const float boxMin[3], const float boxMax[3], const AString& description)
+{
+    CaretPointer<SignedDistanceHelperBase> myBase(new SignedDistanceHelperBase(&mySurf));
+    SignedDistanceHelper myHelper(myBase);
+    vector<SignedDistanceHelper::SegmentHit> hits;
+    vector<BruteHit> bruteHits;
+    int totalHits = 0;
+    for (int s = 0; s < NUM_SEGMENTS; ++s)
+    {
+        Vector3D start, end;
+        for (int i = 0; i < 3; ++i)
+        {
+            start[i] = randomFloat(boxMin[i], boxMax[i]);
+            end[i] = randomFloat(boxMin[i], boxMax[i]);
+        }
+        Vector3D direction = end - start;
+        myHelper.segmentHits(start, direction, hits);
+        bruteForceHits(mySurf, start, direction, bruteHits);
+        const AString segmentName = description + " segment " + AString::number(s);
+        for (int h = 1; h < (int)hits.size(); ++h)
+        {
+            if (hits[h].distance < hits[h - 1].distance)
+            {
+                setFailed(segmentName + ": hits are not sorted by distance");
+                return;
+            }
+        }
+        for (int b = 0; b < (int)bruteHits.size(); ++b)
+        {
+            const BruteHit& thisBrute = bruteHits[b];
+            int found = -1;
+            for (int h = 0; h < (int)hits.size(); ++h)
+            {
+                if (hits[h].triangle == thisBrute.triangle) found = h;
+            }
+            if (found == -1)
+            {
+                if (!thisBrute.ambiguous)
+                {
+                    setFailed(segmentName + " misses triangle " + AString::number(thisBrute.triangle) + " at distance " + AString::number(thisBrute.distance));
+                    return;
+                }
+                continue;
+            }
+            ++totalHits;
+            if (abs(hits[found].distance - thisBrute.distance) > 1e-4f)
+            {
+                setFailed(segmentName + " hits triangle " + AString::number(thisBrute.triangle) + " at distance " + AString::number(hits[found].distance) +
+                          ", brute force gives " + AString::number(thisBrute.distance));
+                return;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                if (abs(hits[found].baryWeights[i] - thisBrute.weights[i]) > 1e-3f)
+                {
+                    setFailed(segmentName + ": weight " + AString::number(i) + " on triangle " + AString::number(thisBrute.triangle) + " is " +
+                              AString::number(hits[found].baryWeights[i]) + ", brute force gives " + AString::number(thisBrute.weights[i]));
+                    return;
+                }
+            }
+        }
+        for (int h = 0; h < (int)hits.size(); ++h)
+        {
+            bool found = false;
+            for (int b = 0; b < (int)bruteHits.size(); ++b)
+            {
+                if (bruteHits[b].triangle == hits[h].triangle) found = true;
+            }
+            if (!found)
+            {
+                setFailed(segmentName + " reports triangle " + AString::number(hits[h].triangle) + ", which brute force says it doesn't cross");
+                return;
+            }
+        }
+    }
+    if (totalHits < NUM_SEGMENTS / 4)
+    {
+        setFailed(description + ": only " + AString::number(totalHits) + " hits were checked, the segments mostly miss the surface");
+    }
+}
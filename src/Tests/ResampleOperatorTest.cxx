@@ -0,0 +1,263 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ResampleOperatorTest.h"
+
+#include "AlgorithmException.h"
+#include "AlgorithmMetricResample.h"
+#include "AlgorithmVolumeToSurfaceMapping.h"
+#include "CaretBinaryFile.h"
+#include "CaretException.h"
+#include "MetricFile.h"
+#include "RibbonMappingHelper.h"
+#include "SurfaceFile.h"
+#include "SurfaceResamplingHelper.h"
+#include "TestSurfaces.h"
+#include "VolumeFile.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    bool metricsEqual(const MetricFile& left, const MetricFile& right)
+    {
+        if (left.getNumberOfNodes() != right.getNumberOfNodes() || left.getNumberOfColumns() != right.getNumberOfColumns()) return false;
+        for (int col = 0; col < left.getNumberOfColumns(); ++col)
+        {
+            for (int node = 0; node < left.getNumberOfNodes(); ++node)
+            {
+                if (left.getValue(node, col) != right.getValue(node, col)) return false;
+            }
+        }
+        return true;
+    }
+    
+    AString tempFileName(const AString& name)
+    {
+        return QDir::tempPath() + "/resampleoperatortest_" + name;
+    }
+}
+
+ResampleOperatorTest::ResampleOperatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ResampleOperatorTest::execute()
+{
+    checkSurfaceOperator();
+    checkRibbonOperator();
+    checkCorruptOperator();
+}
+
+//create, write, read, resample, and compare with resampling that computes the weights itself
+void ResampleOperatorTest::checkSurfaceOperator()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    SurfaceFile curSphere, newSphere;
+    TestSurfaces::makeSphere(4, 100.0f, coords, tiles);
+    TestSurfaces::makeSurfaceFile(coords, tiles, curSphere);
+    TestSurfaces::makeSphere(3, 100.0f, coords, tiles);
+    for (int i = 0; i < (int)coords.size(); i += 3)
+    {//rotate a little, so that new vertices don't land exactly on old ones
+        const float x = coords[i], y = coords[i + 1];
+        coords[i] = x * cos(0.1f) - y * sin(0.1f);
+        coords[i + 1] = x * sin(0.1f) + y * cos(0.1f);
+    }
+    TestSurfaces::makeSurfaceFile(coords, tiles, newSphere);
+    const int curNodes = curSphere.getNumberOfNodes(), newNodes = newSphere.getNumberOfNodes();
+    MetricFile metricIn, curAreas, newAreas;
+    metricIn.setNumberOfNodesAndColumns(curNodes, 3);
+    for (int col = 0; col < 3; ++col)
+    {
+        for (int node = 0; node < curNodes; ++node)
+        {
+            metricIn.setValue(node, col, rand() / (float)RAND_MAX);
+        }
+    }
+    vector<float> areas;
+    curSphere.computeNodeAreas(areas);
+    curAreas.setNumberOfNodesAndColumns(curNodes, 1);
+    curAreas.setValuesForColumn(0, areas.data());
+    newSphere.computeNodeAreas(areas);
+    newAreas.setNumberOfNodesAndColumns(newNodes, 1);
+    newAreas.setValuesForColumn(0, areas.data());
+    const SurfaceResamplingMethodEnum::Enum methods[2] = { SurfaceResamplingMethodEnum::BARYCENTRIC, SurfaceResamplingMethodEnum::ADAP_BARY_AREA };
+    const AString fileNames[2] = { tempFileName("surface.wbop"), tempFileName("surface.wbop.gz") };//compressed files don't report their size
+    for (int m = 0; m < 2; ++m)
+    {
+        const AString methodName = SurfaceResamplingMethodEnum::toName(methods[m]);
+        MetricFile directOut;
+        AlgorithmMetricResample(NULL, &metricIn, &curSphere, &newSphere, methods[m], &directOut, &curAreas, &newAreas);
+        for (int f = 0; f < 2; ++f)
+        {
+            try
+            {
+                SurfaceResamplingHelper(methods[m], &curSphere, &newSphere, curAreas.getValuePointerForColumn(0),
+                                        newAreas.getValuePointerForColumn(0)).writeOperator(fileNames[f]);
+                SurfaceResamplingHelper readBack;
+                readBack.readOperator(fileNames[f]);
+                if (readBack.getNumberOfInputNodes() != curNodes || readBack.getNumberOfOutputNodes() != newNodes)
+                {
+                    setFailed(methodName + " operator read from " + fileNames[f] + " has the wrong vertex counts");
+                    continue;
+                }
+                MetricFile operatorOut;
+                AlgorithmMetricResample(NULL, &metricIn, &curSphere, &newSphere, methods[m], &operatorOut, NULL, NULL, NULL, NULL, false, &readBack);
+                if (!metricsEqual(directOut, operatorOut))
+                {
+                    setFailed(methodName + " resampling with the operator from " + fileNames[f] + " differs from computing the weights directly");
+                }
+            } catch (CaretException& e) {
+                setFailed(methodName + " operator round trip through " + fileNames[f] + " threw: " + e.whatString());
+            }
+            QFile::remove(fileNames[f]);
+        }
+    }
+}
+
+//ribbon weights saved from one mapping must give the same result on the same volume, and be refused for a different volume space
+void ResampleOperatorTest::checkRibbonOperator()
+{
+    vector<float> innerCoords, outerCoords, midCoords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(4, 30.0f, innerCoords, tiles);
+    TestSurfaces::makeSphere(4, 36.0f, outerCoords, tiles);
+    TestSurfaces::makeSphere(4, 33.0f, midCoords, tiles);
+    SurfaceFile innerSurf, outerSurf, midSurf;
+    TestSurfaces::makeSurfaceFile(innerCoords, tiles, innerSurf);
+    TestSurfaces::makeSurfaceFile(outerCoords, tiles, outerSurf);
+    TestSurfaces::makeSurfaceFile(midCoords, tiles, midSurf);
+    vector<int64_t> dims(4, 32);
+    dims[3] = 3;
+    vector<vector<float> > sform(4, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        sform[i][i] = 2.5f;
+        sform[i][3] = -2.5f * (dims[i] - 1) / 2.0f;
+    }
+    sform[3][3] = 1.0f;
+    VolumeFile volIn(dims, sform);
+    for (int64_t b = 0; b < dims[3]; ++b)
+    {
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    volIn.setValue(sin(i * 0.3f + b) + cos(j * 0.2f) * k * 0.1f, i, j, k, b);
+                }
+            }
+        }
+    }
+    const AString fileName = tempFileName("ribbon.wbop.gz");
+    try
+    {
+        MetricFile directOut, operatorOut;
+        vector<vector<VoxelWeight> > directWeights, readWeights;
+        AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &directOut, &innerSurf, &outerSurf, NULL, 3, false, -1, -1.0f, -1, NULL, false, &directWeights);
+        RibbonMappingHelper::writeOperator(fileName, directWeights, volIn.getVolumeSpace());
+        VolumeSpace readSpace;
+        RibbonMappingHelper::readOperator(fileName, readWeights, readSpace);
+        if (readSpace != volIn.getVolumeSpace())
+        {
+            setFailed("ribbon operator volume space changed in the round trip");
+        }
+        bool weightsMatch = (readWeights.size() == directWeights.size());
+        for (int node = 0; weightsMatch && node < (int)directWeights.size(); ++node)
+        {
+            weightsMatch = (readWeights[node].size() == directWeights[node].size());
+            for (int w = 0; weightsMatch && w < (int)directWeights[node].size(); ++w)
+            {
+                const VoxelWeight& left = directWeights[node][w], & right = readWeights[node][w];
+                weightsMatch = (left.weight == right.weight && left.ijk[0] == right.ijk[0] && left.ijk[1] == right.ijk[1] && left.ijk[2] == right.ijk[2]);
+            }
+        }
+        if (!weightsMatch)
+        {
+            setFailed("ribbon operator weights changed in the round trip");
+        }
+        AlgorithmVolumeToSurfaceMapping(NULL, &volIn, &midSurf, &operatorOut, readWeights, readSpace);
+        if (!metricsEqual(directOut, operatorOut))
+        {
+            setFailed("ribbon mapping with the operator differs from computing the weights directly");
+        }
+        vector<int64_t> otherDims = dims;
+        otherDims[0] += 1;
+        VolumeFile otherVol(otherDims, sform);
+        otherVol.setValueAllVoxels(0.0f);
+        bool threw = false;
+        try
+        {
+            AlgorithmVolumeToSurfaceMapping(NULL, &otherVol, &midSurf, &operatorOut, readWeights, readSpace);
+        } catch (AlgorithmException&) {
+            threw = true;
+        }
+        if (!threw)
+        {
+            setFailed("ribbon operator was accepted for a volume in a different volume space");
+        }
+    } catch (CaretException& e) {
+        setFailed("ribbon operator round trip threw: " + e.whatString());
+    }
+    QFile::remove(fileName);
+}
+
+//headers that claim more data than the file has must be rejected before allocating for it
+void ResampleOperatorTest::checkCorruptOperator()
+{
+    const int32_t header[3] = { 1, 100000, 100000 };
+    const int64_t numElems = (int64_t)header[1] * header[2];//plausible for the vertex counts, but far more than the file contains
+    const int64_t rowStart[4] = { 0, 3, 6, 9 };
+    const AString fileNames[2] = { tempFileName("corrupt.wbop"), tempFileName("corrupt.wbop.gz") };
+    for (int f = 0; f < 2; ++f)
+    {
+        {
+            CaretBinaryFile myFile(fileNames[f], CaretBinaryFile::WRITE_TRUNCATE);//test machines are little endian
+            myFile.write("wbrsmpop", 8);
+            myFile.write(header, sizeof(header));
+            myFile.write(&numElems, sizeof(numElems));
+            myFile.write(rowStart, sizeof(rowStart));
+            myFile.close();
+        }
+        bool threw = false;
+        try
+        {
+            SurfaceResamplingHelper readBack;
+            readBack.readOperator(fileNames[f]);
+        } catch (CaretException&) {
+            threw = true;
+        }
+        if (!threw)
+        {
+            setFailed("truncated resampling operator " + fileNames[f] + " was accepted");
+        }
+        QFile::remove(fileNames[f]);
+    }
+}
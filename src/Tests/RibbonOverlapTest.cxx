@@ -0,0 +1,161 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "RibbonOverlapTest.h"
+
+#include "FloatMatrix.h"
+#include "RibbonMappingHelper.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "VolumeSpace.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const float INNER_RADIUS = 30.0f, OUTER_RADIUS = 40.0f, SPACING = 3.0f;
+    const int64_t DIM = 32;
+    
+    double meshVolume(const vector<float>& coords, const vector<int32_t>& tiles)
+    {
+        double ret = 0.0;
+        for (int t = 0; t < (int)tiles.size(); t += 3)
+        {
+            const float* a = coords.data() + tiles[t] * 3, * b = coords.data() + tiles[t + 1] * 3, * c = coords.data() + tiles[t + 2] * 3;
+            ret += (a[0] * ((double)b[1] * c[2] - (double)b[2] * c[1]) + a[1] * ((double)b[2] * c[0] - (double)b[0] * c[2]) + a[2] * ((double)b[0] * c[1] - (double)b[1] * c[0])) / 6.0;
+        }
+        return ret;
+    }
+    
+    VolumeSpace makeSpace(const bool flipX)
+    {
+        vector<vector<float> > sform = FloatMatrix::identity(4).getMatrix();
+        for (int i = 0; i < 3; ++i)
+        {
+            sform[i][i] = SPACING;
+            sform[i][3] = -SPACING * (DIM - 1) / 2.0f + 0.4f;//don't center a voxel on the sphere center
+        }
+        if (flipX)
+        {
+            sform[0][0] = -SPACING;
+            sform[0][3] = -sform[0][3];
+        }
+        const int64_t dims[3] = { DIM, DIM, DIM };
+        return VolumeSpace(dims, sform);
+    }
+    
+    //sum of weights over all vertices, per voxel
+    vector<double> voxelTotals(const vector<vector<VoxelWeight> >& myWeights, const VolumeSpace& mySpace, double& totalOut)
+    {
+        vector<double> ret(DIM * DIM * DIM, 0.0);
+        totalOut = 0.0;
+        for (int node = 0; node < (int)myWeights.size(); ++node)
+        {
+            for (int w = 0; w < (int)myWeights[node].size(); ++w)
+            {
+                ret[mySpace.getIndex(myWeights[node][w].ijk)] += myWeights[node][w].weight;
+                totalOut += myWeights[node][w].weight;
+            }
+        }
+        return ret;
+    }
+}
+
+RibbonOverlapTest::RibbonOverlapTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//thin column polyhedra tile the space between the surfaces, so their voxel fractions must add up to the voxels the ribbon covers
+void RibbonOverlapTest::execute()
+{
+    vector<float> innerCoords, outerCoords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(4, INNER_RADIUS, innerCoords, tiles);
+    TestSurfaces::makeSphere(4, OUTER_RADIUS, outerCoords, tiles);
+    SurfaceFile innerSurf, outerSurf;
+    TestSurfaces::makeSurfaceFile(innerCoords, tiles, innerSurf);
+    TestSurfaces::makeSurfaceFile(outerCoords, tiles, outerSurf);
+    const double shellVoxels = (meshVolume(outerCoords, tiles) - meshVolume(innerCoords, tiles)) / (SPACING * SPACING * SPACING);
+    double exactTotal = 0.0;
+    for (int flip = 0; flip < 2; ++flip)
+    {
+        const AString spaceName = (flip != 0) ? "flipped sform" : "normal sform";
+        const VolumeSpace mySpace = makeSpace(flip != 0);
+        vector<vector<VoxelWeight> > exactWeights, sampledWeights;
+        RibbonMappingHelper::computeWeightsRibbon(exactWeights, mySpace, &innerSurf, &outerSurf, NULL, 3, true, true);
+        RibbonMappingHelper::computeWeightsRibbon(sampledWeights, mySpace, &innerSurf, &outerSurf, NULL, 4, true, false);
+        double thisExactTotal, sampledTotal;
+        const vector<double> exactPerVoxel = voxelTotals(exactWeights, mySpace, thisExactTotal);
+        voxelTotals(sampledWeights, mySpace, sampledTotal);
+        if (abs(thisExactTotal - shellVoxels) > 1e-3 * shellVoxels)
+        {
+            setFailed("-exact-overlap with " + spaceName + " covers " + AString::number(thisExactTotal) + " voxels, the ribbon is " + AString::number(shellVoxels) + " voxels");
+        }
+        if (abs(sampledTotal - shellVoxels) > 0.02 * shellVoxels)
+        {
+            setFailed("subdivision with " + spaceName + " covers " + AString::number(sampledTotal) + " voxels, the ribbon is " + AString::number(shellVoxels) + " voxels");
+        }
+        if (flip != 0 && abs(thisExactTotal - exactTotal) > 1e-4 * exactTotal)
+        {
+            setFailed("-exact-overlap total changes when the sform is flipped");
+        }
+        exactTotal = thisExactTotal;
+        for (int64_t k = 0; k < DIM; ++k)
+        {
+            for (int64_t j = 0; j < DIM; ++j)
+            {
+                for (int64_t i = 0; i < DIM; ++i)
+                {
+                    float minRadius = -1.0f, maxRadius = -1.0f;//range of distances from the center over the voxel's corners
+                    for (int corner = 0; corner < 8; ++corner)
+                    {
+                        float xyz[3];
+                        mySpace.indexToSpace(i + ((corner & 1) ? 0.5f : -0.5f), j + ((corner & 2) ? 0.5f : -0.5f), k + ((corner & 4) ? 0.5f : -0.5f), xyz);
+                        const float radius = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+                        if (minRadius < 0.0f || radius < minRadius) minRadius = radius;
+                        if (radius > maxRadius) maxRadius = radius;
+                    }
+                    const double covered = exactPerVoxel[mySpace.getIndex(i, j, k)];
+                    const AString voxelName = AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k);
+                    if (covered > 1.0 + 1e-4)
+                    {
+                        setFailed("-exact-overlap thin columns overlap in voxel " + voxelName + " with " + spaceName + ", total fraction " + AString::number(covered));
+                        return;
+                    }
+                    const float MARGIN = 0.5f;//the meshes are slightly inside the spheres
+                    if (minRadius > INNER_RADIUS + MARGIN && maxRadius < OUTER_RADIUS - MARGIN && abs(covered - 1.0) > 1e-3)
+                    {
+                        setFailed("-exact-overlap thin columns leave a gap in voxel " + voxelName + " with " + spaceName + ", total fraction " + AString::number(covered));
+                        return;
+                    }
+                    if ((maxRadius < INNER_RADIUS - MARGIN || minRadius > OUTER_RADIUS + MARGIN) && covered != 0.0)
+                    {
+                        setFailed("-exact-overlap gives weight to voxel " + voxelName + " outside the ribbon with " + spaceName);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,163 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SignedDistanceVolumeTest.h"
+
+#include "AlgorithmCreateSignedDistanceVolume.h"
+#include "AlgorithmException.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const float RADIUS = 20.0f, EXACT_LIMIT = 3.0f;
+    
+    //anisotropic voxels, with the sphere near the center of the FOV
+    vector<vector<float> > makeSform(const float spacing[3], const vector<int64_t>& dims, const float skew)
+    {
+        vector<vector<float> > ret(4, vector<float>(4, 0.0f));
+        for (int i = 0; i < 3; ++i)
+        {
+            ret[i][i] = spacing[i];
+            ret[i][3] = -spacing[i] * (dims[i] - 1) / 2.0f + 0.37f;//don't line the voxel grid up with the mesh vertices
+        }
+        ret[0][1] = skew;
+        ret[3][3] = 1.0f;
+        return ret;
+    }
+}
+
+SignedDistanceVolumeTest::SignedDistanceVolumeTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SignedDistanceVolumeTest::execute()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(4, RADIUS, coords, tiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    vector<int64_t> dims(3);
+    dims[0] = 40; dims[1] = 48; dims[2] = 30;
+    const float spacing[3] = { 1.5f, 1.25f, 2.0f };
+    const vector<vector<float> > sform = makeSform(spacing, dims, 0.0f);
+    //exact band only: -fast-sweep gets the sign from voxel columns instead of per voxel, the values must not change
+    {
+        VolumeFile heapOut(dims, sform), sweepOut(dims, sform), heapRoi(dims, sform), sweepRoi(dims, sform);
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &heapOut, &heapRoi, 0.0f, EXACT_LIMIT, EXACT_LIMIT, 2, SignedDistanceHelper::EVEN_ODD, false);
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &sweepOut, &sweepRoi, 0.0f, EXACT_LIMIT, EXACT_LIMIT, 2, SignedDistanceHelper::EVEN_ODD, true);
+        int64_t numBand = 0;
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    if (heapRoi.getValue(i, j, k) != sweepRoi.getValue(i, j, k))
+                    {
+                        setFailed("exact band roi differs with -fast-sweep at voxel " + AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k));
+                        return;
+                    }
+                    if (heapRoi.getValue(i, j, k) == 0.0f) continue;
+                    ++numBand;
+                    const float expected = heapOut.getValue(i, j, k), actual = sweepOut.getValue(i, j, k);
+                    if (abs(expected - actual) > 1e-4f && abs(expected) > 1e-3f)
+                    {
+                        setFailed("exact band value differs with -fast-sweep at voxel " + AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k) +
+                                  ", expected " + AString::number(expected) + ", got " + AString::number(actual));
+                        return;
+                    }
+                }
+            }
+        }
+        if (numBand == 0)
+        {
+            setFailed("exact band is empty, the test volume doesn't contain the surface");
+            return;
+        }
+    }
+    //whole FOV: both methods approximate the far field, compare them to the analytic distance from the sphere
+    {
+        const float approxLim = 1000.0f;
+        VolumeFile heapOut(dims, sform), sweepOut(dims, sform), sweepRoi(dims, sform);
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &heapOut, NULL, 0.0f, EXACT_LIMIT, approxLim, 2, SignedDistanceHelper::EVEN_ODD, false);
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &sweepOut, &sweepRoi, 0.0f, EXACT_LIMIT, approxLim, 2, SignedDistanceHelper::EVEN_ODD, true);
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    AString voxelName = AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k);
+                    if (sweepRoi.getValue(i, j, k) != 1.0f)
+                    {
+                        setFailed("-fast-sweep with a large approximate limit didn't fill voxel " + voxelName);
+                        return;
+                    }
+                    float xyz[3];
+                    sweepOut.indexToSpace(i, j, k, xyz);
+                    const float analytic = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]) - RADIUS;
+                    const float sweepVal = sweepOut.getValue(i, j, k), heapVal = heapOut.getValue(i, j, k);
+                    if (abs(analytic) > 1.0f && (sweepVal < 0.0f) != (analytic < 0.0f))
+                    {
+                        setFailed("-fast-sweep has the wrong sign at voxel " + voxelName + ", analytic distance " + AString::number(analytic) + ", got " + AString::number(sweepVal));
+                        return;
+                    }
+                    //first order sweeping overestimates diagonal distances by a few percent, the heap method by less
+                    const float tolerance = 0.3f + 0.06f * abs(analytic);
+                    if (abs(sweepVal - analytic) > tolerance)
+                    {
+                        setFailed("-fast-sweep is too far from the analytic distance at voxel " + voxelName + ", expected " + AString::number(analytic) + ", got " + AString::number(sweepVal));
+                        return;
+                    }
+                    if (abs(sweepVal - heapVal) > tolerance)
+                    {
+                        setFailed("-fast-sweep is too far from the heap method at voxel " + voxelName + ", heap gave " + AString::number(heapVal) + ", sweep gave " + AString::number(sweepVal));
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    //sweeping assumes orthogonal voxel axes
+    {
+        const vector<vector<float> > skewed = makeSform(spacing, dims, 0.5f);
+        VolumeFile sweepOut(dims, skewed);
+        bool threw = false;
+        try
+        {
+            AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &sweepOut, NULL, 0.0f, EXACT_LIMIT, 10.0f, 2, SignedDistanceHelper::EVEN_ODD, true);
+        } catch (AlgorithmException&) {
+            threw = true;
+        }
+        if (!threw)
+        {
+            setFailed("-fast-sweep accepted a volume space with non-orthogonal voxel axes");
+        }
+    }
+}
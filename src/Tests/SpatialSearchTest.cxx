@@ -0,0 +1,226 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SpatialSearchTest.h"
+
+#include "CaretPointLocator.h"
+#include "CaretPointer.h"
+#include "SignedDistanceHelper.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "Vector3D.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <set>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int NUM_POINTS = 20000, NUM_QUERIES = 2000;
+    const float EPSILON = 1e-4f;//queries this close to a range limit are not checked, since rounding may go either way
+    
+    float randomFloat(const float minimum, const float maximum)
+    {
+        return minimum + (maximum - minimum) * (rand() / (float)RAND_MAX);
+    }
+    
+    //closest point on a triangle, by region of the triangle's plane (Ericson, Real-Time Collision Detection, 5.1.5)
+    Vector3D closestOnTriangle(const Vector3D& p, const Vector3D& a, const Vector3D& b, const Vector3D& c)
+    {
+        Vector3D ab = b - a, ac = c - a, ap = p - a;
+        float d1 = ab.dot(ap), d2 = ac.dot(ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+        Vector3D bp = p - b;
+        float d3 = ab.dot(bp), d4 = ac.dot(bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+        Vector3D cp = p - c;
+        float d5 = ab.dot(cp), d6 = ac.dot(cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        float denom = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+}
+
+SpatialSearchTest::SpatialSearchTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SpatialSearchTest::checkPointLocator()
+{
+    vector<float> coords(NUM_POINTS * 3), extraCoords(300 * 3);
+    for (int i = 0; i < NUM_POINTS * 3; ++i)
+    {//clumped in x, so the tree is uneven
+        coords[i] = (i % 3 == 0) ? pow(randomFloat(0.0f, 1.0f), 3.0f) * 100.0f : randomFloat(0.0f, 100.0f);
+    }
+    for (int i = 0; i < (int)extraCoords.size(); ++i)
+    {
+        extraCoords[i] = randomFloat(40.0f, 60.0f);
+    }
+    CaretPointLocator myLocator(coords.data(), NUM_POINTS);
+    const int32_t extraSet = myLocator.addPointSet(extraCoords.data(), (int64_t)extraCoords.size() / 3);
+    const int32_t removedSet = myLocator.addPointSet(extraCoords.data(), 10);
+    myLocator.removePointSet(removedSet);
+    for (int q = 0; q < NUM_QUERIES; ++q)
+    {
+        const float target[3] = { randomFloat(-10.0f, 110.0f), randomFloat(-10.0f, 110.0f), randomFloat(-10.0f, 110.0f) };
+        const float maxDist = randomFloat(0.5f, 8.0f);
+        const Vector3D targetVec(target);
+        float bestDist = numeric_limits<float>::max();
+        set<LocatorInfo> expectedInRange, uncertainInRange;
+        for (int s = 0; s < 2; ++s)
+        {
+            const vector<float>& setCoords = (s == 0) ? coords : extraCoords;
+            const int32_t whichSet = (s == 0) ? 0 : extraSet;
+            for (int64_t i = 0; i < (int64_t)setCoords.size() / 3; ++i)
+            {
+                const float dist = (Vector3D(setCoords.data() + i * 3) - targetVec).length();
+                bestDist = min(bestDist, dist);
+                if (dist < maxDist - EPSILON) expectedInRange.insert(LocatorInfo(i, whichSet, Vector3D()));
+                else if (dist < maxDist + EPSILON) uncertainInRange.insert(LocatorInfo(i, whichSet, Vector3D()));
+            }
+        }
+        const AString name = "query " + AString::number(q);
+        LocatorInfo closestInfo(-1, -1, Vector3D());
+        const int64_t closest = myLocator.closestPoint(target, &closestInfo);
+        if (closest < 0 || abs((closestInfo.coords - targetVec).length() - bestDist) > EPSILON)
+        {
+            setFailed(name + ": closest point is at distance " + AString::number((closestInfo.coords - targetVec).length()) + ", brute force found " + AString::number(bestDist));
+            return;
+        }
+        if (abs(bestDist - maxDist) > EPSILON)
+        {
+            LocatorInfo limitedInfo(-1, -1, Vector3D());
+            const int64_t limited = myLocator.closestPointLimited(target, maxDist, &limitedInfo);
+            if ((bestDist > maxDist) != (limited == -1) ||
+                (limited != -1 && abs((limitedInfo.coords - targetVec).length() - bestDist) > EPSILON))
+            {
+                setFailed(name + ": limited closest point disagrees with brute force distance " + AString::number(bestDist) + " and limit " + AString::number(maxDist));
+                return;
+            }
+            if (myLocator.anyInRange(target, maxDist) != (bestDist < maxDist))
+            {
+                setFailed(name + ": any in range disagrees with brute force distance " + AString::number(bestDist) + " and limit " + AString::number(maxDist));
+                return;
+            }
+        }
+        const set<LocatorInfo> inRange = myLocator.pointsInRange(target, maxDist);
+        for (set<LocatorInfo>::const_iterator iter = expectedInRange.begin(); iter != expectedInRange.end(); ++iter)
+        {
+            if (inRange.find(*iter) == inRange.end())
+            {
+                setFailed(name + ": points in range missed point " + AString::number(iter->index) + " of set " + AString::number(iter->whichSet));
+                return;
+            }
+        }
+        for (set<LocatorInfo>::const_iterator iter = inRange.begin(); iter != inRange.end(); ++iter)
+        {
+            if (expectedInRange.find(*iter) == expectedInRange.end() && uncertainInRange.find(*iter) == uncertainInRange.end())
+            {
+                setFailed(name + ": points in range added point " + AString::number(iter->index) + " of set " + AString::number(iter->whichSet));
+                return;
+            }
+        }
+    }
+}
+
+void SpatialSearchTest::checkSignedDistance()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    const float radius = 50.0f;
+    TestSurfaces::makeSphere(4, radius, coords, tiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    const int32_t numTiles = mySurf.getNumberOfTriangles();
+    CaretPointer<SignedDistanceHelperBase> myBase(new SignedDistanceHelperBase(&mySurf));
+    SignedDistanceHelper myHelper(myBase);
+    for (int q = 0; q < NUM_QUERIES; ++q)
+    {
+        const float target[3] = { randomFloat(-80.0f, 80.0f), randomFloat(-80.0f, 80.0f), randomFloat(-80.0f, 80.0f) };
+        const Vector3D targetVec(target);
+        float bestDist = numeric_limits<float>::max();
+        for (int32_t t = 0; t < numTiles; ++t)
+        {
+            const int32_t* tile = mySurf.getTriangle(t);
+            const Vector3D closest = closestOnTriangle(targetVec, Vector3D(mySurf.getCoordinate(tile[0])), Vector3D(mySurf.getCoordinate(tile[1])), Vector3D(mySurf.getCoordinate(tile[2])));
+            bestDist = min(bestDist, (closest - targetVec).length());
+        }
+        const AString name = "signed distance query " + AString::number(q);
+        const float tolerance = EPSILON * radius;
+        const float signedDist = myHelper.dist(target, SignedDistanceHelper::EVEN_ODD);
+        if (abs(abs(signedDist) - bestDist) > tolerance)
+        {
+            setFailed(name + ": distance " + AString::number(signedDist) + ", brute force found " + AString::number(bestDist));
+            return;
+        }
+        const float targetRadius = targetVec.length();//the polyhedron is within the sphere, and contains the sphere of 0.9 times the radius
+        if ((targetRadius < 0.85f * radius && signedDist >= 0.0f) || (targetRadius > 1.05f * radius && signedDist <= 0.0f))
+        {
+            setFailed(name + ": wrong sign " + AString::number(signedDist) + " at radius " + AString::number(targetRadius));
+            return;
+        }
+        if (abs(myHelper.unsignedDist(target) - bestDist) > tolerance)
+        {
+            setFailed(name + ": unsigned distance " + AString::number(myHelper.unsignedDist(target)) + ", brute force found " + AString::number(bestDist));
+            return;
+        }
+        BarycentricInfo baryInfo;
+        myHelper.barycentricWeights(target, baryInfo);
+        if (abs(baryInfo.absDistance - bestDist) > tolerance || baryInfo.triangle < 0 || baryInfo.triangle >= numTiles)
+        {
+            setFailed(name + ": barycentric distance " + AString::number(baryInfo.absDistance) + ", brute force found " + AString::number(bestDist));
+            return;
+        }
+        Vector3D weighted;
+        float weightSum = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (baryInfo.baryWeights[i] < 0.0f)
+            {
+                setFailed(name + ": negative barycentric weight");
+                return;
+            }
+            weighted += Vector3D(mySurf.getCoordinate(baryInfo.nodes[i])) * baryInfo.baryWeights[i];
+            weightSum += baryInfo.baryWeights[i];
+        }
+        if (abs(weightSum - 1.0f) > EPSILON || (weighted - baryInfo.point).length() > tolerance || abs((weighted - targetVec).length() - bestDist) > tolerance)
+        {
+            setFailed(name + ": barycentric weights don't give the closest point");
+            return;
+        }
+    }
+}
+
+void SpatialSearchTest::execute()
+{
+    checkPointLocator();
+    checkSignedDistance();
+}
@@ -0,0 +1,141 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SphericalTriangleLocatorTest.h"
+
+#include "CaretPointer.h"
+#include "SignedDistanceHelper.h"
+#include "SphericalTriangleLocator.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "Vector3D.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float randFloat()
+    {
+        return (rand() % 20001) / 10000.0f - 1.0f;
+    }
+    
+    //the direction of point passes through the triangle if it is on the inner side of all three origin-edge planes
+    bool triangleContains(const SurfaceFile& mySurf, const int32_t triangle, const float point[3])
+    {
+        const int32_t* nodes = mySurf.getTriangle(triangle);
+        Vector3D verts[3], dir = point;
+        for (int i = 0; i < 3; ++i)
+        {
+            verts[i] = mySurf.getCoordinate(nodes[i]);
+        }
+        const float tolerance = 1e-6f * dir.length() * verts[0].length() * verts[1].length();//for queries that are exactly on an edge or vertex
+        for (int i = 0; i < 3; ++i)
+        {
+            if (dir.dot(verts[i].cross(verts[(i + 1) % 3])) < -tolerance) return false;
+        }
+        return true;
+    }
+    
+    bool sameWeights(const BarycentricInfo& left, const BarycentricInfo& right)
+    {
+        if (left.triangle != right.triangle || left.type != right.type) return false;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (left.nodes[i] != right.nodes[i] || left.baryWeights[i] != right.baryWeights[i]) return false;
+        }
+        return true;
+    }
+}
+
+SphericalTriangleLocatorTest::SphericalTriangleLocatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SphericalTriangleLocatorTest::execute()
+{
+    srand(31);
+    const float RADIUS = 100.0f;
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(5, RADIUS, coords, tiles);
+    const int32_t numNodes = (int32_t)(coords.size() / 3), numTiles = (int32_t)(tiles.size() / 3);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {//make the mesh irregular, but keep it on the sphere
+        Vector3D thisCoord(coords.data() + i * 3);
+        for (int j = 0; j < 3; ++j) thisCoord[j] += 0.3f * randFloat();
+        thisCoord = thisCoord.normal() * RADIUS;
+        for (int j = 0; j < 3; ++j) coords[i * 3 + j] = thisCoord[j];
+    }
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    SphericalTriangleLocator myLocator(&mySurf);
+    CaretPointer<SignedDistanceHelperBase> myBase(new SignedDistanceHelperBase(&mySurf));
+    SignedDistanceHelper myHelper(myBase);
+    //random directions at a few radii, and points exactly on vertices and edge midpoints, where the closest triangle is a tie
+    vector<Vector3D> queries;
+    for (int i = 0; i < 3000; ++i)
+    {
+        Vector3D dir(randFloat(), randFloat(), randFloat());
+        if (dir.length() < 0.01f) continue;
+        queries.push_back(dir.normal() * (RADIUS * (0.5f + (i % 3) * 0.5f)));
+    }
+    for (int32_t i = 0; i < numNodes; i += 7)
+    {
+        queries.push_back(Vector3D(coords.data() + i * 3));
+    }
+    for (int32_t t = 0; t < numTiles; t += 11)
+    {
+        const int32_t* nodes = mySurf.getTriangle(t);
+        queries.push_back((Vector3D(mySurf.getCoordinate(nodes[0])) + Vector3D(mySurf.getCoordinate(nodes[1]))) * 0.5f);
+    }
+    int32_t lastTriangle = -1;
+    for (int q = 0; q < (int)queries.size(); ++q)
+    {
+        const float* query = queries[q];
+        int32_t fromGrid = myLocator.locate(query), fromLast = myLocator.locate(query, lastTriangle);
+        if (fromGrid == -1 || !triangleContains(mySurf, fromGrid, query))
+        {
+            setFailed("locate from the bucket grid returned triangle " + AString::number(fromGrid) + ", which doesn't contain query " + AString::number(q));
+            return;
+        }
+        if (fromLast != -1 && !triangleContains(mySurf, fromLast, query))
+        {
+            setFailed("locate from the previous result returned triangle " + AString::number(fromLast) + ", which doesn't contain query " + AString::number(q));
+            return;
+        }
+        lastTriangle = fromGrid;
+        //the hint must only speed up the search, even a far away hint must give the same closest point
+        BarycentricInfo noHint, located, farHint;
+        myHelper.barycentricWeights(query, noHint);
+        myHelper.barycentricWeights(query, located, fromGrid);
+        myHelper.barycentricWeights(query, farHint, rand() % numTiles);
+        if (!sameWeights(noHint, located) || !sameWeights(noHint, farHint))
+        {
+            setFailed("barycentric weights for query " + AString::number(q) + " depend on the hint triangle: triangle " + AString::number(noHint.triangle) +
+                      " without a hint, " + AString::number(located.triangle) + " with the located hint, " + AString::number(farHint.triangle) + " with a random hint");
+            return;
+        }
+    }
+}
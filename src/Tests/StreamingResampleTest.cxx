@@ -0,0 +1,149 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "StreamingResampleTest.h"
+
+#include "AlgorithmCiftiResample.h"
+#include "CiftiFile.h"
+#include "FloatMatrix.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "VolumeSpace.h"
+
+#include <QDir>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //left cortex on a sphere, plus a small block of thalamus voxels
+    CiftiBrainModelsMap makeModels(const int64_t numNodes, const VolumeSpace& volSpace)
+    {
+        CiftiBrainModelsMap ret;
+        ret.setVolumeSpace(volSpace);
+        ret.addSurfaceModel(numNodes, StructureEnum::CORTEX_LEFT);
+        vector<int64_t> ijkList;
+        for (int64_t k = 2; k < 5; ++k)
+        {
+            for (int64_t j = 1; j < 5; ++j)
+            {
+                for (int64_t i = 2; i < 4; ++i)
+                {
+                    ijkList.push_back(i);
+                    ijkList.push_back(j);
+                    ijkList.push_back(k);
+                }
+            }
+        }
+        ret.addVolumeModel(StructureEnum::THALAMUS_LEFT, ijkList);
+        return ret;
+    }
+}
+
+StreamingResampleTest::StreamingResampleTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//-mem-limit resamples rows first and goes through tiled temporary files, it must match the in-memory column then row resampling
+void StreamingResampleTest::execute()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    SurfaceFile curSphere, newSphere;
+    TestSurfaces::makeSphere(3, 100.0f, coords, tiles);
+    TestSurfaces::makeSurfaceFile(coords, tiles, curSphere);
+    TestSurfaces::makeSphere(2, 100.0f, coords, tiles);
+    for (int i = 0; i < (int)coords.size(); i += 3)
+    {//rotate a little, so that new vertices don't land exactly on old ones
+        const float x = coords[i], z = coords[i + 2];
+        coords[i] = x * cos(0.2f) - z * sin(0.2f);
+        coords[i + 2] = x * sin(0.2f) + z * cos(0.2f);
+    }
+    TestSurfaces::makeSurfaceFile(coords, tiles, newSphere);
+    const int64_t volDims[3] = { 6, 6, 7 };
+    vector<vector<float> > sform = FloatMatrix::identity(4).getMatrix();
+    sform[0][0] = 2.0f; sform[1][1] = 2.0f; sform[2][2] = 2.0f;
+    const VolumeSpace volSpace(volDims, sform);
+    CiftiXML inXML, templateXML;
+    inXML.setNumberOfDimensions(2);
+    const CiftiBrainModelsMap inModels = makeModels(curSphere.getNumberOfNodes(), volSpace);
+    inXML.setMap(CiftiXML::ALONG_ROW, inModels);
+    inXML.setMap(CiftiXML::ALONG_COLUMN, inModels);
+    templateXML.setNumberOfDimensions(2);
+    const CiftiBrainModelsMap newModels = makeModels(newSphere.getNumberOfNodes(), volSpace);
+    templateXML.setMap(CiftiXML::ALONG_ROW, newModels);
+    templateXML.setMap(CiftiXML::ALONG_COLUMN, newModels);
+    CiftiFile ciftiIn, templateCifti;
+    ciftiIn.setCiftiXML(inXML);
+    templateCifti.setCiftiXML(templateXML);
+    const int64_t inLength = inXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    vector<float> row(inLength);
+    for (int64_t r = 0; r < inLength; ++r)
+    {
+        for (int64_t c = 0; c < inLength; ++c)
+        {
+            row[c] = rand() / (float)RAND_MAX;
+        }
+        ciftiIn.setRow(row.data(), r);
+    }
+    const FloatMatrix affine = FloatMatrix::identity(4);
+    CiftiFile tempCifti, expectCifti;
+    AlgorithmCiftiResample(NULL, &ciftiIn, CiftiXML::ALONG_COLUMN, &templateCifti, CiftiXML::ALONG_ROW, SurfaceResamplingMethodEnum::BARYCENTRIC, VolumeFile::TRILINEAR,
+                           &tempCifti, false, 0.0f, 0.0f, affine, &curSphere, &newSphere, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    AlgorithmCiftiResample(NULL, &tempCifti, CiftiXML::ALONG_ROW, &templateCifti, CiftiXML::ALONG_ROW, SurfaceResamplingMethodEnum::BARYCENTRIC, VolumeFile::TRILINEAR,
+                           &expectCifti, false, 0.0f, 0.0f, affine, &curSphere, &newSphere, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    const int64_t outLength = templateXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    vector<float> expectRow(outLength), actualRow(outLength);
+    //tiny limit for many blocks and row groups, a block width that doesn't divide the row length, and a limit large enough for one block
+    const int64_t limits[3] = { 4096, 7 * (inLength + outLength) * (int64_t)sizeof(float), (int64_t)1 << 30 };
+    for (int l = 0; l < 3; ++l)
+    {
+        CiftiFile streamCifti;
+        AlgorithmCiftiResample::resampleBothStreaming(&ciftiIn, &templateCifti, CiftiXML::ALONG_ROW, SurfaceResamplingMethodEnum::BARYCENTRIC, VolumeFile::TRILINEAR,
+                                                      &streamCifti, false, 0.0f, 0.0f, &affine, NULL, &curSphere, &newSphere, NULL, NULL,
+                                                      NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                                      AlgorithmVolumeDilate::WEIGHTED, 2.0f, AlgorithmMetricDilate::WEIGHTED, 2.0f, limits[l], QDir::tempPath());
+        const CiftiXML& streamXML = streamCifti.getCiftiXML();
+        if (streamXML.getDimensionLength(CiftiXML::ALONG_ROW) != outLength || streamXML.getDimensionLength(CiftiXML::ALONG_COLUMN) != outLength)
+        {
+            setFailed("streaming resample with memory limit " + AString::number(limits[l]) + " has the wrong output dimensions");
+            continue;
+        }
+        for (int64_t r = 0; r < outLength; ++r)
+        {
+            expectCifti.getRow(expectRow.data(), r);
+            streamCifti.getRow(actualRow.data(), r);
+            for (int64_t c = 0; c < outLength; ++c)
+            {//the order of the two linear resamplings is swapped, so allow for rounding
+                if (abs(expectRow[c] - actualRow[c]) > 1e-5f * (1.0f + abs(expectRow[c])))
+                {
+                    setFailed("streaming resample with memory limit " + AString::number(limits[l]) + " differs at row " + AString::number(r) + ", column " +
+                              AString::number(c) + ", expected " + AString::number(expectRow[c]) + ", got " + AString::number(actualRow[c]));
+                    return;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceBuffersTest.h"
+
+#include "GraphicsOpenGLSurfaceBuffers.h"
+#include "Matrix4x4.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SurfaceBuffersTest::SurfaceBuffersTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SurfaceBuffersTest::execute()
+{
+    checkModificationCounts();
+    checkFallback();
+}
+
+//the buffers only reload when these counts change, so every edit must change them, and reading the surface must not
+void SurfaceBuffersTest::checkModificationCounts()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(3, 50.0f, coords, tiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    int64_t geometryCount = mySurf.getGeometryModificationCount(), coloringCount = mySurf.getNodeColoringModificationCount();
+    //reading
+    mySurf.computeNormals();
+    vector<float> areas;
+    mySurf.computeNodeAreas(areas);
+    mySurf.getTopologyHelper();
+    mySurf.getSignedDistanceHelper();
+    mySurf.getBoundingBox();
+    mySurf.getSurfaceNodeColoringRgbaForBrowserTab(0);
+    if (mySurf.getGeometryModificationCount() != geometryCount)
+    {
+        setFailed("reading the surface changed the geometry modification count, buffers would reload every frame");
+    }
+    if (mySurf.getNodeColoringModificationCount() != coloringCount)
+    {
+        setFailed("reading the surface changed the node coloring modification count, buffers would reload every frame");
+    }
+    //each kind of geometry edit
+    const float newCoord[3] = { 1.0f, 2.0f, 3.0f };
+    mySurf.setCoordinate(5, newCoord);
+    if (mySurf.getGeometryModificationCount() == geometryCount) setFailed("setCoordinate didn't change the geometry modification count");
+    geometryCount = mySurf.getGeometryModificationCount();
+    mySurf.computeNormals();//incremental update of the normals, which are also in the buffers
+    if (mySurf.getGeometryModificationCount() == geometryCount) setFailed("updating normals after setCoordinate didn't change the geometry modification count");
+    geometryCount = mySurf.getGeometryModificationCount();
+    mySurf.setCoordinates(coords.data());
+    mySurf.computeNormals();
+    if (mySurf.getGeometryModificationCount() == geometryCount) setFailed("setCoordinates didn't change the geometry modification count");
+    geometryCount = mySurf.getGeometryModificationCount();
+    const int32_t flipped[3] = { tiles[2], tiles[1], tiles[0] };
+    mySurf.setTriangle(0, flipped);
+    if (mySurf.getGeometryModificationCount() == geometryCount) setFailed("setTriangle didn't change the geometry modification count");
+    geometryCount = mySurf.getGeometryModificationCount();
+    Matrix4x4 myMatrix;
+    myMatrix.translate(1.0, 2.0, 3.0);
+    mySurf.applyMatrix(myMatrix);
+    if (mySurf.getGeometryModificationCount() == geometryCount) setFailed("applyMatrix didn't change the geometry modification count");
+    //colorings, every tab and kind shares one count
+    const int32_t numNodes = mySurf.getNumberOfNodes();
+    vector<float> rgba(numNodes * 4, 0.5f);
+    mySurf.setSurfaceNodeColoringRgbaForBrowserTab(0, rgba.data());
+    if (mySurf.getNodeColoringModificationCount() == coloringCount) setFailed("setting surface node coloring didn't change the coloring modification count");
+    coloringCount = mySurf.getNodeColoringModificationCount();
+    mySurf.setSurfaceMontageNodeColoringRgbaForBrowserTab(1, rgba.data());
+    if (mySurf.getNodeColoringModificationCount() == coloringCount) setFailed("setting montage node coloring didn't change the coloring modification count");
+    coloringCount = mySurf.getNodeColoringModificationCount();
+    mySurf.setWholeBrainNodeColoringRgbaForBrowserTab(2, rgba.data());
+    if (mySurf.getNodeColoringModificationCount() == coloringCount) setFailed("setting whole brain node coloring didn't change the coloring modification count");
+}
+
+//without an OpenGL context that can create buffers, every load must fail so drawing uses client memory
+void SurfaceBuffersTest::checkFallback()
+{
+    vector<float> coords, normals;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(2, 50.0f, coords, tiles);
+    normals = coords;
+    const int32_t numNodes = (int32_t)(coords.size() / 3), numTiles = (int32_t)(tiles.size() / 3);
+    vector<float> rgba(numNodes * 4, 1.0f);
+    GraphicsOpenGLSurfaceBuffers myBuffers;
+    if (myBuffers.loadGeometry(NULL, 1, coords.data(), normals.data(), numNodes, tiles.data(), numTiles))
+    {
+        setFailed("loading geometry without an OpenGL context succeeded");
+    }
+    int notAContext = 0;//nothing in the test driver creates buffer objects, so buffer creation fails as in an unsupported context
+    if (myBuffers.loadGeometry(&notAContext, 1, coords.data(), normals.data(), numNodes, tiles.data(), numTiles))
+    {
+        setFailed("loading geometry succeeded when no buffer objects could be created");
+    }
+    if (myBuffers.loadColors(rgba.data(), 1))
+    {
+        setFailed("loading colors succeeded without loaded geometry");
+    }
+    if (myBuffers.loadLevelOfDetailTriangles(0, tiles.data(), numTiles))
+    {
+        setFailed("loading level of detail triangles succeeded without loaded geometry");
+    }
+}
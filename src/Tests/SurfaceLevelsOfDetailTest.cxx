@@ -0,0 +1,133 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceLevelsOfDetailTest.h"
+
+#include "SurfaceLevelsOfDetail.h"
+#include "TestSurfaces.h"
+
+#include <atomic>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SurfaceLevelsOfDetailTest::SurfaceLevelsOfDetailTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SurfaceLevelsOfDetailTest::checkLevels(const AString& name, const vector<float>& coords, const vector<int32_t>& tiles,
+                                            const bool closed, const set<int32_t>& keptVertices)
+{
+    const int32_t numNodes = (int32_t)(coords.size() / 3), numTiles = (int32_t)(tiles.size() / 3);
+    SurfaceLevelsOfDetail lod(coords.data(), numNodes, tiles.data(), numTiles, 0);
+    if (lod.getNumberOfLevels() < 1)
+    {
+        setFailed(name + ": expected levels from " + AString::number(numTiles) + " triangles, got " + AString::number(lod.getNumberOfLevels()));
+        return;
+    }
+    int32_t previousCount = numTiles;
+    for (int32_t level = 0; level < lod.getNumberOfLevels(); ++level)
+    {
+        const AString levelName = name + " level " + AString::number(level);
+        const int32_t count = lod.getLevelNumberOfTriangles(level);
+        const int32_t* levelTiles = lod.getLevelTriangles(level);
+        if (count <= 0 || count >= previousCount)
+        {
+            setFailed(levelName + ": " + AString::number(count) + " triangles after " + AString::number(previousCount));
+            return;
+        }
+        previousCount = count;
+        set<pair<int32_t, int32_t> > edges;//directed, so a repeat means a folded or duplicated triangle
+        set<int32_t> used;
+        for (int32_t t = 0; t < count; ++t)
+        {
+            for (int e = 0; e < 3; ++e)
+            {
+                const int32_t a = levelTiles[t * 3 + e], b = levelTiles[t * 3 + (e + 1) % 3];
+                if (a < 0 || a >= numNodes || a == b)
+                {
+                    setFailed(levelName + ": invalid triangle " + AString::number(t));
+                    return;
+                }
+                if (!edges.insert(make_pair(a, b)).second)
+                {
+                    setFailed(levelName + ": edge " + AString::number(a) + "-" + AString::number(b) + " is used twice in the same direction");
+                    return;
+                }
+                used.insert(a);
+            }
+        }
+        if (closed)
+        {
+            for (set<pair<int32_t, int32_t> >::const_iterator iter = edges.begin(); iter != edges.end(); ++iter)
+            {
+                if (edges.find(make_pair(iter->second, iter->first)) == edges.end())
+                {
+                    setFailed(levelName + ": closed surface has a hole at edge " + AString::number(iter->first) + "-" + AString::number(iter->second));
+                    return;
+                }
+            }
+        }
+        for (set<int32_t>::const_iterator iter = keptVertices.begin(); iter != keptVertices.end(); ++iter)
+        {
+            if (used.find(*iter) == used.end())
+            {
+                setFailed(levelName + ": boundary vertex " + AString::number(*iter) + " was removed");
+                return;
+            }
+        }
+    }
+    if (lod.getLevelForNumberOfTriangles(numTiles) != -1 ||
+        lod.getLevelForNumberOfTriangles(0) != lod.getNumberOfLevels() - 1 ||
+        lod.getLevelForNumberOfTriangles(lod.getLevelNumberOfTriangles(0)) != 0)
+    {
+        setFailed(name + ": wrong level selected for number of triangles");
+    }
+}
+
+void SurfaceLevelsOfDetailTest::execute()
+{
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(6, 1.0f, coords, tiles);
+    checkLevels("sphere", coords, tiles, true, set<int32_t>());
+    
+    const int sheetDim = 120;
+    TestSurfaces::makeSheet(sheetDim, coords, tiles);
+    set<int32_t> boundary;
+    for (int i = 0; i < sheetDim; ++i)
+    {
+        boundary.insert(i);
+        boundary.insert((sheetDim - 1) * sheetDim + i);
+        boundary.insert(i * sheetDim);
+        boundary.insert(i * sheetDim + sheetDim - 1);
+    }
+    checkLevels("sheet", coords, tiles, false, boundary);
+    
+    const atomic<bool> cancelFlag(true);
+    SurfaceLevelsOfDetail canceled(coords.data(), (int32_t)(coords.size() / 3), tiles.data(), (int32_t)(tiles.size() / 3), 0, &cancelFlag);
+    if (canceled.getNumberOfLevels() != 0)
+    {
+        setFailed("canceled simplification created " + AString::number(canceled.getNumberOfLevels()) + " levels");
+    }
+}
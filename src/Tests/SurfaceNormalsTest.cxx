@@ -0,0 +1,124 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SurfaceNormalsTest.h"
+
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    float randFloat()
+    {
+        return (rand() % 20001) / 10000.0f - 1.0f;
+    }
+    
+    void moveNodes(SurfaceFile& mySurf, const int32_t numToMove)
+    {
+        const int32_t numNodes = mySurf.getNumberOfNodes();
+        for (int32_t i = 0; i < numToMove; ++i)
+        {
+            const int32_t node = rand() % numNodes;
+            const float* oldCoord = mySurf.getCoordinate(node);
+            mySurf.setCoordinate(node, oldCoord[0] + randFloat(), oldCoord[1] + randFloat(), oldCoord[2] + randFloat());
+        }
+    }
+}
+
+SurfaceNormalsTest::SurfaceNormalsTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//normals and node areas of a surface whose nodes were moved must be identical to those of a new surface with the same coordinates
+bool SurfaceNormalsTest::compareWithFullRecompute(SurfaceFile& moved, const AString& description)
+{
+    moved.computeNormals();
+    const int32_t numNodes = moved.getNumberOfNodes(), numTiles = moved.getNumberOfTriangles();
+    vector<float> coords(moved.getCoordinateData(), moved.getCoordinateData() + numNodes * 3);
+    vector<int32_t> tiles(numTiles * 3);
+    for (int32_t t = 0; t < numTiles; ++t)
+    {
+        const int32_t* thisTri = moved.getTriangle(t);
+        for (int j = 0; j < 3; ++j) tiles[t * 3 + j] = thisTri[j];
+    }
+    SurfaceFile fresh;
+    TestSurfaces::makeSurfaceFile(coords, tiles, fresh);
+    const float* movedNormals = moved.getNormalData(), * freshNormals = fresh.getNormalData();
+    for (int32_t i = 0; i < numNodes * 3; ++i)
+    {
+        if (movedNormals[i] != freshNormals[i])
+        {
+            setFailed(description + ": normal of node " + AString::number(i / 3) + " is " + AString::number(movedNormals[i]) +
+                      " in component " + AString::number(i % 3) + ", full recompute gives " + AString::number(freshNormals[i]));
+            return false;
+        }
+    }
+    vector<float> movedAreas, freshAreas;
+    moved.computeNodeAreas(movedAreas);
+    fresh.computeNodeAreas(freshAreas);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (movedAreas[i] != freshAreas[i])
+        {
+            setFailed(description + ": area of node " + AString::number(i) + " is " + AString::number(movedAreas[i]) +
+                      ", full recompute gives " + AString::number(freshAreas[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+void SurfaceNormalsTest::execute()
+{
+    srand(53);
+    vector<float> coords;
+    vector<int32_t> tiles;
+    TestSurfaces::makeSphere(5, 100.0f, coords, tiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(coords, tiles, mySurf);
+    const int32_t numNodes = mySurf.getNumberOfNodes();
+    //a few nodes, updated incrementally
+    moveNodes(mySurf, 20);
+    if (!compareWithFullRecompute(mySurf, "after moving 20 nodes")) return;
+    //again, so the incremental update starts from incrementally updated normals, and some nodes move twice before one update
+    moveNodes(mySurf, 50);
+    moveNodes(mySurf, 50);
+    if (!compareWithFullRecompute(mySurf, "after moving 100 more nodes")) return;
+    //neighboring nodes, so that triangles with more than one moved node are only counted once
+    const int32_t* firstTri = mySurf.getTriangle(0);
+    for (int j = 0; j < 3; ++j)
+    {
+        const float* oldCoord = mySurf.getCoordinate(firstTri[j]);
+        mySurf.setCoordinate(firstTri[j], oldCoord[0] * 1.1f, oldCoord[1] * 1.1f, oldCoord[2] * 1.1f);
+    }
+    if (!compareWithFullRecompute(mySurf, "after moving a whole triangle")) return;
+    //more than an eighth of the nodes, which falls back to recomputing everything
+    moveNodes(mySurf, numNodes / 4);
+    if (!compareWithFullRecompute(mySurf, "after moving a quarter of the nodes")) return;
+    //and incremental updates must still work after the fallback
+    moveNodes(mySurf, 10);
+    compareWithFullRecompute(mySurf, "after moving 10 nodes following a full recompute");
+}
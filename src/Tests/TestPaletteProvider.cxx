@@ -0,0 +1,48 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TestPaletteProvider.h"
+
+#include "EventManager.h"
+#include "EventPaletteGetByName.h"
+
+using namespace caret;
+
+TestPaletteProvider::TestPaletteProvider()
+{
+    EventManager::get()->addEventListener(this, EventTypeEnum::EVENT_PALETTE_GET_BY_NAME);
+}
+
+TestPaletteProvider::~TestPaletteProvider()
+{
+    EventManager::get()->removeAllEventsFromListener(this);
+}
+
+void TestPaletteProvider::receiveEvent(Event* event)
+{
+    EventPaletteGetByName* paletteEvent = dynamic_cast<EventPaletteGetByName*>(event);
+    if (paletteEvent == NULL) return;
+    Palette* palette = m_paletteFile.getPaletteByName(paletteEvent->getPaletteName());
+    if (palette != NULL)
+    {
+        paletteEvent->setPalette(palette);
+        paletteEvent->setEventProcessed();
+    }
+}
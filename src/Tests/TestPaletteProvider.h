@@ -0,0 +1,41 @@
+#ifndef __TEST_PALETTE_PROVIDER_H__
+#define __TEST_PALETTE_PROVIDER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "EventListenerInterface.h"
+#include "PaletteFile.h"
+
+namespace caret
+{
+
+    //palettes are normally provided by the Brain, this answers palette requests from coloring code while it exists
+    class TestPaletteProvider : public EventListenerInterface
+    {
+        PaletteFile m_paletteFile;
+    public:
+        TestPaletteProvider();
+        ~TestPaletteProvider();
+        void receiveEvent(Event* event);
+    };
+
+}
+#endif // __TEST_PALETTE_PROVIDER_H__
@@ -0,0 +1,106 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TestSurfaces.h"
+
+#include "SurfaceFile.h"
+
+#include <cmath>
+#include <map>
+#include <utility>
+
+using namespace caret;
+using namespace std;
+
+void TestSurfaces::makeSphere(const int subdivisions, const float radius, vector<float>& coords, vector<int32_t>& tiles)
+{
+    coords = { 1, 0, 0,  -1, 0, 0,  0, 1, 0,  0, -1, 0,  0, 0, 1,  0, 0, -1 };
+    tiles = { 0, 2, 4,  2, 1, 4,  1, 3, 4,  3, 0, 4,  2, 0, 5,  1, 2, 5,  3, 1, 5,  0, 3, 5 };
+    for (int s = 0; s < subdivisions; ++s)
+    {
+        map<pair<int32_t, int32_t>, int32_t> midpoints;
+        vector<int32_t> newTiles;
+        for (int t = 0; t < (int)tiles.size(); t += 3)
+        {
+            int32_t mid[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                const int32_t a = tiles[t + e], b = tiles[t + (e + 1) % 3];
+                const pair<int32_t, int32_t> key(min(a, b), max(a, b));
+                map<pair<int32_t, int32_t>, int32_t>::iterator iter = midpoints.find(key);
+                if (iter == midpoints.end())
+                {
+                    float xyz[3];
+                    for (int i = 0; i < 3; ++i) xyz[i] = coords[a * 3 + i] + coords[b * 3 + i];
+                    const float length = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+                    mid[e] = (int32_t)(coords.size() / 3);
+                    for (int i = 0; i < 3; ++i) coords.push_back(xyz[i] / length);
+                    midpoints[key] = mid[e];
+                } else {
+                    mid[e] = iter->second;
+                }
+            }
+            const int32_t add[12] = { tiles[t], mid[0], mid[2],  mid[0], tiles[t + 1], mid[1],
+                                      mid[2], mid[1], tiles[t + 2],  mid[0], mid[1], mid[2] };
+            newTiles.insert(newTiles.end(), add, add + 12);
+        }
+        tiles = newTiles;
+    }
+    for (int i = 0; i < (int)coords.size(); ++i)
+    {
+        coords[i] *= radius;
+    }
+}
+
+void TestSurfaces::makeSheet(const int dim, vector<float>& coords, vector<int32_t>& tiles)
+{
+    coords.clear();
+    tiles.clear();
+    for (int j = 0; j < dim; ++j)
+    {
+        for (int i = 0; i < dim; ++i)
+        {
+            coords.push_back((float)i);
+            coords.push_back((float)j);
+            coords.push_back(3.0f * sin(i * 0.1f) * cos(j * 0.07f));
+        }
+    }
+    for (int j = 0; j < dim - 1; ++j)
+    {
+        for (int i = 0; i < dim - 1; ++i)
+        {
+            const int32_t v = j * dim + i;
+            const int32_t add[6] = { v, v + 1, v + dim + 1,  v, v + dim + 1, v + dim };
+            tiles.insert(tiles.end(), add, add + 6);
+        }
+    }
+}
+
+void TestSurfaces::makeSurfaceFile(const vector<float>& coords, const vector<int32_t>& tiles, SurfaceFile& surfOut)
+{
+    const int32_t numNodes = (int32_t)(coords.size() / 3), numTiles = (int32_t)(tiles.size() / 3);
+    surfOut.setNumberOfNodesAndTriangles(numNodes, numTiles);
+    surfOut.setCoordinates(coords.data());
+    for (int32_t t = 0; t < numTiles; ++t)
+    {
+        surfOut.setTriangle(t, tiles.data() + t * 3);
+    }
+    surfOut.computeNormals();
+}
@@ -0,0 +1,46 @@
+#ifndef __TEST_SURFACES_H__
+#define __TEST_SURFACES_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace caret
+{
+
+    class SurfaceFile;
+    
+    //small meshes built in memory, so that tests don't need data files
+    namespace TestSurfaces
+    {
+        //octahedron with each triangle subdivided into 4, repeatedly, projected onto a sphere
+        void makeSphere(const int subdivisions, const float radius, std::vector<float>& coords, std::vector<int32_t>& tiles);
+        
+        //square sheet in the xy plane with unit spacing, bumped in z, triangles counterclockwise from +z
+        void makeSheet(const int dim, std::vector<float>& coords, std::vector<int32_t>& tiles);
+        
+        void makeSurfaceFile(const std::vector<float>& coords, const std::vector<int32_t>& tiles, SurfaceFile& surfOut);
+    }
+
+}
+#endif // __TEST_SURFACES_H__
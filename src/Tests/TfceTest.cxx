@@ -0,0 +1,120 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TfceTest.h"
+#include "TfceHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int GRID_X = 23, GRID_Y = 17;
+    
+    struct GridNeighbors
+    {
+        void operator()(const int64_t& index, vector<int64_t>& neighOut)
+        {
+            neighOut.clear();
+            int x = index % GRID_X, y = index / GRID_X;
+            if (x > 0) neighOut.push_back(index - 1);
+            if (x < GRID_X - 1) neighOut.push_back(index + 1);
+            if (y > 0) neighOut.push_back(index - GRID_X);
+            if (y < GRID_Y - 1) neighOut.push_back(index + GRID_X);
+        }
+    };
+}
+
+TfceTest::TfceTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TfceTest::execute()
+{
+    const int numElems = GRID_X * GRID_Y;
+    const float param_e = 0.5f, param_h = 2.0f;
+    vector<float> data(numElems), areas(numElems);
+    for (int i = 0; i < numElems; ++i)
+    {
+        data[i] = (rand() % 21 - 5) / 3.0f;//lots of ties and some negatives
+        areas[i] = 0.5f + (rand() % 10) / 10.0f;
+    }
+    GridNeighbors myNeighbors;
+    vector<double> unionFind(numElems, 0.0);
+    TfceHelper myTfce(param_e, param_h);
+    myTfce.addPositive(numElems, data.data(), areas.data(), 0.0f, myNeighbors, unionFind.data());
+    vector<float> levels;//brute force: the extent is constant between consecutive distinct values, so flood fill once per level
+    for (int i = 0; i < numElems; ++i)
+    {
+        if (data[i] > 0.0f) levels.push_back(data[i]);
+    }
+    sort(levels.begin(), levels.end());
+    levels.erase(unique(levels.begin(), levels.end()), levels.end());
+    vector<double> bruteForce(numElems, 0.0);
+    double lastLevel = 0.0, integrated_h = param_h + 1.0;
+    for (int l = 0; l < (int)levels.size(); ++l)
+    {
+        vector<int> cluster(numElems, -1);
+        vector<double> clusterArea;
+        for (int i = 0; i < numElems; ++i)
+        {
+            if (data[i] < levels[l] || cluster[i] != -1) continue;
+            int thisCluster = (int)clusterArea.size();
+            clusterArea.push_back(0.0);
+            vector<int64_t> stack(1, i), neighbors;
+            cluster[i] = thisCluster;
+            while (!stack.empty())
+            {
+                int64_t elem = stack.back();
+                stack.pop_back();
+                clusterArea[thisCluster] += areas[elem];
+                myNeighbors(elem, neighbors);
+                for (int j = 0; j < (int)neighbors.size(); ++j)
+                {
+                    if (data[neighbors[j]] >= levels[l] && cluster[neighbors[j]] == -1)
+                    {
+                        cluster[neighbors[j]] = thisCluster;
+                        stack.push_back(neighbors[j]);
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < numElems; ++i)
+        {
+            if (cluster[i] != -1)
+            {
+                bruteForce[i] += pow(clusterArea[cluster[i]], (double)param_e) * (pow((double)levels[l], integrated_h) - pow(lastLevel, integrated_h)) / integrated_h;
+            }
+        }
+        lastLevel = levels[l];
+    }
+    for (int i = 0; i < numElems; ++i)
+    {
+        if (abs(bruteForce[i] - unionFind[i]) > 1e-6 * (1.0 + abs(bruteForce[i])))
+        {
+            setFailed("mismatch at element " + AString::number(i) + ", union-find: " + AString::number(unionFind[i]) + ", brute force: " + AString::number(bruteForce[i]));
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VolumeColoringTest.h"
+
+#include "NodeAndVoxelColoring.h"
+#include "PaletteColorMapping.h"
+#include "TestPaletteProvider.h"
+#include "VolumeFile.h"
+#include "VolumeFileVoxelColorizer.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //large enough that the colorizer colors all but the requested voxels in the background
+    const int64_t DIM_I = 256, DIM_J = 256, DIM_K = 64;
+    
+    void makeVolume(VolumeFile& volOut, const int64_t numMaps)
+    {
+        vector<int64_t> dims(4);
+        dims[0] = DIM_I;
+        dims[1] = DIM_J;
+        dims[2] = DIM_K;
+        dims[3] = numMaps;
+        vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+        for (int i = 0; i < 3; ++i)
+        {
+            sform[i][i] = 1.0f;
+        }
+        volOut.reinitialize(dims, sform);
+        volOut.setType(SubvolumeAttributes::FUNCTIONAL);
+        const int64_t frameSize = DIM_I * DIM_J * DIM_K;
+        vector<float> frame(frameSize);
+        for (int64_t m = 0; m < numMaps; ++m)
+        {
+            for (int64_t i = 0; i < frameSize; ++i)
+            {
+                frame[i] = (rand() % 20001) / 2000.0f - 5.0f;
+            }
+            volOut.setFrame(frame.data(), m);
+        }
+    }
+}
+
+VolumeColoringTest::VolumeColoringTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+//the colors of an axial slice must match coloring the whole map with the map's current palette settings
+bool VolumeColoringTest::checkSlice(const VolumeFileVoxelColorizer& colorizer, VolumeFile& volume, const int32_t mapIndex, const int64_t sliceIndex, const AString& description)
+{
+    const int64_t frameSize = DIM_I * DIM_J * DIM_K, sliceSize = DIM_I * DIM_J;
+    vector<uint8_t> expected(frameSize * 4), sliceRGBA(sliceSize * 4);
+    const float* mapData = volume.getFrame(mapIndex);
+    const PaletteColorMapping* mapping = volume.getMapPaletteColorMapping(mapIndex);
+    NodeAndVoxelColoring::colorScalarsWithPalette(volume.getMapFastStatistics(mapIndex), mapping, mapData, mapping, mapData,
+                                                  frameSize, expected.data(), true);
+    colorizer.getVoxelColorsForSliceInMap(mapIndex, VolumeSliceViewPlaneEnum::AXIAL, sliceIndex, DisplayGroupEnum::DISPLAY_GROUP_TAB, 0, sliceRGBA.data());
+    const int64_t sliceStart = sliceIndex * sliceSize * 4;
+    for (int64_t i = 0; i < sliceSize * 4; ++i)
+    {
+        if (sliceRGBA[i] != expected[sliceStart + i])
+        {
+            setFailed(description + ": voxel " + AString::number(i / 4) + " of slice " + AString::number(sliceIndex) + " in map " + AString::number(mapIndex) +
+                      " has " + AString::number(sliceRGBA[i]) + " in component " + AString::number(i % 4) + ", expected " + AString::number(expected[sliceStart + i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VolumeColoringTest::checkColored(const VolumeFileVoxelColorizer& colorizer, const int32_t mapIndex, const bool expectColored, const AString& description)
+{
+    if (colorizer.isMapColored(mapIndex) != expectColored)
+    {
+        setFailed(description + ": map " + AString::number(mapIndex) + (expectColored ? " should" : " should not") + " be colored");
+        return false;
+    }
+    return true;
+}
+
+void VolumeColoringTest::execute()
+{
+    srand(11);
+    TestPaletteProvider paletteProvider;
+    VolumeFile volume;
+    makeVolume(volume, 3);
+    VolumeFileVoxelColorizer colorizer(&volume);
+    
+    //canceled: a palette change while the map is colored in the background discards the thread's coloring
+    if (!checkSlice(colorizer, volume, 0, 10, "first request")) return;
+    if (!checkColored(colorizer, 0, false, "first request")) return;
+    volume.getMapPaletteColorMapping(0)->setSelectedPaletteName("videen_style");
+    colorizer.assignVoxelColorsForMap(0);
+    colorizer.waitForBackgroundColoring();
+    if (!checkColored(colorizer, 0, false, "palette changed")) return;
+    if (!checkSlice(colorizer, volume, 0, 20, "palette changed")) return;
+    colorizer.waitForBackgroundColoring();
+    if (!checkSlice(colorizer, volume, 0, 30, "background coloring finished")) return;
+    if (!checkColored(colorizer, 0, true, "background coloring finished")) return;
+    
+    //harvested: starting the background coloring of another map keeps the coloring of a finished thread
+    if (!checkSlice(colorizer, volume, 1, 5, "second map")) return;
+    colorizer.waitForBackgroundColoring();
+    if (!checkSlice(colorizer, volume, 2, 5, "third map")) return;
+    if (!checkColored(colorizer, 1, true, "third map requested after second map finished")) return;
+    if (!checkColored(colorizer, 2, false, "third map requested")) return;
+    colorizer.waitForBackgroundColoring();
+    for (int32_t m = 0; m < 3; ++m)
+    {
+        if (!checkSlice(colorizer, volume, m, DIM_K - 1, "all maps colored")) return;
+        if (!checkColored(colorizer, m, true, "all maps colored")) return;
+    }
+    
+    //evicted: the memory limit applies to the colorings of all files, least recently used first
+    const int64_t mapBytes = DIM_I * DIM_J * DIM_K * 4;
+    const int64_t savedMaximum = VolumeFileVoxelColorizer::getMaximumColoringMemoryBytes();
+    VolumeFileVoxelColorizer::setMaximumColoringMemoryBytes(mapBytes * 3 + mapBytes / 2);
+    VolumeFile otherVolume;
+    makeVolume(otherVolume, 1);
+    VolumeFileVoxelColorizer otherColorizer(&otherVolume);
+    if (!checkSlice(colorizer, volume, 2, 0, "before other file")) return;
+    if (!checkSlice(colorizer, volume, 0, 0, "before other file")) return;
+    if (!checkSlice(colorizer, volume, 1, 0, "before other file")) return;
+    if (!checkSlice(otherColorizer, otherVolume, 0, 0, "other file")) return;
+    otherColorizer.waitForBackgroundColoring();
+    if (!checkSlice(otherColorizer, otherVolume, 0, 1, "other file finished")) return;
+    const int64_t usedBytes = VolumeFileVoxelColorizer::getColoringMemoryBytes();
+    VolumeFileVoxelColorizer::setMaximumColoringMemoryBytes(savedMaximum);
+    if (!checkColored(otherColorizer, 0, true, "other file finished")) return;
+    if (!checkColored(colorizer, 2, false, "least recently used map of first file")) return;
+    if (!checkColored(colorizer, 0, true, "recently used map of first file")) return;
+    if (!checkColored(colorizer, 1, true, "most recently used map of first file")) return;
+    if (usedBytes > mapBytes * 3 + mapBytes / 2)
+    {
+        setFailed("colorings use " + AString::number(usedBytes) + " bytes, over the limit of " + AString::number(mapBytes * 3 + mapBytes / 2));
+        return;
+    }
+    if (!checkSlice(colorizer, volume, 2, 3, "evicted map colored again")) return;
+}
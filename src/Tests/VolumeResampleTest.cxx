@@ -0,0 +1,178 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VolumeResampleTest.h"
+
+#include "AlgorithmVolumeAffineResample.h"
+#include "AlgorithmVolumeResample.h"
+#include "AlgorithmVolumeWarpfieldResample.h"
+#include "FloatMatrix.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    vector<vector<float> > makeSform(const float spacing, const float origin)
+    {
+        vector<vector<float> > ret(3, vector<float>(4, 0.0f));
+        for (int i = 0; i < 3; ++i)
+        {
+            ret[i][i] = spacing;
+            ret[i][3] = origin;
+        }
+        return ret;
+    }
+    
+    float linearFunc(const float xyz[3])
+    {
+        return 0.5f * xyz[0] - 0.3f * xyz[1] + 0.2f * xyz[2] + 3.0f;
+    }
+    
+    //map 0 is linear in world coordinates, so trilinear resampling reproduces it exactly, map 1 is noise
+    void makeInput(VolumeFile& volOut)
+    {
+        vector<int64_t> dims(4, 20);
+        dims[3] = 2;
+        volOut.reinitialize(dims, makeSform(2.0f, -20.0f));
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    float xyz[3];
+                    volOut.indexToSpace(i, j, k, xyz);
+                    volOut.setValue(linearFunc(xyz), i, j, k, 0);
+                    volOut.setValue((rand() % 1000) / 100.0f, i, j, k, 1);
+                }
+            }
+        }
+    }
+    
+    //covers only part of the output space, so some output voxels get invalid displacements
+    void makeWarpfield(VolumeFile& volOut)
+    {
+        vector<int64_t> dims(4, 8);
+        dims[3] = 3;
+        volOut.reinitialize(dims, makeSform(2.5f, -6.0f));
+        for (int64_t k = 0; k < dims[2]; ++k)
+        {
+            for (int64_t j = 0; j < dims[1]; ++j)
+            {
+                for (int64_t i = 0; i < dims[0]; ++i)
+                {
+                    volOut.setValue(1.2f * sin(j * 0.7f), i, j, k, 0);
+                    volOut.setValue(0.8f * cos(k * 0.5f + i * 0.3f), i, j, k, 1);
+                    volOut.setValue(-0.6f * sin(i * 0.9f), i, j, k, 2);
+                }
+            }
+        }
+    }
+    
+    FloatMatrix makeAffine()
+    {
+        FloatMatrix ret = FloatMatrix::identity(4);
+        const float angle = 5.0f * 3.14159265f / 180.0f;
+        ret[0][0] = cos(angle); ret[0][1] = -sin(angle);
+        ret[1][0] = sin(angle); ret[1][1] = cos(angle);
+        ret[0][3] = 1.0f; ret[1][3] = -0.5f; ret[2][3] = 0.7f;
+        return ret;
+    }
+}
+
+VolumeResampleTest::VolumeResampleTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void VolumeResampleTest::compareVolumes(const VolumeFile& fused, const VolumeFile& reference, const int64_t map, const float tolerance, const AString& description)
+{
+    vector<int64_t> dims;
+    fused.getDimensions(dims);
+    int64_t numCompared = 0;
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                const float fusedVal = fused.getValue(i, j, k, map), refVal = reference.getValue(i, j, k, map);
+                const bool fusedInvalid = (fusedVal == VolumeFile::INVALID_INTERP_VALUE), refInvalid = (refVal == VolumeFile::INVALID_INTERP_VALUE);
+                if (fusedInvalid != refInvalid || abs(fusedVal - refVal) > tolerance * (1.0f + abs(refVal)))
+                {
+                    setFailed(description + " differs at voxel " + AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k) +
+                              ": " + AString::number(fusedVal) + " vs " + AString::number(refVal));
+                    return;
+                }
+                if (!refInvalid) ++numCompared;
+            }
+        }
+    }
+    if (numCompared == 0)
+    {
+        setFailed(description + " had no valid voxels to compare");
+    }
+}
+
+void VolumeResampleTest::execute()
+{
+    srand(23);
+    VolumeFile inVol, warpVol;
+    makeInput(inVol);
+    makeWarpfield(warpVol);
+    const FloatMatrix myAffine = makeAffine();
+    const int64_t outDims[3] = { 12, 12, 12 };
+    const vector<vector<float> > outSform = makeSform(1.5f, -8.0f);
+    //a single step must match the single-transform commands
+    {
+        vector<AlgorithmVolumeResample::TransformStep> transforms(1, AlgorithmVolumeResample::TransformStep(myAffine));
+        VolumeFile fusedVol, refVol;
+        AlgorithmVolumeResample(NULL, &inVol, transforms, outDims, outSform, VolumeFile::CUBIC, &fusedVol);
+        AlgorithmVolumeAffineResample(NULL, &inVol, myAffine, outDims, outSform, VolumeFile::CUBIC, &refVol);
+        compareVolumes(fusedVol, refVol, 0, 0.0001f, "cubic affine step");
+        compareVolumes(fusedVol, refVol, 1, 0.0001f, "cubic affine step, noise map");
+    }
+    {
+        vector<AlgorithmVolumeResample::TransformStep> transforms(1, AlgorithmVolumeResample::TransformStep(&warpVol));
+        VolumeFile fusedVol, refVol;
+        AlgorithmVolumeResample(NULL, &inVol, transforms, outDims, outSform, VolumeFile::CUBIC, &fusedVol);
+        AlgorithmVolumeWarpfieldResample(NULL, &inVol, &warpVol, outDims, outSform, VolumeFile::CUBIC, &refVol);
+        compareVolumes(fusedVol, refVol, 0, 0.0001f, "cubic warpfield step");
+        compareVolumes(fusedVol, refVol, 1, 0.0001f, "cubic warpfield step, noise map");
+    }
+    //affine then warpfield, against resampling through an intermediate volume on the input grid
+    //trilinear reproduces a linear function exactly, so the intermediate volume loses nothing for map 0
+    {
+        vector<AlgorithmVolumeResample::TransformStep> transforms;
+        transforms.push_back(AlgorithmVolumeResample::TransformStep(myAffine));
+        transforms.push_back(AlgorithmVolumeResample::TransformStep(&warpVol));
+        VolumeFile fusedVol, intermediateVol, chainedVol;
+        AlgorithmVolumeResample(NULL, &inVol, transforms, outDims, outSform, VolumeFile::TRILINEAR, &fusedVol);
+        const int64_t inDims[3] = { 20, 20, 20 };
+        AlgorithmVolumeAffineResample(NULL, &inVol, myAffine, inDims, makeSform(2.0f, -20.0f), VolumeFile::TRILINEAR, &intermediateVol);
+        AlgorithmVolumeWarpfieldResample(NULL, &intermediateVol, &warpVol, outDims, outSform, VolumeFile::TRILINEAR, &chainedVol);
+        compareVolumes(fusedVol, chainedVol, 0, 0.0001f, "trilinear affine + warpfield chain");
+    }
+}
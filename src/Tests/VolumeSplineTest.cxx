@@ -0,0 +1,174 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VolumeSplineTest.h"
+
+#include "AlgorithmVolumeSplinePrefilter.h"
+#include "AlgorithmVolumeToSurfaceMapping.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TestSurfaces.h"
+#include "VolumeFile.h"
+#include "VolumeSpline.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t DIMS[3] = { 12, 13, 14 };
+    
+    void makeSmoothVolume(VolumeFile& volOut)
+    {
+        vector<int64_t> dims(DIMS, DIMS + 3);
+        vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+        sform[0][0] = 2.0f; sform[1][1] = 2.0f; sform[2][2] = 2.0f;
+        sform[0][1] = 0.3f;//skewed on purpose, the spline works in index space
+        sform[0][3] = -12.0f; sform[1][3] = -13.0f; sform[2][3] = -14.0f;
+        volOut.reinitialize(dims, sform);
+        for (int64_t k = 0; k < DIMS[2]; ++k)
+        {
+            for (int64_t j = 0; j < DIMS[1]; ++j)
+            {
+                for (int64_t i = 0; i < DIMS[0]; ++i)
+                {
+                    volOut.setValue(sin(i * 0.4f) * cos(j * 0.3f) + 0.05f * k * k + 0.1f * (rand() % 10), i, j, k);
+                }
+            }
+        }
+    }
+    
+    //random index-space points, the last few outside the volume
+    void makePoints(const VolumeFile& vol, const int numPoints, vector<float>& ijkOut, vector<float>& coordsOut)
+    {
+        ijkOut.resize(numPoints * 3);
+        coordsOut.resize(numPoints * 3);
+        for (int p = 0; p < numPoints; ++p)
+        {
+            const bool outside = (p >= numPoints - 5);
+            for (int a = 0; a < 3; ++a)
+            {
+                float frac = (rand() % 10000) / 10000.0f;
+                if (outside && a == p % 3) frac = 1.5f;
+                ijkOut[p * 3 + a] = frac * (DIMS[a] - 1);
+            }
+            vol.indexToSpace(ijkOut.data() + p * 3, coordsOut.data() + p * 3);
+        }
+    }
+}
+
+VolumeSplineTest::VolumeSplineTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void VolumeSplineTest::execute()
+{
+    srand(17);
+    VolumeFile rawVol, prefiltVol;
+    makeSmoothVolume(rawVol);
+    AlgorithmVolumeSplinePrefilter(NULL, &rawVol, &prefiltVol);
+    const int numPoints = 203;//not a multiple of the group size in sampleMultiple
+    vector<float> ijk, coords;
+    makePoints(rawVol, numPoints, ijk, coords);
+    const int numInside = numPoints - 5;
+    VolumeSpline rawSpline(rawVol.getFrame(), DIMS), prefiltSpline(prefiltVol.getFrame(), DIMS, true), coefSpline(prefiltVol.getFrame(), DIMS);
+    //the prefiltered volume must hold the coefficients that the raw volume deconvolves to
+    for (int p = 0; p < numInside; ++p)
+    {
+        const float expected = rawSpline.sample(ijk.data() + p * 3), got = prefiltSpline.sample(ijk.data() + p * 3);
+        if (abs(expected - got) > 0.0001f * (1.0f + abs(expected)))
+        {
+            setFailed("prefiltered spline sample at point " + AString::number(p) + " is " + AString::number(got) + ", direct spline gives " + AString::number(expected));
+            return;
+        }
+    }
+    //sampleMultiple must be bit-identical to sample, including points outside the volume
+    vector<float> multiOut(numPoints);
+    rawSpline.sampleMultiple(ijk.data(), multiOut.data(), numPoints);
+    for (int p = 0; p < numPoints; ++p)
+    {
+        const float single = rawSpline.sample(ijk.data() + p * 3);
+        if (multiOut[p] != single)
+        {
+            setFailed("sampleMultiple at point " + AString::number(p) + " gave " + AString::number(multiOut[p]) + ", sample gave " + AString::number(single));
+            return;
+        }
+    }
+    //the cached frame spline must follow the mode of the last validateSpline call, not whichever mode built it first
+    const bool modes[3] = { true, false, true };
+    for (int m = 0; m < 3; ++m)
+    {
+        prefiltVol.validateSpline(0, 0, modes[m]);
+        VolumeSpline& reference = (modes[m] ? prefiltSpline : coefSpline);
+        for (int p = 0; p < numInside; ++p)
+        {
+            const float expected = reference.sample(ijk.data() + p * 3);
+            const float got = prefiltVol.interpolateValue(coords.data() + p * 3, VolumeFile::CUBIC);
+            if (abs(expected - got) > 0.0001f * (1.0f + abs(expected)))
+            {
+                setFailed(AString("cubic interpolation after validateSpline(") + (modes[m] ? "true" : "false") + ") at point " + AString::number(p) +
+                          " is " + AString::number(got) + ", expected " + AString::number(expected));
+                return;
+            }
+        }
+    }
+    //interpolateValuesCubic must match interpolateValue per point, with and without a prefiltered spline
+    for (int m = 0; m < 2; ++m)
+    {
+        VolumeFile& testVol = (m == 0 ? rawVol : prefiltVol);
+        if (m == 1) prefiltVol.validateSpline(0, 0, true);
+        vector<float> batchOut(numPoints);
+        testVol.interpolateValuesCubic(coords.data(), batchOut.data(), numPoints);
+        for (int p = 0; p < numPoints; ++p)
+        {
+            const float single = testVol.interpolateValue(coords.data() + p * 3, VolumeFile::CUBIC);
+            if (batchOut[p] != single)
+            {
+                setFailed(AString("interpolateValuesCubic on ") + (m == 0 ? "raw" : "prefiltered") + " volume at point " + AString::number(p) +
+                          " gave " + AString::number(batchOut[p]) + ", interpolateValue gave " + AString::number(single));
+                return;
+            }
+        }
+    }
+    //mapping with -input-prefiltered must agree with mapping the original volume
+    vector<float> sphereCoords;
+    vector<int32_t> sphereTiles;
+    TestSurfaces::makeSphere(3, 6.0f, sphereCoords, sphereTiles);
+    SurfaceFile mySurf;
+    TestSurfaces::makeSurfaceFile(sphereCoords, sphereTiles, mySurf);
+    MetricFile rawMapped, prefiltMapped;
+    AlgorithmVolumeToSurfaceMapping(NULL, &rawVol, &mySurf, &rawMapped, VolumeFile::CUBIC);
+    AlgorithmVolumeToSurfaceMapping(NULL, &prefiltVol, &mySurf, &prefiltMapped, VolumeFile::CUBIC, -1, true);
+    const float* rawData = rawMapped.getValuePointerForColumn(0);
+    const float* prefiltData = prefiltMapped.getValuePointerForColumn(0);
+    for (int32_t n = 0; n < mySurf.getNumberOfNodes(); ++n)
+    {
+        if (abs(rawData[n] - prefiltData[n]) > 0.0001f * (1.0f + abs(rawData[n])))
+        {
+            setFailed("mapping prefiltered volume at node " + AString::number(n) + " gave " + AString::number(prefiltData[n]) +
+                      ", mapping original gave " + AString::number(rawData[n]));
+            return;
+        }
+    }
+}
@@ -33,21 +33,44 @@
 #include "CaretException.h"
 
 //tests
+#include "BlockResampleTest.h"
 #include "CiftiFileTest.h"
+#include "ConnectedComponentTest.h"
 #include "DotTest.h"
+#include "FrameBlockMappingTest.h"
+#include "FrameProfilerTest.h"
+#include "FtglTextTest.h"
 #include "GeodesicHelperTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
 #include "LookupTest.h"
 #include "MathExpressionTest.h"
+#include "MetricColoringTest.h"
+#include "MetricTfcePermutationTest.h"
 #include "NiftiTest.h"
+#include "PaletteLookupTest.h"
+#include "ParallelProjectionTest.h"
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "RayCastTest.h"
+#include "ResampleOperatorTest.h"
+#include "RibbonOverlapTest.h"
+#include "SignedDistanceVolumeTest.h"
+#include "SpatialSearchTest.h"
+#include "SphericalTriangleLocatorTest.h"
 #include "StatisticsTest.h"
+#include "StreamingResampleTest.h"
+#include "SurfaceBuffersTest.h"
+#include "SurfaceLevelsOfDetailTest.h"
+#include "SurfaceNormalsTest.h"
+#include "TfceTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
+#include "VolumeColoringTest.h"
 #include "VolumeFileTest.h"
+#include "VolumeResampleTest.h"
+#include "VolumeSplineTest.h"
 #include "XnatTest.h"
 
 using namespace std;
@@ -69,22 +92,45 @@ int main(int argc, char** argv)
         caret_global_commandLine_init(argc, argv);
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
+        mytests.push_back(new BlockResampleTest("blockresample"));
         mytests.push_back(new CiftiFileTest("ciftifile"));
+        mytests.push_back(new ConnectedComponentTest("connectedcomponent"));
         mytests.push_back(new DotTest("dotsimd"));
+        mytests.push_back(new FrameBlockMappingTest("frameblockmapping"));
+        mytests.push_back(new FrameProfilerTest("frameprofiler"));
+        mytests.push_back(new FtglTextTest("ftgltext"));
         mytests.push_back(new GeodesicHelperTest("geohelp"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
         mytests.push_back(new LookupTest("lookup"));
         mytests.push_back(new MathExpressionTest("mathexpression"));
+        mytests.push_back(new MetricColoringTest("metriccoloring"));
+        mytests.push_back(new MetricTfcePermutationTest("metrictfceperm"));
         mytests.push_back(new NiftiFileTest("niftifile"));
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new PaletteLookupTest("palettelookup"));
+        mytests.push_back(new ParallelProjectionTest("parallelprojection"));
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new RayCastTest("raycast"));
+        mytests.push_back(new ResampleOperatorTest("resampleoperator"));
+        mytests.push_back(new RibbonOverlapTest("ribbonoverlap"));
+        mytests.push_back(new SignedDistanceVolumeTest("signeddistancevolume"));
+        mytests.push_back(new SpatialSearchTest("spatialsearch"));
+        mytests.push_back(new SphericalTriangleLocatorTest("sphericaltrianglelocator"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new StreamingResampleTest("streamingresample"));
+        mytests.push_back(new SurfaceBuffersTest("surfacebuffers"));
+        mytests.push_back(new SurfaceLevelsOfDetailTest("surfacelod"));
+        mytests.push_back(new SurfaceNormalsTest("surfacenormals"));
+        mytests.push_back(new TfceTest("tfce"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
+        mytests.push_back(new VolumeColoringTest("volumecoloring"));
         mytests.push_back(new VolumeFileTest("volumefile"));
+        mytests.push_back(new VolumeResampleTest("volumeresample"));
+        mytests.push_back(new VolumeSplineTest("volumespline"));
         mytests.push_back(new XnatTest("xnat"));
         if (argc < 2)
         {